@@ -130,6 +130,9 @@ class CheckoutConfig(typing.NamedTuple):
     - redirections: dict where keys are relative pathnames in the EdenFS mount
       and the values are RedirectionType enum values that describe the type of
       the redirection.
+    - ephemeral_overlay: whether local changes are only kept in memory, and
+      discarded when the checkout is unmounted or edenfs restarts. Meant for
+      throwaway checkouts, such as CI builds. Not supported on Windows.
     """
 
     backing_repo: Path
@@ -140,6 +143,7 @@ class CheckoutConfig(typing.NamedTuple):
     default_revision: str
     redirections: Dict[str, "RedirectionType"]
     active_prefetch_profiles: List[str]
+    ephemeral_overlay: bool = False
 
 
 class EdenInstance:
@@ -930,6 +934,7 @@ class EdenCheckout:
                 "guid": checkout_config.guid,
                 "protocol": checkout_config.mount_protocol,
                 "case-sensitive": checkout_config.case_sensitive,
+                "ephemeral-overlay": checkout_config.ephemeral_overlay,
             },
             "redirections": redirections,
             "profiles": {"active": checkout_config.active_prefetch_profiles},
@@ -987,6 +992,13 @@ class EdenCheckout:
             # For existing repositories, keep it case sensitive
             case_sensitive = sys.platform != "win32"
 
+        ephemeral_overlay = repository.get("ephemeral-overlay", False)
+        if not isinstance(ephemeral_overlay, bool):
+            raise Exception(
+                f"{config_path} has an invalid ephemeral-overlay setting "
+                "(boolean expected)"
+            )
+
         redirections = {}
         redirections_dict = config.get("redirections")
 
@@ -1039,6 +1051,7 @@ class EdenCheckout:
                 repository.get("default-revision") or DEFAULT_REVISION[scm_type]
             ),
             active_prefetch_profiles=prefetch_profiles,
+            ephemeral_overlay=ephemeral_overlay,
         )
 
     def get_snapshot(self) -> str:
@@ -1086,6 +1099,7 @@ class EdenCheckout:
             redirections=old_config.redirections,
             default_revision=old_config.default_revision,
             active_prefetch_profiles=new_active_profiles,
+            ephemeral_overlay=old_config.ephemeral_overlay,
         )
 
         self.save_config(new_config)
@@ -1118,6 +1132,7 @@ class EdenCheckout:
             redirections=old_config.redirections,
             default_revision=old_config.default_revision,
             active_prefetch_profiles=new_active_profiles,
+            ephemeral_overlay=old_config.ephemeral_overlay,
         )
 
         self.save_config(new_config)
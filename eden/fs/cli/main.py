@@ -717,6 +717,13 @@ class CloneCmd(Subcmd):
             action="store_true",
             help=argparse.SUPPRESS,
         )
+        parser.add_argument(
+            "--ephemeral-overlay",
+            action="store_true",
+            help="Only keep local changes in memory. They are lost when the "
+            "checkout is unmounted or edenfs restarts, so this is only meant for "
+            "throwaway checkouts such as CI builds.",
+        )
 
     async def run(self, args: argparse.Namespace) -> int:
         instance = get_eden_instance(args)
@@ -751,6 +758,12 @@ class CloneCmd(Subcmd):
             print_stderr("error: {}", ex)
             return 1
 
+        if args.ephemeral_overlay:
+            if sys.platform == "win32":
+                print_stderr("error: --ephemeral-overlay is not supported on Windows")
+                return 1
+            repo_config = repo_config._replace(ephemeral_overlay=True)
+
         # Find the commit to check out
         if args.rev is not None:
             try:
@@ -611,6 +611,7 @@ def apply_redirection_configs_to_checkout_config(
         default_revision=config.default_revision,
         redirections=redirections,
         active_prefetch_profiles=config.active_prefetch_profiles,
+        ephemeral_overlay=config.ephemeral_overlay,
     )
 
 
@@ -403,6 +403,7 @@ class LocalStoreCmd(Subcmd):
             ("tree", True),
             ("treemeta", True),
             ("hgcommit2tree", True),
+            ("globresult", True),
             ("scsproxyhash", True),
             ("hgproxyhash", False),
         ]
@@ -30,6 +30,7 @@ constexpr folly::StringPiece kRepoSection{"repository"};
 constexpr folly::StringPiece kRepoSourceKey{"path"};
 constexpr folly::StringPiece kRepoTypeKey{"type"};
 constexpr folly::StringPiece kRepoCaseSensitiveKey{"case-sensitive"};
+constexpr folly::StringPiece kRepoEphemeralOverlayKey{"ephemeral-overlay"};
 constexpr folly::StringPiece kMountProtocol{"protocol"};
 #ifdef _WIN32
 constexpr folly::StringPiece kRepoGuid{"guid"};
@@ -166,6 +167,14 @@ bool CheckoutConfig::getCaseSensitive() const {
   return caseSensitive_;
 }
 
+bool CheckoutConfig::getEphemeralOverlay() const {
+  return ephemeralOverlay_;
+}
+
+bool CheckoutConfig::isSnapshotMount() const {
+  return snapshotMount_;
+}
+
 AbsolutePath CheckoutConfig::getSnapshotPath() const {
   return clientDirectory_ + kSnapshotFile;
 }
@@ -200,6 +209,9 @@ std::unique_ptr<CheckoutConfig> CheckoutConfig::loadFromClientDirectory(
   config->caseSensitive_ =
       caseSensitive ? *caseSensitive : kPathMapDefaultCaseSensitive;
 
+  config->ephemeralOverlay_ =
+      repository->get_as<bool>(kRepoEphemeralOverlayKey.str()).value_or(false);
+
 #ifdef _WIN32
   auto guid = repository->get_as<std::string>(kRepoGuid.str());
   config->repoGuid_ = guid ? Guid{*guid} : Guid::generate();
@@ -208,6 +220,31 @@ std::unique_ptr<CheckoutConfig> CheckoutConfig::loadFromClientDirectory(
   return config;
 }
 
+std::unique_ptr<CheckoutConfig> CheckoutConfig::createSnapshotMount(
+    AbsolutePathPiece mountPath,
+    AbsolutePathPiece clientDirectory,
+    const CheckoutConfig& source,
+    const Hash& commit) {
+  auto config = std::make_unique<CheckoutConfig>(mountPath, clientDirectory);
+  config->repoType_ = source.repoType_;
+  config->repoSource_ = source.repoSource_;
+  config->mountProtocol_ = source.mountProtocol_;
+  config->caseSensitive_ = source.caseSensitive_;
+  config->ephemeralOverlay_ = true;
+  config->snapshotMount_ = true;
+#ifdef _WIN32
+  config->repoGuid_ = Guid::generate();
+#endif
+
+  // No config.toml is saved: snapshot mounts are never remounted, and a
+  // graceful restart unmounts them like the other mounts with an ephemeral
+  // overlay. The client directory only holds the SNAPSHOT file and whatever
+  // the overlay stores there.
+  ensureDirectoryExists(clientDirectory);
+  config->setParentCommits(commit);
+  return config;
+}
+
 folly::dynamic CheckoutConfig::loadClientDirectoryMap(
     AbsolutePathPiece edenDir) {
   // Extract the JSON and strip any comments.
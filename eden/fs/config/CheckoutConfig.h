@@ -58,6 +58,22 @@ class CheckoutConfig {
       AbsolutePathPiece mountPath,
       AbsolutePathPiece clientDirectory);
 
+  /**
+   * Create the client directory of a read-only view of the given commit,
+   * using the same repository as the source checkout, and return its
+   * CheckoutConfig.
+   *
+   * Snapshot mounts always use an ephemeral overlay, and are neither added
+   * to the client directory map nor given a config.toml: they go away along
+   * with their client directory when they are unmounted, including by a
+   * graceful restart.
+   */
+  static std::unique_ptr<CheckoutConfig> createSnapshotMount(
+      AbsolutePathPiece mountPath,
+      AbsolutePathPiece clientDirectory,
+      const CheckoutConfig& source,
+      const Hash& commit);
+
   static folly::dynamic loadClientDirectoryMap(AbsolutePathPiece edenDir);
 
   /**
@@ -116,6 +132,15 @@ class CheckoutConfig {
   /** Whether this repository is mounted in case-sensitive mode */
   bool getCaseSensitive() const;
 
+  /**
+   * Whether the overlay of this checkout is kept in memory and discarded on
+   * unmount, rather than persisted to disk.
+   */
+  bool getEphemeralOverlay() const;
+
+  /** Whether this is a read-only view created by createSnapshotMount() */
+  bool isSnapshotMount() const;
+
 #ifdef _WIN32
   /** Guid for that repository */
   Guid getRepoGuid() const {
@@ -130,6 +155,8 @@ class CheckoutConfig {
   std::string repoSource_;
   MountProtocol mountProtocol_;
   bool caseSensitive_{!folly::kIsWindows};
+  bool ephemeralOverlay_{false};
+  bool snapshotMount_{false};
 #ifdef _WIN32
   Guid repoGuid_;
 #endif
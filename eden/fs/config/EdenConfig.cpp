@@ -9,6 +9,7 @@
 
 #include <cpptoml.h> // @manual=fbsource//third-party/cpptoml:cpptoml
 #include <array>
+#include <iomanip>
 #include <sstream>
 
 #include <boost/filesystem.hpp>
@@ -362,7 +363,7 @@ namespace {
 // layers want to consume a bool or array, they expect to do so by consuming
 // the string representation of it.
 // This helper performs the reverse transformation so that we allow
-// users to specify their configuration as a true boolean or array type.
+// users to specify their configuration as a true boolean, array or table type.
 cpptoml::option<std::string> itemAsString(
     const std::shared_ptr<cpptoml::table>& currSection,
     const std::string& entryKey) {
@@ -384,6 +385,25 @@ cpptoml::option<std::string> itemAsString(
     return stringifiedValue.str();
   }
 
+  auto valueTable = currSection->get_table(entryKey);
+  if (valueTable) {
+    // re-serialize as an inline table
+    std::vector<std::string> entries;
+    for (const auto& [key, value] : *valueTable) {
+      std::ostringstream entry;
+      entry << std::quoted(key) << " = ";
+      if (auto str = cpptoml::get_impl<std::string>(value)) {
+        entry << std::quoted(*str);
+      } else if (auto integer = cpptoml::get_impl<int64_t>(value)) {
+        entry << *integer;
+      } else {
+        return {};
+      }
+      entries.push_back(entry.str());
+    }
+    return folly::to<std::string>("{", folly::join(", ", entries), "}");
+  }
+
   return {};
 }
 } // namespace
@@ -10,6 +10,7 @@
 #include <chrono>
 #include <memory>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 #include <folly/dynamic.h>
@@ -315,6 +316,11 @@ class EdenConfig : private ConfigSettingManager {
       20'000'000,
       this};
 
+  ConfigSetting<uint64_t> localStoreGlobResultSizeLimit{
+      "store:globresult-size-limit",
+      100'000'000,
+      this};
+
   ConfigSetting<bool> useEdenNativePrefetch{
       "store:use-eden-native-prefetch",
       false,
@@ -367,6 +373,16 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<bool> fuseUseEdenFS{"fuse:use-edenfs", false, this};
 
+  /**
+   * After a glob prefetches files, push the contents of the prefetched files
+   * that are loaded and not materialized into the kernel's page cache with
+   * FUSE_NOTIFY_STORE, up to this many bytes per glob. 0 disables it.
+   */
+  ConfigSetting<uint64_t> fuseNotifyStoreBudget{
+      "fuse:notify-store-budget",
+      0,
+      this};
+
   /**
    * Whether Eden should implement its own unix domain socket permission checks
    * or rely on filesystem permissions.
@@ -396,6 +412,26 @@ class EdenConfig : private ConfigSettingManager {
       "",
       this};
 
+  /**
+   * Per event type sampling rates for structured logging, keyed by the event
+   * type name (e.g. "fetch_heavy").  A rate of N logs one in N events of that
+   * type and a rate of 0 drops them entirely.  Event types that are not listed
+   * are always logged.  The rates are read when the logger is created.
+   */
+  ConfigSetting<std::unordered_map<std::string, uint32_t>> eventSampleRates{
+      "telemetry:event-sample-rates",
+      {},
+      this};
+
+  /**
+   * Identical structured events logged within this interval are aggregated
+   * into a single event with a "count" field before being sent to scribe.
+   */
+  ConfigSetting<std::chrono::nanoseconds> eventAggregationInterval{
+      "telemetry:event-aggregation-interval",
+      std::chrono::seconds{1},
+      this};
+
   /**
    * Legacy to be deleted, once all running eden's are compatible with
    * log-object-fetch-path-regex.
@@ -447,6 +483,89 @@ class EdenConfig : private ConfigSettingManager {
       "store:max-tree-prefetches",
       5,
       this};
+
+  /**
+   * The maximum number of tree fetches that a single glob or diff of source
+   * control trees may have in progress. Further fetches are queued.
+   */
+  ConfigSetting<uint64_t> maxTraversalTreeFetches{
+      "store:max-traversal-tree-fetches",
+      256,
+      this};
+
+  /**
+   * How long ObjectStore remembers that the backing store does not have an
+   * object. Requests for the object fail immediately during that time.
+   */
+  ConfigSetting<std::chrono::nanoseconds> negativeCacheNotFoundTtl{
+      "store:negative-cache-not-found-ttl",
+      std::chrono::seconds(30),
+      this};
+
+  /**
+   * After an object fails to import, ObjectStore fails requests for it
+   * immediately for this long, doubled with each consecutive failure up to
+   * negativeCacheMaxBackoff. 0 disables the backoff.
+   */
+  ConfigSetting<std::chrono::nanoseconds> negativeCacheInitialBackoff{
+      "store:negative-cache-initial-backoff",
+      std::chrono::seconds(1),
+      this};
+  ConfigSetting<std::chrono::nanoseconds> negativeCacheMaxBackoff{
+      "store:negative-cache-max-backoff",
+      std::chrono::minutes(1),
+      this};
+  /**
+   * Limits on the rate of imports from Mercurial, in requests and bytes per
+   * second, for each level of HgImportThrottle. 0 means unlimited.
+   *
+   * The global limits apply to all the repositories of this EdenFS process,
+   * the repo limits to each repository, and the channel, thrift and
+   * background limits to the imports of a repository caused by filesystem
+   * requests, Thrift requests, and prefetches respectively. Imports caused by
+   * filesystem requests are never delayed by the global and repo limits.
+   */
+  ConfigSetting<uint64_t> importRequestsPerSecond{
+      "hg:import-requests-per-second",
+      0,
+      this};
+  ConfigSetting<uint64_t> importBytesPerSecond{
+      "hg:import-bytes-per-second",
+      0,
+      this};
+  ConfigSetting<uint64_t> repoImportRequestsPerSecond{
+      "hg:repo-import-requests-per-second",
+      0,
+      this};
+  ConfigSetting<uint64_t> repoImportBytesPerSecond{
+      "hg:repo-import-bytes-per-second",
+      0,
+      this};
+  ConfigSetting<uint64_t> channelImportRequestsPerSecond{
+      "hg:channel-import-requests-per-second",
+      0,
+      this};
+  ConfigSetting<uint64_t> channelImportBytesPerSecond{
+      "hg:channel-import-bytes-per-second",
+      0,
+      this};
+  ConfigSetting<uint64_t> thriftImportRequestsPerSecond{
+      "hg:thrift-import-requests-per-second",
+      0,
+      this};
+  ConfigSetting<uint64_t> thriftImportBytesPerSecond{
+      "hg:thrift-import-bytes-per-second",
+      0,
+      this};
+  ConfigSetting<uint64_t> backgroundImportRequestsPerSecond{
+      "hg:background-import-requests-per-second",
+      0,
+      this};
+  ConfigSetting<uint64_t> backgroundImportBytesPerSecond{
+      "hg:background-import-bytes-per-second",
+      0,
+      this};
+
   /**
    * A command to run to warn the user of a generic problem encountered
    * while trying to process a request.
@@ -483,6 +602,26 @@ class EdenConfig : private ConfigSettingManager {
    * Controls whether Mountd will register itself against rpcbind.
    */
   ConfigSetting<bool> registerMountd{"nfs:register-mountd", false, this};
+
+  /**
+   * Files at least this large are partially materialized when first written:
+   * the overlay only stores the modified extents, and unmodified data keeps
+   * being read from the source control blob.  0 disables partial
+   * materialization.
+   */
+  ConfigSetting<uint64_t> partialMaterializationMinSize{
+      "overlay:partial-materialization-min-size",
+      0,
+      this};
+
+  /**
+   * Once more than this fraction of a partially materialized file has been
+   * modified, the file is fully materialized into the overlay.
+   */
+  ConfigSetting<double> partialMaterializationMaxModifiedRatio{
+      "overlay:partial-materialization-max-modified-ratio",
+      0.5,
+      this};
 };
 } // namespace eden
 } // namespace facebook
@@ -8,12 +8,14 @@
 #pragma once
 
 #include <cpptoml.h> // @manual=fbsource//third-party/cpptoml:cpptoml
+#include <algorithm>
 #include <chrono>
 #include <map>
 #include <optional>
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 
 #include <re2/re2.h>
 
@@ -134,6 +136,71 @@ class FieldConverter<std::vector<T>> {
   }
 };
 
+/*
+ * FieldConverter implementation for string-keyed tables, written as TOML inline
+ * tables such as `{fetch_heavy = "10", fuse_error = 1}`.
+ */
+template <typename T>
+class FieldConverter<std::unordered_map<std::string, T>> {
+ public:
+  folly::Expected<std::unordered_map<std::string, T>, std::string> fromString(
+      folly::StringPiece value,
+      const std::map<std::string, std::string>& convData) const {
+    // make the table parsable by cpptoml
+    std::string kTableKeyName{"table"};
+    std::istringstream valueStream{
+        folly::to<std::string>(kTableKeyName, " = ", value.str())};
+
+    // parse in toml type
+    std::shared_ptr<cpptoml::table> elements;
+    try {
+      cpptoml::parser parser{valueStream};
+      auto table = parser.parse();
+      elements = table->get_table(kTableKeyName);
+    } catch (cpptoml::parse_exception& err) {
+      return folly::Unexpected<std::string>(
+          folly::to<std::string>("Error parsing a table: ", err.what()));
+    }
+    if (!elements) {
+      return folly::Unexpected<std::string>(
+          "Error parsing a table: expected an inline table");
+    }
+
+    // parse from toml type to eden type
+    std::unordered_map<std::string, T> deserializedElements;
+    for (const auto& [key, element] : *elements) {
+      std::string stringElement;
+      if (auto str = cpptoml::get_impl<std::string>(element)) {
+        stringElement = *str;
+      } else if (auto integer = cpptoml::get_impl<int64_t>(element)) {
+        stringElement = folly::to<std::string>(*integer);
+      } else {
+        return folly::Unexpected<std::string>(
+            "eden currently only supports tables of strings and integers for config values");
+      }
+      auto deserializedElement =
+          FieldConverter<T>{}.fromString(stringElement, convData);
+      if (deserializedElement.hasError()) {
+        return folly::Unexpected(deserializedElement.error());
+      }
+      deserializedElements.emplace(key, std::move(deserializedElement).value());
+    }
+    return deserializedElements;
+  }
+
+  std::string toDebugString(
+      const std::unordered_map<std::string, T>& value) const {
+    std::vector<std::string> serializedElements;
+    serializedElements.reserve(value.size());
+    for (const auto& [key, element] : value) {
+      serializedElements.push_back(folly::to<std::string>(
+          key, "=", FieldConverter<T>{}.toDebugString(element)));
+    }
+    std::sort(serializedElements.begin(), serializedElements.end());
+    return folly::join(", ", serializedElements);
+  }
+};
+
 /*
  * FieldConverter implementation for integers, floating point, and bool types
  */
@@ -214,3 +214,24 @@ TEST_F(CheckoutConfigTest, testBadSnapshot) {
           48},
       "incorrect data size for Hash");
 }
+
+TEST_F(CheckoutConfigTest, testCreateSnapshotMount) {
+  auto source =
+      CheckoutConfig::loadFromClientDirectory(mountPoint_, clientDir_);
+  auto snapshotDir = AbsolutePath{(edenDir_->path() / "snapshot").string()};
+  Hash commit{"0123456789abcdef0123456789abcdef01234567"};
+
+  auto config = CheckoutConfig::createSnapshotMount(
+      AbsolutePath{"/tmp/snapshot"}, snapshotDir, *source, commit);
+  EXPECT_TRUE(config->isSnapshotMount());
+  EXPECT_TRUE(config->getEphemeralOverlay());
+  EXPECT_EQ("git", config->getRepoType());
+  EXPECT_EQ(commit, config->getParentCommits().parent1());
+
+  EXPECT_EQ("/data/users/carenthomas/fbsource", config->getRepoSource());
+  EXPECT_EQ(source->getCaseSensitive(), config->getCaseSensitive());
+
+  // Snapshot mounts are never remounted, so no config is saved for them.
+  EXPECT_FALSE(folly::fs::exists((snapshotDir + "config.toml"_pc).value()));
+  EXPECT_TRUE(folly::fs::exists(config->getSnapshotPath().value()));
+}
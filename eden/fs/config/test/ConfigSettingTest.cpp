@@ -411,3 +411,19 @@ TEST_F(ConfigSettingTest, setArrayOptional) {
   checkSet(
       setting, std::vector<std::optional<std::string>>{"foo"}, "[\"foo\"]");
 }
+
+TEST_F(ConfigSettingTest, setTable) {
+  using Table = std::unordered_map<std::string, uint32_t>;
+  ConfigSetting<Table> setting{"test:value", Table{}, nullptr};
+  EXPECT_EQ(Table{}, setting.getValue());
+  checkSet(setting, Table{{"a", 1}}, "{a = 1}");
+  checkSet(setting, Table{{"a", 1}, {"b", 20}}, "{a = \"1\", \"b\" = 20}");
+  EXPECT_EQ("a=1, b=20", setting.getStringValue());
+  checkSet(setting, Table{}, "{}");
+  checkSetError(
+      setting, "Error parsing a table: expected an inline table", "[1, 2]");
+  checkSetError(
+      setting,
+      "eden currently only supports tables of strings and integers for config values",
+      "{a = 1.5}");
+}
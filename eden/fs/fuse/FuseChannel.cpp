@@ -18,7 +18,9 @@
 #include "eden/fs/fuse/DirList.h"
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/fuse/FuseRequestContext.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/Synchronized.h"
 #include "eden/fs/utils/SystemError.h"
@@ -489,6 +491,21 @@ constexpr const HandlerEntry* lookupFuseHandlerEntry(uint32_t opcode) {
   return entry.name.empty() ? nullptr : &entry;
 }
 
+ChannelThreadStats::HistogramPtr queueWaitHistogram(
+    FuseRequestClass requestClass) {
+  switch (requestClass) {
+    case FuseRequestClass::Metadata:
+      return &ChannelThreadStats::metadataQueueWait;
+    case FuseRequestClass::Data:
+      return &ChannelThreadStats::dataQueueWait;
+    case FuseRequestClass::Mutation:
+      return &ChannelThreadStats::mutationQueueWait;
+    case FuseRequestClass::Forget:
+      return &ChannelThreadStats::forgetQueueWait;
+  }
+  EDEN_BUG() << "unknown FUSE request class " << enumValue(requestClass);
+}
+
 constexpr std::pair<uint32_t, const char*> kCapsLabels[] = {
     {FUSE_ASYNC_READ, "ASYNC_READ"},
     {FUSE_POSIX_LOCKS, "POSIX_LOCKS"},
@@ -596,6 +613,68 @@ ProcessAccessLog::AccessType fuseOpcodeAccessType(uint32_t opcode) {
                : ProcessAccessLog::AccessType::FsChannelOther;
 }
 
+FuseRequestClass fuseOpcodeRequestClass(uint32_t opcode) {
+  switch (opcode) {
+    case FUSE_FORGET:
+    case FUSE_BATCH_FORGET:
+      return FuseRequestClass::Forget;
+
+    case FUSE_READ:
+    case FUSE_WRITE:
+    case FUSE_READLINK:
+    case FUSE_READDIR:
+    case FUSE_FLUSH:
+    case FUSE_FSYNC:
+    case FUSE_FSYNCDIR:
+    case FUSE_FALLOCATE:
+      return FuseRequestClass::Data;
+
+    case FUSE_SETATTR:
+    case FUSE_SYMLINK:
+    case FUSE_MKNOD:
+    case FUSE_MKDIR:
+    case FUSE_UNLINK:
+    case FUSE_RMDIR:
+    case FUSE_RENAME:
+    case FUSE_LINK:
+    case FUSE_CREATE:
+    case FUSE_SETXATTR:
+    case FUSE_REMOVEXATTR:
+      return FuseRequestClass::Mutation;
+
+    default:
+      return FuseRequestClass::Metadata;
+  }
+}
+
+StringPiece fuseRequestClassName(FuseRequestClass requestClass) {
+  switch (requestClass) {
+    case FuseRequestClass::Metadata:
+      return "metadata";
+    case FuseRequestClass::Data:
+      return "data";
+    case FuseRequestClass::Mutation:
+      return "mutation";
+    case FuseRequestClass::Forget:
+      return "forget";
+  }
+  EDEN_BUG() << "unknown FUSE request class " << enumValue(requestClass);
+}
+
+size_t FuseRequestClassThreads::get(FuseRequestClass requestClass) const {
+  switch (requestClass) {
+    case FuseRequestClass::Metadata:
+      return metadata;
+    case FuseRequestClass::Data:
+      return data;
+    case FuseRequestClass::Mutation:
+      return mutation;
+    case FuseRequestClass::Forget:
+      return forget;
+  }
+  EDEN_BUG() << "unknown FUSE request class " << enumValue(requestClass);
+}
+
 FuseChannel::DataRange::DataRange(int64_t off, int64_t len)
     : offset(off), length(len) {}
 
@@ -615,6 +694,11 @@ FuseChannel::InvalidationEntry::InvalidationEntry(Promise<Unit> p)
       inode(kRootNodeId),
       promise(std::move(p)) {}
 
+FuseChannel::InvalidationEntry::InvalidationEntry(
+    InodeNumber num,
+    std::unique_ptr<folly::IOBuf> d)
+    : type(InvalidationType::STORE), inode(num), data(std::move(d)) {}
+
 FuseChannel::InvalidationEntry::~InvalidationEntry() {
   switch (type) {
     case InvalidationType::INODE:
@@ -626,6 +710,9 @@ FuseChannel::InvalidationEntry::~InvalidationEntry() {
     case InvalidationType::FLUSH:
       promise.~Promise();
       return;
+    case InvalidationType::STORE:
+      data.~unique_ptr();
+      return;
   }
   XLOG(FATAL) << "unknown InvalidationEntry type: "
               << static_cast<uint64_t>(type);
@@ -657,6 +744,9 @@ FuseChannel::InvalidationEntry::InvalidationEntry(
     case InvalidationType::FLUSH:
       new (&promise) Promise<Unit>(std::move(other.promise));
       return;
+    case InvalidationType::STORE:
+      new (&data) std::unique_ptr<folly::IOBuf>(std::move(other.data));
+      return;
   }
 }
 
@@ -672,6 +762,9 @@ std::ostream& operator<<(
                 << "\")";
     case FuseChannel::InvalidationType::FLUSH:
       return os << "(invalidation flush)";
+    case FuseChannel::InvalidationType::STORE:
+      return os << "(store inode " << entry.inode << ", length "
+                << entry.data->computeChainDataLength() << ")";
   }
   return os << "(unknown invalidation type "
             << static_cast<uint64_t>(entry.type) << " inode " << entry.inode
@@ -773,9 +866,11 @@ FuseChannel::FuseChannel(
     folly::Logger* straceLogger,
     std::shared_ptr<ProcessNameCache> processNameCache,
     folly::Duration requestTimeout,
-    Notifications* notifications)
+    Notifications* notifications,
+    FuseRequestClassThreads requestClassThreads)
     : bufferSize_(std::max(size_t(getpagesize()) + 0x1000, MIN_BUFSIZE)),
       numThreads_(numThreads),
+      requestClassThreads_(requestClassThreads),
       dispatcher_(std::move(dispatcher)),
       straceLogger_(straceLogger),
       mountPath_(mountPath),
@@ -788,6 +883,11 @@ FuseChannel::FuseChannel(
           "FuseTrace" + mountPath.stringPiece().str(),
           kTraceBusCapacity)) {
   XCHECK_GE(numThreads_, 1ul);
+  for (auto requestClass : kFuseRequestClasses) {
+    XCHECK_GE(requestClassThreads_.get(requestClass), 1ul)
+        << "no worker thread for " << fuseRequestClassName(requestClass)
+        << " FUSE requests";
+  }
   installSignalHandler();
 
   traceSubscriptionHandles_.push_back(traceBus_->subscribeFunction(
@@ -822,7 +922,7 @@ Future<FuseChannel::StopFuture> FuseChannel::initialize(bool caseSensitive) {
   // once initialization completes.
   return folly::makeFutureWith([&] {
     auto state = state_.wlock();
-    state->workerThreads.reserve(numThreads_);
+    state->workerThreads.reserve(getWorkerThreadCount());
     state->workerThreads.emplace_back(
         [this, caseSensitive] { initWorkerThread(caseSensitive); });
     return initPromise_.getFuture();
@@ -855,8 +955,17 @@ void FuseChannel::startWorkerThreads() {
   }
 
   try {
-    state->workerThreads.reserve(numThreads_);
-    while (state->workerThreads.size() < numThreads_) {
+    // Start the request worker threads before the remaining threads reading
+    // from the FUSE device, so that every request that gets read has a
+    // thread to process it.
+    state->workerThreads.reserve(getWorkerThreadCount());
+    for (auto requestClass : kFuseRequestClasses) {
+      for (size_t i = 0; i < requestClassThreads_.get(requestClass); ++i) {
+        state->workerThreads.emplace_back(
+            [this, requestClass] { requestWorkerThread(requestClass); });
+      }
+    }
+    while (state->workerThreads.size() < getWorkerThreadCount()) {
       state->workerThreads.emplace_back([this] { fuseWorkerThread(); });
     }
 
@@ -865,6 +974,7 @@ void FuseChannel::startWorkerThreads() {
     XLOG(ERR) << "Error starting FUSE worker threads: " << exceptionStr(ex);
     // Request any threads we did start to stop now.
     requestSessionExit(state, StopReason::INIT_FAILED);
+    closeRequestQueues();
     stopInvalidationThread();
     throw;
   }
@@ -930,6 +1040,13 @@ void FuseChannel::invalidateInodes(folly::Range<InodeNumber*> range) {
     invalidationCV_.notify_one();
   }
 }
+void FuseChannel::storeInodeData(
+    InodeNumber ino,
+    std::unique_ptr<folly::IOBuf> data) {
+  invalidationQueue_.lock()->queue.emplace_back(ino, std::move(data));
+  invalidationCV_.notify_one();
+}
+
 folly::Future<folly::Unit> FuseChannel::flushInvalidations() {
   // Add a promise to the invalidation queue, which the invalidation thread
   // will fulfill once it reaches that element in the queue.
@@ -963,6 +1080,9 @@ void FuseChannel::sendInvalidation(InvalidationEntry& entry) {
         // invalidation queue have been completed.
         entry.promise.setValue();
         return;
+      case InvalidationType::STORE:
+        sendStoreInode(entry.inode, *entry.data);
+        return;
     }
     EDEN_BUG() << "unknown invalidation entry type "
                << static_cast<uint64_t>(entry.type);
@@ -1192,8 +1312,6 @@ void FuseChannel::fuseWorkerThread() noexcept {
   disablePthreadCancellation();
   setThreadName(to<std::string>("fuse", mountPath_.basename()));
   setThreadSigmask();
-  *(liveRequestWatches_.get()) =
-      std::make_shared<RequestMetricsScope::LockedRequestWatchList>();
 
   try {
     processSession();
@@ -1206,20 +1324,171 @@ void FuseChannel::fuseWorkerThread() noexcept {
     // Fall through and continue with the normal thread exit code.
   }
 
-  // Record that we have shut down.
+  // Once the last thread reading from the FUSE device stops, no more requests
+  // can be queued, and the request worker threads can exit once they have
+  // drained their queue.
+  bool lastReader;
   {
-    auto state = state_.wlock();
-    ++state->stoppedThreads;
-    XDCHECK(!state->destroyPending) << "destroyPending cannot be set while "
-                                       "worker threads are still running";
-
-    // If we are the last thread to stop and there are no more requests
-    // outstanding then invoke sessionComplete().  If we are the last thread
-    // but there are still outstanding requests we will invoke
-    // sessionComplete() when we process the final stage of the request
-    // processing for the last request.
-    if (state->stoppedThreads == numThreads_ && state->pendingRequests == 0) {
-      sessionComplete(std::move(state));
+    auto queues = requestQueues_.lock();
+    lastReader = ++queues->stoppedReaders == numThreads_;
+  }
+  if (lastReader) {
+    closeRequestQueues();
+  }
+
+  workerThreadStopped();
+}
+
+void FuseChannel::requestWorkerThread(FuseRequestClass requestClass) noexcept {
+  disablePthreadCancellation();
+  setThreadName(to<std::string>("fuse", mountPath_.basename()));
+  *(liveRequestWatches_.get()) =
+      std::make_shared<RequestMetricsScope::LockedRequestWatchList>();
+
+  while (auto request = dequeueRequest(requestClass)) {
+    auto queueWait = std::chrono::steady_clock::now() - request->enqueueTime;
+    dispatcher_->getStats()->getChannelStatsForCurrentThread().recordLatency(
+        queueWaitHistogram(requestClass),
+        std::chrono::duration_cast<std::chrono::microseconds>(queueWait));
+
+    const auto* header =
+        reinterpret_cast<const fuse_in_header*>(request->buffer.data());
+    const ByteRange arg{
+        reinterpret_cast<const uint8_t*>(header + 1),
+        request->buffer.size() - sizeof(fuse_in_header)};
+    try {
+      processRequest(*header, arg, queueWait);
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "unexpected error in FUSE worker thread: "
+                << exceptionStr(ex);
+      requestSessionExit(StopReason::WORKER_EXCEPTION);
+      // The request never got to its completion callback.
+      requestCompleted();
+    }
+  }
+
+  workerThreadStopped();
+}
+
+void FuseChannel::workerThreadStopped() {
+  auto state = state_.wlock();
+  ++state->stoppedThreads;
+  XDCHECK(!state->destroyPending) << "destroyPending cannot be set while "
+                                     "worker threads are still running";
+
+  // If we are the last thread to stop and there are no more requests
+  // outstanding then invoke sessionComplete().  If we are the last thread
+  // but there are still outstanding requests we will invoke
+  // sessionComplete() when we process the final stage of the request
+  // processing for the last request.
+  if (state->stoppedThreads == getWorkerThreadCount() &&
+      state->pendingRequests == 0) {
+    sessionComplete(std::move(state));
+  }
+}
+
+void FuseChannel::requestCompleted() {
+  // We may be complete; check to see if all requests are
+  // done and whether there are any threads remaining.
+  auto state = state_.wlock();
+  XCHECK_NE(state->pendingRequests, 0u) << "pendingRequests double decrement";
+  if (--state->pendingRequests == 0 &&
+      state->stoppedThreads == getWorkerThreadCount()) {
+    sessionComplete(std::move(state));
+  }
+}
+
+void FuseChannel::enqueueRequest(
+    FuseRequestClass requestClass,
+    const char* data,
+    size_t size) {
+  auto index = enumValue(requestClass);
+  QueuedRequest request{
+      std::vector<char>(data, data + size), std::chrono::steady_clock::now()};
+  requestQueues_.lock()->queues[index].push_back(std::move(request));
+  requestQueueCVs_[index].notify_one();
+}
+
+std::optional<FuseChannel::QueuedRequest> FuseChannel::dequeueRequest(
+    FuseRequestClass requestClass) {
+  auto index = enumValue(requestClass);
+  auto queues = requestQueues_.lock();
+  auto& queue = queues->queues[index];
+  while (queue.empty()) {
+    if (queues->closed) {
+      return std::nullopt;
+    }
+    requestQueueCVs_[index].wait(queues.getUniqueLock());
+  }
+  auto request = std::move(queue.front());
+  queue.pop_front();
+  return request;
+}
+
+void FuseChannel::closeRequestQueues() {
+  requestQueues_.lock()->closed = true;
+  for (auto& cv : requestQueueCVs_) {
+    cv.notify_all();
+  }
+}
+
+size_t FuseChannel::getRequestQueueDepth(FuseRequestClass requestClass) const {
+  return requestQueues_.lock()->queues[enumValue(requestClass)].size();
+}
+
+/**
+ * Send FUSE_NOTIFY_STORE messages to the kernel for the contents of an inode.
+ *
+ * This method always runs in the invalidation thread.
+ */
+void FuseChannel::sendStoreInode(InodeNumber ino, folly::IOBuf& data) {
+  // FUSE_NOTIFY_STORE was added in protocol version 7.15.
+  if (connInfo_->major == 7 && connInfo_->minor < 15) {
+    XLOG(DBG4) << "not storing data for inode " << ino
+               << ": unsupported by the kernel";
+    return;
+  }
+
+  // The kernel copies the data of a message while holding the locks of the
+  // pages it fills, so send large contents in bounded chunks.
+  constexpr size_t kMaxStoreSize = 1024 * 1024;
+
+  auto contents = data.coalesce();
+  XLOG(DBG3) << "sendStoreInode(ino=" << ino << ", len=" << contents.size()
+             << ")";
+  for (size_t offset = 0; offset < contents.size(); offset += kMaxStoreSize) {
+    auto chunk = contents.subpiece(offset, kMaxStoreSize);
+
+    fuse_notify_store_out notify = {};
+    notify.nodeid = ino.get();
+    notify.offset = offset;
+    notify.size = chunk.size();
+
+    fuse_out_header out;
+    out.unique = 0;
+    out.error = FUSE_NOTIFY_STORE;
+
+    std::array<iovec, 3> iov;
+
+    iov[0].iov_base = &out;
+    iov[0].iov_len = sizeof(out);
+
+    iov[1].iov_base = &notify;
+    iov[1].iov_len = sizeof(notify);
+
+    iov[2].iov_base = const_cast<uint8_t*>(chunk.data());
+    iov[2].iov_len = chunk.size();
+
+    try {
+      sendRawReply(iov.data(), iov.size());
+    } catch (const std::system_error& exc) {
+      // Ignore ENOENT.  The kernel may have forgotten the inode.
+      if (!isEnoent(exc)) {
+        throwSystemErrorExplicit(
+            exc.code().value(), "error storing data for FUSE inode ", ino);
+      }
+      XLOG(DBG6) << "sendStoreInode(ino=" << ino << ") failed with ENOENT";
+      return;
     }
   }
 }
@@ -1640,63 +1909,11 @@ void FuseChannel::processSession() {
 
       default: {
         if (handlerEntry && handlerEntry->handler) {
-          auto requestId = generateUniqueID();
-          if (handlerEntry->argRenderer &&
-              traceDetailedArguments_->load(std::memory_order_acquire)) {
-            traceBus_->publish(FuseTraceEvent::start(
-                requestId, *header, handlerEntry->argRenderer(arg)));
-          } else {
-            traceBus_->publish(FuseTraceEvent::start(requestId, *header));
-          }
-
-          // This is a shared_ptr because, due to timeouts, the internal request
-          // lifetime may not match the FUSE request lifetime, so we capture it
-          // in both. I'm sure this could be improved with some cleverness.
-          auto request = std::make_shared<FuseRequestContext>(this, *header);
-
+          // Hand the request off to the worker threads of its class. The
+          // request is pending until it completes.
           ++state_.wlock()->pendingRequests;
-
-          auto headerCopy = *header;
-
-          FB_LOG(*straceLogger_, DBG7, ([&]() -> std::string {
-            std::string rendered;
-            if (handlerEntry->argRenderer) {
-              rendered = handlerEntry->argRenderer(arg);
-            }
-            return fmt::format(
-                "{}({}{}{})",
-                handlerEntry->getShortName(),
-                headerCopy.nodeid,
-                rendered.empty() ? "" : ", ",
-                rendered);
-          })());
-
-          request
-              ->catchErrors(
-                  folly::makeFutureWith([&] {
-                    request->startRequest(
-                        dispatcher_->getStats(),
-                        handlerEntry->histogram,
-                        *(liveRequestWatches_.get()));
-                    return (this->*handlerEntry->handler)(
-                        *request, request->getReq(), arg);
-                  }).ensure([request] {
-                    }).within(requestTimeout_),
-                  notifications_)
-              .ensure([this, request, requestId, headerCopy] {
-                traceBus_->publish(FuseTraceEvent::finish(
-                    requestId, headerCopy, request->getResult()));
-
-                // We may be complete; check to see if all requests are
-                // done and whether there are any threads remaining.
-                auto state = state_.wlock();
-                XCHECK_NE(state->pendingRequests, 0u)
-                    << "pendingRequests double decrement";
-                if (--state->pendingRequests == 0 &&
-                    state->stoppedThreads == numThreads_) {
-                  sessionComplete(std::move(state));
-                }
-              });
+          enqueueRequest(
+              fuseOpcodeRequestClass(header->opcode), buf.data(), arg_size);
           break;
         }
 
@@ -1729,6 +1946,72 @@ void FuseChannel::processSession() {
   }
 }
 
+void FuseChannel::processRequest(
+    const fuse_in_header& header,
+    ByteRange arg,
+    std::chrono::steady_clock::duration queueWait) {
+  auto* handlerEntry = lookupFuseHandlerEntry(header.opcode);
+  XCHECK(handlerEntry && handlerEntry->handler)
+      << "queued FUSE request without a handler: " << header.opcode;
+
+  auto requestId = generateUniqueID();
+  if (handlerEntry->argRenderer &&
+      traceDetailedArguments_->load(std::memory_order_acquire)) {
+    traceBus_->publish(FuseTraceEvent::start(
+        requestId, header, handlerEntry->argRenderer(arg)));
+  } else {
+    traceBus_->publish(FuseTraceEvent::start(requestId, header));
+  }
+
+  // This is a shared_ptr because, due to timeouts, the internal request
+  // lifetime may not match the FUSE request lifetime, so we capture it
+  // in both. I'm sure this could be improved with some cleverness.
+  auto request = std::make_shared<FuseRequestContext>(this, header);
+
+  auto headerCopy = header;
+
+  // The timeout starts when the request is queued, so that a request stuck
+  // behind a backlog of its class doesn't wait for the full timeout again
+  // once a worker thread picks it up.
+  auto timeout = requestTimeout_ -
+      std::chrono::duration_cast<folly::Duration>(queueWait);
+
+  FB_LOG(*straceLogger_, DBG7, ([&]() -> std::string {
+    std::string rendered;
+    if (handlerEntry->argRenderer) {
+      rendered = handlerEntry->argRenderer(arg);
+    }
+    return fmt::format(
+        "{}({}{}{})",
+        handlerEntry->getShortName(),
+        headerCopy.nodeid,
+        rendered.empty() ? "" : ", ",
+        rendered);
+  })());
+
+  request
+      ->catchErrors(
+          folly::makeFutureWith([&] {
+            request->startRequest(
+                dispatcher_->getStats(),
+                handlerEntry->histogram,
+                *(liveRequestWatches_.get()));
+            if (timeout <= folly::Duration::zero()) {
+              // The request waited in its queue for the whole timeout.
+              throw folly::FutureTimeout{};
+            }
+            return (this->*handlerEntry->handler)(
+                *request, request->getReq(), arg);
+          }).ensure([request] {
+            }).within(std::max(timeout, folly::Duration{1})),
+          notifications_)
+      .ensure([this, request, requestId, headerCopy] {
+        traceBus_->publish(FuseTraceEvent::finish(
+            requestId, headerCopy, request->getResult()));
+        requestCompleted();
+      });
+}
+
 void FuseChannel::sessionComplete(folly::Synchronized<State>::LockedPtr state) {
   // Check to see if we should delete ourself after fulfilling
   // sessionCompletePromise_
@@ -12,10 +12,14 @@
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
+#include <folly/io/IOBuf.h>
 #include <folly/synchronization/CallOnce.h>
 #include <stdlib.h>
 #include <sys/uio.h>
+#include <array>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <iosfwd>
 #include <memory>
 #include <optional>
@@ -137,6 +141,46 @@ struct FuseTraceEvent : TraceEventBase {
   Details details_;
 };
 
+/**
+ * The classes of FUSE requests. Each class is served by its own worker
+ * threads, so that slow requests of one class, like READs waiting on imports,
+ * can't starve the requests of the other classes.
+ */
+enum class FuseRequestClass : uint8_t {
+  /** Requests that only look at inode metadata, like LOOKUP and GETATTR. */
+  Metadata,
+  /** Requests that read or write file or directory contents. */
+  Data,
+  /** Requests that modify the directory structure or inode attributes. */
+  Mutation,
+  /** FORGET and BATCH_FORGET. */
+  Forget,
+};
+
+constexpr FuseRequestClass kFuseRequestClasses[] = {
+    FuseRequestClass::Metadata,
+    FuseRequestClass::Data,
+    FuseRequestClass::Mutation,
+    FuseRequestClass::Forget,
+};
+
+constexpr size_t kFuseRequestClassCount = std::size(kFuseRequestClasses);
+
+/**
+ * The number of worker threads reserved for each FuseRequestClass.
+ */
+struct FuseRequestClassThreads {
+  size_t metadata{4};
+  size_t data{8};
+  size_t mutation{2};
+  size_t forget{1};
+
+  size_t get(FuseRequestClass requestClass) const;
+  size_t total() const {
+    return metadata + data + mutation + forget;
+  }
+};
+
 class FuseChannel {
  public:
   enum class StopReason {
@@ -197,6 +241,9 @@ class FuseChannel {
    * The caller is expected to follow up with a call to the
    * initialize() method to perform the handshake with the
    * kernel and set up the thread pool.
+   *
+   * numThreads threads read requests from the FUSE device, and hand them off
+   * to the worker threads of their FuseRequestClass.
    */
   FuseChannel(
       folly::File&& fuseDevice,
@@ -206,7 +253,8 @@ class FuseChannel {
       folly::Logger* straceLogger,
       std::shared_ptr<ProcessNameCache> processNameCache,
       folly::Duration requestTimeout = std::chrono::seconds(60),
-      Notifications* FOLLY_NULLABLE notifications = nullptr);
+      Notifications* FOLLY_NULLABLE notifications = nullptr,
+      FuseRequestClassThreads requestClassThreads = {});
 
   /**
    * Destroy the FuseChannel.
@@ -317,6 +365,19 @@ class FuseChannel {
    */
   void invalidateInodes(folly::Range<InodeNumber*> range);
 
+  /**
+   * Push the contents of the specified inode into the kernel's page cache,
+   * starting at offset 0, so that reads of it don't have to go through FUSE.
+   *
+   * This is sent through the same queue as invalidations, and is thus ordered
+   * with them: an invalidation requested after this call will drop the data.
+   * The kernel ignores the request if it doesn't know about the inode.
+   *
+   * @param ino the inode number
+   * @param data the full contents of the inode
+   */
+  void storeInodeData(InodeNumber ino, std::unique_ptr<folly::IOBuf> data);
+
   /**
    * Wait for all currently scheduled invalidateInode() and invalidateEntry()
    * operations to complete.
@@ -436,6 +497,12 @@ class FuseChannel {
 
   size_t getRequestMetric(RequestMetricsScope::RequestMetric metric) const;
 
+  /**
+   * Returns the number of requests of the given class that were read from the
+   * FUSE device but that no worker thread has started processing yet.
+   */
+  size_t getRequestQueueDepth(FuseRequestClass requestClass) const;
+
  private:
   /**
    * All of our mutable state that may be accessed from the worker threads,
@@ -494,11 +561,13 @@ class FuseChannel {
     INODE,
     DIR_ENTRY,
     FLUSH,
+    STORE,
   };
   struct InvalidationEntry {
     InvalidationEntry(InodeNumber inode, int64_t offset, int64_t length);
     InvalidationEntry(InodeNumber inode, PathComponentPiece name);
     explicit InvalidationEntry(folly::Promise<folly::Unit> promise);
+    InvalidationEntry(InodeNumber inode, std::unique_ptr<folly::IOBuf> data);
     InvalidationEntry(InvalidationEntry&& other) noexcept;
     ~InvalidationEntry();
 
@@ -508,12 +577,31 @@ class FuseChannel {
       PathComponent name;
       DataRange range;
       folly::Promise<folly::Unit> promise;
+      std::unique_ptr<folly::IOBuf> data;
     };
   };
   struct InvalidationQueue {
     std::vector<InvalidationEntry> queue;
     bool stop{false};
   };
+
+  /**
+   * A request read from the FUSE device, waiting for a worker thread of its
+   * class.
+   */
+  struct QueuedRequest {
+    std::vector<char> buffer;
+    std::chrono::steady_clock::time_point enqueueTime;
+  };
+  struct RequestQueues {
+    std::array<std::deque<QueuedRequest>, kFuseRequestClassCount> queues;
+    size_t stoppedReaders{0};
+    /**
+     * Set once no more requests will be queued. The worker threads exit once
+     * their queue is drained.
+     */
+    bool closed{false};
+  };
   friend std::ostream& operator<<(
       std::ostream& os,
       const InvalidationEntry& entry);
@@ -664,11 +752,25 @@ class FuseChannel {
   void setThreadSigmask();
   void initWorkerThread(bool caseSensitive) noexcept;
   void fuseWorkerThread() noexcept;
+  void requestWorkerThread(FuseRequestClass requestClass) noexcept;
+  void workerThreadStopped();
+  void requestCompleted();
+  void enqueueRequest(
+      FuseRequestClass requestClass,
+      const char* data,
+      size_t size);
+  std::optional<QueuedRequest> dequeueRequest(FuseRequestClass requestClass);
+  void closeRequestQueues();
+  void processRequest(
+      const fuse_in_header& header,
+      folly::ByteRange arg,
+      std::chrono::steady_clock::duration queueWait);
   void invalidationThread() noexcept;
   void stopInvalidationThread();
   void sendInvalidation(InvalidationEntry& entry);
   void sendInvalidateInode(InodeNumber ino, int64_t off, int64_t len);
   void sendInvalidateEntry(InodeNumber parent, PathComponentPiece name);
+  void sendStoreInode(InodeNumber ino, folly::IOBuf& data);
   void readInitPacket(bool caseSensitive);
   void startWorkerThreads();
 
@@ -681,6 +783,14 @@ class FuseChannel {
    */
   void sessionComplete(folly::Synchronized<State>::LockedPtr state);
 
+  /**
+   * The number of threads reading from the FUSE device, plus the number of
+   * request worker threads.
+   */
+  size_t getWorkerThreadCount() const {
+    return numThreads_ + requestClassThreads_.total();
+  }
+
   static bool isFuseDeviceValid(StopReason reason) {
     // The FuseDevice may still be used if the FuseChannel was stopped due to a
     // takeover request or because the FuseChannel object was destroyed without
@@ -694,7 +804,8 @@ class FuseChannel {
   }
 
   /**
-   * Dispatches fuse requests until the session is torn down.
+   * Reads fuse requests and queues them for the request worker threads until
+   * the session is torn down.
    * This function blocks until the fuse session is stopped.
    * The intent is that this is called from each of the
    * fuse worker threads provided by the MountPoint.
@@ -714,6 +825,7 @@ class FuseChannel {
    */
   const size_t bufferSize_{0};
   const size_t numThreads_;
+  const FuseRequestClassThreads requestClassThreads_;
   std::unique_ptr<FuseDispatcher> dispatcher_;
   folly::Logger* const straceLogger_;
   const AbsolutePath mountPath_;
@@ -765,13 +877,17 @@ class FuseChannel {
   std::condition_variable invalidationCV_;
   std::thread invalidationThread_;
 
+  // Requests read from the FUSE device, waiting for a worker thread.
+  folly::Synchronized<RequestQueues, std::mutex> requestQueues_;
+  std::array<std::condition_variable, kFuseRequestClassCount> requestQueueCVs_;
+
   ProcessAccessLog processAccessLog_;
 
   // this tracks metrics for live FUSE requests, this is a thread local
-  // to avoid contention between the FuseWorkerThreads as they kick off
+  // to avoid contention between the request worker threads as they kick off
   // requests.
   // each thread local is a shared pointer to keep the tracker from being
-  // destroyed when the owning FuseWorkerThread ends if there are outstanding
+  // destroyed when the owning worker thread ends if there are outstanding
   // requests as these may outlive the spawning worker thread.
   class ThreadLocalTag {};
   folly::ThreadLocal<
@@ -801,6 +917,8 @@ class FuseChannel {
 
 folly::StringPiece fuseOpcodeName(uint32_t opcode);
 ProcessAccessLog::AccessType fuseOpcodeAccessType(uint32_t opcode);
+FuseRequestClass fuseOpcodeRequestClass(uint32_t opcode);
+folly::StringPiece fuseRequestClassName(FuseRequestClass requestClass);
 
 /**
  * FuseChannelDeleter acts as a deleter argument for std::shared_ptr or
@@ -8,9 +8,12 @@
 #include "eden/fs/fuse/FuseChannel.h"
 
 #include <folly/Random.h>
+#include <folly/ScopeGuard.h>
 #include <folly/logging/xlog.h>
 #include <folly/test/TestUtils.h>
 #include <gtest/gtest.h>
+#include <set>
+#include <thread>
 #include <unordered_map>
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/telemetry/EdenStats.h"
@@ -65,7 +68,9 @@ fuse_entry_out genRandomLookupResponse(uint64_t nodeid) {
 class FuseChannelTest : public ::testing::Test {
  protected:
   unique_ptr<FuseChannel, FuseChannelDeleter> createChannel(
-      size_t numThreads = 2) {
+      size_t numThreads = 2,
+      FuseRequestClassThreads requestClassThreads = {},
+      folly::Duration requestTimeout = 60s) {
     auto testDispatcher = std::make_unique<TestDispatcher>(&stats_);
     dispatcher_ = testDispatcher.get();
     return unique_ptr<FuseChannel, FuseChannelDeleter>(new FuseChannel(
@@ -74,7 +79,10 @@ class FuseChannelTest : public ::testing::Test {
         numThreads,
         std::move(testDispatcher),
         &straceLogger,
-        std::make_shared<ProcessNameCache>()));
+        std::make_shared<ProcessNameCache>(),
+        requestTimeout,
+        nullptr,
+        requestClassThreads));
   }
 
   FuseChannel::StopFuture performInit(
@@ -104,6 +112,24 @@ class FuseChannelTest : public ::testing::Test {
     return std::move(initFuture).get(kTimeout);
   }
 
+  /**
+   * Wait until the given number of requests of requestClass are queued, since
+   * the threads reading from the FUSE device queue them asynchronously.
+   */
+  void waitForQueueDepth(
+      FuseChannel* channel,
+      FuseRequestClass requestClass,
+      size_t depth) {
+    auto deadline = std::chrono::steady_clock::now() + kTimeout;
+    while (channel->getRequestQueueDepth(requestClass) != depth) {
+      ASSERT_LT(std::chrono::steady_clock::now(), deadline)
+          << "timed out waiting for " << depth << " queued "
+          << fuseRequestClassName(requestClass) << " requests";
+      /* sleep override */
+      std::this_thread::sleep_for(1ms);
+    }
+  }
+
   FakeFuse fuse_;
   EdenStats stats_;
   TestDispatcher* dispatcher_;
@@ -366,3 +392,93 @@ TEST_F(FuseChannelTest, interruptLookups) {
     EXPECT_EQ(requestId, received.header.unique);
   }
 }
+
+TEST_F(FuseChannelTest, metadataRequestsCompleteWhileDataRequestsBlock) {
+  FuseRequestClassThreads requestClassThreads;
+  requestClassThreads.data = 2;
+  auto channel = createChannel(2, requestClassThreads);
+  auto completeFuture = performInit(channel.get());
+  SCOPE_EXIT {
+    dispatcher_->unblockReads();
+  };
+
+  // Block every data worker thread, and queue one more READ behind them.
+  fuse_read_in readArg = {};
+  readArg.size = 4096;
+  std::set<uint64_t> readIds;
+  for (size_t i = 0; i < requestClassThreads.data + 1; ++i) {
+    readIds.insert(fuse_.sendRequest(FUSE_READ, FUSE_ROOT_ID, readArg));
+  }
+  dispatcher_->waitForBlockedReads(requestClassThreads.data);
+  waitForQueueDepth(channel.get(), FuseRequestClass::Data, 1);
+
+  auto getattrId =
+      fuse_.sendRequest(FUSE_GETATTR, FUSE_ROOT_ID, fuse_getattr_in{});
+  auto lookupId = fuse_.sendLookup(FUSE_ROOT_ID, "foo");
+  auto lookup = dispatcher_->waitForLookup(lookupId);
+  lookup.promise.setValue(genRandomLookupResponse(9));
+
+  std::set<uint64_t> metadataIds;
+  for (size_t i = 0; i < 2; ++i) {
+    auto response = fuse_.recvResponse();
+    EXPECT_EQ(0, response.header.error);
+    metadataIds.insert(response.header.unique);
+  }
+  EXPECT_EQ((std::set<uint64_t>{getattrId, lookupId}), metadataIds);
+  EXPECT_EQ(0, channel->getRequestQueueDepth(FuseRequestClass::Metadata));
+  EXPECT_EQ(1, channel->getRequestQueueDepth(FuseRequestClass::Data));
+
+  dispatcher_->unblockReads();
+  std::set<uint64_t> completedReadIds;
+  for (size_t i = 0; i < readIds.size(); ++i) {
+    auto response = fuse_.recvResponse();
+    EXPECT_EQ(0, response.header.error);
+    completedReadIds.insert(response.header.unique);
+  }
+  EXPECT_EQ(readIds, completedReadIds);
+  EXPECT_EQ(0, channel->getRequestQueueDepth(FuseRequestClass::Data));
+}
+
+TEST_F(FuseChannelTest, requestTimeoutIncludesTimeQueued) {
+  FuseRequestClassThreads requestClassThreads;
+  requestClassThreads.data = 1;
+  auto channel = createChannel(2, requestClassThreads, 100ms);
+  auto completeFuture = performInit(channel.get());
+  SCOPE_EXIT {
+    dispatcher_->unblockReads();
+  };
+
+  fuse_read_in readArg = {};
+  readArg.size = 4096;
+  auto blockedId = fuse_.sendRequest(FUSE_READ, FUSE_ROOT_ID, readArg);
+  auto queuedId = fuse_.sendRequest(FUSE_READ, FUSE_ROOT_ID, readArg);
+  dispatcher_->waitForBlockedReads(1);
+  waitForQueueDepth(channel.get(), FuseRequestClass::Data, 1);
+
+  // Keep the second READ queued for longer than the request timeout.
+  /* sleep override */
+  std::this_thread::sleep_for(200ms);
+  dispatcher_->unblockReads();
+
+  auto response = fuse_.recvResponse();
+  EXPECT_EQ(blockedId, response.header.unique);
+  EXPECT_EQ(0, response.header.error);
+  response = fuse_.recvResponse();
+  EXPECT_EQ(queuedId, response.header.unique);
+  EXPECT_EQ(-ETIMEDOUT, response.header.error);
+  EXPECT_EQ(1, dispatcher_->getReadCount());
+}
+
+TEST(FuseRequestClassTest, opcodesAreClassified) {
+  EXPECT_EQ(FuseRequestClass::Metadata, fuseOpcodeRequestClass(FUSE_LOOKUP));
+  EXPECT_EQ(FuseRequestClass::Metadata, fuseOpcodeRequestClass(FUSE_GETATTR));
+  EXPECT_EQ(FuseRequestClass::Metadata, fuseOpcodeRequestClass(FUSE_OPENDIR));
+  EXPECT_EQ(FuseRequestClass::Data, fuseOpcodeRequestClass(FUSE_READ));
+  EXPECT_EQ(FuseRequestClass::Data, fuseOpcodeRequestClass(FUSE_READDIR));
+  EXPECT_EQ(FuseRequestClass::Data, fuseOpcodeRequestClass(FUSE_WRITE));
+  EXPECT_EQ(FuseRequestClass::Mutation, fuseOpcodeRequestClass(FUSE_SETATTR));
+  EXPECT_EQ(FuseRequestClass::Mutation, fuseOpcodeRequestClass(FUSE_RENAME));
+  EXPECT_EQ(FuseRequestClass::Forget, fuseOpcodeRequestClass(FUSE_FORGET));
+  EXPECT_EQ(
+      FuseRequestClass::Forget, fuseOpcodeRequestClass(FUSE_BATCH_FORGET));
+}
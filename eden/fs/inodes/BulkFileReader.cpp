@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/BulkFileReader.h"
+
+#include <folly/io/IOBuf.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/InodeError.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/BlobAccess.h"
+#include "eden/fs/store/ObjectStore.h"
+
+using folly::Future;
+using folly::IOBuf;
+using folly::makeFuture;
+using folly::Try;
+using folly::Unit;
+
+namespace facebook {
+namespace eden {
+
+namespace {
+std::system_error pathError(int errnum, RelativePathPiece path) {
+  return std::system_error(
+      errnum, std::generic_category(), path.stringPiece().str());
+}
+} // namespace
+
+BulkFileReader::BulkFileReader(
+    std::shared_ptr<EdenMount> mount,
+    std::vector<RelativePath> paths,
+    std::optional<Hash> commit,
+    ObjectFetchContext& context,
+    size_t maxReadAhead)
+    : mount_{std::move(mount)},
+      paths_{std::move(paths)},
+      commit_{std::move(commit)},
+      context_{context},
+      maxReadAhead_{std::max<size_t>(maxReadAhead, 1)} {
+  components_.reserve(paths_.size());
+  for (const auto& path : paths_) {
+    auto& components = components_.emplace_back();
+    for (auto component : path.components()) {
+      components.push_back(component);
+    }
+  }
+}
+
+Future<std::optional<BulkFileReader::File>> BulkFileReader::next() {
+  if (!files_) {
+    return prepare().thenValue(
+        [self = shared_from_this()](Unit) { return self->next(); });
+  }
+
+  // Keep reading ahead of the file returned, but no further than
+  // maxReadAhead_: contents are only consumed as fast as the caller asks for
+  // them, and each read holds the contents of a file until then.
+  while (inFlight_.size() < maxReadAhead_ && nextToRead_ < files_->size()) {
+    inFlight_.push_back(startRead(nextToRead_++));
+  }
+  if (inFlight_.empty()) {
+    return makeFuture(std::optional<File>{});
+  }
+
+  auto read = std::move(inFlight_.front());
+  inFlight_.pop_front();
+  return std::move(read).thenValue(
+      [](File&& file) { return std::optional<File>{std::move(file)}; });
+}
+
+Future<Unit> BulkFileReader::stop() {
+  if (files_) {
+    nextToRead_ = files_->size();
+  } else {
+    files_.emplace();
+  }
+  std::vector<Future<File>> reads;
+  reads.reserve(inFlight_.size());
+  for (auto& read : inFlight_) {
+    reads.push_back(std::move(read));
+  }
+  inFlight_.clear();
+  return folly::collectAllUnsafe(std::move(reads)).unit();
+}
+
+Future<Unit> BulkFileReader::prepare() {
+  return resolveAll().thenValue([self = shared_from_this()](
+                                    std::vector<Try<ResolvedFile>>&& files) {
+    // Import all the blobs that are missing locally at once, rather than one
+    // by one as each file is read.
+    std::vector<Hash> blobHashes;
+    for (const auto& file : files) {
+      if (file.hasValue() && !file->inode) {
+        blobHashes.push_back(file->blobHash);
+      }
+    }
+    self->files_ = std::move(files);
+    if (blobHashes.empty()) {
+      return makeFuture();
+    }
+    return self->mount_->getObjectStore()
+        ->prefetchBlobs(blobHashes, self->context_)
+        .thenError([](folly::exception_wrapper&& ew) {
+          // Each file reports its own error when it is read.
+          XLOG(DBG3) << "failed to prefetch blobs: " << ew.what();
+        });
+  });
+}
+
+Future<BulkFileReader::File> BulkFileReader::startRead(size_t index) {
+  // The resolved file isn't needed past this point, which releases its inode
+  // as soon as it is read.
+  auto file = std::move((*files_)[index]);
+  if (file.hasException()) {
+    return File{index, Contents{std::move(file).exception()}};
+  }
+  return folly::makeFutureWith([&] {
+           return readFile(file.value());
+         })
+      .thenTry([index](Contents&& contents) {
+        return File{index, std::move(contents)};
+      });
+}
+
+Future<std::vector<Try<BulkFileReader::ResolvedFile>>>
+BulkFileReader::resolveAll() {
+  if (commit_) {
+    return mount_->getObjectStore()
+        ->getTreeForCommit(*commit_, context_)
+        .thenValue([self = shared_from_this()](
+                       std::shared_ptr<const Tree> rootTree) {
+          std::vector<Future<ResolvedFile>> futures;
+          futures.reserve(self->paths_.size());
+          for (size_t index = 0; index < self->paths_.size(); ++index) {
+            futures.push_back(
+                folly::makeFutureWith([&] {
+                  return self->resolveInTree(rootTree, index, 0);
+                }).thenValue([](Hash blobHash) {
+                  return ResolvedFile{FileInodePtr{}, blobHash};
+                }));
+          }
+          return folly::collectAll(std::move(futures));
+        });
+  }
+
+  auto rootInode = mount_->getRootInode();
+  std::vector<Future<ResolvedFile>> futures;
+  futures.reserve(paths_.size());
+  for (size_t index = 0; index < paths_.size(); ++index) {
+    futures.push_back(folly::makeFutureWith(
+        [&] { return resolveInInode(rootInode, index, 0); }));
+  }
+  return folly::collectAll(std::move(futures));
+}
+
+Future<BulkFileReader::ResolvedFile> BulkFileReader::resolveInInode(
+    TreeInodePtr tree,
+    size_t pathIndex,
+    size_t depth) {
+  const auto& components = components_[pathIndex];
+  if (depth == components.size()) {
+    return makeFuture<ResolvedFile>(pathError(EISDIR, paths_[pathIndex]));
+  }
+  auto name = components[depth];
+  bool isLast = depth + 1 == components.size();
+
+  InodePtr child;
+  std::optional<Hash> hash;
+  {
+    auto contents = tree->getContents().rlock();
+    if (contents->treeHash) {
+      // The whole subtree is identical to source control, so the rest of the
+      // path can be resolved without loading any inode.
+      auto treeHash = *contents->treeHash;
+      contents.unlock();
+      return mount_->getObjectStore()
+          ->getTree(treeHash, context_)
+          .thenValue([self = shared_from_this(), pathIndex, depth](
+                         std::shared_ptr<const Tree> scmTree) {
+            return self->resolveInTree(std::move(scmTree), pathIndex, depth);
+          })
+          .thenValue([](Hash blobHash) {
+            return ResolvedFile{FileInodePtr{}, blobHash};
+          });
+    }
+
+    auto it = contents->entries.find(name);
+    if (it == contents->entries.end()) {
+      return makeFuture<ResolvedFile>(InodeError(ENOENT, tree, name));
+    }
+    const auto& entry = it->second;
+    child = entry.getInodePtr();
+    if (!child && !entry.isMaterialized()) {
+      if (isLast && entry.isDirectory()) {
+        return makeFuture<ResolvedFile>(InodeError(EISDIR, tree, name));
+      }
+      if (!isLast && !entry.isDirectory()) {
+        return makeFuture<ResolvedFile>(InodeError(ENOTDIR, tree, name));
+      }
+      hash = entry.getHash();
+    }
+  }
+
+  if (child) {
+    return resolveLoadedChild(std::move(child), pathIndex, depth);
+  }
+
+  if (!hash) {
+    // The child was modified, and its contents are in the overlay, which is
+    // only accessed through inodes.
+    return tree->getOrLoadChild(name, context_)
+        .thenValue([self = shared_from_this(), pathIndex, depth](
+                       InodePtr loaded) {
+          return self->resolveLoadedChild(std::move(loaded), pathIndex, depth);
+        });
+  }
+
+  if (isLast) {
+    return ResolvedFile{FileInodePtr{}, *hash};
+  }
+  return mount_->getObjectStore()
+      ->getTree(*hash, context_)
+      .thenValue([self = shared_from_this(), pathIndex, depth](
+                     std::shared_ptr<const Tree> scmTree) {
+        return self->resolveInTree(std::move(scmTree), pathIndex, depth + 1);
+      })
+      .thenValue([](Hash blobHash) {
+        return ResolvedFile{FileInodePtr{}, blobHash};
+      });
+}
+
+Future<BulkFileReader::ResolvedFile> BulkFileReader::resolveLoadedChild(
+    InodePtr child,
+    size_t pathIndex,
+    size_t depth) {
+  if (depth + 1 == components_[pathIndex].size()) {
+    return ResolvedFile{child.asFilePtr(), Hash{}};
+  }
+  return resolveInInode(child.asTreePtr(), pathIndex, depth + 1);
+}
+
+Future<Hash> BulkFileReader::resolveInTree(
+    std::shared_ptr<const Tree> tree,
+    size_t pathIndex,
+    size_t depth) {
+  const auto& components = components_[pathIndex];
+  if (depth == components.size()) {
+    return makeFuture<Hash>(pathError(EISDIR, paths_[pathIndex]));
+  }
+  const auto* entry = tree->getEntryPtr(components[depth]);
+  if (!entry) {
+    return makeFuture<Hash>(pathError(ENOENT, paths_[pathIndex]));
+  }
+
+  if (depth + 1 == components.size()) {
+    if (entry->isTree()) {
+      return makeFuture<Hash>(pathError(EISDIR, paths_[pathIndex]));
+    }
+    return entry->getHash();
+  }
+  if (!entry->isTree()) {
+    return makeFuture<Hash>(pathError(ENOTDIR, paths_[pathIndex]));
+  }
+  return mount_->getObjectStore()
+      ->getTree(entry->getHash(), context_)
+      .thenValue([self = shared_from_this(), pathIndex, depth](
+                     std::shared_ptr<const Tree> subtree) {
+        return self->resolveInTree(std::move(subtree), pathIndex, depth + 1);
+      });
+}
+
+Future<std::unique_ptr<IOBuf>> BulkFileReader::readFile(
+    const ResolvedFile& file) {
+  if (file.inode) {
+#ifdef _WIN32
+    return file.inode->readAll(context_, CacheHint::NotNeededAgain)
+        .thenValue([](std::string contents) {
+          return IOBuf::fromString(std::move(contents));
+        });
+#else
+    return file.inode->stat(context_).thenValue(
+        [self = shared_from_this(), inode = file.inode](struct stat st) {
+          return self->readInode(inode, nullptr, 0, st.st_size);
+        });
+#endif
+  }
+  // The contents share the blob's buffer, which stays alive as long as they
+  // do.
+  return mount_->getBlobAccess()
+      ->getBlob(
+          file.blobHash, context_, BlobCache::Interest::UnlikelyNeededAgain)
+      .thenValue([](BlobCache::GetResult result) {
+        return std::make_unique<IOBuf>(result.blob->getContents());
+      });
+}
+
+#ifndef _WIN32
+Future<std::unique_ptr<IOBuf>> BulkFileReader::readInode(
+    FileInodePtr inode,
+    std::unique_ptr<IOBuf> contents,
+    size_t offset,
+    size_t size) {
+  if (offset >= size) {
+    return contents ? std::move(contents) : IOBuf::create(0);
+  }
+  // Unlike readAll(), read() shares the blob's buffer when the file isn't
+  // materialized, and reads the overlay straight into the buffer it returns
+  // when it is.
+  return inode->read(size - offset, offset, context_)
+      .thenValue([self = shared_from_this(),
+                  inode,
+                  contents = std::move(contents),
+                  offset,
+                  size](BufVec buf) mutable -> Future<std::unique_ptr<IOBuf>> {
+        auto length = buf->computeChainDataLength();
+        if (length == 0) {
+          // The file was truncated since it was stat()ed.
+          return contents ? std::move(contents) : std::move(buf);
+        }
+        if (contents) {
+          contents->prependChain(std::move(buf));
+        } else {
+          contents = std::move(buf);
+        }
+        return self->readInode(
+            std::move(inode), std::move(contents), offset + length, size);
+      });
+}
+#endif
+
+} // namespace eden
+} // namespace facebook
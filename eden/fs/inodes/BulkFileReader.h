@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Try.h>
+#include <folly/futures/Future.h>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "eden/fs/inodes/InodePtr.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace folly {
+class IOBuf;
+}
+
+namespace facebook {
+namespace eden {
+
+class EdenMount;
+class ObjectFetchContext;
+class Tree;
+
+/**
+ * Reads the contents of many files of a mount at once, either from its working
+ * copy or from a given commit.
+ *
+ * This is meant for tools that scan large numbers of files, and avoids most of
+ * the per-file costs of reading them through the filesystem:
+ * - paths are resolved without loading inodes wherever the working copy
+ *   matches source control, by walking source control trees instead;
+ * - the blobs that are missing locally are fetched in a single batched import
+ *   before any of them is read;
+ * - contents come straight from the BlobCache, or from the overlay for files
+ *   that were modified;
+ * - only a bounded number of files are read ahead of the one the caller is
+ *   consuming, so memory use doesn't grow with the number of paths.
+ */
+class BulkFileReader : public std::enable_shared_from_this<BulkFileReader> {
+ public:
+  using Contents = folly::Try<std::unique_ptr<folly::IOBuf>>;
+
+  /**
+   * The contents of the file at index in the paths, or the error that
+   * prevented reading it.
+   */
+  struct File {
+    size_t index;
+    Contents contents;
+  };
+
+  /**
+   * How many files are read at once by default.
+   */
+  static constexpr size_t kDefaultMaxReadAhead = 64;
+
+  /**
+   * If commit is set, the files are read from that commit instead of the
+   * working copy. At most maxReadAhead files are read at once.
+   *
+   * The context must remain valid until every file was returned by next(),
+   * or until the Future returned by stop() completes.
+   */
+  BulkFileReader(
+      std::shared_ptr<EdenMount> mount,
+      std::vector<RelativePath> paths,
+      std::optional<Hash> commit,
+      ObjectFetchContext& context,
+      size_t maxReadAhead = kDefaultMaxReadAhead);
+
+  BulkFileReader(const BulkFileReader&) = delete;
+  BulkFileReader& operator=(const BulkFileReader&) = delete;
+
+  /**
+   * Return the next file, in the order of the paths, or std::nullopt once
+   * all of them were returned.
+   *
+   * The first call resolves all the paths and fetches the blobs that are
+   * missing locally. Each call then starts reading the files that follow the
+   * one it returns, up to maxReadAhead of them: nothing more is read until
+   * the caller asks for the next file.
+   *
+   * Calls must not overlap.
+   */
+  FOLLY_NODISCARD folly::Future<std::optional<File>> next();
+
+  /**
+   * Don't read any more files. The returned Future completes once the reads
+   * already started are done, after which the context isn't used anymore.
+   *
+   * Must not be called while a call to next() is pending.
+   */
+  FOLLY_NODISCARD folly::Future<folly::Unit> stop();
+
+ private:
+  /**
+   * A file resolved either to its loaded inode, or to a source control blob
+   * when that is what the file contains.
+   */
+  struct ResolvedFile {
+    FileInodePtr inode;
+    Hash blobHash;
+  };
+
+  /**
+   * Resolve all the paths into files_, and fetch the blobs that are missing
+   * locally.
+   */
+  folly::Future<folly::Unit> prepare();
+
+  folly::Future<File> startRead(size_t index);
+
+  folly::Future<std::vector<folly::Try<ResolvedFile>>> resolveAll();
+
+  folly::Future<ResolvedFile>
+  resolveInInode(TreeInodePtr tree, size_t pathIndex, size_t depth);
+
+  folly::Future<ResolvedFile>
+  resolveLoadedChild(InodePtr child, size_t pathIndex, size_t depth);
+
+  folly::Future<Hash> resolveInTree(
+      std::shared_ptr<const Tree> tree,
+      size_t pathIndex,
+      size_t depth);
+
+  folly::Future<std::unique_ptr<folly::IOBuf>> readFile(
+      const ResolvedFile& file);
+
+#ifndef _WIN32
+  /**
+   * Append the bytes of inode in [offset, size) to contents.
+   */
+  folly::Future<std::unique_ptr<folly::IOBuf>> readInode(
+      FileInodePtr inode,
+      std::unique_ptr<folly::IOBuf> contents,
+      size_t offset,
+      size_t size);
+#endif
+
+  const std::shared_ptr<EdenMount> mount_;
+  const std::vector<RelativePath> paths_;
+
+  /**
+   * The components of each path of paths_.
+   */
+  std::vector<std::vector<PathComponentPiece>> components_;
+
+  const std::optional<Hash> commit_;
+  ObjectFetchContext& context_;
+  const size_t maxReadAhead_;
+
+  /**
+   * Set once prepare() completes. Each file is moved out when it is read.
+   */
+  std::optional<std::vector<folly::Try<ResolvedFile>>> files_;
+
+  /**
+   * Index in files_ of the next file to start reading.
+   */
+  size_t nextToRead_{0};
+
+  /**
+   * The reads started and not yet returned by next(), in the order of the
+   * paths.
+   */
+  std::deque<folly::Future<File>> inFlight_;
+};
+
+} // namespace eden
+} // namespace facebook
@@ -9,6 +9,7 @@
 
 #ifndef _WIN32
 #include "eden/fs/inodes/FuseDispatcherImpl.h"
+#include "eden/fs/inodes/NfsDispatcherImpl.h"
 #else
 #include "eden/fs/inodes/PrjfsDispatcherImpl.h"
 #endif
@@ -20,6 +21,11 @@ std::unique_ptr<FuseDispatcher> EdenDispatcherFactory::makeFuseDispatcher(
     EdenMount* mount) {
   return std::make_unique<FuseDispatcherImpl>(mount);
 }
+
+std::unique_ptr<NfsDispatcher> EdenDispatcherFactory::makeNfsDispatcher(
+    EdenMount* mount) {
+  return std::make_unique<NfsDispatcherImpl>(mount);
+}
 #else
 std::unique_ptr<PrjfsDispatcher> EdenDispatcherFactory::makePrjfsDispatcher(
     EdenMount* mount) {
@@ -9,6 +9,7 @@
 
 #ifndef _WIN32
 #include "eden/fs/fuse/FuseDispatcher.h"
+#include "eden/fs/nfs/NfsDispatcher.h"
 #else
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 #endif
@@ -21,6 +22,7 @@ class EdenDispatcherFactory {
  public:
 #ifndef _WIN32
   static std::unique_ptr<FuseDispatcher> makeFuseDispatcher(EdenMount* mount);
+  static std::unique_ptr<NfsDispatcher> makeNfsDispatcher(EdenMount* mount);
 #else
   static std::unique_ptr<PrjfsDispatcher> makePrjfsDispatcher(EdenMount* mount);
 #endif
@@ -7,6 +7,8 @@
 
 #include "eden/fs/inodes/EdenMount.h"
 
+#include <algorithm>
+#include <atomic>
 #include <boost/filesystem.hpp>
 #include <folly/ExceptionWrapper.h>
 #include <folly/FBString.h>
@@ -69,6 +71,22 @@ using std::make_unique;
 using std::shared_ptr;
 
 DEFINE_int32(fuseNumThreads, 16, "how many fuse dispatcher threads to spawn");
+DEFINE_int32(
+    fuseMetadataThreads,
+    4,
+    "how many fuse worker threads to reserve for metadata requests");
+DEFINE_int32(
+    fuseDataThreads,
+    8,
+    "how many fuse worker threads to reserve for read and write requests");
+DEFINE_int32(
+    fuseMutationThreads,
+    2,
+    "how many fuse worker threads to reserve for requests modifying inodes");
+DEFINE_int32(
+    fuseForgetThreads,
+    1,
+    "how many fuse worker threads to reserve for forget requests");
 DEFINE_string(
     edenfsctlPath,
     "edenfsctl",
@@ -206,7 +224,9 @@ EdenMount::EdenMount(
       overlay_{Overlay::create(
           config_->getOverlayPath(),
           config_->getCaseSensitive(),
-          serverState_->getStructuredLogger())},
+          serverState_->getStructuredLogger(),
+          config_->getEphemeralOverlay() ? Overlay::Type::Ephemeral
+                                         : Overlay::Type::Persistent)},
 #ifndef _WIN32
       overlayFileAccess_{overlay_.get()},
 #endif
@@ -236,16 +256,42 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
         // snapshot id forward through subsequent journal entries.
         journal_->recordHashUpdate(parents.parent1());
 
+        // Start fetching the root tree while the overlay is being opened, so
+        // that the two don't add up on the mount's critical path. The tree is
+        // only used if the root directory isn't materialized in the overlay.
+        static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+            "EdenMount::createRootInode");
+        auto rootTree =
+            objectStore_->getTreeForCommit(parents.parent1(), *context);
+
         // Initialize the overlay.
         // This must be performed before we do any operations that may
         // allocate inode numbers, including creating the root TreeInode.
         return overlay_->initialize(std::move(progressCallback))
-            .deferValue([parents](auto&&) { return parents; });
+            .deferValue([this, rootTree = std::move(rootTree)](
+                            auto&&) mutable {
+              return createRootInode(std::move(rootTree));
+            });
       })
-      .thenValue(
-          [this](ParentCommits&& parents) { return createRootInode(parents); })
       .thenValue([this, takeover](TreeInodePtr initTreeNode) {
+#ifndef _WIN32
+        if (serverState_->getReloadableConfig()
+                .getEdenConfig()
+                ->enableNfsServer.getValue() &&
+            getConfig()->getMountProtocol() == MountProtocol::NFS) {
+          inodeMap_->setRememberUnreferencedInodes();
+        }
+#endif
         if (takeover) {
+          // An ephemeral overlay starts out empty, so it would hand out inode
+          // numbers that the kernel still knows as other files. EdenServer
+          // unmounts these mounts rather than handing them over.
+          if (overlay_->getType() == Overlay::Type::Ephemeral) {
+            throw std::domain_error(folly::to<std::string>(
+                "cannot take over ",
+                getPath(),
+                ": mounts with an ephemeral overlay must be remounted"));
+          }
           inodeMap_->initializeFromTakeover(std::move(initTreeNode), *takeover);
         } else {
           inodeMap_->initialize(std::move(initTreeNode));
@@ -267,7 +313,7 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
 }
 
 folly::Future<TreeInodePtr> EdenMount::createRootInode(
-    const ParentCommits& parentCommits) {
+    folly::Future<std::shared_ptr<const Tree>>&& rootTree) {
   // Load the overlay, if present.
   auto rootOverlayDir = overlay_->loadOverlayDir(kRootNodeId);
   if (rootOverlayDir) {
@@ -276,10 +322,8 @@ folly::Future<TreeInodePtr> EdenMount::createRootInode(
         this, std::move(*rootOverlayDir), std::nullopt);
   }
 
-  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
-      "EdenMount::createRootInode");
-  return objectStore_->getTreeForCommit(parentCommits.parent1(), *context)
-      .thenValue([this](std::shared_ptr<const Tree> tree) {
+  return std::move(rootTree).thenValue(
+      [this](std::shared_ptr<const Tree> tree) {
         return TreeInodePtr::makeNew(this, std::move(tree));
       });
 }
@@ -674,6 +718,46 @@ InodeMetadataTable* EdenMount::getInodeMetadataTable() const {
 FuseChannel* EdenMount::getFuseChannel() const {
   return channel_.get();
 }
+
+folly::Future<folly::Unit> EdenMount::storeBlobsInKernelCache(
+    const std::vector<Hash>& blobs) {
+  auto budget = serverState_->getReloadableConfig()
+                    .getEdenConfig()
+                    ->fuseNotifyStoreBudget.getValue();
+  if (budget == 0 || !getFuseChannel() || blobs.empty()) {
+    return folly::unit;
+  }
+
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "EdenMount::storeBlobsInKernelCache");
+  auto remaining = std::make_shared<std::atomic<int64_t>>(budget);
+  std::vector<folly::Future<folly::Unit>> futures;
+  for (auto& file : inodeMap_->getLoadedFileInodes()) {
+    auto hash = file->getBlobHash();
+    if (!hash || !std::binary_search(blobs.begin(), blobs.end(), *hash)) {
+      continue;
+    }
+    // The size comes from the metadata saved by the prefetch, so that blobs
+    // that don't fit in the budget are never loaded.
+    futures.push_back(
+        objectStore_->getBlobSize(*hash, *context)
+            .thenValue([objectStore = objectStore_,
+                        file,
+                        hash = *hash,
+                        remaining](uint64_t blobSize) {
+              auto size = static_cast<int64_t>(blobSize);
+              if (remaining->fetch_sub(size) < size) {
+                return folly::makeFuture();
+              }
+              return objectStore->getBlob(hash, *context)
+                  .thenValue(
+                      [file, hash](std::shared_ptr<const Blob> blob) {
+                        file->storeInKernelCache(hash, *blob);
+                      });
+            }));
+  }
+  return folly::collectAll(futures).unit();
+}
 #else
 PrjfsChannel* EdenMount::getPrjfsChannel() const {
   return channel_.get();
@@ -1081,7 +1165,8 @@ std::unique_ptr<DiffContext> EdenMount::createDiffContext(
       getObjectStore(),
       serverState_->getTopLevelIgnores(),
       std::move(loadContents),
-      request);
+      request,
+      serverState_->getEdenConfig()->maxTraversalTreeFetches.getValue());
 }
 
 Future<Unit> EdenMount::diff(DiffContext* ctxPtr, Hash commitHash) const {
@@ -1274,7 +1359,7 @@ folly::Future<EdenMount::channelType> EdenMount::channelMount(bool readOnly) {
                 return nfsServer->registerMount(
                     mountPath,
                     getRootInode()->getNodeId(),
-                    nullptr, // TODO(xavierd): Add makeNfsDispatcher()
+                    EdenDispatcherFactory::makeNfsDispatcher(this),
                     &getStraceLogger(),
                     serverState_->getProcessNameCache(),
                     std::chrono::duration_cast<folly::Duration>(
@@ -1369,7 +1454,12 @@ void EdenMount::createChannel(EdenMount::channelType channel) {
           serverState_->getReloadableConfig()
               .getEdenConfig()
               ->fuseRequestTimeout.getValue()),
-      serverState_->getNotifications()));
+      serverState_->getNotifications(),
+      FuseRequestClassThreads{
+          folly::to<size_t>(FLAGS_fuseMetadataThreads),
+          folly::to<size_t>(FLAGS_fuseDataThreads),
+          folly::to<size_t>(FLAGS_fuseMutationThreads),
+          folly::to<size_t>(FLAGS_fuseForgetThreads)}));
 #endif
 }
 
@@ -274,6 +274,20 @@ class EdenMount {
   PrjfsChannel* getPrjfsChannel() const;
 #else
   FuseChannel* getFuseChannel() const;
+
+  /**
+   * Push the contents of the given blobs into the kernel's page cache, for
+   * the loaded files that are backed by them, up to fuse:notify-store-budget
+   * bytes. This is meant to be called after prefetching the blobs, so that
+   * reads of the files don't have to go through FUSE.
+   *
+   * This is best-effort, and its fetches aren't attributed to any request, so
+   * callers don't need to wait for the returned future.
+   *
+   * blobs must be sorted.
+   */
+  folly::Future<folly::Unit> storeBlobsInKernelCache(
+      const std::vector<Hash>& blobs);
 #endif
 
   ProcessAccessLog& getProcessAccessLog() const {
@@ -723,8 +737,12 @@ class EdenMount {
   EdenMount(EdenMount const&) = delete;
   EdenMount& operator=(EdenMount const&) = delete;
 
+  /**
+   * Create the root inode from the overlay, or from rootTree if the root
+   * directory is not materialized.
+   */
   folly::Future<TreeInodePtr> createRootInode(
-      const ParentCommits& parentCommits);
+      folly::Future<std::shared_ptr<const Tree>>&& rootTree);
 
   FOLLY_NODISCARD folly::Future<folly::Unit> setupDotEden(TreeInodePtr root);
 
@@ -11,6 +11,7 @@
 #include <folly/io/IOBuf.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/xlog.h>
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/TreeInode.h"
@@ -28,6 +29,7 @@
 #ifndef _WIN32
 #include "eden/fs/inodes/InodeTable.h"
 #include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/store/BlobAccess.h"
 #include "eden/fs/utils/XAttr.h"
 #endif
@@ -54,9 +56,10 @@ namespace eden {
  */
 class FileInode::LockedState {
  public:
-  explicit LockedState(FileInode* inode) : ptr_{inode->state_.wlock()} {}
+  explicit LockedState(FileInode* inode)
+      : inode_{inode}, ptr_{inode->state_.wlock()} {}
   explicit LockedState(const FileInodePtr& inode)
-      : ptr_{inode->state_.wlock()} {}
+      : inode_{inode.get()}, ptr_{inode->state_.wlock()} {}
 
   LockedState(LockedState&&) = default;
   LockedState& operator=(LockedState&&) = default;
@@ -99,6 +102,7 @@ class FileInode::LockedState {
       BlobCache::Interest interest);
 
  private:
+  FileInode* inode_;
   folly::Synchronized<State>::LockedPtr ptr_;
 };
 
@@ -156,6 +160,15 @@ void FileInode::LockedState::setMaterialized() {
 
 #ifndef _WIN32
   ptr_->readByteRanges.clear();
+
+  if (ptr_->storedInKernelCache) {
+    ptr_->storedInKernelCache = false;
+    // Invalidations are sent in order with pushed data, so this drops the
+    // blob's contents from the kernel even if they haven't been sent yet.
+    if (auto* channel = inode_->getMount()->getFuseChannel()) {
+      channel->invalidateInode(inode_->getNodeId(), 0, 0);
+    }
+  }
 #endif
 }
 
@@ -170,7 +183,9 @@ ReturnType FileInode::runWhileDataLoaded(
     BlobCache::Interest interest,
     ObjectFetchContext& fetchContext,
     std::shared_ptr<const Blob> blob,
-    Fn&& fn) {
+    Fn&& fn,
+    off_t off,
+    size_t size) {
   auto future = Future<std::shared_ptr<const Blob>>::makeEmpty();
   switch (state->tag) {
     case State::BLOB_NOT_LOADING:
@@ -193,15 +208,29 @@ ReturnType FileInode::runWhileDataLoaded(
       state.unlock();
       break;
     case State::MATERIALIZED_IN_OVERLAY:
+#ifndef _WIN32
+      // A partially materialized file may still need its base blob.
+      return runWithBaseBlob<ReturnType>(
+          std::move(state),
+          interest,
+          fetchContext,
+          std::move(blob),
+          off,
+          size,
+          std::forward<Fn>(fn));
+#else
       return folly::makeFutureWith(
           [&] { return std::forward<Fn>(fn)(std::move(state), nullptr); });
+#endif
   }
 
   return std::move(future).thenValue(
       [self = inodePtrFromThis(),
        fn = std::forward<Fn>(fn),
        interest,
-       &fetchContext](std::shared_ptr<const Blob> blob) mutable {
+       &fetchContext,
+       off,
+       size](std::shared_ptr<const Blob> blob) mutable {
         // Simply call runWhileDataLoaded() again when we we finish loading the
         // blob data.  The state should be BLOB_NOT_LOADING or
         // MATERIALIZED_IN_OVERLAY this time around.
@@ -215,7 +244,9 @@ ReturnType FileInode::runWhileDataLoaded(
             interest,
             fetchContext,
             std::move(blob),
-            std::forward<Fn>(fn));
+            std::forward<Fn>(fn),
+            off,
+            size);
       });
 }
 
@@ -352,6 +383,183 @@ FileInode::truncateAndRun(LockedState state, Fn&& fn) {
 
   XLOG(FATAL) << "unexpected FileInode state " << state->tag;
 }
+
+template <typename ReturnType, typename Fn>
+ReturnType FileInode::runWithBaseBlob(
+    LockedState state,
+    BlobCache::Interest interest,
+    ObjectFetchContext& fetchContext,
+    std::shared_ptr<const Blob> blob,
+    off_t off,
+    size_t size,
+    Fn&& fn) {
+  XDCHECK_EQ(state->tag, State::MATERIALIZED_IN_OVERLAY);
+  auto baseBlobHash =
+      getOverlayFileAccess(state)->getBaseBlobHash(*this, off, size);
+  if (!baseBlobHash) {
+    return folly::makeFutureWith(
+        [&] { return std::forward<Fn>(fn)(std::move(state), nullptr); });
+  }
+
+  // The caller may have passed in the blob this file was materialized from,
+  // or we may still hold an interest handle for it.
+  if (!blob || blob->getHash() != *baseBlobHash) {
+    blob = state->interestHandle.getBlob();
+  }
+  if (!blob || blob->getHash() != *baseBlobHash) {
+    auto result = getMount()->getBlobCache()->get(*baseBlobHash, interest);
+    blob = std::move(result.blob);
+    if (blob) {
+      state->interestHandle = std::move(result.interestHandle);
+    }
+  }
+  if (blob) {
+    return folly::makeFutureWith([&] {
+      return std::forward<Fn>(fn)(std::move(state), std::move(blob));
+    });
+  }
+
+  // Unlock the state while we wait on the base blob to load.
+  state.unlock();
+  return getMount()
+      ->getBlobAccess()
+      ->getBlob(*baseBlobHash, fetchContext, interest)
+      .thenValue([self = inodePtrFromThis(),
+                  fn = std::forward<Fn>(fn),
+                  interest,
+                  &fetchContext,
+                  off,
+                  size](BlobCache::GetResult result) mutable {
+        // Call runWithBaseBlob() again now that the blob is loaded.  The file
+        // may have been fully materialized in the meantime, in which case the
+        // blob is no longer needed.
+        auto stateLock = LockedState{self};
+        stateLock->interestHandle = std::move(result.interestHandle);
+        return self->runWithBaseBlob<ReturnType>(
+            std::move(stateLock),
+            interest,
+            fetchContext,
+            std::move(result.blob),
+            off,
+            size,
+            std::forward<Fn>(fn));
+      });
+}
+
+template <typename Fn>
+typename folly::futures::detail::callableResult<FileInode::LockedState, Fn>::
+    Return
+    FileInode::runWhileWritable(
+        LockedState state,
+        off_t off,
+        size_t size,
+        std::optional<uint64_t> blobSize,
+        Fn&& fn) {
+  auto config = getMount()->getServerState()->getEdenConfig();
+  switch (state->tag) {
+    case State::BLOB_NOT_LOADING: {
+      auto minSize = config->partialMaterializationMinSize.getValue();
+      if (minSize == 0) {
+        break;
+      }
+
+      if (!blobSize.has_value()) {
+        static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+            "FileInode::runWhileWritable");
+        auto sizeFuture =
+            getObjectStore()->getBlobSize(state->hash.value(), *context);
+        if (!sizeFuture.isReady()) {
+          state.unlock();
+          return std::move(sizeFuture)
+              .thenTry([self = inodePtrFromThis(),
+                        off,
+                        size,
+                        fn = std::forward<Fn>(fn)](
+                           folly::Try<uint64_t> sizeTry) mutable {
+                // If the size is unknown, pass 0 so that the file is fully
+                // materialized, which reports any error loading the blob.
+                return self->runWhileWritable(
+                    LockedState{self},
+                    off,
+                    size,
+                    sizeTry.hasValue() ? sizeTry.value() : 0,
+                    std::forward<Fn>(fn));
+              });
+        }
+        blobSize = sizeFuture.hasValue() ? sizeFuture.value() : 0;
+      }
+
+      // Writes that replace most of the file gain nothing from partial
+      // materialization.
+      auto maxModifiedRatio =
+          config->partialMaterializationMaxModifiedRatio.getValue();
+      if (*blobSize < minSize ||
+          size > maxModifiedRatio * std::max<uint64_t>(*blobSize, off + size)) {
+        break;
+      }
+
+      materializePartially(state, *blobSize);
+      // As in runWhileMaterialized(), call materializeInParent() once the
+      // caller's function has released the state lock.
+      SCOPE_EXIT {
+        XCHECK(state.isNull());
+        materializeInParent();
+      };
+      return folly::makeFutureWith(
+          [&] { return std::forward<Fn>(fn)(LockedState{std::move(state)}); });
+    }
+    case State::BLOB_LOADING:
+      break;
+    case State::MATERIALIZED_IN_OVERLAY:
+      if (getOverlayFileAccess(state)->needsCompleteMaterialization(
+              *this,
+              off,
+              size,
+              config->partialMaterializationMaxModifiedRatio.getValue())) {
+        return runWhileFullyMaterialized(
+            std::move(state), std::forward<Fn>(fn));
+      }
+      return folly::makeFutureWith(
+          [&] { return std::forward<Fn>(fn)(LockedState{std::move(state)}); });
+  }
+
+  return runWhileMaterialized(std::move(state), nullptr, std::forward<Fn>(fn));
+}
+
+template <typename Fn>
+typename folly::futures::detail::callableResult<FileInode::LockedState, Fn>::
+    Return
+    FileInode::runWhileFullyMaterialized(LockedState state, Fn&& fn) {
+  using Return = typename folly::futures::detail::
+      callableResult<FileInode::LockedState, Fn>::Return;
+  return runWhileMaterialized(
+      std::move(state),
+      nullptr,
+      [self = inodePtrFromThis(),
+       fn = std::forward<Fn>(fn)](LockedState&& state) mutable -> Return {
+        if (!self->getOverlayFileAccess(state)->isPartiallyMaterialized(
+                *self)) {
+          return folly::makeFutureWith([&] { return fn(std::move(state)); });
+        }
+
+        static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+            "FileInode::runWhileFullyMaterialized");
+        return self->runWithBaseBlob<Return>(
+            std::move(state),
+            BlobCache::Interest::UnlikelyNeededAgain,
+            *context,
+            nullptr,
+            0,
+            std::numeric_limits<size_t>::max(),
+            [self, fn = std::move(fn)](
+                LockedState&& state,
+                std::shared_ptr<const Blob> baseBlob) mutable {
+              self->getOverlayFileAccess(state)->completeMaterialization(
+                  *self, baseBlob.get());
+              return fn(std::move(state));
+            });
+      });
+}
 #endif // !_WIN32
 
 /*********************************************************************
@@ -478,6 +686,10 @@ folly::Future<FuseDispatcher::Attr> FileInode::setattr(
   auto state = LockedState{this};
   if (truncate) {
     return truncateAndRun(std::move(state), setAttrs);
+  } else if (attr.valid & FATTR_SIZE) {
+    // Partially materialized files cannot change size, so make sure the
+    // file's contents are entirely in the overlay.
+    return runWhileFullyMaterialized(std::move(state), setAttrs);
   } else {
     return runWhileMaterialized(std::move(state), nullptr, setAttrs);
   }
@@ -621,6 +833,22 @@ std::optional<Hash> FileInode::getBlobHash() const {
   return state_.rlock()->hash;
 }
 
+#ifndef _WIN32
+bool FileInode::storeInKernelCache(const Hash& hash, const Blob& blob) {
+  auto* channel = getMount()->getFuseChannel();
+  if (!channel) {
+    return false;
+  }
+  auto state = LockedState{this};
+  if (state->isMaterialized() || state->hash != hash) {
+    return false;
+  }
+  state->storedInKernelCache = true;
+  channel->storeInodeData(getNodeId(), blob.getContents().clone());
+  return true;
+}
+#endif
+
 void FileInode::materializeInParent() {
   auto renameLock = getMount()->acquireRenameLock();
   auto loc = getLocationInfo(renameLock);
@@ -675,7 +903,21 @@ Future<Hash> FileInode::getSha1(ObjectFetchContext& fetchContext) {
       return folly::makeFutureWith(
           [this] { return getFileSha1(getMaterializedFilePath()); });
 #else
-      return getOverlayFileAccess(state)->getSha1(*this);
+      if (auto sha1 = getOverlayFileAccess(state)->getCachedSha1(*this)) {
+        return *sha1;
+      }
+      return runWithBaseBlob<Future<Hash>>(
+          std::move(state),
+          BlobCache::Interest::UnlikelyNeededAgain,
+          fetchContext,
+          nullptr,
+          0,
+          std::numeric_limits<size_t>::max(),
+          [self = inodePtrFromThis()](
+              LockedState&& state, std::shared_ptr<const Blob> baseBlob) {
+            return self->getOverlayFileAccess(state)->getSha1(
+                *self, baseBlob.get());
+          });
 #endif // _WIN32
   }
 
@@ -753,9 +995,8 @@ void FileInode::fsync(bool datasync) {
 }
 
 void FileInode::fallocate(uint64_t offset, uint64_t length) {
-  runWhileMaterialized(
+  runWhileFullyMaterialized(
       LockedState{this},
-      nullptr,
       [offset, length, self = inodePtrFromThis()](LockedState&& state) {
         self->getOverlayFileAccess(state)->fallocate(*self, offset, length);
       });
@@ -792,8 +1033,8 @@ Future<string> FileInode::readAll(
 #ifdef _WIN32
             result = readFile(self->getMaterializedFilePath()).value();
 #else
-            XDCHECK(!blob);
-            result = self->getOverlayFileAccess(state)->readAllContents(*self);
+            result = self->getOverlayFileAccess(state)->readAllContents(
+                *self, blob.get());
 #endif
             break;
           }
@@ -845,9 +1086,11 @@ FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
           self->updateAtimeLocked(*state);
         };
 
-        // Materialized either before or during blob load.
+        // Materialized either before or during blob load.  If the file is
+        // partially materialized, blob is its base blob.
         if (state->tag == State::MATERIALIZED_IN_OVERLAY) {
-          return self->getOverlayFileAccess(state)->read(*self, size, off);
+          return self->getOverlayFileAccess(state)->read(
+              *self, size, off, blob.get());
         }
 
         // runWhileDataLoaded() ensures that the state is either
@@ -878,7 +1121,9 @@ FileInode::read(size_t size, off_t off, ObjectFetchContext& context) {
         cursor.cloneAtMost(result, size);
 
         return BufVec{std::move(result)};
-      });
+      },
+      off,
+      size);
 }
 
 size_t FileInode::writeImpl(
@@ -900,9 +1145,12 @@ size_t FileInode::writeImpl(
 }
 
 folly::Future<size_t> FileInode::write(BufVec&& buf, off_t off) {
-  return runWhileMaterialized(
+  auto size = buf->computeChainDataLength();
+  return runWhileWritable(
       LockedState{this},
-      nullptr,
+      off,
+      size,
+      std::nullopt,
       [buf = std::move(buf), off, self = inodePtrFromThis()](
           LockedState&& state) {
         auto vec = buf->getIov();
@@ -913,17 +1161,29 @@ folly::Future<size_t> FileInode::write(BufVec&& buf, off_t off) {
 folly::Future<size_t> FileInode::write(folly::StringPiece data, off_t off) {
   auto state = LockedState{this};
 
-  // If we are currently materialized we don't need to copy the input data.
-  if (state->tag == State::MATERIALIZED_IN_OVERLAY) {
+  // If we are currently materialized we don't need to copy the input data,
+  // unless a partially materialized file has to be fully materialized first.
+  if (state->tag == State::MATERIALIZED_IN_OVERLAY &&
+      !getOverlayFileAccess(state)->needsCompleteMaterialization(
+          *this,
+          off,
+          data.size(),
+          getMount()
+              ->getServerState()
+              ->getEdenConfig()
+              ->partialMaterializationMaxModifiedRatio.getValue())) {
     struct iovec iov;
     iov.iov_base = const_cast<char*>(data.data());
     iov.iov_len = data.size();
     return writeImpl(state, &iov, 1, off);
   }
 
-  return runWhileMaterialized(
+  auto size = data.size();
+  return runWhileWritable(
       std::move(state),
-      nullptr,
+      off,
+      size,
+      std::nullopt,
       [data = data.str(), off, self = inodePtrFromThis()](
           LockedState&& stateLock) {
         struct iovec iov;
@@ -1035,6 +1295,15 @@ void FileInode::materializeNow(
   state.setMaterialized();
 }
 
+void FileInode::materializePartially(LockedState& state, uint64_t blobSize) {
+  XDCHECK_EQ(state->tag, State::BLOB_NOT_LOADING);
+  XLOG(DBG4) << "partially materializing inode " << getNodeId() << " ("
+             << blobSize << " bytes) from blob " << state->hash.value();
+  getOverlayFileAccess(state)->createPartialFile(
+      getNodeId(), state->hash.value(), blobSize);
+  state.setMaterialized();
+}
+
 void FileInode::materializeAndTruncate(LockedState& state) {
   XCHECK_NE(state->tag, State::MATERIALIZED_IN_OVERLAY);
   getOverlayFileAccess(state)->createEmptyFile(getNodeId());
@@ -10,6 +10,7 @@
 #include <folly/futures/Future.h>
 #include <folly/futures/SharedPromise.h>
 #include <chrono>
+#include <limits>
 #include <optional>
 #include "eden/fs/inodes/CacheHint.h"
 #include "eden/fs/inodes/InodeBase.h"
@@ -48,6 +49,11 @@ class OverlayFileAccess;
  *   - loading: fetching data from backing store, but it's not available yet
  *   - materialized: contents are written into overlay
  *
+ * A materialized file may be partially materialized: its overlay file then
+ * only holds the modified extents, and the rest of its contents is read from
+ * the source control blob it was materialized from (see OverlayFileAccess).
+ * While materialized, interestHandle may refer to that base blob.
+ *
  * Valid state transitions:
  *   - not loading -> loading
  *   - not loading -> materialized (O_TRUNC)
@@ -81,6 +87,16 @@ struct FileInodeState {
 
   Tag tag;
 
+#ifndef _WIN32
+  /**
+   * Set when storeInKernelCache() queued the blob's contents to be pushed
+   * into the kernel's page cache. The push may still be pending when the file
+   * is materialized, so materializing the file then invalidates the kernel's
+   * cached data after it.
+   */
+  bool storedInKernelCache{false};
+#endif
+
   /**
    * Set only in 'not loading' and 'loading' states. std::nullopt otherwise.
    */
@@ -219,6 +235,19 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    */
   std::optional<Hash> getBlobHash() const;
 
+#ifndef _WIN32
+  /**
+   * Push blob into the kernel's page cache for this file, if the file is
+   * still backed by it. Returns true if the data was queued.
+   *
+   * The data is only sent later, from the FUSE invalidation thread, by which
+   * time the file may have been modified. Materializing the file therefore
+   * queues an invalidation of the kernel's cached data, which is sent after
+   * the pushed data and drops it if it is stale.
+   */
+  bool storeInKernelCache(const Hash& hash, const Blob& blob);
+#endif
+
   /**
    * Read the entire file contents, and return them as a string.
    *
@@ -273,6 +302,10 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    *
    * The blob parameter is used when recursing.
    *
+   * If state->tag is MATERIALIZED_IN_OVERLAY and the file is partially
+   * materialized, the second argument is the base blob if it is needed to
+   * read the range [off, off + size), and null otherwise.
+   *
    * Returns a Future with the result of fn(state_.wlock(), blob)
    */
   template <typename ReturnType, typename Fn>
@@ -281,7 +314,9 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
       BlobCache::Interest interest,
       ObjectFetchContext& fetchContext,
       std::shared_ptr<const Blob> blob,
-      Fn&& fn);
+      Fn&& fn,
+      off_t off = 0,
+      size_t size = std::numeric_limits<size_t>::max());
 
 #ifndef _WIN32
   /**
@@ -313,6 +348,57 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
       LockedState state,
       Fn&& fn);
 
+  /**
+   * Run a function with the base blob of a partially materialized file
+   * loaded.
+   *
+   * state->tag must be MATERIALIZED_IN_OVERLAY.  fn(state, blob) is invoked
+   * with the base blob if reading the range [off, off + size) requires it,
+   * and with a null blob otherwise (including when the file is fully
+   * materialized).
+   *
+   * The blob parameter is used when recursing.
+   */
+  template <typename ReturnType, typename Fn>
+  ReturnType runWithBaseBlob(
+      LockedState state,
+      BlobCache::Interest interest,
+      ObjectFetchContext& fetchContext,
+      std::shared_ptr<const Blob> blob,
+      off_t off,
+      size_t size,
+      Fn&& fn);
+
+  /**
+   * Run a function that writes the range [off, off + size) of the file.
+   *
+   * Like runWhileMaterialized(), but large files are partially materialized
+   * instead of having their contents copied into the overlay, and partially
+   * materialized files are fully materialized first if the write would
+   * modify too much of them.
+   *
+   * blobSize is used when recursing.
+   */
+  template <typename Fn>
+  typename folly::futures::detail::callableResult<LockedState, Fn>::Return
+  runWhileWritable(
+      LockedState state,
+      off_t off,
+      size_t size,
+      std::optional<uint64_t> blobSize,
+      Fn&& fn);
+
+  /**
+   * Run a function with the FileInode fully materialized.
+   *
+   * Like runWhileMaterialized(), but partially materialized files are
+   * converted to regular overlay files first.  This is required by
+   * operations that change the size of the file.
+   */
+  template <typename Fn>
+  typename folly::futures::detail::callableResult<LockedState, Fn>::Return
+  runWhileFullyMaterialized(LockedState state, Fn&& fn);
+
 #endif // !_WIN32
 
   /**
@@ -344,6 +430,17 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    */
   void materializeAndTruncate(LockedState& state);
 
+  /**
+   * Materialize the file as a partially materialized file in the overlay
+   * that refers to the current blob, without loading the blob.
+   *
+   * state->tag must be BLOB_NOT_LOADING when this is called.
+   *
+   * After this function returns the caller must call materializeInParent()
+   * after releasing the state lock.
+   */
+  void materializePartially(LockedState& state, uint64_t blobSize);
+
   /**
    * Replace this file's contents in the overlay with an empty file.
    *
@@ -296,7 +296,7 @@ void GlobNode::parse(StringPiece pattern) {
 
 template <typename ROOT>
 Future<vector<GlobNode::GlobResult>> GlobNode::evaluateImpl(
-    const ObjectStore* store,
+    TreeFetchScheduler* fetcher,
     ObjectFetchContext& context,
     RelativePathPiece rootPath,
     ROOT&& root,
@@ -306,7 +306,7 @@ Future<vector<GlobNode::GlobResult>> GlobNode::evaluateImpl(
   vector<std::pair<PathComponentPiece, GlobNode*>> recurse;
   vector<Future<vector<GlobResult>>> futures;
   futures.emplace_back(evaluateRecursiveComponentImpl(
-      store, context, rootPath, root, fileBlobsToPrefetch, originHash));
+      fetcher, context, rootPath, root, fileBlobsToPrefetch, originHash));
 
   auto recurseIfNecessary =
       [&](PathComponentPiece name, GlobNode* node, const auto& entry) {
@@ -317,15 +317,15 @@ Future<vector<GlobNode::GlobResult>> GlobNode::evaluateImpl(
           } else {
             auto candidateName = rootPath + name;
             futures.emplace_back(
-                store->getTree(root.entryHash(entry), context)
+                fetcher->getTree(root.entryHash(entry), context)
                     .thenValue([candidateName,
-                                store,
+                                fetcher,
                                 &context,
                                 innerNode = node,
                                 fileBlobsToPrefetch,
                                 &originHash](std::shared_ptr<const Tree> dir) {
                       return innerNode->evaluateImpl(
-                          store,
+                          fetcher,
                           context,
                           candidateName,
                           TreeRoot(dir),
@@ -384,14 +384,14 @@ Future<vector<GlobNode::GlobResult>> GlobNode::evaluateImpl(
   for (auto& item : recurse) {
     auto candidateName = rootPath + item.first;
     futures.emplace_back(root.getOrLoadChildTree(item.first)
-                             .thenValue([store,
+                             .thenValue([fetcher,
                                          &context,
                                          candidateName,
                                          node = item.second,
                                          fileBlobsToPrefetch,
                                          &originHash](TreeInodePtr dir) {
                                return node->evaluateImpl(
-                                   store,
+                                   fetcher,
                                    context,
                                    candidateName,
                                    TreeInodePtrRoot(dir),
@@ -420,14 +420,14 @@ Future<vector<GlobNode::GlobResult>> GlobNode::evaluateImpl(
 }
 
 Future<vector<GlobNode::GlobResult>> GlobNode::evaluate(
-    const ObjectStore* store,
+    TreeFetchScheduler* fetcher,
     ObjectFetchContext& context,
     RelativePathPiece rootPath,
     TreeInodePtr root,
     GlobNode::PrefetchList fileBlobsToPrefetch,
     const Hash& originHash) {
   return evaluateImpl(
-      store,
+      fetcher,
       context,
       rootPath,
       TreeInodePtrRoot(root),
@@ -436,14 +436,14 @@ Future<vector<GlobNode::GlobResult>> GlobNode::evaluate(
 }
 
 folly::Future<vector<GlobNode::GlobResult>> GlobNode::evaluate(
-    const ObjectStore* store,
+    TreeFetchScheduler* fetcher,
     ObjectFetchContext& context,
     RelativePathPiece rootPath,
     const std::shared_ptr<const Tree>& tree,
     GlobNode::PrefetchList fileBlobsToPrefetch,
     const Hash& originHash) {
   return evaluateImpl(
-      store,
+      fetcher,
       context,
       rootPath,
       TreeRoot(tree),
@@ -491,7 +491,7 @@ GlobNode* GlobNode::lookupToken(
 
 template <typename ROOT>
 Future<vector<GlobNode::GlobResult>> GlobNode::evaluateRecursiveComponentImpl(
-    const ObjectStore* store,
+    TreeFetchScheduler* fetcher,
     ObjectFetchContext& context,
     RelativePathPiece rootPath,
     ROOT&& root,
@@ -529,16 +529,16 @@ Future<vector<GlobNode::GlobResult>> GlobNode::evaluateRecursiveComponentImpl(
           subDirNames.emplace_back(candidateName);
         } else {
           futures.emplace_back(
-              store->getTree(root.entryHash(entry), context)
+              fetcher->getTree(root.entryHash(entry), context)
                   .thenValue(
                       [candidateName,
-                       store,
+                       fetcher,
                        &context,
                        this,
                        fileBlobsToPrefetch,
                        &originHash](const std::shared_ptr<const Tree>& tree) {
                         return evaluateRecursiveComponentImpl(
-                            store,
+                            fetcher,
                             context,
                             candidateName,
                             TreeRoot(tree),
@@ -554,13 +554,13 @@ Future<vector<GlobNode::GlobResult>> GlobNode::evaluateRecursiveComponentImpl(
   for (auto& candidateName : subDirNames) {
     futures.emplace_back(root.getOrLoadChildTree(candidateName.basename())
                              .thenValue([candidateName,
-                                         store,
+                                         fetcher,
                                          &context,
                                          this,
                                          fileBlobsToPrefetch,
                                          &originHash](TreeInodePtr dir) {
                                return evaluateRecursiveComponentImpl(
-                                   store,
+                                   fetcher,
                                    context,
                                    candidateName,
                                    TreeInodePtrRoot(dir),
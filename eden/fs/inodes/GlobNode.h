@@ -13,6 +13,7 @@
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GlobMatcher.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/TreeFetchScheduler.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -87,7 +88,9 @@ class GlobNode {
   // the provided input path and inode.
   // It returns the set of matching file names.
   // Note_0: the caller is responsible for ensuring that this
-  // GlobNode exists until the returned Future is resolved.
+  // GlobNode and the fetcher exist until the returned Future is resolved.
+  // Trees that have no inode are fetched through the fetcher, which bounds
+  // the number of concurrent fetches.
   // Note_1: The caller is also responsible for ensuring the originHash's
   // lifetime exceeds that of all the returned GlobResults. These GlobResults
   // will hold pointers to this originHash.
@@ -96,7 +99,7 @@ class GlobNode {
   // materialization or overlay state for children that already have
   // inodes assigned.
   folly::Future<std::vector<GlobResult>> evaluate(
-      const ObjectStore* store,
+      TreeFetchScheduler* fetcher,
       ObjectFetchContext& context,
       RelativePathPiece rootPath,
       TreeInodePtr root,
@@ -105,7 +108,7 @@ class GlobNode {
 
   // This is the Tree version of the method above
   folly::Future<std::vector<GlobResult>> evaluate(
-      const ObjectStore* store,
+      TreeFetchScheduler* fetcher,
       ObjectFetchContext& context,
       RelativePathPiece rootPath,
       const std::shared_ptr<const Tree>& tree,
@@ -145,7 +148,7 @@ class GlobNode {
   // matched against all the children of the inode.
   template <typename ROOT>
   folly::Future<std::vector<GlobResult>> evaluateRecursiveComponentImpl(
-      const ObjectStore* store,
+      TreeFetchScheduler* fetcher,
       ObjectFetchContext& context,
       RelativePathPiece rootPath,
       ROOT&& root,
@@ -154,7 +157,7 @@ class GlobNode {
 
   template <typename ROOT>
   folly::Future<std::vector<GlobResult>> evaluateImpl(
-      const ObjectStore* store,
+      TreeFetchScheduler* fetcher,
       ObjectFetchContext& context,
       RelativePathPiece rootPath,
       ROOT&& root,
@@ -18,6 +18,7 @@
 #include "eden/fs/inodes/ParentInodeInfo.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/service/ThriftUtil.h"
+#include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/NotImplemented.h"
 
@@ -189,6 +190,18 @@ void InodeMap::initializeFromTakeover(
 }
 
 Future<InodePtr> InodeMap::lookupInode(InodeNumber number) {
+  return lookupInodeImpl(number, std::nullopt);
+}
+
+Future<InodePtr> InodeMap::lookupInodeWithParentHint(
+    InodeNumber number,
+    InodeNumber parentHint) {
+  return lookupInodeImpl(number, parentHint);
+}
+
+Future<InodePtr> InodeMap::lookupInodeImpl(
+    InodeNumber number,
+    std::optional<InodeNumber> parentHint) {
   // Lock the data.
   // We hold it while doing most of our work below, but explicitly unlock it
   // before triggering inode loading or before fulfilling any Promises.
@@ -210,6 +223,34 @@ Future<InodePtr> InodeMap::lookupInode(InodeNumber number) {
   // Look up the data in the unloadedInodes_ map.
   auto unloadedIter = data->unloadedInodes_.find(number);
   if (UNLIKELY(unloadedIter == data->unloadedInodes_.end())) {
+    if (parentHint.has_value()) {
+      // The caller got this inode number from somewhere that doesn't hold an
+      // inode number reference, so it is expected that we may have forgotten
+      // about it.  Look for it in the directory it was last seen in.
+      //
+      // With rememberUnreferencedInodes_ set, every inode that was loaded is
+      // still in unloadedInodes_ unless it was removed, so this only finds
+      // inodes that were never loaded.
+      auto parentNumber = parentHint.value();
+      if (parentNumber == number ||
+          (data->loadedInodes_.count(parentNumber) == 0 &&
+           data->unloadedInodes_.count(parentNumber) == 0)) {
+        return folly::makeFuture<InodePtr>(std::system_error(
+            ESTALE,
+            std::generic_category(),
+            folly::to<std::string>(
+                "unknown inode number ",
+                number,
+                " with unknown parent ",
+                parentNumber)));
+      }
+      data.unlock();
+      return lookupTreeInode(parentNumber)
+          .thenValue([this, number](const TreeInodePtr& parent) {
+            return loadChildByInodeNumber(parent, number);
+          });
+    }
+
     // This generally shouldn't happen.  If a InodeNumber has been allocated we
     // should always know about it.  It's a bug if our caller calls us with an
     // invalid InodeNumber number.
@@ -414,6 +455,34 @@ InodeMap::PromiseVector InodeMap::extractPendingPromises(InodeNumber number) {
   return promises;
 }
 
+Future<InodePtr> InodeMap::loadChildByInodeNumber(
+    const TreeInodePtr& parent,
+    InodeNumber number) {
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "InodeMap::loadChildByInodeNumber");
+  std::optional<PathComponent> childName;
+  {
+    auto contents = parent->getContents().rlock();
+    for (const auto& entry : contents->entries) {
+      if (entry.second.getInodeNumber() == number) {
+        childName = entry.first;
+        break;
+      }
+    }
+  }
+  if (!childName.has_value()) {
+    return folly::makeFuture<InodePtr>(std::system_error(
+        ESTALE,
+        std::generic_category(),
+        folly::to<std::string>(
+            "inode number ",
+            number,
+            " is no longer in ",
+            parent->getLogPath())));
+  }
+  return parent->getOrLoadChild(childName.value(), *context);
+}
+
 Future<TreeInodePtr> InodeMap::lookupTreeInode(InodeNumber number) {
   return lookupInode(number).thenValue(
       [](const InodePtr& inode) { return inode.asTreePtr(); });
@@ -677,6 +746,10 @@ bool InodeMap::isInodeRemembered(InodeNumber ino) const {
   return data_.rlock()->unloadedInodes_.count(ino) > 0;
 }
 
+void InodeMap::setRememberUnreferencedInodes() {
+  data_.wlock()->rememberUnreferencedInodes_ = true;
+}
+
 void InodeMap::onInodeUnreferenced(
     InodeBase* inode,
     ParentInodeInfo&& parentInfo) {
@@ -842,7 +915,7 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     auto& treeContents = asTree->getContents().unsafeGetUnlocked();
 
     // If the fs refcount is non-zero we have to remember this inode.
-    if (fsCount > 0) {
+    if (fsCount > 0 || data->rememberUnreferencedInodes_) {
       XLOG(DBG5) << "unloading tree inode " << inode->getNodeId()
                  << " with Fs refcount=" << fsCount << ": "
                  << inode->getLogPath();
@@ -866,7 +939,7 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     return std::nullopt;
   } else {
     // We have to remember files only if their FS refcount is non-zero
-    if (fsCount > 0) {
+    if (fsCount > 0 || data->rememberUnreferencedInodes_) {
       XLOG(DBG5) << "unloading file inode " << inode->getNodeId()
                  << " with FS refcount=" << fsCount << ": "
                  << inode->getLogPath();
@@ -948,5 +1021,19 @@ std::vector<InodeNumber> InodeMap::getReferencedInodes() const {
 
   return inodes;
 }
+
+std::vector<FileInodePtr> InodeMap::getLoadedFileInodes() const {
+  std::vector<FileInodePtr> files;
+  auto data = data_.rlock();
+  files.reserve(data->numFileInodes_);
+  for (const auto& kv : data->loadedInodes_) {
+    // Avoid taking references on trees: dropping the last one while holding
+    // the data_ lock would deadlock.
+    if (auto* file = dynamic_cast<FileInode*>(kv.second.get())) {
+      files.push_back(FileInodePtr::newPtrLocked(file));
+    }
+  }
+  return files;
+}
 } // namespace eden
 } // namespace facebook
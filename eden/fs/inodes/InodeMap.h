@@ -162,6 +162,27 @@ class InodeMap {
    */
   folly::Future<InodePtr> lookupInode(InodeNumber number);
 
+  /**
+   * Lookup an Inode object by inode number, falling back to searching the
+   * directory parentHint for it if the InodeMap does not know about number.
+   *
+   * lookupInode() requires the inode number refcount to be non-zero, which
+   * NFS clients cannot guarantee: they hold on to file handles without
+   * telling us, and the InodeMap forgets about unreferenced inodes once they
+   * are unloaded or after a graceful restart.  NFS file handles therefore
+   * also carry the inode number of the parent directory, which lets the inode
+   * be reloaded by looking for the child entry with a matching inode number.
+   * With setRememberUnreferencedInodes(), inodes that were loaded are
+   * reloaded from the parent and name they were unloaded with instead, so
+   * this also works after a rename.
+   *
+   * The returned Future fails with ESTALE if number cannot be found either
+   * way, for instance because it was removed.
+   */
+  folly::Future<InodePtr> lookupInodeWithParentHint(
+      InodeNumber number,
+      InodeNumber parentHint);
+
   /**
    * Lookup a TreeInode object by inode number.
    *
@@ -263,6 +284,19 @@ class InodeMap {
    */
   bool isInodeRemembered(InodeNumber ino) const;
 
+  /**
+   * Remember the parent and name of every inode that is unloaded, unless it
+   * was removed, even if its FS refcount is zero.
+   *
+   * NFS clients hold on to inode numbers in their file handles without
+   * referencing them. Remembering the inodes lets lookupInodeWithParentHint()
+   * load them again by walking up from the inode to its first loaded
+   * ancestor, including across a graceful restart, rather than searching for
+   * them. The cost is an unloadedInodes_ entry per inode that was ever loaded
+   * and still exists.
+   */
+  void setRememberUnreferencedInodes();
+
   /**
    * onInodeUnreferenced() will be called when an Inode's InodePtr reference
    * count drops to zero.
@@ -384,6 +418,11 @@ class InodeMap {
    */
   std::vector<InodeNumber> getReferencedInodes() const;
 
+  /**
+   * Return pointers to all the currently loaded FileInodes.
+   */
+  std::vector<FileInodePtr> getLoadedFileInodes() const;
+
  private:
   friend class InodeMapLock;
 
@@ -512,6 +551,12 @@ class InodeMap {
      */
     bool isUnmounted_{false};
 
+    /**
+     * Whether to remember inodes in unloadedInodes_ when they are unloaded
+     * even if their FS refcount is zero, see setRememberUnreferencedInodes().
+     */
+    bool rememberUnreferencedInodes_{false};
+
     /**
      * The number of loaded TreeInode objects
      */
@@ -545,6 +590,13 @@ class InodeMap {
 
   void shutdownComplete(folly::Synchronized<Members>::LockedPtr&& data);
 
+  folly::Future<InodePtr> lookupInodeImpl(
+      InodeNumber number,
+      std::optional<InodeNumber> parentHint);
+  folly::Future<InodePtr> loadChildByInodeNumber(
+      const TreeInodePtr& parent,
+      InodeNumber number);
+
   void setupParentLookupPromise(
       folly::Promise<InodePtr>& promise,
       PathComponentPiece childName,
@@ -96,6 +96,14 @@ class InodeTable {
             detail::InodeTableEntry<OldRecords>...>(path, true)}};
   }
 
+  /**
+   * Create an empty InodeTable in the given file, which must be empty.
+   */
+  static std::unique_ptr<InodeTable> createInFile(folly::File file) {
+    return std::unique_ptr<InodeTable>{new InodeTable{
+        MappedDiskVector<Entry>::createInFile(std::move(file))}};
+  }
+
   /**
    * If no value is stored for this inode, assigns one.  Returns the new value,
    * whether it was set to the default or not.
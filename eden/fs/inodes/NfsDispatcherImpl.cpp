@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/NfsDispatcherImpl.h"
+
+#include <folly/futures/Future.h>
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/nfs/NfsdRpc.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/utils/StatTimes.h"
+#include "eden/fs/utils/SystemError.h"
+
+namespace facebook::eden {
+
+NfsDispatcherImpl::NfsDispatcherImpl(EdenMount* mount)
+    : NfsDispatcher(mount->getStats(), mount->getMountGeneration()),
+      inodeMap_(mount->getInodeMap()) {}
+
+folly::Future<TreeInodePtr> NfsDispatcherImpl::lookupTreeInode(
+    const nfs_fh3& fh) {
+  if (fh.ino.empty()) {
+    return folly::makeFuture<TreeInodePtr>(NfsBadHandleError{});
+  }
+  return inodeMap_->lookupInodeWithParentHint(fh.ino, fh.parent)
+      .thenValue([](const InodePtr& inode) { return inode.asTreePtr(); });
+}
+
+folly::Future<FileInodePtr> NfsDispatcherImpl::lookupFileInode(
+    const nfs_fh3& fh) {
+  if (fh.ino.empty()) {
+    return folly::makeFuture<FileInodePtr>(NfsBadHandleError{});
+  }
+  return inodeMap_->lookupInodeWithParentHint(fh.ino, fh.parent)
+      .thenValue([](const InodePtr& inode) { return inode.asFilePtr(); });
+}
+
+folly::Future<NfsDispatcher::WriteRes>
+NfsDispatcherImpl::write(const nfs_fh3& file, BufVec data, off_t offset) {
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "NfsDispatcherImpl::write");
+  return lookupFileInode(file).thenValue(
+      [data = std::move(data), offset](FileInodePtr inode) mutable {
+        return inode->write(std::move(data), offset)
+            .thenValue([inode](size_t written) {
+              return inode->stat(*context).thenTry(
+                  [written](folly::Try<struct stat> st) {
+                    // The write succeeded even if the attributes can't be
+                    // computed, so don't fail the request in that case.
+                    return WriteRes{
+                        written,
+                        st.hasValue() ? std::make_optional(st.value())
+                                      : std::nullopt};
+                  });
+            });
+      });
+}
+
+namespace {
+/**
+ * The atime and mtime that mark a file created with CreateMode::Exclusive,
+ * as done by the Linux NFS server.
+ */
+fuse_setattr_in exclusiveCreateAttr(uint64_t verifier) {
+  fuse_setattr_in attr = {};
+  attr.valid = FATTR_ATIME | FATTR_MTIME;
+  attr.atime = verifier >> 32;
+  attr.mtime = verifier & 0xffffffff;
+  return attr;
+}
+
+bool hasExclusiveCreateVerifier(const struct stat& st, uint64_t verifier) {
+  auto attr = exclusiveCreateAttr(verifier);
+  return stAtime(st).tv_sec == static_cast<time_t>(attr.atime) &&
+      stAtime(st).tv_nsec == 0 &&
+      stMtime(st).tv_sec == static_cast<time_t>(attr.mtime) &&
+      stMtime(st).tv_nsec == 0;
+}
+
+bool isEexist(const folly::exception_wrapper& ew) {
+  auto* err = ew.get_exception<std::system_error>();
+  return err && isErrnoError(*err) && err->code().value() == EEXIST;
+}
+} // namespace
+
+folly::Future<NfsDispatcher::CreateRes> NfsDispatcherImpl::create(
+    const nfs_fh3& dir,
+    PathComponent name,
+    CreateArgs args) {
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "NfsDispatcherImpl::create");
+  // Force 'mode' to be a regular file, in which case the rdev argument to
+  // mknod is ignored.
+  mode_t mode = S_IFREG | (07777 & args.mode);
+  return lookupTreeInode(dir).thenValue([name = std::move(name), mode, args](
+                                            const TreeInodePtr& inode) {
+    return folly::makeFutureWith([&] {
+             auto child =
+                 inode->mknod(name, mode, 0, InvalidationRequired::No);
+             if (args.how == CreateMode::Exclusive) {
+               return child->setattr(exclusiveCreateAttr(args.verifier))
+                   .thenValue([child](FuseDispatcher::Attr attr) {
+                     return CreateRes{child->getNodeId(), attr.st};
+                   });
+             }
+             return child->stat(*context).thenValue(
+                 [child](struct stat st) -> CreateRes {
+                   return CreateRes{child->getNodeId(), st};
+                 });
+           })
+        .thenError([inode, name, args](folly::exception_wrapper&& ew) {
+          if (args.how == CreateMode::Guarded || !isEexist(ew)) {
+            return folly::makeFuture<CreateRes>(std::move(ew));
+          }
+          return inode->getOrLoadChild(name, *context)
+              .thenValue([args, ew = std::move(ew)](
+                             InodePtr existing) mutable
+                         -> folly::Future<CreateRes> {
+                auto file = existing.asFilePtrOrNull();
+                if (!file) {
+                  return folly::makeFuture<CreateRes>(std::move(ew));
+                }
+                if (args.how == CreateMode::Unchecked && args.truncateTo) {
+                  fuse_setattr_in truncate = {};
+                  truncate.valid = FATTR_SIZE;
+                  truncate.size = *args.truncateTo;
+                  return file->setattr(truncate).thenValue(
+                      [file](FuseDispatcher::Attr attr) {
+                        return CreateRes{file->getNodeId(), attr.st};
+                      });
+                }
+                return file->stat(*context).thenValue(
+                    [file, args, ew = std::move(ew)](
+                        struct stat st) mutable -> folly::Future<CreateRes> {
+                      if (args.how == CreateMode::Exclusive &&
+                          !hasExclusiveCreateVerifier(st, args.verifier)) {
+                        return folly::makeFuture<CreateRes>(std::move(ew));
+                      }
+                      return CreateRes{file->getNodeId(), st};
+                    });
+              });
+        });
+  });
+}
+
+folly::Future<NfsDispatcher::CreateRes> NfsDispatcherImpl::mkdir(
+    const nfs_fh3& dir,
+    PathComponent name,
+    mode_t mode) {
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "NfsDispatcherImpl::mkdir");
+  return lookupTreeInode(dir).thenValue(
+      [name = std::move(name), mode](const TreeInodePtr& inode) {
+        auto child = inode->mkdir(name, mode, InvalidationRequired::No);
+        return child->stat(*context).thenValue(
+            [child](struct stat st) -> CreateRes {
+              return CreateRes{child->getNodeId(), st};
+            });
+      });
+}
+
+namespace {
+/**
+ * Returns the number of child if the operation that removed it left it
+ * without a name.
+ */
+std::optional<InodeNumber> getNumberIfUnlinked(const InodePtr& child) {
+  if (child && child->isUnlinked()) {
+    return child->getNodeId();
+  }
+  return std::nullopt;
+}
+} // namespace
+
+folly::Future<std::optional<InodeNumber>> NfsDispatcherImpl::unlink(
+    const nfs_fh3& dir,
+    PathComponent name) {
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "NfsDispatcherImpl::unlink");
+  return lookupTreeInode(dir).thenValue(
+      [name = std::move(name)](const TreeInodePtr& inode) {
+        // unlink loads the child anyway. Holding it tells which inode was
+        // removed, even if name is replaced concurrently.
+        return inode->getOrLoadChild(name, *context)
+            .thenValue([inode, name](InodePtr child) {
+              return inode->unlink(name, InvalidationRequired::No)
+                  .thenValue([child = std::move(child)](folly::Unit) {
+                    return getNumberIfUnlinked(child);
+                  });
+            });
+      });
+}
+
+folly::Future<std::optional<InodeNumber>> NfsDispatcherImpl::rename(
+    const nfs_fh3& fromDir,
+    PathComponent fromName,
+    const nfs_fh3& toDir,
+    PathComponent toName) {
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "NfsDispatcherImpl::rename");
+  // Start looking up both parents
+  auto fromDirFuture = lookupTreeInode(fromDir);
+  auto toDirFuture = lookupTreeInode(toDir);
+  // Do the rename once we have looked up both parents.
+  return std::move(fromDirFuture)
+      .thenValue([toDirFuture = std::move(toDirFuture),
+                  fromName = std::move(fromName),
+                  toName = std::move(toName)](
+                     const TreeInodePtr& fromDirInode) mutable {
+        return std::move(toDirFuture)
+            .thenValue([fromDirInode, fromName, toName](
+                           const TreeInodePtr& toDirInode) {
+              // Hold the inode being replaced, if any, to tell whether the
+              // rename left it without a name.
+              return toDirInode->getOrLoadChild(toName, *context)
+                  .thenTry([fromDirInode, fromName, toDirInode, toName](
+                               folly::Try<InodePtr> replaced) {
+                    auto child = replaced.hasValue() ? std::move(*replaced)
+                                                     : InodePtr{};
+                    return fromDirInode
+                        ->rename(
+                            fromName,
+                            toDirInode,
+                            toName,
+                            InvalidationRequired::No)
+                        .thenValue([child = std::move(child)](folly::Unit) {
+                          return getNumberIfUnlinked(child);
+                        });
+                  });
+            });
+      });
+}
+
+folly::Future<folly::Unit> NfsDispatcherImpl::commit(
+    const nfs_fh3& file,
+    bool datasync) {
+  return lookupFileInode(file).thenValue(
+      [datasync](FileInodePtr inode) { inode->fsync(datasync); });
+}
+
+} // namespace facebook::eden
+
+#endif
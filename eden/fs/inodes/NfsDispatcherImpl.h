@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/InodePtr.h"
+#include "eden/fs/nfs/NfsDispatcher.h"
+
+namespace facebook::eden {
+
+class EdenMount;
+class InodeMap;
+
+class NfsDispatcherImpl : public NfsDispatcher {
+ public:
+  explicit NfsDispatcherImpl(EdenMount* mount);
+
+  folly::Future<WriteRes> write(const nfs_fh3& file, BufVec data, off_t offset)
+      override;
+
+  folly::Future<CreateRes>
+  create(const nfs_fh3& dir, PathComponent name, CreateArgs args) override;
+
+  folly::Future<CreateRes>
+  mkdir(const nfs_fh3& dir, PathComponent name, mode_t mode) override;
+
+  folly::Future<std::optional<InodeNumber>> unlink(
+      const nfs_fh3& dir,
+      PathComponent name) override;
+
+  folly::Future<std::optional<InodeNumber>> rename(
+      const nfs_fh3& fromDir,
+      PathComponent fromName,
+      const nfs_fh3& toDir,
+      PathComponent toName) override;
+
+  folly::Future<folly::Unit> commit(const nfs_fh3& file, bool datasync)
+      override;
+
+ private:
+  folly::Future<TreeInodePtr> lookupTreeInode(const nfs_fh3& fh);
+  folly::Future<FileInodePtr> lookupFileInode(const nfs_fh3& fh);
+
+  InodeMap* const inodeMap_;
+};
+
+} // namespace facebook::eden
+
+#endif
@@ -44,24 +44,35 @@ using std::optional;
 std::shared_ptr<Overlay> Overlay::create(
     AbsolutePathPiece localDir,
     bool caseSensitive,
-    std::shared_ptr<StructuredLogger> logger) {
+    std::shared_ptr<StructuredLogger> logger,
+    Type type) {
   struct MakeSharedEnabler : public Overlay {
     explicit MakeSharedEnabler(
         AbsolutePathPiece localDir,
         bool caseSensitive,
-        std::shared_ptr<StructuredLogger> logger)
-        : Overlay(localDir, caseSensitive, logger) {}
+        std::shared_ptr<StructuredLogger> logger,
+        Type type)
+        : Overlay(localDir, caseSensitive, logger, type) {}
   };
-  return std::make_shared<MakeSharedEnabler>(localDir, caseSensitive, logger);
+  return std::make_shared<MakeSharedEnabler>(
+      localDir, caseSensitive, logger, type);
 }
 
 Overlay::Overlay(
     AbsolutePathPiece localDir,
     bool caseSensitive,
-    std::shared_ptr<StructuredLogger> logger)
+    std::shared_ptr<StructuredLogger> logger,
+    Type type)
     : backingOverlay_{localDir},
       caseSensitive_{caseSensitive},
-      structuredLogger_{logger} {}
+      type_{type},
+      structuredLogger_{logger} {
+#ifdef _WIN32
+  if (type_ == Type::Ephemeral) {
+    throw std::domain_error("ephemeral overlays are not supported on Windows");
+  }
+#endif // _WIN32
+}
 
 Overlay::~Overlay() {
   close();
@@ -76,6 +87,20 @@ void Overlay::close() {
     gcThread_.join();
   }
 
+#ifndef _WIN32
+  if (type_ == Type::Ephemeral) {
+    if (!ephemeralOverlay_) {
+      return;
+    }
+    // There is nothing to persist: all the data is dropped along with the
+    // EphemeralOverlay.
+    closeAndWaitForOutstandingIO();
+    inodeMetadataTable_.reset();
+    ephemeralOverlay_.reset();
+    return;
+  }
+#endif // !_WIN32
+
   // Make sure everything is shut down in reverse of construction order.
   // Cleanup is not necessary if overlay was not initialized
   if (!backingOverlay_.initialized()) {
@@ -107,6 +132,9 @@ bool Overlay::isClosed() {
 #ifndef _WIN32
 struct statfs Overlay::statFs() {
   IORequest req{this};
+  if (type_ == Type::Ephemeral) {
+    return ephemeralOverlay_->statFs();
+  }
   return backingOverlay_.statFs();
 }
 #endif // !_WIN32
@@ -124,8 +152,9 @@ folly::SemiFuture<Unit> Overlay::initialize(
   gcThread_ = std::thread([this,
                            progressCallback = std::move(progressCallback),
                            promise = std::move(initPromise)]() mutable {
+    bool needsBackgroundCheck;
     try {
-      initOverlay(progressCallback);
+      needsBackgroundCheck = initOverlay(progressCallback);
     } catch (std::exception& ex) {
       XLOG(ERR) << "overlay initialization failed for "
                 << backingOverlay_.getLocalDir() << ": " << ex.what();
@@ -135,19 +164,54 @@ folly::SemiFuture<Unit> Overlay::initialize(
     }
     promise.setValue();
 #ifndef _WIN32
+    if (needsBackgroundCheck) {
+      try {
+        checkOverlay();
+      } catch (std::exception& ex) {
+        XLOG(ERR) << "background scan of overlay "
+                  << backingOverlay_.getLocalDir()
+                  << " failed: " << folly::exceptionStr(ex);
+      }
+    }
+
     // TODO: On Windows files are cached by the ProjectedFS. We need to
     // clean the cached files while doing GC.
 
     gcThread();
+#else
+    (void)needsBackgroundCheck;
 #endif
   });
   return std::move(initFuture);
 }
 
-void Overlay::initOverlay(
+bool Overlay::initOverlay(
     const OverlayChecker::ProgressCallback& progressCallback) {
   IORequest req{this};
+#ifndef _WIN32
+  if (type_ == Type::Ephemeral) {
+    initEphemeralOverlay();
+    return false;
+  }
+#endif // !_WIN32
+  bool needsBackgroundCheck = false;
   auto optNextInodeNumber = backingOverlay_.initOverlay(true);
+#ifndef _WIN32
+  if (!optNextInodeNumber.has_value()) {
+    // All the inode numbers allocated by the previous user are below its
+    // reservation, so we don't need to scan the overlay to pick the next inode
+    // number. Checking it for corruption can then happen without delaying the
+    // mount.
+    optNextInodeNumber = backingOverlay_.getInodeNumberReservation();
+    if (optNextInodeNumber.has_value()) {
+      XLOG(WARN) << "Overlay " << backingOverlay_.getLocalDir()
+                 << " was not shut down cleanly.  Resuming at reserved inode "
+                 << "number " << *optNextInodeNumber
+                 << " and scanning it in the background.";
+      needsBackgroundCheck = true;
+    }
+  }
+#endif // !_WIN32
   if (!optNextInodeNumber.has_value()) {
 #ifndef _WIN32
     // If the next-inode-number data is missing it means that this overlay was
@@ -183,10 +247,14 @@ void Overlay::initOverlay(
     // end up here - it's a bug.
     EDEN_BUG() << "Sqlite Overlay is null value for NextInodeNumber";
 #endif
-  } else {
+  } else if (!needsBackgroundCheck) {
     hadCleanStartup_ = true;
   }
   nextInodeNumber_.store(optNextInodeNumber->get(), std::memory_order_relaxed);
+#ifndef _WIN32
+  // Reserve inode numbers before any can be allocated.
+  backingOverlay_.updateUsedInodeNumber(optNextInodeNumber->get());
+#endif // !_WIN32
 
 #ifndef _WIN32
   // Open after infoFile_'s lock is acquired because the InodeTable acquires
@@ -196,7 +264,51 @@ void Overlay::initOverlay(
                                 PathComponentPiece{FsOverlay::kMetadataFile})
                                    .c_str());
 #endif // !_WIN32
+  return needsBackgroundCheck;
+}
+
+#ifndef _WIN32
+void Overlay::initEphemeralOverlay() {
+  auto ephemeralOverlay =
+      std::make_unique<EphemeralOverlay>(backingOverlay_.getLocalDir());
+  ephemeralOverlay->initialize();
+
+  // Inode metadata is small and frequently accessed, so it always lives in
+  // memory.
+  inodeMetadataTable_ = InodeMetadataTable::createInFile(
+      ephemeralOverlay->createAnonymousFile(0));
+  ephemeralOverlay_ = std::move(ephemeralOverlay);
+
+  nextInodeNumber_.store(kRootNodeId.get() + 1, std::memory_order_relaxed);
+  hadCleanStartup_ = true;
+}
+
+std::optional<overlay::OverlayDir> Overlay::loadOverlayDirData(
+    InodeNumber inodeNumber) {
+  if (type_ == Type::Ephemeral) {
+    return ephemeralOverlay_->loadOverlayDir(inodeNumber);
+  }
+  return backingOverlay_.loadOverlayDir(inodeNumber);
+}
+
+void Overlay::checkOverlay() {
+  // This runs while the overlay is in use, so the checker may see
+  // modifications that are in progress. Only report what it finds, repairs
+  // are left to an offline fsck.
+  IORequest req{this};
+  OverlayChecker checker(
+      &backingOverlay_, backingOverlay_.getInodeNumberReservation());
+  folly::stop_watch<> fsckRuntime;
+  checker.scanForErrors();
+  auto fsckRuntimeInSeconds =
+      std::chrono::duration<double>{fsckRuntime.elapsed()}.count();
+  checker.logErrors();
+  structuredLogger_->logEvent(Fsck{
+      fsckRuntimeInSeconds,
+      checker.getErrors().empty(),
+      false /*attempted_repair*/});
 }
+#endif // !_WIN32
 
 InodeNumber Overlay::allocateInodeNumber() {
   // InodeNumber should generally be 64-bits wide, in which case it isn't even
@@ -213,16 +325,26 @@ InodeNumber Overlay::allocateInodeNumber() {
   // This could be a relaxed atomic operation.  It doesn't matter on x86 but
   // might on ARM.
   auto previous = nextInodeNumber_++;
-#ifdef _WIN32
+#ifndef _WIN32
+  // Ephemeral overlays never outlive the process, so they don't need to
+  // reserve the inode numbers they use.
+  if (type_ == Type::Persistent) {
+    backingOverlay_.updateUsedInodeNumber(previous);
+  }
+#else
   backingOverlay_.updateUsedInodeNumber(previous);
-#endif
+#endif // !_WIN32
   XDCHECK_NE(0u, previous) << "allocateInodeNumber called before initialize";
   return InodeNumber{previous};
 }
 
 optional<DirContents> Overlay::loadOverlayDir(InodeNumber inodeNumber) {
   IORequest req{this};
+#ifndef _WIN32
+  auto dirData = loadOverlayDirData(inodeNumber);
+#else
   auto dirData = backingOverlay_.loadOverlayDir(inodeNumber);
+#endif // !_WIN32
   if (!dirData.has_value()) {
     return std::nullopt;
   }
@@ -304,6 +426,12 @@ void Overlay::saveOverlayDir(InodeNumber inodeNumber, const DirContents& dir) {
         std::make_pair(entName.stringPiece().str(), std::move(oent)));
   }
 
+#ifndef _WIN32
+  if (type_ == Type::Ephemeral) {
+    ephemeralOverlay_->saveOverlayDir(inodeNumber, std::move(odir));
+    return;
+  }
+#endif // !_WIN32
   backingOverlay_.saveOverlayDir(inodeNumber, odir);
 }
 
@@ -313,7 +441,11 @@ void Overlay::removeOverlayData(InodeNumber inodeNumber) {
 #ifndef _WIN32
   // TODO: batch request during GC
   getInodeMetadataTable()->freeInode(inodeNumber);
-  backingOverlay_.removeOverlayFile(inodeNumber);
+  if (type_ == Type::Ephemeral) {
+    ephemeralOverlay_->removeOverlayData(inodeNumber);
+  } else {
+    backingOverlay_.removeOverlayFile(inodeNumber);
+  }
 #else
   backingOverlay_.removeOverlayData(inodeNumber);
 #endif // !_WIN32
@@ -322,7 +454,7 @@ void Overlay::removeOverlayData(InodeNumber inodeNumber) {
 #ifndef _WIN32
 void Overlay::recursivelyRemoveOverlayData(InodeNumber inodeNumber) {
   IORequest req{this};
-  auto dirData = backingOverlay_.loadOverlayDir(inodeNumber);
+  auto dirData = loadOverlayDirData(inodeNumber);
 
   // This inode's data must be removed from the overlay before
   // recursivelyRemoveOverlayData returns to avoid a race condition if
@@ -351,6 +483,11 @@ folly::Future<folly::Unit> Overlay::flushPendingAsync() {
 
 bool Overlay::hasOverlayData(InodeNumber inodeNumber) {
   IORequest req{this};
+#ifndef _WIN32
+  if (type_ == Type::Ephemeral) {
+    return ephemeralOverlay_->hasOverlayData(inodeNumber);
+  }
+#endif // !_WIN32
   return backingOverlay_.hasOverlayData(inodeNumber);
 }
 
@@ -361,12 +498,20 @@ OverlayFile Overlay::openFile(
     InodeNumber inodeNumber,
     folly::StringPiece headerId) {
   IORequest req{this};
+  if (type_ == Type::Ephemeral) {
+    return OverlayFile(
+        ephemeralOverlay_->openFile(inodeNumber, headerId), weak_from_this());
+  }
   return OverlayFile(
       backingOverlay_.openFile(inodeNumber, headerId), weak_from_this());
 }
 
 OverlayFile Overlay::openFileNoVerify(InodeNumber inodeNumber) {
   IORequest req{this};
+  if (type_ == Type::Ephemeral) {
+    return OverlayFile(
+        ephemeralOverlay_->openFileNoVerify(inodeNumber), weak_from_this());
+  }
   return OverlayFile(
       backingOverlay_.openFileNoVerify(inodeNumber), weak_from_this());
 }
@@ -377,6 +522,11 @@ OverlayFile Overlay::createOverlayFile(
   IORequest req{this};
   XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
       << "createOverlayFile called with unallocated inode number";
+  if (type_ == Type::Ephemeral) {
+    return OverlayFile(
+        ephemeralOverlay_->createOverlayFile(inodeNumber, contents),
+        weak_from_this());
+  }
   return OverlayFile(
       backingOverlay_.createOverlayFile(inodeNumber, contents),
       weak_from_this());
@@ -388,11 +538,34 @@ OverlayFile Overlay::createOverlayFile(
   IORequest req{this};
   XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
       << "createOverlayFile called with unallocated inode number";
+  if (type_ == Type::Ephemeral) {
+    return OverlayFile(
+        ephemeralOverlay_->createOverlayFile(inodeNumber, contents),
+        weak_from_this());
+  }
   return OverlayFile(
       backingOverlay_.createOverlayFile(inodeNumber, contents),
       weak_from_this());
 }
 
+OverlayFile Overlay::createPartialOverlayFile(
+    InodeNumber inodeNumber,
+    const Hash& baseBlobHash,
+    uint64_t size) {
+  IORequest req{this};
+  XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
+      << "createPartialOverlayFile called with unallocated inode number";
+  if (type_ == Type::Ephemeral) {
+    return OverlayFile(
+        ephemeralOverlay_->createPartialOverlayFile(
+            inodeNumber, baseBlobHash, size),
+        weak_from_this());
+  }
+  return OverlayFile(
+      backingOverlay_.createPartialOverlayFile(inodeNumber, baseBlobHash, size),
+      weak_from_this());
+}
+
 #endif // !_WIN32
 
 InodeNumber Overlay::getMaxInodeNumber() {
@@ -530,7 +703,7 @@ void Overlay::handleGCRequest(GCRequest& request) {
 
     overlay::OverlayDir dir;
     try {
-      auto dirData = backingOverlay_.loadOverlayDir(ino);
+      auto dirData = loadOverlayDirData(ino);
       if (!dirData.has_value()) {
         XLOG(DBG7) << "no dir data for inode " << ino;
         continue;
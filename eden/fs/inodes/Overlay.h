@@ -25,6 +25,7 @@
 #include "eden/fs/utils/PathFuncs.h"
 
 #ifndef _WIN32
+#include "eden/fs/inodes/overlay/EphemeralOverlay.h"
 #include "eden/fs/inodes/overlay/FsOverlay.h"
 #endif
 
@@ -67,6 +68,20 @@ class OverlayFile;
  */
 class Overlay : public std::enable_shared_from_this<Overlay> {
  public:
+  enum class Type {
+    /**
+     * Store the overlay on disk, so that it survives restarts of EdenFS.
+     */
+    Persistent,
+    /**
+     * Keep the overlay in memory, spilling large files to unlinked files in
+     * the overlay directory. Its contents are lost when the mount is
+     * unmounted, which makes it only suitable for throwaway checkouts.
+     * Not supported on Windows.
+     */
+    Ephemeral,
+  };
+
   /**
    * Create a new Overlay object.
    *
@@ -76,7 +91,8 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
   static std::shared_ptr<Overlay> create(
       AbsolutePathPiece localDir,
       bool caseSensitive,
-      std::shared_ptr<StructuredLogger> logger);
+      std::shared_ptr<StructuredLogger> logger,
+      Type type = Type::Persistent);
 
   ~Overlay();
 
@@ -132,6 +148,10 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
     return hadCleanStartup_;
   }
 
+  Type getType() const {
+    return type_;
+  }
+
   /**
    * Get the maximum inode number that has ever been allocated to an inode.
    */
@@ -213,6 +233,15 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents);
 
+  /**
+   * Helper function that creates an overlay file for a FileInode whose
+   * contents are still backed by the given blob.
+   */
+  OverlayFile createPartialOverlayFile(
+      InodeNumber inodeNumber,
+      const Hash& baseBlobHash,
+      uint64_t size);
+
   /**
    * call statfs(2) on the filesystem in which the overlay is located
    */
@@ -222,7 +251,8 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
   explicit Overlay(
       AbsolutePathPiece localDir,
       bool caseSensitive,
-      std::shared_ptr<StructuredLogger> logger);
+      std::shared_ptr<StructuredLogger> logger,
+      Type type);
 
   /**
    * A request for the background GC thread.  There are two types of requests:
@@ -250,8 +280,32 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
     std::vector<GCRequest> queue;
   };
 
-  void initOverlay(
+  /**
+   * Open the overlay and compute the next inode number. Returns true if the
+   * overlay was not shut down cleanly but a scan of it was not required to
+   * start using it, in which case checkOverlay() should be called.
+   */
+  bool initOverlay(
       const OverlayChecker::ProgressCallback& progressCallback = [](auto) {});
+#ifndef _WIN32
+  /**
+   * Scan the overlay for errors and report them, without repairing them.
+   */
+  void checkOverlay();
+
+  /**
+   * Initialize an ephemeral overlay, which starts out empty and therefore
+   * never needs to be checked.
+   */
+  void initEphemeralOverlay();
+
+  /**
+   * Load the serialized directory from whichever of backingOverlay_ and
+   * ephemeralOverlay_ is in use.
+   */
+  std::optional<overlay::OverlayDir> loadOverlayDirData(
+      InodeNumber inodeNumber);
+#endif // !_WIN32
   void gcThread() noexcept;
   void handleGCRequest(GCRequest& request);
 
@@ -280,6 +334,12 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    * should be released first during shutdown.
    */
   std::unique_ptr<InodeMetadataTable> inodeMetadataTable_;
+
+  /**
+   * Set iff type_ is Type::Ephemeral and the overlay is initialized, in which
+   * case it is used instead of backingOverlay_.
+   */
+  std::unique_ptr<EphemeralOverlay> ephemeralOverlay_;
 #endif // !_WIN32
 
   /**
@@ -304,6 +364,7 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
 
   folly::Baton<> lastOutstandingRequestIsComplete_;
   bool caseSensitive_;
+  const Type type_;
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
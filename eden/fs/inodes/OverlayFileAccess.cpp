@@ -11,6 +11,7 @@
 
 #include <folly/Expected.h>
 #include <folly/Range.h>
+#include <folly/io/Cursor.h>
 #include <folly/logging/xlog.h>
 #include <gflags/gflags.h>
 #include <openssl/sha.h>
@@ -36,6 +37,14 @@ namespace eden {
 
 DEFINE_uint64(overlayFileCacheSize, 100, "");
 
+namespace {
+/**
+ * The amount of data to read at a time when hashing a partially materialized
+ * file.
+ */
+constexpr size_t kPartialFileHashChunkSize = 64 * 1024;
+} // namespace
+
 void OverlayFileAccess::Entry::Info::invalidateMetadata() {
   ++version;
   size = std::nullopt;
@@ -74,6 +83,107 @@ void OverlayFileAccess::createFile(
       ino, std::make_shared<Entry>(std::move(file), blob.getSize(), sha1));
 }
 
+void OverlayFileAccess::createPartialFile(
+    InodeNumber ino,
+    const Hash& baseBlobHash,
+    uint64_t size) {
+  auto file = overlay_->createPartialOverlayFile(ino, baseBlobHash, size);
+  FsOverlay::PartialFileInfo partial;
+  partial.baseBlobHash = baseBlobHash;
+  partial.size = size;
+  auto state = state_.wlock();
+  XCHECK(!state->entries.exists(ino))
+      << "Cannot create overlay file " << ino << " when it's already open!";
+  state->entries.set(
+      ino,
+      std::make_shared<Entry>(
+          std::move(file), std::nullopt, std::nullopt, std::move(partial)));
+}
+
+bool OverlayFileAccess::isPartiallyMaterialized(FileInode& inode) {
+  auto entry = getEntryForInode(inode.getNodeId());
+  return entry->info.rlock()->partial.has_value();
+}
+
+std::optional<Hash>
+OverlayFileAccess::getBaseBlobHash(FileInode& inode, off_t off, size_t size) {
+  auto entry = getEntryForInode(inode.getNodeId());
+  auto info = entry->info.rlock();
+  if (!info->partial) {
+    return std::nullopt;
+  }
+
+  const auto& partial = *info->partial;
+  uint64_t begin = static_cast<uint64_t>(off);
+  if (begin >= partial.size) {
+    return std::nullopt;
+  }
+  uint64_t end = partial.size - begin < size ? partial.size : begin + size;
+  if (partial.extents.covers(begin, end)) {
+    return std::nullopt;
+  }
+  return partial.baseBlobHash;
+}
+
+bool OverlayFileAccess::needsCompleteMaterialization(
+    FileInode& inode,
+    off_t off,
+    size_t size,
+    double maxModifiedRatio) {
+  auto entry = getEntryForInode(inode.getNodeId());
+  auto info = entry->info.rlock();
+  if (!info->partial) {
+    return false;
+  }
+
+  auto extents = info->partial->extents;
+  extents.add(off, off + size);
+  if (extents.getIntervalCount() > FsOverlay::kPartialFileMaxExtents) {
+    return true;
+  }
+  auto newSize = std::max<uint64_t>(info->partial->size, off + size);
+  return extents.getCoveredSize() > maxModifiedRatio * newSize;
+}
+
+void OverlayFileAccess::completeMaterialization(
+    FileInode& inode,
+    const Blob* baseBlob) {
+  auto ino = inode.getNodeId();
+  auto entry = getEntryForInode(ino);
+  std::optional<FsOverlay::PartialFileInfo> partial;
+  {
+    auto info = entry->info.rlock();
+    if (!info->partial) {
+      return;
+    }
+    partial = info->partial;
+  }
+
+  // The caller holds the FileInode's state lock, so the file cannot be
+  // modified while we assemble its full contents.
+  auto contents = folly::IOBuf::create(partial->size);
+  readPartial(
+      inode,
+      *entry,
+      *partial,
+      baseBlob,
+      contents->writableData(),
+      partial->size,
+      0);
+  contents->append(partial->size);
+
+  // createOverlayFile() atomically replaces the partially materialized file.
+  auto file = overlay_->createOverlayFile(ino, *contents);
+  XLOG(DBG3) << "completed materialization of inode " << ino << " ("
+             << partial->size << " bytes, "
+             << partial->extents.getCoveredSize() << " modified)";
+
+  auto state = state_.wlock();
+  state->entries.set(
+      ino,
+      std::make_shared<Entry>(std::move(file), partial->size, std::nullopt));
+}
+
 off_t OverlayFileAccess::getFileSize(FileInode& inode) {
   return getFileSize(inode.getNodeId(), &inode);
 }
@@ -83,6 +193,9 @@ off_t OverlayFileAccess::getFileSize(InodeNumber ino, InodeBase* inode) {
   uint64_t version;
   {
     auto info = entry->info.rlock();
+    if (info->partial) {
+      return info->partial->size;
+    }
     if (info->size.has_value()) {
       return *info->size;
     }
@@ -121,15 +234,17 @@ off_t OverlayFileAccess::getFileSize(InodeNumber ino, InodeBase* inode) {
   return size;
 }
 
-Hash OverlayFileAccess::getSha1(FileInode& inode) {
+Hash OverlayFileAccess::getSha1(FileInode& inode, const Blob* baseBlob) {
   auto entry = getEntryForInode(inode.getNodeId());
   uint64_t version;
+  std::optional<FsOverlay::PartialFileInfo> partial;
   {
     auto info = entry->info.rlock();
     if (info->sha1.has_value()) {
       return *info->sha1;
     }
     version = info->version;
+    partial = info->partial;
   }
 
   // SHA-1 is not known, so recompute it. Do so while the lock is not held to
@@ -138,27 +253,36 @@ Hash OverlayFileAccess::getSha1(FileInode& inode) {
   SHA_CTX ctx;
   SHA1_Init(&ctx);
 
-  off_t off = FsOverlay::kHeaderLength;
-  while (true) {
-    // Using pread here so that we don't move the file position;
-    // the file descriptor is shared between multiple file handles
-    // and while we serialize the requests to FileData, it seems
-    // like a good property of this function to avoid changing that
-    // state.
-    uint8_t buf[8192];
-    auto ret = entry->file.preadNoInt(&buf, sizeof(buf), off);
-    if (ret.hasError()) {
-      throw InodeError(
-          ret.error(),
-          inode.inodePtrFromThis(),
-          "pread failed during SHA-1 calculation");
+  if (partial) {
+    std::vector<uint8_t> buf(kPartialFileHashChunkSize);
+    for (uint64_t off = 0; off < partial->size; off += buf.size()) {
+      auto len = std::min<uint64_t>(buf.size(), partial->size - off);
+      readPartial(inode, *entry, *partial, baseBlob, buf.data(), len, off);
+      SHA1_Update(&ctx, buf.data(), len);
     }
-    auto len = ret.value();
-    if (len == 0) {
-      break;
+  } else {
+    off_t off = FsOverlay::kHeaderLength;
+    while (true) {
+      // Using pread here so that we don't move the file position;
+      // the file descriptor is shared between multiple file handles
+      // and while we serialize the requests to FileData, it seems
+      // like a good property of this function to avoid changing that
+      // state.
+      uint8_t buf[8192];
+      auto ret = entry->file.preadNoInt(&buf, sizeof(buf), off);
+      if (ret.hasError()) {
+        throw InodeError(
+            ret.error(),
+            inode.inodePtrFromThis(),
+            "pread failed during SHA-1 calculation");
+      }
+      auto len = ret.value();
+      if (len == 0) {
+        break;
+      }
+      SHA1_Update(&ctx, buf, len);
+      off += len;
     }
-    SHA1_Update(&ctx, buf, len);
-    off += len;
   }
 
   static_assert(Hash::RAW_SIZE == SHA_DIGEST_LENGTH);
@@ -173,8 +297,29 @@ Hash OverlayFileAccess::getSha1(FileInode& inode) {
   return sha1;
 }
 
-std::string OverlayFileAccess::readAllContents(FileInode& inode) {
+std::optional<Hash> OverlayFileAccess::getCachedSha1(FileInode& inode) {
   auto entry = getEntryForInode(inode.getNodeId());
+  return entry->info.rlock()->sha1;
+}
+
+std::string OverlayFileAccess::readAllContents(
+    FileInode& inode,
+    const Blob* baseBlob) {
+  auto entry = getEntryForInode(inode.getNodeId());
+
+  auto partial = entry->info.rlock()->partial;
+  if (partial) {
+    std::string result(partial->size, '\0');
+    readPartial(
+        inode,
+        *entry,
+        *partial,
+        baseBlob,
+        reinterpret_cast<uint8_t*>(result.data()),
+        result.size(),
+        0);
+    return result;
+  }
 
   // Note that this code requires a write lock on the entry because the lseek()
   // call modifies the file offset of the file descriptor. Otherwise, concurrent
@@ -205,9 +350,27 @@ std::string OverlayFileAccess::readAllContents(FileInode& inode) {
   return result.value();
 }
 
-BufVec OverlayFileAccess::read(FileInode& inode, size_t size, off_t off) {
+BufVec OverlayFileAccess::read(
+    FileInode& inode,
+    size_t size,
+    off_t off,
+    const Blob* baseBlob) {
   auto entry = getEntryForInode(inode.getNodeId());
 
+  auto partial = entry->info.rlock()->partial;
+  if (partial) {
+    uint64_t begin = static_cast<uint64_t>(off);
+    if (begin >= partial->size) {
+      return BufVec{folly::IOBuf::wrapBuffer("", 0)};
+    }
+    auto length = std::min<uint64_t>(size, partial->size - begin);
+    auto buf = folly::IOBuf::createCombined(length);
+    readPartial(
+        inode, *entry, *partial, baseBlob, buf->writableData(), length, begin);
+    buf->append(length);
+    return BufVec{std::move(buf)};
+  }
+
   auto buf = folly::IOBuf::createCombined(size);
   auto res = entry->file.preadNoInt(
       buf->writableBuffer(), size, off + FsOverlay::kHeaderLength);
@@ -229,22 +392,70 @@ size_t OverlayFileAccess::write(
     size_t iovcnt,
     off_t off) {
   auto entry = getEntryForInode(inode.getNodeId());
+  bool isPartial = entry->info.rlock()->partial.has_value();
 
-  auto xfer = entry->file.pwritev(iov, iovcnt, off + FsOverlay::kHeaderLength);
+  auto contentOffset = isPartial ? FsOverlay::kPartialFileContentOffset
+                                 : FsOverlay::kHeaderLength;
+  auto xfer = entry->file.pwritev(iov, iovcnt, off + contentOffset);
   if (xfer.hasError()) {
     throw InodeError(
         xfer.error(),
         inode.inodePtrFromThis(),
         "pwritev failed during file write");
   }
-  auto info = entry->info.wlock();
-  info->invalidateMetadata();
+
+  if (!isPartial) {
+    auto info = entry->info.wlock();
+    info->invalidateMetadata();
+    return xfer.value();
+  }
+
+  // Record the newly written extent in the partial file header.  The data is
+  // written before the extent table so that the table never refers to data
+  // that has not been written.
+  std::string header;
+  {
+    auto info = entry->info.wlock();
+    info->invalidateMetadata();
+    auto& partial = info->partial.value();
+    uint64_t end = off + xfer.value();
+    partial.extents.add(off, end);
+    partial.size = std::max(partial.size, end);
+    header = FsOverlay::serializePartialFileHeader(partial);
+  }
+
+  iovec headerIov;
+  headerIov.iov_base = header.data();
+  headerIov.iov_len = header.size();
+  auto headerXfer = entry->file.pwritev(&headerIov, 1, 0);
+  if (headerXfer.hasError()) {
+    throw InodeError(
+        headerXfer.error(),
+        inode.inodePtrFromThis(),
+        "unable to update partially materialized overlay file header");
+  }
 
   return xfer.value();
 }
 
 void OverlayFileAccess::truncate(FileInode& inode, off_t size) {
-  auto entry = getEntryForInode(inode.getNodeId());
+  auto ino = inode.getNodeId();
+  auto entry = getEntryForInode(ino);
+
+  if (entry->info.rlock()->partial) {
+    if (size != 0) {
+      EDEN_BUG() << "cannot truncate partially materialized inode " << ino
+                 << " to " << size << " bytes";
+    }
+    // Replace the file with an empty, fully materialized one.
+    auto file = overlay_->createOverlayFile(ino, folly::ByteRange{});
+    auto state = state_.wlock();
+    state->entries.set(
+        ino,
+        std::make_shared<Entry>(std::move(file), size_t{0}, kEmptySha1));
+    return;
+  }
+
   auto result = entry->file.ftruncate(size + FsOverlay::kHeaderLength);
   if (result.hasError()) {
     throw InodeError(
@@ -276,6 +487,10 @@ void OverlayFileAccess::fallocate(
     uint64_t offset,
     uint64_t length) {
   auto entry = getEntryForInode(inode.getNodeId());
+  if (entry->info.rlock()->partial) {
+    EDEN_BUG() << "cannot fallocate partially materialized inode "
+               << inode.getNodeId();
+  }
   auto result = entry->file.fallocate(offset, length);
   if (result.hasError()) {
     throw InodeError(
@@ -299,8 +514,10 @@ OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
   // TODO: A possible future optimization here is, if a SHA-1 is known when
   // the blob is evicted, write it into an xattr when the blob is closed. When
   // reopened, if the xattr exists, read it back out (and clear).
+  auto file = overlay_->openFileNoVerify(ino);
+  auto partial = loadPartialFileInfo(file, ino);
   auto entry = std::make_shared<Entry>(
-      overlay_->openFileNoVerify(ino), std::nullopt, std::nullopt);
+      std::move(file), std::nullopt, std::nullopt, std::move(partial));
 
   {
     auto state = state_.wlock();
@@ -310,6 +527,110 @@ OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
   return entry;
 }
 
+std::optional<FsOverlay::PartialFileInfo>
+OverlayFileAccess::loadPartialFileInfo(
+    const OverlayFile& file,
+    InodeNumber ino) {
+  std::array<char, FsOverlay::kHeaderIdentifierPartialFile.size()> id;
+  auto ret = file.preadNoInt(id.data(), id.size(), 0);
+  if (ret.hasError()) {
+    throw InodeError(
+        ret.error(), InodePtr{}, "unable to read overlay file header");
+  }
+  if (static_cast<size_t>(ret.value()) != id.size() ||
+      folly::StringPiece{id.data(), id.size()} !=
+          FsOverlay::kHeaderIdentifierPartialFile) {
+    return std::nullopt;
+  }
+
+  std::string header(FsOverlay::kPartialFileContentOffset, '\0');
+  ret = file.preadNoInt(header.data(), header.size(), 0);
+  if (ret.hasError()) {
+    throw InodeError(
+        ret.error(),
+        InodePtr{},
+        "unable to read partially materialized overlay file header");
+  }
+  header.resize(ret.value());
+  XLOG(DBG4) << "opened partially materialized overlay file for inode "
+             << ino;
+  return FsOverlay::parsePartialFileHeader(ino, folly::StringPiece{header});
+}
+
+void OverlayFileAccess::readPartial(
+    FileInode& inode,
+    const Entry& entry,
+    const FsOverlay::PartialFileInfo& partial,
+    const Blob* baseBlob,
+    uint8_t* buf,
+    size_t size,
+    uint64_t off) {
+  XDCHECK_LE(off + size, partial.size);
+  uint64_t end = off + size;
+
+  // Unmodified bytes come from the base blob, or are zero if the file has
+  // been extended past the end of the blob.
+  auto fillFromBase = [&](uint64_t begin, uint64_t stop) {
+    if (begin >= stop) {
+      return;
+    }
+    if (!baseBlob) {
+      EDEN_BUG() << "base blob " << partial.baseBlobHash
+                 << " is required to read partially materialized inode "
+                 << inode.getNodeId();
+    }
+    uint8_t* dest = buf + (begin - off);
+    uint64_t baseSize = baseBlob->getSize();
+    if (begin < baseSize) {
+      auto copyEnd = std::min(stop, baseSize);
+      folly::io::Cursor cursor(&baseBlob->getContents());
+      cursor.skip(begin);
+      cursor.pull(dest, copyEnd - begin);
+      dest += copyEnd - begin;
+      begin = copyEnd;
+    }
+    memset(dest, 0, stop - begin);
+  };
+
+  uint64_t pos = off;
+  for (const auto& extent : partial.extents.getIntervals()) {
+    if (extent.second <= pos) {
+      continue;
+    }
+    if (extent.first >= end) {
+      break;
+    }
+    uint64_t readBegin = std::max<uint64_t>(pos, extent.first);
+    uint64_t readEnd = std::min<uint64_t>(end, extent.second);
+    fillFromBase(pos, readBegin);
+
+    while (readBegin < readEnd) {
+      auto ret = entry.file.preadNoInt(
+          buf + (readBegin - off),
+          readEnd - readBegin,
+          readBegin + FsOverlay::kPartialFileContentOffset);
+      if (ret.hasError()) {
+        throw InodeError(
+            ret.error(),
+            inode.inodePtrFromThis(),
+            "pread failed during partially materialized file read");
+      }
+      if (ret.value() == 0) {
+        // The extent table claims more data than the file holds, which can
+        // happen if the data never made it to disk before a crash.
+        XLOG(WARN) << "partially materialized overlay file for inode "
+                   << inode.getNodeId() << " is missing data at offset "
+                   << readBegin;
+        memset(buf + (readBegin - off), 0, readEnd - readBegin);
+        break;
+      }
+      readBegin += ret.value();
+    }
+    pos = readEnd;
+  }
+  fillFromBase(pos, end);
+}
+
 } // namespace eden
 } // namespace facebook
 
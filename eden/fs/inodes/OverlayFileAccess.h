@@ -14,6 +14,7 @@
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/OverlayFile.h"
+#include "eden/fs/inodes/overlay/FsOverlay.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/utils/BufVec.h"
 
@@ -28,6 +29,12 @@ class Overlay;
  * Provides a file handle caching layer between FileInode and the Overlay. Read
  * and write operations for different inodes can be interleaved, and the
  * OverlayFileAccess will keep a number of file handles open in LRU.
+ *
+ * Overlay files may be partially materialized: they then only hold the
+ * extents written since materialization, and the rest of their contents comes
+ * from a base source control blob.  Functions that may need to read file
+ * contents accept the base blob as a parameter; callers can use
+ * getBaseBlobHash() to find out whether it is needed.
  */
 class OverlayFileAccess {
  public:
@@ -56,6 +63,56 @@ class OverlayFileAccess {
       const Blob& blob,
       const std::optional<Hash>& sha1);
 
+  /**
+   * Creates a new partially materialized file in the overlay whose contents
+   * are those of the blob with the given hash and size.  The blob contents
+   * are not copied into the overlay.
+   *
+   * The caller must verify the overlay file does not already exist.
+   */
+  void createPartialFile(
+      InodeNumber ino,
+      const Hash& baseBlobHash,
+      uint64_t size);
+
+  /**
+   * Returns true if the overlay file for this inode is partially
+   * materialized.
+   */
+  bool isPartiallyMaterialized(FileInode& inode);
+
+  /**
+   * If reading the range [off, off + size) of this inode requires data from
+   * the base blob of a partially materialized file, return the hash of that
+   * blob.  Returns std::nullopt if the range is entirely stored in the
+   * overlay.
+   */
+  std::optional<Hash>
+  getBaseBlobHash(FileInode& inode, off_t off, size_t size);
+
+  /**
+   * Returns true if writing the range [off, off + size) to a partially
+   * materialized file would leave more than maxModifiedRatio of the file
+   * modified, or would need more extents than a partial file can record.
+   * The caller should call completeMaterialization() before writing.
+   *
+   * Always returns false for files that are fully materialized.
+   */
+  bool needsCompleteMaterialization(
+      FileInode& inode,
+      off_t off,
+      size_t size,
+      double maxModifiedRatio);
+
+  /**
+   * Replace a partially materialized overlay file with a regular overlay file
+   * holding the full contents.  baseBlob must be the file's base blob, unless
+   * getBaseBlobHash() reports that it is not needed.
+   *
+   * Does nothing if the file is already fully materialized.
+   */
+  void completeMaterialization(FileInode& inode, const Blob* baseBlob);
+
   /**
    * Return the size of the overlay file at the given inode number. The result
    * will never be negative.
@@ -69,18 +126,25 @@ class OverlayFileAccess {
   /**
    * Returns the SHA-1 hash of the file contents for the given inode number.
    */
-  Hash getSha1(FileInode& inode);
+  Hash getSha1(FileInode& inode, const Blob* baseBlob = nullptr);
+
+  /**
+   * Returns the SHA-1 hash of the file contents if it is known without
+   * reading the file.
+   */
+  std::optional<Hash> getCachedSha1(FileInode& inode);
 
   /**
    * Reads the entire file's contents into memory and returns it.
    */
-  std::string readAllContents(FileInode& inode);
+  std::string readAllContents(FileInode& inode, const Blob* baseBlob = nullptr);
 
   /**
    * Reads a range from the file. At EOF, may return a BufVec smaller than the
    * requested size.
    */
-  BufVec read(FileInode& inode, size_t size, off_t off);
+  BufVec
+  read(FileInode& inode, size_t size, off_t off, const Blob* baseBlob = nullptr);
 
   /**
    * Writes data into the file at the specified offset. Returns the number of
@@ -91,6 +155,9 @@ class OverlayFileAccess {
 
   /**
    * Sets the size of the file in the overlay.
+   *
+   * Partially materialized files may only be truncated to 0 bytes; callers
+   * must use completeMaterialization() before changing their size otherwise.
    */
   void truncate(FileInode& inode, off_t size = 0);
 
@@ -100,6 +167,7 @@ class OverlayFileAccess {
    */
   void fsync(FileInode& inode, bool datasync);
 
+
   /**
    * Call fallocate(mode=0) or posix_fallocate on the backing overlay storage.
    */
@@ -126,18 +194,32 @@ class OverlayFileAccess {
    */
 
   struct Entry {
-    Entry(OverlayFile f, std::optional<size_t> s, const std::optional<Hash>& h)
-        : file{std::move(f)}, info{folly::in_place, s, h} {}
+    Entry(
+        OverlayFile f,
+        std::optional<size_t> s,
+        const std::optional<Hash>& h,
+        std::optional<FsOverlay::PartialFileInfo> p = std::nullopt)
+        : file{std::move(f)}, info{folly::in_place, s, h, std::move(p)} {}
 
     struct Info {
-      Info(std::optional<size_t> s, const std::optional<Hash>& h)
-          : size{s}, sha1{h} {}
+      Info(
+          std::optional<size_t> s,
+          const std::optional<Hash>& h,
+          std::optional<FsOverlay::PartialFileInfo> p)
+          : size{s}, sha1{h}, partial{std::move(p)} {}
 
       void invalidateMetadata();
 
       std::optional<size_t> size;
       std::optional<Hash> sha1;
       uint64_t version{0};
+
+      /**
+       * Set if the file is partially materialized.  This mirrors the header
+       * and extent table stored in the overlay file, and is never
+       * invalidated.
+       */
+      std::optional<FsOverlay::PartialFileInfo> partial;
     };
 
     const OverlayFile file;
@@ -160,6 +242,28 @@ class OverlayFileAccess {
    */
   EntryPtr getEntryForInode(InodeNumber);
 
+  /**
+   * Read the partial file header of a newly opened overlay file, if it has
+   * one.
+   */
+  static std::optional<FsOverlay::PartialFileInfo> loadPartialFileInfo(
+      const OverlayFile& file,
+      InodeNumber ino);
+
+  /**
+   * Fill buf with size bytes of the contents of a partially materialized
+   * file, starting at off.  Modified extents are read from the overlay file,
+   * and everything else from baseBlob.  The range must lie within the file.
+   */
+  static void readPartial(
+      FileInode& inode,
+      const Entry& entry,
+      const FsOverlay::PartialFileInfo& partial,
+      const Blob* baseBlob,
+      uint8_t* buf,
+      size_t size,
+      uint64_t off);
+
   Overlay* overlay_ = nullptr;
   folly::Synchronized<State> state_;
 };
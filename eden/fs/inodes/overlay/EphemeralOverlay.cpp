@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/overlay/EphemeralOverlay.h"
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <array>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/MapUtil.h>
+#include <folly/String.h>
+#include <folly/io/IOBuf.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/inodes/overlay/FsOverlay.h"
+
+namespace facebook {
+namespace eden {
+
+using folly::ByteRange;
+using folly::fbvector;
+using folly::File;
+using folly::IOBuf;
+
+constexpr size_t EphemeralOverlay::kMaxInMemoryFileSize;
+
+namespace {
+constexpr PathComponentPiece kNamedFilesDir{"ephemeral-files"};
+
+/**
+ * The number of unlinked files to hold if RLIMIT_NOFILE can't be determined.
+ */
+constexpr size_t kFallbackMaxOpenFiles = 1024;
+
+void writeContents(
+    const File& file,
+    InodeNumber inodeNumber,
+    iovec* iov,
+    size_t iovCount) {
+  auto sizeWritten = folly::writevFull(file.fd(), iov, iovCount);
+  folly::checkUnixError(
+      sizeWritten,
+      "error writing to ephemeral overlay file for inode ",
+      inodeNumber);
+}
+
+size_t totalLength(const iovec* iov, size_t iovCount) {
+  size_t length = 0;
+  for (size_t i = 0; i < iovCount; ++i) {
+    length += iov[i].iov_len;
+  }
+  return length;
+}
+} // namespace
+
+size_t EphemeralOverlay::getDefaultMaxOpenFiles() {
+  struct rlimit limit;
+  if (::getrlimit(RLIMIT_NOFILE, &limit) != 0 ||
+      limit.rlim_cur == RLIM_INFINITY) {
+    return kFallbackMaxOpenFiles;
+  }
+  return limit.rlim_cur / 4;
+}
+
+EphemeralOverlay::EphemeralOverlay(
+    AbsolutePathPiece localDir,
+    size_t maxOpenFiles)
+    : localDir_{localDir},
+      namedFilesDir_{localDir + kNamedFilesDir},
+      maxOpenFiles_{maxOpenFiles} {}
+
+EphemeralOverlay::~EphemeralOverlay() {
+  if (state_.rlock()->namedFiles.empty()) {
+    return;
+  }
+  try {
+    removeRecursively(namedFilesDir_);
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "failed to remove ephemeral overlay files in "
+              << namedFilesDir_ << ": " << folly::exceptionStr(ex);
+  }
+}
+
+void EphemeralOverlay::initialize() {
+  ensureDirectoryExists(localDir_);
+  removeRecursively(namedFilesDir_);
+}
+
+AbsolutePath EphemeralOverlay::getNamedFilePath(
+    InodeNumber inodeNumber) const {
+  return namedFilesDir_ +
+      PathComponent{folly::to<std::string>(inodeNumber.get())};
+}
+
+struct statfs EphemeralOverlay::statFs() const {
+  struct statfs fs = {};
+  ::statfs(localDir_.c_str(), &fs);
+  return fs;
+}
+
+void EphemeralOverlay::saveOverlayDir(
+    InodeNumber inodeNumber,
+    overlay::OverlayDir odir) {
+  state_.wlock()->dirs[inodeNumber] = std::move(odir);
+}
+
+std::optional<overlay::OverlayDir> EphemeralOverlay::loadOverlayDir(
+    InodeNumber inodeNumber) {
+  auto state = state_.rlock();
+  auto* odir = folly::get_ptr(state->dirs, inodeNumber);
+  if (!odir) {
+    return std::nullopt;
+  }
+  return *odir;
+}
+
+File EphemeralOverlay::createAnonymousFile(size_t expectedSize) {
+#ifdef __linux__
+  if (expectedSize <= kMaxInMemoryFileSize) {
+    int fd = memfd_create("edenfs-overlay", MFD_CLOEXEC);
+    if (fd >= 0) {
+      return File{fd, /* ownsFd */ true};
+    }
+    XLOG(DBG3) << "memfd_create failed: " << folly::errnoStr(errno);
+  }
+#ifdef O_TMPFILE
+  int fd = ::open(localDir_.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+  if (fd >= 0) {
+    return File{fd, /* ownsFd */ true};
+  }
+  XLOG(DBG3) << "O_TMPFILE is not supported in " << localDir_ << ": "
+             << folly::errnoStr(errno);
+#endif
+#else
+  (void)expectedSize;
+#endif
+
+  // Fall back to creating a named file and unlinking it right away.
+  auto path = (localDir_ + PathComponentPiece{"ephemeral.XXXXXX"}).value();
+  int fd = mkstemp(&path[0]);
+  folly::checkUnixError(
+      fd, "failed to create ephemeral overlay file in ", localDir_);
+  File file{fd, /* ownsFd */ true};
+  folly::checkUnixError(
+      ::fcntl(fd, F_SETFD, FD_CLOEXEC),
+      "failed to set FD_CLOEXEC on ",
+      path);
+  folly::checkUnixError(::unlink(path.c_str()), "failed to unlink ", path);
+  return file;
+}
+
+File EphemeralOverlay::createFile(
+    InodeNumber inodeNumber,
+    size_t expectedSize) {
+  // A file that is replaced stays where it was, so that an inode never has
+  // both kinds of file.
+  auto state = state_.wlock();
+  if (!state->namedFiles.count(inodeNumber) &&
+      (state->files.count(inodeNumber) ||
+       state->files.size() < maxOpenFiles_)) {
+    auto file = createAnonymousFile(expectedSize);
+    auto result = file.dup();
+    state->files[inodeNumber] = std::move(file);
+    return result;
+  }
+
+  if (state->namedFiles.empty()) {
+    ensureDirectoryExists(namedFilesDir_);
+  }
+  auto path = getNamedFilePath(inodeNumber);
+  int fd =
+      ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0600);
+  folly::checkUnixError(
+      fd, "failed to create ephemeral overlay file ", path);
+  state->namedFiles.insert(inodeNumber);
+  return File{fd, /* ownsFd */ true};
+}
+
+File EphemeralOverlay::createOverlayFile(
+    InodeNumber inodeNumber,
+    ByteRange contents) {
+  auto header = FsOverlay::createHeader(
+      FsOverlay::kHeaderIdentifierFile, FsOverlay::kHeaderVersion);
+
+  std::array<struct iovec, 2> iov;
+  iov[0].iov_base = header.data();
+  iov[0].iov_len = header.size();
+  iov[1].iov_base = const_cast<uint8_t*>(contents.data());
+  iov[1].iov_len = contents.size();
+
+  auto file = createFile(inodeNumber, totalLength(iov.data(), iov.size()));
+  writeContents(file, inodeNumber, iov.data(), iov.size());
+  return file;
+}
+
+File EphemeralOverlay::createOverlayFile(
+    InodeNumber inodeNumber,
+    const IOBuf& contents) {
+  if (contents.next() == &contents) {
+    return createOverlayFile(
+        inodeNumber, ByteRange{contents.data(), contents.length()});
+  }
+
+  auto header = FsOverlay::createHeader(
+      FsOverlay::kHeaderIdentifierFile, FsOverlay::kHeaderVersion);
+
+  fbvector<struct iovec> iov;
+  iov.resize(1);
+  iov[0].iov_base = header.data();
+  iov[0].iov_len = header.size();
+  contents.appendToIov(&iov);
+
+  auto file = createFile(inodeNumber, totalLength(iov.data(), iov.size()));
+  writeContents(file, inodeNumber, iov.data(), iov.size());
+  return file;
+}
+
+File EphemeralOverlay::createPartialOverlayFile(
+    InodeNumber inodeNumber,
+    const Hash& baseBlobHash,
+    uint64_t size) {
+  FsOverlay::PartialFileInfo info;
+  info.baseBlobHash = baseBlobHash;
+  info.size = size;
+  auto header = FsOverlay::serializePartialFileHeader(info);
+
+  std::array<struct iovec, 1> iov;
+  iov[0].iov_base = header.data();
+  iov[0].iov_len = header.size();
+
+  // The contents are filled in from the base blob as they are read or
+  // written, so size the file for its eventual contents.
+  auto file = createFile(inodeNumber, header.size() + size);
+  writeContents(file, inodeNumber, iov.data(), iov.size());
+  return file;
+}
+
+File EphemeralOverlay::openFile(
+    InodeNumber inodeNumber,
+    folly::StringPiece headerId) {
+  auto file = openFileNoVerify(inodeNumber);
+
+  std::string contents(FsOverlay::kHeaderLength, '\0');
+  auto sizeRead =
+      folly::preadFull(file.fd(), &contents[0], contents.size(), 0);
+  folly::checkUnixError(
+      sizeRead,
+      "failed to read ephemeral overlay file for inode ",
+      inodeNumber);
+  contents.resize(sizeRead);
+
+  FsOverlay::validateHeader(inodeNumber, contents, headerId);
+  return file;
+}
+
+File EphemeralOverlay::openFileNoVerify(InodeNumber inodeNumber) {
+  auto state = state_.rlock();
+  if (auto* file = folly::get_ptr(state->files, inodeNumber)) {
+    return file->dup();
+  }
+  if (state->namedFiles.count(inodeNumber)) {
+    auto path = getNamedFilePath(inodeNumber);
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    folly::checkUnixError(fd, "failed to open ephemeral overlay file ", path);
+    return File{fd, /* ownsFd */ true};
+  }
+  folly::throwSystemErrorExplicit(
+      ENOENT, "no ephemeral overlay file for inode ", inodeNumber);
+}
+
+void EphemeralOverlay::removeOverlayData(InodeNumber inodeNumber) {
+  File file;
+  {
+    auto state = state_.wlock();
+    state->dirs.erase(inodeNumber);
+    auto it = state->files.find(inodeNumber);
+    if (it != state->files.end()) {
+      file = std::move(it->second);
+      state->files.erase(it);
+    }
+    if (state->namedFiles.erase(inodeNumber)) {
+      auto path = getNamedFilePath(inodeNumber);
+      if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+        XLOG(WARN) << "failed to remove ephemeral overlay file " << path
+                   << ": " << folly::errnoStr(errno);
+      }
+    }
+  }
+  // The file is closed here, outside of the lock.
+}
+
+bool EphemeralOverlay::hasOverlayData(InodeNumber inodeNumber) {
+  auto state = state_.rlock();
+  return state->dirs.count(inodeNumber) || state->files.count(inodeNumber) ||
+      state->namedFiles.count(inodeNumber);
+}
+
+} // namespace eden
+} // namespace facebook
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/PathFuncs.h"
+#ifdef __APPLE__
+#include <sys/mount.h>
+#include <sys/param.h>
+#else
+#include <sys/vfs.h>
+#endif
+
+namespace folly {
+class IOBuf;
+}
+
+namespace facebook {
+namespace eden {
+
+/**
+ * EphemeralOverlay stores the overlay of a checkout whose local changes don't
+ * need to outlive the mount, such as a CI checkout that is thrown away after
+ * a build.  It is the counterpart of FsOverlay that skips all the durability
+ * work.
+ *
+ * Directories are kept in memory as OverlayDir objects, and never serialized.
+ * Files are unlinked temporary files that are never synced: files that start
+ * out small are kept in memory, and larger ones spill to the overlay
+ * directory, where the kernel can write them back under memory pressure.
+ * Files keep the FsOverlay header, so that OverlayFileAccess handles both the
+ * same way.
+ *
+ * An unlinked file only exists as long as a descriptor of it is open, so
+ * each of them holds one.  To stay well below RLIMIT_NOFILE, once
+ * maxOpenFiles files are held further files are created as named files in
+ * the overlay directory instead, and are reopened each time they are opened.
+ *
+ * Nothing is left behind once the EphemeralOverlay is destroyed, and in
+ * particular its contents don't survive a restart of EdenFS.
+ */
+class EphemeralOverlay {
+ public:
+  /**
+   * Files whose initial contents are at most this large are created in
+   * memory.
+   */
+  static constexpr size_t kMaxInMemoryFileSize = 1024 * 1024;
+
+  /**
+   * The number of descriptors of unlinked files to hold when no limit is
+   * given: a quarter of the RLIMIT_NOFILE soft limit, leaving the rest for
+   * FUSE requests, the LocalStore and other mounts.
+   */
+  static size_t getDefaultMaxOpenFiles();
+
+  explicit EphemeralOverlay(
+      AbsolutePathPiece localDir,
+      size_t maxOpenFiles = getDefaultMaxOpenFiles());
+
+  ~EphemeralOverlay();
+
+  EphemeralOverlay(const EphemeralOverlay&) = delete;
+  EphemeralOverlay& operator=(const EphemeralOverlay&) = delete;
+
+  /**
+   * Create the overlay directory if needed, since large files are spilled
+   * there, and remove any named files left behind by an EphemeralOverlay
+   * that was not destroyed cleanly.
+   */
+  void initialize();
+
+  const AbsolutePath& getLocalDir() const {
+    return localDir_;
+  }
+
+  /**
+   * call statfs(2) on the filesystem in which the overlay is located
+   */
+  struct statfs statFs() const;
+
+  void saveOverlayDir(InodeNumber inodeNumber, overlay::OverlayDir odir);
+
+  std::optional<overlay::OverlayDir> loadOverlayDir(InodeNumber inodeNumber);
+
+  folly::File createOverlayFile(
+      InodeNumber inodeNumber,
+      folly::ByteRange contents);
+
+  folly::File createOverlayFile(
+      InodeNumber inodeNumber,
+      const folly::IOBuf& contents);
+
+  folly::File createPartialOverlayFile(
+      InodeNumber inodeNumber,
+      const Hash& baseBlobHash,
+      uint64_t size);
+
+  /**
+   * Returns a new descriptor of the file stored for the inode, after checking
+   * that it has the given header.
+   */
+  folly::File openFile(InodeNumber inodeNumber, folly::StringPiece headerId);
+
+  folly::File openFileNoVerify(InodeNumber inodeNumber);
+
+  /**
+   * Remove the directory or file stored for the inode.  The contents of a
+   * file are freed once all the descriptors returned for it are closed.
+   */
+  void removeOverlayData(InodeNumber inodeNumber);
+
+  bool hasOverlayData(InodeNumber inodeNumber);
+
+  /**
+   * Create an unlinked file, in memory if expectedSize is at most
+   * kMaxInMemoryFileSize, or in the overlay directory otherwise.
+   */
+  folly::File createAnonymousFile(size_t expectedSize);
+
+ private:
+  struct State {
+    std::unordered_map<InodeNumber, overlay::OverlayDir> dirs;
+    /**
+     * Unlinked files, which are kept alive by these descriptors.
+     */
+    std::unordered_map<InodeNumber, folly::File> files;
+    /**
+     * Files stored under namedFilesDir_ because maxOpenFiles_ unlinked files
+     * were already held when they were created.
+     */
+    std::unordered_set<InodeNumber> namedFiles;
+  };
+
+  /**
+   * Create an empty file for the inode, replacing any previous one, and
+   * return a descriptor of it.
+   */
+  folly::File createFile(InodeNumber inodeNumber, size_t expectedSize);
+
+  AbsolutePath getNamedFilePath(InodeNumber inodeNumber) const;
+
+  const AbsolutePath localDir_;
+  const AbsolutePath namedFilesDir_;
+  const size_t maxOpenFiles_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace eden
+} // namespace facebook
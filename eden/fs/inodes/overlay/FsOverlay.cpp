@@ -46,6 +46,7 @@ using std::string;
  */
 constexpr StringPiece kInfoFile{"info"};
 constexpr const char* kNextInodeNumberFile{"next-inode-number"};
+constexpr const char* kReservedInodeNumberFile{"reserved-inode-number"};
 
 /**
  * 4-byte magic identifier to put at the start of the info file.
@@ -54,6 +55,7 @@ constexpr const char* kNextInodeNumberFile{"next-inode-number"};
 constexpr StringPiece kInfoHeaderMagic{"\xed\xe0\x00\x01"};
 
 constexpr folly::StringPiece FsOverlay::kMetadataFile;
+constexpr uint64_t FsOverlay::kInodeNumberReservationSize;
 
 /**
  * A version number for the overlay directory format.
@@ -68,8 +70,12 @@ constexpr size_t kInfoHeaderSize =
 
 constexpr folly::StringPiece FsOverlay::kHeaderIdentifierDir;
 constexpr folly::StringPiece FsOverlay::kHeaderIdentifierFile;
+constexpr folly::StringPiece FsOverlay::kHeaderIdentifierPartialFile;
 constexpr uint32_t FsOverlay::kHeaderVersion;
 constexpr size_t FsOverlay::kHeaderLength;
+constexpr size_t FsOverlay::kPartialFileExtentTableLength;
+constexpr size_t FsOverlay::kPartialFileMaxExtents;
+constexpr size_t FsOverlay::kPartialFileContentOffset;
 constexpr uint32_t FsOverlay::kNumShards;
 
 static void doFormatSubdirPath(
@@ -136,6 +142,7 @@ std::optional<InodeNumber> FsOverlay::initOverlay(bool createIfNonExisting) {
   if (overlayCreated) {
     return InodeNumber{kRootNodeId.get() + 1};
   }
+  previousReservation_ = tryLoadReservedInodeNumber();
   return tryLoadNextInodeNumber();
 }
 
@@ -199,6 +206,62 @@ std::optional<InodeNumber> FsOverlay::tryLoadNextInodeNumber() {
   return InodeNumber{nextInodeNumber};
 }
 
+std::optional<InodeNumber> FsOverlay::tryLoadReservedInodeNumber() {
+  int fd =
+      openat(dirFile_.fd(), kReservedInodeNumberFile, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    if (errno == ENOENT) {
+      return std::nullopt;
+    }
+    folly::throwSystemError("Failed to open ", kReservedInodeNumberFile);
+  }
+  folly::File reservedInodeNumberFile{fd, /* ownsFd */ true};
+
+  uint64_t reservedInodeNumber;
+  auto readResult =
+      folly::readFull(fd, &reservedInodeNumber, sizeof(reservedInodeNumber));
+  if (readResult < 0) {
+    folly::throwSystemError(
+        "Failed to read ", kReservedInodeNumberFile, " from overlay");
+  }
+  if (readResult != sizeof(reservedInodeNumber) ||
+      reservedInodeNumber <= kRootNodeId.get()) {
+    XLOG(WARN) << "Invalid " << kReservedInodeNumberFile << " in overlay "
+               << localDir_ << ", ignoring it";
+    return std::nullopt;
+  }
+  return InodeNumber{reservedInodeNumber};
+}
+
+void FsOverlay::saveReservedInodeNumber(InodeNumber reservedInodeNumber) {
+  auto reservedInodeNumberPath =
+      localDir_ + PathComponentPiece{kReservedInodeNumberFile};
+
+  auto reservedInodeVal = reservedInodeNumber.get();
+  writeFileAtomic(
+      reservedInodeNumberPath,
+      ByteRange(
+          reinterpret_cast<const uint8_t*>(&reservedInodeVal),
+          reinterpret_cast<const uint8_t*>(&reservedInodeVal + 1)))
+      .value();
+}
+
+void FsOverlay::updateUsedInodeNumber(uint64_t usedInodeNumber) {
+  if (usedInodeNumber < reservedInodeNumber_.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  // Callers that are past the end of the reservation must wait for the new
+  // one to be on disk before using their inode number.
+  std::lock_guard<std::mutex> guard{reservationMutex_};
+  if (usedInodeNumber < reservedInodeNumber_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  auto reservedInodeNumber = usedInodeNumber + kInodeNumberReservationSize;
+  saveReservedInodeNumber(InodeNumber{reservedInodeNumber});
+  reservedInodeNumber_.store(reservedInodeNumber, std::memory_order_release);
+}
+
 void FsOverlay::saveNextInodeNumber(InodeNumber nextInodeNumber) {
   auto nextInodeNumberPath =
       localDir_ + PathComponentPiece{kNextInodeNumberFile};
@@ -572,6 +635,109 @@ folly::File FsOverlay::createOverlayFile(
   return createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
 }
 
+folly::File FsOverlay::createPartialOverlayFile(
+    InodeNumber inodeNumber,
+    const Hash& baseBlobHash,
+    uint64_t size) {
+  PartialFileInfo info;
+  info.baseBlobHash = baseBlobHash;
+  info.size = size;
+  auto header = serializePartialFileHeader(info);
+
+  // Only the header is written: the contents start out entirely as a hole
+  // that is backed by the base blob.
+  std::array<struct iovec, 1> iov;
+  iov[0].iov_base = header.data();
+  iov[0].iov_len = header.size();
+  return createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
+}
+
+std::string FsOverlay::serializePartialFileHeader(const PartialFileInfo& info) {
+  auto extents = info.extents.getIntervals();
+  if (extents.size() > kPartialFileMaxExtents) {
+    throw std::range_error(folly::to<std::string>(
+        "too many extents for a partially materialized file: ",
+        extents.size()));
+  }
+
+  std::string result(kPartialFileContentOffset, '\0');
+  IOBuf buf{IOBuf::WRAP_BUFFER,
+            folly::MutableByteRange{
+                reinterpret_cast<uint8_t*>(result.data()), result.size()}};
+  buf.clear();
+  folly::io::Appender appender(&buf, 0);
+
+  appender.push(kHeaderIdentifierPartialFile);
+  appender.writeBE(kHeaderVersion);
+  appender.push(info.baseBlobHash.getBytes());
+  appender.writeBE<uint64_t>(info.size);
+  appender.writeBE<uint32_t>(extents.size());
+  // The rest of the header is zero padding.
+  appender.append(kHeaderLength - buf.length());
+
+  for (const auto& extent : extents) {
+    appender.writeBE<uint64_t>(extent.first);
+    appender.writeBE<uint64_t>(extent.second);
+  }
+  return result;
+}
+
+FsOverlay::PartialFileInfo FsOverlay::parsePartialFileHeader(
+    InodeNumber inodeNumber,
+    ByteRange contents) {
+  validateHeader(
+      inodeNumber, StringPiece{contents}, kHeaderIdentifierPartialFile);
+  if (contents.size() < kPartialFileContentOffset) {
+    throw newEdenError(
+        EIO,
+        EdenErrorType::POSIX_ERROR,
+        "Partially materialized overlay file (inode ",
+        inodeNumber,
+        ") is too short for its extent table: size=",
+        contents.size());
+  }
+
+  IOBuf buf(IOBuf::WRAP_BUFFER, contents);
+  folly::io::Cursor cursor(&buf);
+  cursor.skip(kHeaderIdentifierPartialFile.size() + sizeof(kHeaderVersion));
+
+  PartialFileInfo info;
+  cursor.pull(info.baseBlobHash.mutableBytes().data(), Hash::RAW_SIZE);
+  info.size = cursor.readBE<uint64_t>();
+  auto extentCount = cursor.readBE<uint32_t>();
+  if (extentCount > kPartialFileMaxExtents) {
+    throw newEdenError(
+        EIO,
+        EdenErrorType::POSIX_ERROR,
+        "Partially materialized overlay file (inode ",
+        inodeNumber,
+        ") has too many extents: ",
+        extentCount);
+  }
+
+  cursor.reset(&buf);
+  cursor.skip(kHeaderLength);
+  for (uint32_t n = 0; n < extentCount; ++n) {
+    auto begin = cursor.readBE<uint64_t>();
+    auto end = cursor.readBE<uint64_t>();
+    if (begin >= end || end > info.size) {
+      throw newEdenError(
+          EIO,
+          EdenErrorType::POSIX_ERROR,
+          "Partially materialized overlay file (inode ",
+          inodeNumber,
+          ") has an invalid extent [",
+          begin,
+          ", ",
+          end,
+          ") for size ",
+          info.size);
+    }
+    info.extents.add(begin, end);
+  }
+  return info;
+}
+
 void FsOverlay::validateHeader(
     InodeNumber inodeNumber,
     folly::StringPiece contents,
@@ -11,10 +11,14 @@
 #include <folly/Range.h>
 #include <gtest/gtest_prod.h>
 #include <array>
+#include <atomic>
 #include <condition_variable>
+#include <mutex>
 #include <optional>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/CoverageSet.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/PathFuncs.h"
 #ifdef __APPLE__
@@ -39,6 +43,22 @@ class InodePath;
  */
 class FsOverlay {
  public:
+  /**
+   * The on-disk state of a partially materialized file.
+   *
+   * A partially materialized overlay file only holds the byte ranges that
+   * have been written since the file was materialized.  Every other byte
+   * below the size of the base blob is read from the source control blob the
+   * file was materialized from, and bytes beyond it read as zero.
+   */
+  struct PartialFileInfo {
+    Hash baseBlobHash;
+    /** The logical size of the file. */
+    uint64_t size{0};
+    /** The ranges of the file whose contents are stored in the overlay. */
+    CoverageSet extents;
+  };
+
   explicit FsOverlay(AbsolutePathPiece localDir) : localDir_{localDir} {}
   /**
    * Initialize the overlay, acquire the "info" file lock and load the
@@ -48,9 +68,39 @@ class FsOverlay {
    * Returns the next inode number to start at when allocating new inodes.
    * If the overlay was not shutdown cleanly by the previous user then
    * std::nullopt is returned.  In this case, the caller should re-scan
-   * the overlay to check for issues and compute the next inode number.
+   * the overlay to check for issues and compute the next inode number, or
+   * use getInodeNumberReservation() if it is available.
    */
   std::optional<InodeNumber> initOverlay(bool createIfNonExisting);
+
+  /**
+   * The end of the range of inode numbers that the previous user of the
+   * overlay had reserved, as read by initOverlay().
+   *
+   * Every inode number allocated by the previous user is below this value,
+   * even if it was not shut down cleanly, which makes it a valid next inode
+   * number without scanning the overlay. Returns std::nullopt if the overlay
+   * was created by a version of EdenFS that did not reserve inode numbers.
+   */
+  std::optional<InodeNumber> getInodeNumberReservation() const {
+    return previousReservation_;
+  }
+
+  /**
+   * Record that inode numbers up to and including usedInodeNumber are about
+   * to be used, reserving a new range of inode numbers if usedInodeNumber is
+   * not already covered by the current reservation.
+   *
+   * This is the FsOverlay counterpart to SqliteOverlay::updateUsedInodeNumber:
+   * as long as every allocated inode number is reserved on disk before being
+   * used, a subsequent unclean shutdown does not require a full scan of the
+   * overlay to find a safe next inode number. A reservation covers
+   * kInodeNumberReservationSize inode numbers, so this only writes to disk
+   * once in a while.
+   */
+  void updateUsedInodeNumber(uint64_t usedInodeNumber);
+
+  static constexpr uint64_t kInodeNumberReservationSize = 1 << 20;
   /**
    *  Gracefully, shutdown the overlay, persisting the overlay's
    * nextInodeNumber.
@@ -120,6 +170,14 @@ class FsOverlay {
    */
   std::optional<InodeNumber> tryLoadNextInodeNumber();
 
+  /**
+   * Return the inode number stored in the kReservedInodeNumberFile, or
+   * std::nullopt if the file does not exist or is invalid.
+   */
+  std::optional<InodeNumber> tryLoadReservedInodeNumber();
+
+  void saveReservedInodeNumber(InodeNumber reservedInodeNumber);
+
   /**
    * Validate an existing overlay's info file exists, is valid and contains the
    * correct version.
@@ -141,6 +199,33 @@ class FsOverlay {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents);
 
+  /**
+   * Create a partially materialized overlay file for a FileInode whose
+   * contents are those of the given blob.  None of the blob contents are
+   * copied into the overlay.
+   */
+  folly::File createPartialOverlayFile(
+      InodeNumber inodeNumber,
+      const Hash& baseBlobHash,
+      uint64_t size);
+
+  /**
+   * Serialize the header and extent table of a partially materialized file.
+   * The result is exactly kPartialFileContentOffset bytes long, and should be
+   * written at the start of the overlay file.
+   *
+   * Throws if info contains more than kPartialFileMaxExtents extents.
+   */
+  static std::string serializePartialFileHeader(const PartialFileInfo& info);
+
+  /**
+   * Parse the header and extent table of a partially materialized file.
+   * Throws if the data is not a valid partial file header.
+   */
+  static PartialFileInfo parsePartialFileHeader(
+      InodeNumber inodeNumber,
+      folly::ByteRange contents);
+
   /**
    * Remove the overlay file associated with the passed InodeNumber.
    */
@@ -187,8 +272,20 @@ class FsOverlay {
    */
   static constexpr folly::StringPiece kHeaderIdentifierDir{"OVDR"};
   static constexpr folly::StringPiece kHeaderIdentifierFile{"OVFL"};
+  static constexpr folly::StringPiece kHeaderIdentifierPartialFile{"OVPF"};
   static constexpr uint32_t kHeaderVersion = 1;
   static constexpr size_t kHeaderLength = 64;
+
+  /**
+   * Partially materialized files store a fixed-size table of modified extents
+   * directly after the header, followed by the file contents.  Each extent is
+   * stored as a pair of big-endian 64-bit offsets.
+   */
+  static constexpr size_t kPartialFileExtentTableLength = 4096;
+  static constexpr size_t kPartialFileMaxExtents =
+      kPartialFileExtentTableLength / (2 * sizeof(uint64_t));
+  static constexpr size_t kPartialFileContentOffset =
+      kHeaderLength + kPartialFileExtentTableLength;
   static constexpr uint32_t kNumShards = 256;
   static constexpr size_t kShardDirPathLength = 2;
 
@@ -198,10 +295,6 @@ class FsOverlay {
    */
   static constexpr size_t kMaxDecimalInodeNumberLength = 20;
 
- private:
-  FRIEND_TEST(OverlayTest, getFilePath);
-  friend class RawOverlayTest;
-
   /**
    * Creates header for the files stored in Overlay
    */
@@ -209,6 +302,10 @@ class FsOverlay {
       folly::StringPiece identifier,
       uint32_t version);
 
+ private:
+  FRIEND_TEST(OverlayTest, getFilePath);
+  friend class RawOverlayTest;
+
   /**
    * Get the path to the file for the given inode, relative to localDir.
    *
@@ -241,6 +338,18 @@ class FsOverlay {
    * We maintain this so we can use openat(), unlinkat(), etc.
    */
   folly::File dirFile_;
+
+  /**
+   * The reservation found in the overlay by initOverlay().
+   */
+  std::optional<InodeNumber> previousReservation_;
+
+  /**
+   * Inode numbers below this value are covered by the reservation saved on
+   * disk. Only updated while holding reservationMutex_.
+   */
+  std::atomic<uint64_t> reservedInodeNumber_{0};
+  std::mutex reservationMutex_;
 };
 
 class InodePath {
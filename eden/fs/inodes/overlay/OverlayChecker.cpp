@@ -38,6 +38,30 @@ using std::chrono::seconds;
 namespace facebook {
 namespace eden {
 
+namespace {
+/**
+ * Read the header of a partially materialized overlay file.
+ *
+ * Returns std::nullopt if the file is not partially materialized, and throws
+ * if its header or extent table is invalid.
+ */
+optional<FsOverlay::PartialFileInfo> readPartialFileInfo(
+    InodeNumber number,
+    const folly::File& file) {
+  string header(FsOverlay::kPartialFileContentOffset, '\0');
+  auto bytesRead = folly::preadFull(file.fd(), header.data(), header.size(), 0);
+  if (bytesRead < 0) {
+    folly::throwSystemError("error reading overlay file for inode ", number);
+  }
+  header.resize(bytesRead);
+  if (!StringPiece{header}.startsWith(
+          FsOverlay::kHeaderIdentifierPartialFile)) {
+    return std::nullopt;
+  }
+  return FsOverlay::parsePartialFileHeader(number, ByteRange{StringPiece{header}});
+}
+} // namespace
+
 class OverlayChecker::RepairState {
  public:
   explicit RepairState(OverlayChecker* checker)
@@ -497,6 +521,15 @@ class OverlayChecker::OrphanInode : public OverlayChecker::Error {
       InodeNumber number,
       AbsolutePath archivePath,
       mode_t mode) const {
+    {
+      auto partialInput = repair.fs()->openFileNoVerify(number);
+      if (auto partial = readPartialFileInfo(number, partialInput)) {
+        archivePartialFile(repair, number, partialInput, *partial, archivePath);
+        tryRemoveInode(repair, number);
+        return;
+      }
+    }
+
     auto input =
         repair.fs()->openFile(number, FsOverlay::kHeaderIdentifierFile);
 
@@ -570,6 +603,61 @@ class OverlayChecker::OrphanInode : public OverlayChecker::Error {
     tryRemoveInode(repair, number);
   }
 
+  void archivePartialFile(
+      RepairState& repair,
+      InodeNumber number,
+      const folly::File& input,
+      const FsOverlay::PartialFileInfo& partial,
+      AbsolutePath archivePath) const {
+    // The unmodified contents of a partially materialized file live in its
+    // source control blob, which fsck has no access to.  Recover the modified
+    // extents at their original offsets, leaving holes everywhere else.
+    repair.log(
+        "inode ",
+        number,
+        " was partially materialized from blob ",
+        partial.baseBlobHash.toString(),
+        ": only its modified ranges are recovered to ",
+        archivePath);
+
+    folly::File output(
+        archivePath.value(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    std::vector<uint8_t> buffer;
+    buffer.resize(1024 * 1024);
+    for (const auto& extent : partial.extents.getIntervals()) {
+      for (uint64_t off = extent.first; off < extent.second;) {
+        auto length = std::min<uint64_t>(buffer.size(), extent.second - off);
+        auto bytesRead = folly::preadFull(
+            input.fd(),
+            buffer.data(),
+            length,
+            off + FsOverlay::kPartialFileContentOffset);
+        if (bytesRead < 0) {
+          folly::throwSystemError(
+              "read error while copying data from inode ",
+              number,
+              " to ",
+              archivePath);
+        } else if (bytesRead == 0) {
+          break;
+        }
+        auto bytesWritten =
+            folly::pwriteFull(output.fd(), buffer.data(), bytesRead, off);
+        folly::checkUnixError(
+            bytesWritten,
+            "write error while copying data from inode ",
+            number,
+            " to ",
+            archivePath);
+        off += bytesRead;
+      }
+    }
+    folly::checkUnixError(
+        ftruncate(output.fd(), partial.size),
+        "error setting the size of ",
+        archivePath);
+  }
+
   void processOrphanedError(RepairState& repair, InodeNumber number) const {
     // Inodes with a type of InodeType::Error should have already had their
     // broken data moved to the fsck repair directory by
@@ -983,6 +1071,17 @@ OverlayChecker::InodeInfo OverlayChecker::loadInodeInfo(InodeNumber number) {
     type = InodeType::Dir;
   } else if (typeID == FsOverlay::kHeaderIdentifierFile) {
     type = InodeType::File;
+  } else if (typeID == FsOverlay::kHeaderIdentifierPartialFile) {
+    // Partially materialized files are regular files whose header is
+    // followed by an extent table.  Make sure the table is usable.
+    try {
+      readPartialFileInfo(number, file);
+    } catch (const std::exception& ex) {
+      return inodeError(
+          "invalid partially materialized file header: ",
+          folly::exceptionStr(ex));
+    }
+    type = InodeType::File;
   } else {
     return inodeError(
         "unknown overlay file type ID: ", folly::hexlify(ByteRange{typeID}));
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/BulkFileReader.h"
+#include <folly/io/IOBuf.h>
+#include <folly/test/TestUtils.h>
+#include <gtest/gtest.h>
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestChecks.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+
+namespace {
+std::vector<BulkFileReader::Contents> readFiles(
+    TestMount& mount,
+    std::vector<RelativePath> paths,
+    std::optional<Hash> commit = std::nullopt,
+    size_t maxReadAhead = BulkFileReader::kDefaultMaxReadAhead) {
+  auto count = paths.size();
+  auto reader = std::make_shared<BulkFileReader>(
+      mount.getEdenMount(),
+      std::move(paths),
+      std::move(commit),
+      ObjectFetchContext::getNullContext(),
+      maxReadAhead);
+
+  std::vector<BulkFileReader::Contents> results;
+  while (true) {
+    auto file = reader->next().waitVia(mount.getServerExecutor().get());
+    EXPECT_TRUE(file.isReady());
+    auto value = std::move(file).get();
+    if (!value) {
+      break;
+    }
+    // Files are returned in the order of the paths.
+    EXPECT_EQ(results.size(), value->index);
+    results.push_back(std::move(value->contents));
+  }
+  EXPECT_EQ(count, results.size());
+  return results;
+}
+
+std::string toString(const BulkFileReader::Contents& contents) {
+  return contents.value()->moveToFbString().toStdString();
+}
+} // namespace
+
+TEST(BulkFileReader, readsWorkingCopy) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"dir/a.txt", "a"}, {"dir/sub/b.txt", "bb"}});
+  TestMount mount{builder};
+  mount.overwriteFile("dir/a.txt", "modified");
+
+  auto results = readFiles(
+      mount,
+      {"dir/a.txt"_relpath,
+       "dir/sub/b.txt"_relpath,
+       "dir/missing"_relpath,
+       "dir/sub"_relpath,
+       "dir/a.txt/c"_relpath});
+
+  EXPECT_EQ("modified", toString(results[0]));
+  EXPECT_EQ("bb", toString(results[1]));
+  EXPECT_THROW_ERRNO(results[2].value(), ENOENT);
+  EXPECT_THROW_ERRNO(results[3].value(), EISDIR);
+  EXPECT_THROW_ERRNO(results[4].value(), ENOTDIR);
+}
+
+TEST(BulkFileReader, readsCommit) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"dir/a.txt", "a"}, {"dir/sub/b.txt", "bb"}});
+  TestMount mount{builder};
+  mount.overwriteFile("dir/a.txt", "modified");
+
+  auto commit = mount.getEdenMount()->getParentCommits().parent1();
+  auto results = readFiles(
+      mount,
+      {"dir/a.txt"_relpath, "dir/sub/b.txt"_relpath, "dir/missing"_relpath},
+      commit);
+
+  EXPECT_EQ("a", toString(results[0]));
+  EXPECT_EQ("bb", toString(results[1]));
+  EXPECT_THROW_ERRNO(results[2].value(), ENOENT);
+}
+
+TEST(BulkFileReader, readsLargeFiles) {
+  std::string large(3 * 1024 * 1024, 'x');
+  FakeTreeBuilder builder;
+  builder.setFiles({{"large.txt", large}, {"modified.txt", "a"}});
+  TestMount mount{builder};
+  mount.overwriteFile("modified.txt", large);
+
+  auto results =
+      readFiles(mount, {"large.txt"_relpath, "modified.txt"_relpath});
+
+  EXPECT_EQ(large, toString(results[0]));
+  EXPECT_EQ(large, toString(results[1]));
+}
+
+TEST(BulkFileReader, readsAheadOnlyAsFilesAreConsumed) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"a.txt", "a"}, {"b.txt", "bb"}, {"c.txt", "ccc"}});
+  TestMount mount{builder};
+
+  auto results = readFiles(
+      mount,
+      {"a.txt"_relpath, "b.txt"_relpath, "missing"_relpath, "c.txt"_relpath},
+      std::nullopt,
+      /*maxReadAhead=*/1);
+
+  EXPECT_EQ("a", toString(results[0]));
+  EXPECT_EQ("bb", toString(results[1]));
+  EXPECT_THROW_ERRNO(results[2].value(), ENOENT);
+  EXPECT_EQ("ccc", toString(results[3]));
+}
+
+TEST(BulkFileReader, stopsReading) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"a.txt", "a"}, {"b.txt", "bb"}, {"c.txt", "ccc"}});
+  TestMount mount{builder};
+
+  auto reader = std::make_shared<BulkFileReader>(
+      mount.getEdenMount(),
+      std::vector<RelativePath>{
+          "a.txt"_relpath, "b.txt"_relpath, "c.txt"_relpath},
+      std::nullopt,
+      ObjectFetchContext::getNullContext(),
+      /*maxReadAhead=*/2);
+  auto* executor = mount.getServerExecutor().get();
+
+  auto first = reader->next().waitVia(executor);
+  ASSERT_TRUE(first.isReady());
+  EXPECT_EQ("a", toString(std::move(first).get()->contents));
+
+  // The read of b.txt was started ahead, and completes before stop() does.
+  auto stopped = reader->stop().waitVia(executor);
+  EXPECT_TRUE(stopped.isReady());
+
+  auto next = reader->next().waitVia(executor);
+  ASSERT_TRUE(next.isReady());
+  EXPECT_FALSE(std::move(next).get().has_value());
+}
@@ -1070,6 +1070,28 @@ TEST(EdenMount, takeoverFuseFailsIfUnmountWasEverCalled) {
       EdenMountCancelled);
 }
 
+TEST(EdenMount, takeoverIsRefusedWithEphemeralOverlay) {
+  TestMount testMount;
+  testMount.useEphemeralOverlay();
+  FakeTreeBuilder builder;
+  builder.setFile("dir/file.txt", "contents\n");
+  testMount.initialize(builder);
+  ASSERT_EQ(
+      Overlay::Type::Ephemeral,
+      testMount.getEdenMount()->getOverlay()->getType());
+
+  // Load an inode, so that the takeover data refers to an inode number the
+  // new overlay would hand out again.
+  testMount.getFileInode("dir/file.txt");
+
+  EXPECT_THROW_RE(
+      testMount.remountGracefully(),
+      std::domain_error,
+      "mounts with an ephemeral overlay must be remounted");
+  EXPECT_EQ(
+      EdenMount::State::INIT_ERROR, testMount.getEdenMount()->getState());
+}
+
 TEST(EdenMountState, mountIsUninitializedAfterConstruction) {
   auto testMount = TestMount{};
   auto builder = FakeTreeBuilder{};
@@ -15,6 +15,8 @@
 #include <gtest/gtest.h>
 #include <chrono>
 
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/testharness/FakeBackingStore.h"
@@ -616,6 +618,120 @@ TEST(FileInode, reloadsBlobIfCacheIsEvicted) {
       << "reading should insert hash " << hash << " into cache";
 }
 
+class PartialMaterializationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    for (int i = 0; i < 100; ++i) {
+      contents_ += "0123456789";
+    }
+    FakeTreeBuilder builder;
+    builder.setFiles({{"dir/big.txt", contents_}});
+    mount_.initialize(builder);
+
+    auto config = mount_.getEdenConfig();
+    config->partialMaterializationMinSize.setValue(
+        100, ConfigSource::CommandLine);
+    config->partialMaterializationMaxModifiedRatio.setValue(
+        0.5, ConfigSource::CommandLine);
+  }
+
+  std::string getOverlayHeaderId(const FileInodePtr& inode) {
+    auto file = mount_.getEdenMount()->getOverlay()->openFileNoVerify(
+        inode->getNodeId());
+    std::string id(FsOverlay::kHeaderIdentifierFile.size(), '\0');
+    auto result = file.preadNoInt(id.data(), id.size(), 0);
+    EXPECT_TRUE(result.hasValue());
+    return id;
+  }
+
+  std::string contents_;
+  TestMount mount_;
+};
+
+TEST_F(PartialMaterializationTest, smallWriteOnlyStoresModifiedRange) {
+  auto inode = mount_.getFileInode("dir/big.txt");
+  EXPECT_EQ(5, inode->write("HELLO"_sp, 500).get(0ms));
+  contents_.replace(500, 5, "HELLO");
+
+  EXPECT_EQ(FsOverlay::kHeaderIdentifierPartialFile, getOverlayHeaderId(inode));
+  EXPECT_TRUE(isInodeMaterialized(mount_.getTreeInode("dir")));
+  EXPECT_FILE_INODE(inode, contents_, 0644);
+  EXPECT_EQ(
+      Hash::sha1(StringPiece{contents_}),
+      inode->getSha1(ObjectFetchContext::getNullContext()).get(0ms));
+
+  auto data = inode->read(10, 498, ObjectFetchContext::getNullContext())
+                  .get(0ms)
+                  ->moveToFbString();
+  EXPECT_EQ("89HELLO567", data);
+}
+
+TEST_F(PartialMaterializationTest, writePastEndExtendsFile) {
+  auto inode = mount_.getFileInode("dir/big.txt");
+  inode->write("tail"_sp, 1010).get(0ms);
+  contents_.append(10, '\0');
+  contents_ += "tail";
+
+  EXPECT_EQ(FsOverlay::kHeaderIdentifierPartialFile, getOverlayHeaderId(inode));
+  EXPECT_FILE_INODE(inode, contents_, 0644);
+}
+
+TEST_F(PartialMaterializationTest, largeWritesMaterializeCompletely) {
+  auto inode = mount_.getFileInode("dir/big.txt");
+  inode->write("HELLO"_sp, 0).get(0ms);
+  EXPECT_EQ(FsOverlay::kHeaderIdentifierPartialFile, getOverlayHeaderId(inode));
+
+  std::string big(600, 'x');
+  inode->write(StringPiece{big}, 100).get(0ms);
+  contents_.replace(0, 5, "HELLO");
+  contents_.replace(100, big.size(), big);
+
+  EXPECT_EQ(FsOverlay::kHeaderIdentifierFile, getOverlayHeaderId(inode));
+  EXPECT_FILE_INODE(inode, contents_, 0644);
+}
+
+TEST_F(PartialMaterializationTest, truncateMaterializesCompletely) {
+  auto inode = mount_.getFileInode("dir/big.txt");
+  inode->write("HELLO"_sp, 10).get(0ms);
+
+  fuse_setattr_in attr = {};
+  attr.valid = FATTR_SIZE;
+  attr.size = 20;
+  (void)inode->setattr(attr).get(0ms);
+
+  EXPECT_EQ(FsOverlay::kHeaderIdentifierFile, getOverlayHeaderId(inode));
+  EXPECT_FILE_INODE(inode, "0123456789HELLO56789", 0644);
+
+  attr.size = 0;
+  (void)inode->setattr(attr).get(0ms);
+  EXPECT_FILE_INODE(inode, "", 0644);
+}
+
+TEST_F(PartialMaterializationTest, truncateToZeroDiscardsPartialFile) {
+  auto inode = mount_.getFileInode("dir/big.txt");
+  inode->write("HELLO"_sp, 10).get(0ms);
+
+  fuse_setattr_in attr = {};
+  attr.valid = FATTR_SIZE;
+  attr.size = 0;
+  (void)inode->setattr(attr).get(0ms);
+
+  EXPECT_EQ(FsOverlay::kHeaderIdentifierFile, getOverlayHeaderId(inode));
+  EXPECT_FILE_INODE(inode, "", 0644);
+}
+
+TEST_F(PartialMaterializationTest, disabledByDefault) {
+  mount_.getEdenConfig()->partialMaterializationMinSize.setValue(
+      0, ConfigSource::CommandLine);
+
+  auto inode = mount_.getFileInode("dir/big.txt");
+  inode->write("HELLO"_sp, 500).get(0ms);
+  contents_.replace(500, 5, "HELLO");
+
+  EXPECT_EQ(FsOverlay::kHeaderIdentifierFile, getOverlayHeaderId(inode));
+  EXPECT_FILE_INODE(inode, contents_, 0644);
+}
+
 // TODO: test multiple flags together
 // TODO: ensure ctime is updated after every call to setattr()
 // TODO: ensure mtime is updated after opening a file, writing to it, then
@@ -39,14 +39,17 @@ folly::Future<std::vector<GlobResult>> evaluateGlob(
     GlobNode::PrefetchList prefetchHashes,
     const Hash& commitHash) {
   auto rootInode = mount.getTreeInode(RelativePathPiece());
-  auto objectStore = mount.getEdenMount()->getObjectStore();
-  return globRoot.evaluate(
-      objectStore,
-      ObjectFetchContext::getNullContext(),
-      RelativePathPiece(),
-      rootInode,
-      prefetchHashes,
-      commitHash);
+  auto treeFetcher = std::make_shared<TreeFetchScheduler>(
+      mount.getEdenMount()->getObjectStore());
+  return globRoot
+      .evaluate(
+          treeFetcher.get(),
+          ObjectFetchContext::getNullContext(),
+          RelativePathPiece(),
+          rootInode,
+          prefetchHashes,
+          commitHash)
+      .ensure([treeFetcher] {});
 }
 } // namespace
 
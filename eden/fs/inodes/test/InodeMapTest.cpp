@@ -413,6 +413,75 @@ TEST(InodeMap, unloadedFileMetadataIsForgotten) {
 }
 #endif
 
+TEST(InodeMap, lookupForgottenInodeWithParentHint) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/file.txt", "contents");
+  builder.setFile("other/file.txt", "contents");
+  TestMount mount{builder};
+  auto edenMount = mount.getEdenMount();
+  auto* inodeMap = edenMount->getInodeMap();
+
+  auto dir = mount.getTreeInode("dir"_relpath);
+  auto dirIno = dir->getNodeId();
+  auto fileIno = mount.getFileInode("dir/file.txt"_relpath)->getNodeId();
+
+  // Without an FS reference count, unloading the file makes the InodeMap
+  // forget about its inode number entirely.
+  EXPECT_EQ(1, dir->unloadChildrenNow());
+  EXPECT_FALSE(inodeMap->isInodeRemembered(fileIno));
+
+  auto file =
+      inodeMap->lookupInodeWithParentHint(fileIno, dirIno).get(1s).asFilePtr();
+  EXPECT_EQ(fileIno, file->getNodeId());
+  EXPECT_EQ("dir/file.txt", file->getLogPath());
+  file.reset();
+
+  // The inode has to be in the hinted directory.
+  EXPECT_EQ(1, dir->unloadChildrenNow());
+  auto otherIno = mount.getTreeInode("other"_relpath)->getNodeId();
+  EXPECT_THROW_ERRNO(
+      inodeMap->lookupInodeWithParentHint(fileIno, otherIno).get(1s), ESTALE);
+
+  // And the hint must be usable.
+  EXPECT_THROW_ERRNO(
+      inodeMap->lookupInodeWithParentHint(fileIno, fileIno).get(1s), ESTALE);
+}
+
+TEST(InodeMap, lookupRememberedUnreferencedInodeWithParentHint) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/sub/file.txt", "contents");
+  TestMount mount{builder};
+  auto edenMount = mount.getEdenMount();
+  auto* inodeMap = edenMount->getInodeMap();
+  auto root = edenMount->getRootInode();
+  inodeMap->setRememberUnreferencedInodes();
+
+  auto subIno = mount.getTreeInode("dir/sub"_relpath)->getNodeId();
+  auto fileIno = mount.getFileInode("dir/sub/file.txt"_relpath)->getNodeId();
+
+  // Unload the file and all of its ancestors but the root, after renaming
+  // one of them. Without an FS reference count they are still remembered.
+  root->rename("dir"_pc, root, "moved"_pc, InvalidationRequired::No).get(1s);
+  root->unloadChildrenNow();
+  EXPECT_TRUE(inodeMap->isInodeRemembered(subIno));
+  EXPECT_TRUE(inodeMap->isInodeRemembered(fileIno));
+
+  auto file =
+      inodeMap->lookupInodeWithParentHint(fileIno, subIno).get(1s).asFilePtr();
+  EXPECT_EQ(fileIno, file->getNodeId());
+  EXPECT_EQ("moved/sub/file.txt", file->getLogPath());
+  file.reset();
+
+  // Once removed, the inode is gone for good.
+  mount.getTreeInode("moved/sub"_relpath)
+      ->unlink("file.txt"_pc, InvalidationRequired::No)
+      .get(1s);
+  root->unloadChildrenNow();
+  EXPECT_FALSE(inodeMap->isInodeRemembered(fileIno));
+  EXPECT_THROW_ERRNO(
+      inodeMap->lookupInodeWithParentHint(fileIno, subIno).get(1s), ESTALE);
+}
+
 struct InodePersistenceTreeTest : ::testing::Test {
   InodePersistenceTreeTest() {
     builder.setFile("dir/file1.txt", "contents1");
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <benchmark/benchmark.h>
+#include <folly/Utility.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenDispatcherFactory.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/nfs/Nfsd3.h"
+#include "eden/fs/nfs/NfsdRpc.h"
+#include "eden/fs/nfs/rpc/StreamClient.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * Writes issued between two COMMITs, roughly what the Linux NFS client sends
+ * when flushing dirty pages of a file that is being written sequentially.
+ */
+constexpr size_t kWritesPerCommit = 256;
+
+/**
+ * An Nfsd3 program serving a TestMount on the loopback interface, and a client
+ * connected to it.
+ */
+struct NfsLoopback {
+  NfsLoopback() : mount{FakeTreeBuilder{}} {
+    mount.addFile("file", "");
+    fh = nfs_fh3{
+        mount.getFileInode("file")->getNodeId(),
+        kRootNodeId,
+        mount.getEdenMount()->getMountGeneration()};
+
+    evbThread.getEventBase()->runInEventBaseThreadAndWait([this] {
+      nfsd = std::make_unique<Nfsd3>(
+          false,
+          evbThread.getEventBase(),
+          EdenDispatcherFactory::makeNfsDispatcher(
+              mount.getEdenMount().get()),
+          &mount.getEdenMount()->getStraceLogger(),
+          nullptr,
+          std::chrono::seconds{60},
+          nullptr);
+    });
+
+    client = std::make_unique<StreamClient>(
+        folly::SocketAddress{"127.0.0.1", nfsd->getPort()});
+    client->connect();
+  }
+
+  ~NfsLoopback() {
+    client.reset();
+    evbThread.getEventBase()->runInEventBaseThreadAndWait(
+        [this] { nfsd.reset(); });
+  }
+
+  WRITE3res write(uint64_t offset, folly::ByteRange data, stable_how stable) {
+    return client->call<WRITE3res>(
+        kNfsdProgNumber,
+        kNfsd3ProgVersion,
+        folly::to_underlying(nfsv3Procs::write),
+        WRITE3args{
+            fh,
+            offset,
+            static_cast<uint32_t>(data.size()),
+            stable,
+            folly::IOBuf::wrapBuffer(data)});
+  }
+
+  COMMIT3res commit() {
+    return client->call<COMMIT3res>(
+        kNfsdProgNumber,
+        kNfsd3ProgVersion,
+        folly::to_underlying(nfsv3Procs::commit),
+        COMMIT3args{fh, 0, 0});
+  }
+
+  TestMount mount;
+  nfs_fh3 fh;
+  folly::ScopedEventBaseThread evbThread;
+  std::unique_ptr<Nfsd3> nfsd;
+  std::unique_ptr<StreamClient> client;
+};
+
+void checkOk(nfsstat3 status) {
+  if (status != nfsstat3::NFS3_OK) {
+    throw std::runtime_error(folly::to<std::string>(
+        "NFS request failed: ", folly::to_underlying(status)));
+  }
+}
+
+void runWrites(benchmark::State& state, stable_how stable) {
+  NfsLoopback nfs;
+  std::string data(state.range(0), 'a');
+  uint64_t offset = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < kWritesPerCommit; ++i) {
+      checkOk(
+          nfs.write(offset, folly::ByteRange{folly::StringPiece{data}}, stable)
+              .tag);
+      offset += data.size();
+    }
+    if (stable == stable_how::UNSTABLE) {
+      checkOk(nfs.commit().tag);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kWritesPerCommit * data.size());
+}
+
+} // namespace
+
+static void Nfsd3_write_unstable(benchmark::State& state) {
+  runWrites(state, stable_how::UNSTABLE);
+}
+BENCHMARK(Nfsd3_write_unstable)->Arg(4096)->Arg(64 * 1024);
+
+static void Nfsd3_write_file_sync(benchmark::State& state) {
+  runWrites(state, stable_how::FILE_SYNC);
+}
+BENCHMARK(Nfsd3_write_file_sync)->Arg(4096)->Arg(64 * 1024);
+
+EDEN_BENCHMARK_MAIN();
+
+#endif
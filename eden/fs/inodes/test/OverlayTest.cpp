@@ -311,6 +311,118 @@ TEST(PlainOverlayTest, unclean_overlay_is_dirty) {
   EXPECT_FALSE(overlay->hadCleanStartup());
 }
 
+TEST(PlainOverlayTest, unclean_overlay_resumes_at_reserved_inode_number) {
+  folly::test::TemporaryDirectory testDir;
+  auto localDir = AbsolutePath{testDir.path().string()};
+
+  InodeNumber allocated;
+  {
+    auto overlay = Overlay::create(
+        localDir,
+        kPathMapDefaultCaseSensitive,
+        std::make_shared<NullStructuredLogger>());
+    overlay->initialize().get();
+    allocated = overlay->allocateInodeNumber();
+  }
+
+  if (unlink((localDir + "next-inode-number"_pc).c_str())) {
+    folly::throwSystemError("removing saved inode numebr");
+  }
+
+  auto overlay = Overlay::create(
+      localDir,
+      kPathMapDefaultCaseSensitive,
+      std::make_shared<NullStructuredLogger>());
+  overlay->initialize().get();
+  EXPECT_FALSE(overlay->hadCleanStartup());
+  EXPECT_EQ(
+      InodeNumber{allocated.get() + FsOverlay::kInodeNumberReservationSize},
+      overlay->allocateInodeNumber());
+}
+
+TEST(PlainOverlayTest, ephemeral_overlay_keeps_data_in_memory) {
+  folly::test::TemporaryDirectory testDir;
+  auto localDir = AbsolutePath{testDir.path().string()};
+
+  {
+    auto overlay = Overlay::create(
+        localDir,
+        kPathMapDefaultCaseSensitive,
+        std::make_shared<NullStructuredLogger>(),
+        Overlay::Type::Ephemeral);
+    overlay->initialize().get();
+    EXPECT_TRUE(overlay->hadCleanStartup());
+
+    auto ino2 = overlay->allocateInodeNumber();
+    auto ino3 = overlay->allocateInodeNumber();
+    EXPECT_EQ(2_ino, ino2);
+
+    DirContents dir(kPathMapDefaultCaseSensitive);
+    dir.emplace(PathComponentPiece{"f"}, S_IFREG | 0644, ino3);
+    overlay->saveOverlayDir(ino2, dir);
+    overlay->createOverlayFile(ino3, folly::ByteRange{"contents"_sp});
+
+    auto loaded = overlay->loadOverlayDir(ino2);
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(ino3, loaded->at("f"_pc).getInodeNumber());
+
+    auto file = overlay->openFile(ino3, FsOverlay::kHeaderIdentifierFile);
+    EXPECT_TRUE(file.lseek(FsOverlay::kHeaderLength, SEEK_SET).hasValue());
+    EXPECT_EQ("contents", file.readFile().value());
+
+    overlay->removeOverlayData(ino3);
+    EXPECT_FALSE(overlay->hasOverlayData(ino3));
+    EXPECT_TRUE(overlay->hasOverlayData(ino2));
+
+    // Nothing but the directory for spilled files is created on disk.
+    EXPECT_TRUE(boost::filesystem::is_empty(testDir.path()));
+  }
+
+  auto overlay = Overlay::create(
+      localDir,
+      kPathMapDefaultCaseSensitive,
+      std::make_shared<NullStructuredLogger>(),
+      Overlay::Type::Ephemeral);
+  overlay->initialize().get();
+  EXPECT_FALSE(overlay->loadOverlayDir(2_ino));
+  EXPECT_EQ(2_ino, overlay->allocateInodeNumber());
+}
+
+TEST(PlainOverlayTest, ephemeral_overlay_bounds_open_files) {
+  folly::test::TemporaryDirectory testDir;
+  auto localDir = AbsolutePath{testDir.path().string()};
+  auto namedFilesDir = testDir.path() / "ephemeral-files";
+
+  {
+    EphemeralOverlay overlay{localDir, /*maxOpenFiles=*/2};
+    overlay.initialize();
+    for (uint64_t i = 2; i < 6; ++i) {
+      auto contents = folly::to<std::string>("contents of ", i);
+      overlay.createOverlayFile(
+          InodeNumber{i}, folly::ByteRange{folly::StringPiece{contents}});
+    }
+
+    // The first two files are held open, and the others are reopened by name.
+    EXPECT_FALSE(boost::filesystem::exists(namedFilesDir / "3"));
+    EXPECT_TRUE(boost::filesystem::exists(namedFilesDir / "4"));
+    EXPECT_TRUE(boost::filesystem::exists(namedFilesDir / "5"));
+    for (uint64_t i = 2; i < 6; ++i) {
+      auto file =
+          overlay.openFile(InodeNumber{i}, FsOverlay::kHeaderIdentifierFile);
+      EXPECT_TRUE(file.lseek(FsOverlay::kHeaderLength, SEEK_SET).hasValue());
+      EXPECT_EQ(
+          folly::to<std::string>("contents of ", i), file.readFile().value());
+    }
+
+    overlay.removeOverlayData(4_ino);
+    EXPECT_FALSE(overlay.hasOverlayData(4_ino));
+    EXPECT_FALSE(boost::filesystem::exists(namedFilesDir / "4"));
+    EXPECT_TRUE(overlay.hasOverlayData(5_ino));
+  }
+
+  EXPECT_FALSE(boost::filesystem::exists(namedFilesDir));
+}
+
 enum class OverlayRestartMode {
   CLEAN,
   UNCLEAN,
@@ -338,6 +450,12 @@ class RawOverlayTest : public ::testing::TestWithParam<OverlayRestartMode> {
         if (unlink((getLocalDir() + "next-inode-number"_pc).c_str())) {
           folly::throwSystemError("removing saved inode numebr");
         }
+        // Without a reservation the overlay has to be scanned to find the
+        // next inode number.
+        if (unlink((getLocalDir() + "reserved-inode-number"_pc).c_str()) &&
+            errno != ENOENT) {
+          folly::throwSystemError("removing reserved inode number");
+        }
         break;
     }
   }
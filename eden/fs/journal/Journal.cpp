@@ -6,6 +6,7 @@
  */
 
 #include "Journal.h"
+#include <folly/MapUtil.h>
 #include <folly/logging/xlog.h>
 #include "eden/fs/journal/JournalDelta.h"
 
@@ -103,39 +104,56 @@ Journal::Journal(std::shared_ptr<EdenStats> edenStats)
 }
 
 void Journal::recordCreated(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CREATED));
+  addDelta([&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(fileName), FileChangeJournalDelta::CREATED);
+  });
 }
 
 void Journal::recordRemoved(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::REMOVED));
+  addDelta([&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(fileName), FileChangeJournalDelta::REMOVED);
+  });
 }
 
 void Journal::recordChanged(RelativePathPiece fileName) {
-  addDelta(FileChangeJournalDelta(fileName, FileChangeJournalDelta::CHANGED));
+  addDelta([&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(fileName), FileChangeJournalDelta::CHANGED);
+  });
 }
 
 void Journal::recordRenamed(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
-  addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::RENAMED));
+  addDelta([&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(oldName),
+        paths.intern(newName),
+        FileChangeJournalDelta::RENAMED);
+  });
 }
 
 void Journal::recordReplaced(
     RelativePathPiece oldName,
     RelativePathPiece newName) {
-  addDelta(FileChangeJournalDelta(
-      oldName, newName, FileChangeJournalDelta::REPLACED));
+  addDelta([&](JournalPathTable& paths) {
+    return FileChangeJournalDelta(
+        paths.intern(oldName),
+        paths.intern(newName),
+        FileChangeJournalDelta::REPLACED);
+  });
 }
 
 void Journal::recordHashUpdate(Hash toHash) {
-  addDelta(HashUpdateJournalDelta{}, toHash);
+  addDelta(HashUpdateJournalDelta{}, toHash, {});
 }
 
 void Journal::recordHashUpdate(Hash fromHash, Hash toHash) {
   HashUpdateJournalDelta delta;
   delta.fromHash = fromHash;
-  addDelta(std::move(delta), toHash);
+  addDelta(std::move(delta), toHash, {});
 }
 
 void Journal::recordUncleanPaths(
@@ -144,8 +162,7 @@ void Journal::recordUncleanPaths(
     std::unordered_set<RelativePath> uncleanPaths) {
   HashUpdateJournalDelta delta;
   delta.fromHash = fromHash;
-  delta.uncleanPaths = std::move(uncleanPaths);
-  addDelta(std::move(delta), toHash);
+  addDelta(std::move(delta), toHash, uncleanPaths);
 }
 
 void Journal::truncateIfNecessary(DeltaState& deltaState) {
@@ -216,45 +233,181 @@ bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
   return shouldNotify;
 }
 
-void Journal::notifySubscribers() const {
-  auto subscribers = subscriberState_.rlock()->subscribers;
-  for (auto& sub : subscribers) {
-    sub.second();
+void Journal::FilterTrie::insert(RelativePathPiece root, SubscriberId id) {
+  auto* node = this;
+  for (auto component : root.components()) {
+    auto* child = folly::get_ptr(node->children, component);
+    if (child) {
+      node = child->get();
+    } else {
+      auto ret =
+          node->children.emplace(component, std::make_unique<FilterTrie>());
+      node = ret.first->second.get();
+    }
+  }
+  node->subscribers.push_back(id);
+}
+
+void Journal::FilterTrie::remove(RelativePathPiece root, SubscriberId id) {
+  std::vector<std::pair<FilterTrie*, PathComponentPiece>> parents;
+  auto* node = this;
+  for (auto component : root.components()) {
+    auto* child = folly::get_ptr(node->children, component);
+    if (!child) {
+      return;
+    }
+    parents.emplace_back(node, component);
+    node = child->get();
+  }
+
+  auto& ids = node->subscribers;
+  ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+
+  // Prune the nodes that no longer lead to any subscriber.
+  while (!parents.empty() && node->subscribers.empty() &&
+         node->children.empty()) {
+    auto [parent, component] = parents.back();
+    parents.pop_back();
+    parent->children.erase(component);
+    node = parent;
+  }
+}
+
+void Journal::FilterTrie::collect(
+    RelativePathPiece path,
+    std::vector<SubscriberId>& out) const {
+  auto* node = this;
+  out.insert(out.end(), node->subscribers.begin(), node->subscribers.end());
+  for (auto component : path.components()) {
+    auto* child = folly::get_ptr(node->children, component);
+    if (!child) {
+      return;
+    }
+    node = child->get();
+    out.insert(out.end(), node->subscribers.begin(), node->subscribers.end());
+  }
+}
+
+void Journal::notifySubscribers(
+    bool notifyUnfiltered,
+    const ChangedPaths& changedPaths,
+    uint64_t observationCount) {
+  bool notifyFiltered = filteredSubscriberCount_.load() > 0 &&
+      (!changedPaths || !changedPaths->empty());
+  if (!notifyUnfiltered && !notifyFiltered) {
+    return;
+  }
+
+  std::vector<SubscriberCallback> callbacks;
+  {
+    auto subscriberState = subscriberState_.wlock();
+    auto& subscribers = subscriberState->subscribers;
+    if (notifyUnfiltered) {
+      for (auto& entry : subscribers) {
+        if (entry.second.filter.matchesEverything()) {
+          callbacks.push_back(entry.second.callback);
+        }
+      }
+    }
+
+    if (notifyFiltered) {
+      std::vector<SubscriberId> candidates;
+      if (changedPaths) {
+        for (const auto& path : *changedPaths) {
+          subscriberState->filteredSubscribers.collect(path, candidates);
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(
+            std::unique(candidates.begin(), candidates.end()),
+            candidates.end());
+      } else {
+        for (auto& entry : subscribers) {
+          if (!entry.second.filter.matchesEverything()) {
+            candidates.push_back(entry.first);
+          }
+        }
+      }
+
+      for (auto id : candidates) {
+        auto& subscriber = subscribers.at(id);
+        if (subscriber.lastNotification &&
+            *subscriber.lastNotification >= observationCount) {
+          continue;
+        }
+        // The trie only narrowed the candidates down to the subscribers whose
+        // roots contain a changed path; the filter has the final say.
+        if (changedPaths &&
+            std::none_of(
+                changedPaths->begin(),
+                changedPaths->end(),
+                [&](const RelativePath& path) {
+                  return subscriber.filter.matches(path);
+                })) {
+          continue;
+        }
+        subscriber.lastNotification = observationCount;
+        callbacks.push_back(subscriber.callback);
+      }
+    }
+  }
+
+  for (auto& callback : callbacks) {
+    callback();
   }
 }
 
-void Journal::addDelta(FileChangeJournalDelta&& delta) {
+void Journal::addDelta(
+    folly::FunctionRef<FileChangeJournalDelta(JournalPathTable&)> makeDelta) {
   bool shouldNotify;
+  ChangedPaths changedPaths{std::in_place};
+  uint64_t observationCount;
   {
+    // Paths may only be interned while holding the lock.
     auto deltaState = deltaState_.lock();
+    auto delta = makeDelta(deltaState->paths);
+    if (filteredSubscriberCount_.load() > 0) {
+      changedPaths->push_back(delta.path1.path());
+      if (delta.path2) {
+        changedPaths->push_back(delta.path2.path());
+      }
+    }
+    observationCount = deltaState->observationCount;
     shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
   }
-  if (shouldNotify) {
-    notifySubscribers();
-  }
+  notifySubscribers(shouldNotify, changedPaths, observationCount);
 }
 
-void Journal::addDelta(HashUpdateJournalDelta&& delta, const Hash& newHash) {
+void Journal::addDelta(
+    HashUpdateJournalDelta&& delta,
+    const Hash& newHash,
+    const std::unordered_set<RelativePath>& uncleanPaths) {
   bool shouldNotify;
+  uint64_t observationCount;
   {
     auto deltaState = deltaState_.lock();
 
+    delta.uncleanPaths.reserve(uncleanPaths.size());
+    for (const auto& path : uncleanPaths) {
+      delta.uncleanPaths.push_back(deltaState->paths.intern(path));
+    }
+
     // If the hashes were not set to anything, default to copying
     // the value from the prior journal entry
     if (delta.fromHash == kZeroHash) {
       delta.fromHash = deltaState->currentHash;
     }
+    observationCount = deltaState->observationCount;
     shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
     deltaState->currentHash = newHash;
   }
-  if (shouldNotify) {
-    notifySubscribers();
-  }
+  // Every filtered subscriber is interested in a change of the commit.
+  notifySubscribers(shouldNotify, std::nullopt, observationCount);
 }
 
 std::optional<JournalDeltaInfo> Journal::getLatest() {
   auto deltaState = deltaState_.lock();
   deltaState->lastModificationHasBeenObserved = true;
+  ++deltaState->observationCount;
   if (deltaState->empty()) {
     return std::nullopt;
   } else {
@@ -273,10 +426,19 @@ std::optional<JournalDeltaInfo> Journal::getLatest() {
   }
 }
 
-uint64_t Journal::registerSubscriber(SubscriberCallback&& callback) {
+uint64_t Journal::registerSubscriber(
+    SubscriberCallback&& callback,
+    JournalPathFilter filter) {
   auto subscriberState = subscriberState_.wlock();
   auto id = subscriberState->nextSubscriberId++;
-  subscriberState->subscribers[id] = std::move(callback);
+  if (!filter.matchesEverything()) {
+    for (auto root : filter.getRoots()) {
+      subscriberState->filteredSubscribers.insert(root, id);
+    }
+    ++filteredSubscriberCount_;
+  }
+  subscriberState->subscribers[id] =
+      Subscriber{std::move(callback), std::move(filter), std::nullopt};
   return id;
 }
 
@@ -287,8 +449,14 @@ void Journal::cancelSubscriber(uint64_t id) {
     return;
   }
   // Extend the lifetime of the value we're removing
-  auto callback = std::move(it->second);
+  auto subscriber = std::move(it->second);
   subscriberState->subscribers.erase(it);
+  if (!subscriber.filter.matchesEverything()) {
+    for (auto root : subscriber.filter.getRoots()) {
+      subscriberState->filteredSubscribers.remove(root, id);
+    }
+    --filteredSubscriberCount_;
+  }
   // release the lock before we trigger the destructor
   subscriberState.unlock();
   // callback can now run its destructor outside the lock
@@ -298,8 +466,14 @@ void Journal::cancelAllSubscribers() {
   // Take care: some subscribers will attempt to call cancelSubscriber()
   // as part of their tear down, so we need to make sure that we aren't
   // holding the lock when we trigger that.
-  std::unordered_map<SubscriberId, SubscriberCallback> subscribers;
-  subscriberState_.wlock()->subscribers.swap(subscribers);
+  std::unordered_map<SubscriberId, Subscriber> subscribers;
+  {
+    auto subscriberState = subscriberState_.wlock();
+    subscriberState->subscribers.swap(subscribers);
+    subscriberState->filteredSubscribers.subscribers.clear();
+    subscriberState->filteredSubscribers.children.clear();
+    filteredSubscriberCount_ = 0;
+  }
   subscribers.clear();
 }
 
@@ -360,11 +534,13 @@ size_t Journal::estimateMemoryUsage(const DeltaState& deltaState) const {
   if (deltaState.stats) {
     memoryUsage += deltaState.deltaMemoryUsage;
   }
+  memoryUsage += deltaState.paths.estimateMemoryUsage();
   return memoryUsage;
 }
 
 void Journal::flush() {
   bool shouldNotify;
+  uint64_t observationCount;
   {
     auto deltaState = deltaState_.lock();
     ++deltaState->nextSequence;
@@ -381,15 +557,15 @@ void Journal::flush() {
      * flush operation.
      */
     delta.fromHash = lastHash;
+    observationCount = deltaState->observationCount;
     shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
   }
-  if (shouldNotify) {
-    notifySubscribers();
-  }
+  notifySubscribers(shouldNotify, std::nullopt, observationCount);
 }
 
 std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
-    SequenceNumber from) {
+    SequenceNumber from,
+    const JournalPathFilter& filter) {
   XDCHECK(from > 0);
   std::unique_ptr<JournalDeltaRange> result = nullptr;
 
@@ -419,6 +595,9 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
           for (auto& entry : current.getChangedFilesInOverlay()) {
             auto& name = entry.first;
             auto& currentInfo = entry.second;
+            if (!filter.matches(name)) {
+              continue;
+            }
             auto* resultInfo =
                 folly::get_ptr(result->changedFilesInOverlay, name);
             if (!resultInfo) {
@@ -448,8 +627,11 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
           result->snapshotTransitions.push_back(current.fromHash);
 
           // Merge the unclean status list
-          result->uncleanPaths.insert(
-              current.uncleanPaths.begin(), current.uncleanPaths.end());
+          for (const auto& path : current.uncleanPaths) {
+            if (filter.matches(path.path())) {
+              result->uncleanPaths.insert(path.path());
+            }
+          }
         });
   }
 
@@ -472,6 +654,7 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
   }
 
   deltaState->lastModificationHasBeenObserved = true;
+  ++deltaState->observationCount;
   return result;
 }
 
@@ -531,7 +714,7 @@ std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
         currentHash = current.fromHash;
 
         for (auto& path : current.uncleanPaths) {
-          delta.uncleanPaths_ref()->emplace(path.stringPiece().str());
+          delta.uncleanPaths_ref()->emplace(path.path().stringPiece().str());
         }
 
         result.push_back(delta);
@@ -9,15 +9,19 @@
 
 #include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <folly/function/FunctionRef.h>
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <unordered_map>
 #include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/journal/JournalPathFilter.h"
 #include "eden/fs/service/ThriftUtil.h"
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
 #include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/utils/PathMap.h"
 
 namespace facebook::eden {
 
@@ -120,9 +124,14 @@ class Journal {
    * The default limit value indicates that all deltas should be summed.
    *
    * If the limitSequence means that no deltas will match, returns nullptr.
+   *
+   * Only the changed and unclean paths that match the filter are returned.
+   * The sequence range and the snapshot transitions always cover every
+   * delta, so that the caller can use them as the basis of its next query.
    */
   std::unique_ptr<JournalDeltaRange> accumulateRange(
-      SequenceNumber limitSequence = 1);
+      SequenceNumber limitSequence = 1,
+      const JournalPathFilter& filter = JournalPathFilter{});
 
   // Subscription functionality:
 
@@ -139,10 +148,18 @@ class Journal {
    * modifications between subscriber notifications and calls to getLatest or
    * accumulateRange.
    *
+   * If a filter is given, the subscriber is only notified of file changes
+   * that match it, and of every change of the current commit.  Since the
+   * filter is evaluated against the changes of other subscribers too, a
+   * filtered subscriber isn't notified again until one of them is observed
+   * after its last notification.
+   *
    * The return value of registerSubscriber is an identifier than can be passed
    * to cancelSubscriber to later remove the registration.
    */
-  SubscriberId registerSubscriber(SubscriberCallback&& callback);
+  SubscriberId registerSubscriber(
+      SubscriberCallback&& callback,
+      JournalPathFilter filter = JournalPathFilter{});
   void cancelSubscriber(SubscriberId id);
 
   void cancelAllSubscribers();
@@ -182,8 +199,12 @@ class Journal {
    * The delta will have a new sequence number and timestamp
    * applied.
    */
-  void addDelta(FileChangeJournalDelta&& delta);
-  void addDelta(HashUpdateJournalDelta&& delta, const Hash& newHash);
+  void addDelta(
+      folly::FunctionRef<FileChangeJournalDelta(JournalPathTable&)> makeDelta);
+  void addDelta(
+      HashUpdateJournalDelta&& delta,
+      const Hash& newHash,
+      const std::unordered_set<RelativePath>& uncleanPaths);
 
   static constexpr size_t kDefaultJournalMemoryLimit = 1000000000;
 
@@ -193,6 +214,11 @@ class Journal {
      * the chain.
      */
     SequenceNumber nextSequence{1};
+    /**
+     * The paths referenced by the deltas below.  This must be declared before
+     * the deltas so that it outlives them.
+     */
+    JournalPathTable paths;
     /**
      * All recorded entries. Newer (more recent) deltas are added to the back of
      * the appropriate deque.
@@ -210,6 +236,11 @@ class Journal {
     // If true before calling addDelta, subscribers are notified.
     bool lastModificationHasBeenObserved = true;
 
+    // Incremented when getLatest() or accumulateRange() are called.
+    // Filtered subscribers are notified again only once this has changed
+    // since their last notification.
+    uint64_t observationCount = 0;
+
     JournalDeltaPtr frontPtr() noexcept;
     void popFront();
     JournalDeltaPtr backPtr() noexcept;
@@ -247,11 +278,47 @@ class Journal {
   bool compact(FileChangeJournalDelta& delta, DeltaState& deltaState);
   bool compact(HashUpdateJournalDelta& delta, DeltaState& deltaState);
 
+  struct Subscriber {
+    SubscriberCallback callback;
+    JournalPathFilter filter;
+    /**
+     * The observationCount of the DeltaState when this filtered subscriber
+     * was last notified, or std::nullopt if it never was.
+     */
+    std::optional<uint64_t> lastNotification;
+  };
+
+  /**
+   * Indexes the filtered subscribers by the roots of their filters, so that
+   * finding the subscribers interested in a change only walks the components
+   * of the changed path instead of evaluating every filter.
+   */
+  struct FilterTrie {
+    std::vector<SubscriberId> subscribers;
+    PathMap<std::unique_ptr<FilterTrie>> children{kPathMapCaseSensitive};
+
+    void insert(RelativePathPiece root, SubscriberId id);
+    void remove(RelativePathPiece root, SubscriberId id);
+
+    /**
+     * Adds the subscribers whose roots are the path or one of its parents.
+     */
+    void collect(RelativePathPiece path, std::vector<SubscriberId>& out) const;
+  };
+
   struct SubscriberState {
     SubscriberId nextSubscriberId{1};
-    std::unordered_map<SubscriberId, SubscriberCallback> subscribers;
+    std::unordered_map<SubscriberId, Subscriber> subscribers;
+    FilterTrie filteredSubscribers;
   };
 
+  /**
+   * The file changes of a delta, copied out of the DeltaState when there are
+   * filtered subscribers.  A std::nullopt means that every filtered
+   * subscriber is interested, such as when the current commit changed.
+   */
+  using ChangedPaths = std::optional<std::vector<RelativePath>>;
+
   /**
    * Add a delta to the journal without notifying subscribers.
    * The delta will have a new sequence number and timestamp
@@ -266,8 +333,15 @@ class Journal {
   /**
    * Notify subscribers that a change has happened. Must not be called while
    * Journal locks are held.
+   *
+   * Unfiltered subscribers are only notified if notifyUnfiltered is set,
+   * filtered ones if the change matches their filter and the journal was
+   * observed since their last notification.
    */
-  void notifySubscribers() const;
+  void notifySubscribers(
+      bool notifyUnfiltered,
+      const ChangedPaths& changedPaths,
+      uint64_t observationCount);
 
   size_t estimateMemoryUsage(const DeltaState& deltaState) const;
 
@@ -286,6 +360,12 @@ class Journal {
 
   folly::Synchronized<SubscriberState> subscriberState_;
 
+  /**
+   * The number of subscribers with a filter, so that deltas only copy their
+   * paths out of the DeltaState when somebody needs them.
+   */
+  std::atomic<size_t> filteredSubscriberCount_{0};
+
   std::shared_ptr<EdenStats> edenStats_;
 };
 } // namespace facebook::eden
@@ -7,119 +7,79 @@
 
 #include "JournalDelta.h"
 #include <folly/logging/xlog.h>
+#include <folly/memory/Malloc.h>
 
 namespace facebook {
 namespace eden {
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
+    JournalPath fileName,
     FileChangeJournalDelta::Created)
-    : path1{fileName.copy()},
-      info1{PathChangeInfo{false, true}},
-      isPath1Valid{true} {}
+    : path1{std::move(fileName)}, info1{PathChangeInfo{false, true}} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
+    JournalPath fileName,
     FileChangeJournalDelta::Removed)
-    : path1{fileName.copy()},
-      info1{PathChangeInfo{true, false}},
-      isPath1Valid{true} {}
+    : path1{std::move(fileName)}, info1{PathChangeInfo{true, false}} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece fileName,
+    JournalPath fileName,
     FileChangeJournalDelta::Changed)
-    : path1{fileName.copy()},
-      info1{PathChangeInfo{true, true}},
-      isPath1Valid{true} {}
+    : path1{std::move(fileName)}, info1{PathChangeInfo{true, true}} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece oldName,
-    RelativePathPiece newName,
+    JournalPath oldName,
+    JournalPath newName,
     FileChangeJournalDelta::Renamed)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
+    : path1{std::move(oldName)},
+      path2{std::move(newName)},
       info1{PathChangeInfo{true, false}},
-      info2{PathChangeInfo{false, true}},
-      isPath1Valid{true},
-      isPath2Valid{true} {}
+      info2{PathChangeInfo{false, true}} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
-    RelativePathPiece oldName,
-    RelativePathPiece newName,
+    JournalPath oldName,
+    JournalPath newName,
     FileChangeJournalDelta::Replaced)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
+    : path1{std::move(oldName)},
+      path2{std::move(newName)},
       info1{PathChangeInfo{true, false}},
-      info2{PathChangeInfo{true, true}},
-      isPath1Valid{true},
-      isPath2Valid{true} {}
+      info2{PathChangeInfo{true, true}} {}
 
 size_t FileChangeJournalDelta::estimateMemoryUsage() const {
-  size_t mem = sizeof(FileChangeJournalDelta);
-
-  /* NOTE: The following code assumes an unordered_set is separated into an
-   * array of buckets, each one being a chain of nodes containing a next
-   * pointer, a key-value pair, and a stored hash
-   */
-  if (isPath1Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path1);
-  }
-  if (isPath2Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path2);
-  }
-
-  return mem;
+  // The paths themselves are accounted for by the JournalPathTable.
+  return sizeof(FileChangeJournalDelta);
 }
 
 size_t HashUpdateJournalDelta::estimateMemoryUsage() const {
   size_t mem = sizeof(HashUpdateJournalDelta);
-
-  /* NOTE: The following code assumes an unordered_set is separated into an
-   * array of buckets, each one being a chain of nodes containing a next
-   * pointer, a key-value pair, and a stored hash
-   */
-
-  // Calculate Memory For Nodes in Each Bucket (Pointer to element and next)
-  size_t set_elem_size = folly::goodMallocSize(
-      sizeof(void*) + sizeof(decltype(uncleanPaths)::value_type) +
-      sizeof(size_t));
-  for (unsigned long i = 0; i < uncleanPaths.bucket_count(); ++i) {
-    mem += set_elem_size * uncleanPaths.bucket_size(i);
+  if (!uncleanPaths.empty()) {
+    mem += folly::goodMallocSize(
+        sizeof(decltype(uncleanPaths)::value_type) * uncleanPaths.capacity());
   }
-
-  // Calculate Memory Usage of Bucket List
-  mem += folly::goodMallocSize(sizeof(void*) * uncleanPaths.bucket_count());
-
-  // Calculate Memory Usage used indirectly by elements
-  for (auto& path : uncleanPaths) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path);
-  }
-
   return mem;
 }
 
 std::unordered_map<RelativePath, PathChangeInfo>
 FileChangeJournalDelta::getChangedFilesInOverlay() const {
   std::unordered_map<RelativePath, PathChangeInfo> changedFilesInOverlay;
-  if (isPath1Valid) {
-    changedFilesInOverlay[path1] = info1;
+  if (path1) {
+    changedFilesInOverlay[path1.path()] = info1;
   }
-  if (isPath2Valid) {
-    changedFilesInOverlay[path2] = info2;
+  if (path2) {
+    changedFilesInOverlay[path2.path()] = info2;
   }
   return changedFilesInOverlay;
 }
 
 bool FileChangeJournalDelta::isModification() const {
-  return isPath1Valid && !isPath2Valid && info1.existedBefore &&
-      info1.existedAfter;
+  return path1 && !path2 && info1.existedBefore && info1.existedAfter;
 }
 
 bool FileChangeJournalDelta::isSameAction(
     const FileChangeJournalDelta& other) const {
-  return isPath1Valid == other.isPath1Valid && info1 == other.info1 &&
-      path1 == other.path1 && isPath2Valid == other.isPath2Valid &&
-      info2 == other.info2 && path2 == other.path2;
+  // Interned paths compare equal if and only if they are the same path.
+  return path1 == other.path1 && info1 == other.info1 &&
+      path2 == other.path2 && info2 == other.info2;
 }
 
 JournalDeltaPtr::JournalDeltaPtr(std::nullptr_t) {}
@@ -11,6 +11,8 @@
 #include <type_traits>
 #include <unordered_set>
 #include <variant>
+#include <vector>
+#include "eden/fs/journal/JournalPathTable.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -61,7 +63,12 @@ class JournalDelta {
   std::chrono::steady_clock::time_point time;
 };
 
-/** A delta that stores information about changed files */
+/**
+ * A delta that stores information about changed files.
+ *
+ * The paths are interned in the Journal's JournalPathTable, so a delta only
+ * holds a pointer per path.
+ */
 class FileChangeJournalDelta : public JournalDelta {
  public:
   enum Created { CREATED };
@@ -75,34 +82,26 @@ class FileChangeJournalDelta : public JournalDelta {
   FileChangeJournalDelta& operator=(FileChangeJournalDelta&&) = default;
   FileChangeJournalDelta(const FileChangeJournalDelta&) = delete;
   FileChangeJournalDelta& operator=(const FileChangeJournalDelta&) = delete;
-  FileChangeJournalDelta(RelativePathPiece fileName, Created);
-  FileChangeJournalDelta(RelativePathPiece fileName, Removed);
-  FileChangeJournalDelta(RelativePathPiece fileName, Changed);
+  FileChangeJournalDelta(JournalPath fileName, Created);
+  FileChangeJournalDelta(JournalPath fileName, Removed);
+  FileChangeJournalDelta(JournalPath fileName, Changed);
 
   /**
    * "Renamed" means that that newName was created as a result of the mv(1).
    */
-  FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
-      Renamed);
+  FileChangeJournalDelta(JournalPath oldName, JournalPath newName, Renamed);
 
   /**
    * "Replaced" means that that newName was overwritten by oldName as a result
    * of the mv(1).
    */
-  FileChangeJournalDelta(
-      RelativePathPiece oldName,
-      RelativePathPiece newName,
-      Replaced);
-
-  /** Which of these paths actually contain information */
-  RelativePath path1;
-  RelativePath path2;
+  FileChangeJournalDelta(JournalPath oldName, JournalPath newName, Replaced);
+
+  /** Only non-null paths actually contain information */
+  JournalPath path1;
+  JournalPath path2;
   PathChangeInfo info1;
   PathChangeInfo info2;
-  bool isPath1Valid = false;
-  bool isPath2Valid = false;
 
   std::unordered_map<RelativePath, PathChangeInfo> getChangedFilesInOverlay()
       const;
@@ -132,9 +131,9 @@ class HashUpdateJournalDelta : public JournalDelta {
    * a new snapshot from the snapshotable files in the overlay. */
   Hash fromHash;
 
-  /** The set of files that had differing status across a checkout or
+  /** The distinct files that had differing status across a checkout or
    * some other operation that changes the snapshot hash */
-  std::unordered_set<RelativePath> uncleanPaths;
+  std::vector<JournalPath> uncleanPaths;
 
   /** Get memory used (in bytes) by this Delta */
   size_t estimateMemoryUsage() const;
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalPathFilter.h"
+
+#include <folly/Format.h>
+#include <algorithm>
+
+namespace facebook {
+namespace eden {
+
+namespace {
+bool isLiteral(folly::StringPiece component) {
+  return component.find_first_of("*?[\\") == folly::StringPiece::npos;
+}
+
+/**
+ * Returns the longest directory that contains every path the glob can match.
+ */
+RelativePath getGlobRoot(folly::StringPiece glob) {
+  size_t rootEnd = 0;
+  size_t start = 0;
+  while (true) {
+    auto slash = glob.find('/', start);
+    if (slash == folly::StringPiece::npos ||
+        !isLiteral(glob.subpiece(start, slash - start))) {
+      break;
+    }
+    rootEnd = slash;
+    start = slash + 1;
+  }
+  return RelativePath{glob.subpiece(0, rootEnd)};
+}
+} // namespace
+
+JournalPathFilter::JournalPathFilter(
+    std::vector<RelativePath> prefixes,
+    const std::vector<std::string>& globs) {
+  bool matchesAll = std::any_of(
+      prefixes.begin(), prefixes.end(), [](const RelativePath& prefix) {
+        return prefix.empty();
+      });
+  if (matchesAll) {
+    return;
+  }
+  prefixes_ = std::move(prefixes);
+
+  globs_.reserve(globs.size());
+  for (const auto& glob : globs) {
+    auto matcher = GlobMatcher::create(glob, GlobOptions::DEFAULT);
+    if (matcher.hasError()) {
+      throw std::invalid_argument(folly::sformat(
+          "invalid journal filter glob `{}`: {}", glob, matcher.error()));
+    }
+    globs_.push_back(Glob{getGlobRoot(glob), std::move(matcher).value()});
+  }
+}
+
+bool JournalPathFilter::matches(RelativePathPiece path) const {
+  if (matchesEverything()) {
+    return true;
+  }
+  for (const auto& prefix : prefixes_) {
+    if (path == prefix || path.isSubDirOf(prefix)) {
+      return true;
+    }
+  }
+  for (const auto& glob : globs_) {
+    if (glob.matcher.match(path.stringPiece())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<RelativePathPiece> JournalPathFilter::getRoots() const {
+  if (matchesEverything()) {
+    return {RelativePathPiece{}};
+  }
+  std::vector<RelativePathPiece> roots;
+  roots.reserve(prefixes_.size() + globs_.size());
+  for (const auto& prefix : prefixes_) {
+    roots.push_back(prefix);
+  }
+  for (const auto& glob : globs_) {
+    roots.push_back(glob.root);
+  }
+  return roots;
+}
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "eden/fs/model/git/GlobMatcher.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook {
+namespace eden {
+
+/**
+ * Selects the changed paths that a journal subscriber or a delta query is
+ * interested in.
+ *
+ * A path matches if it is equal to or under one of the prefixes, or if it
+ * matches one of the globs.  A filter with neither prefixes nor globs matches
+ * every path.
+ */
+class JournalPathFilter {
+ public:
+  /** Create a filter that matches every path. */
+  JournalPathFilter() = default;
+
+  /**
+   * Throws std::invalid_argument if one of the globs can't be parsed.
+   */
+  JournalPathFilter(
+      std::vector<RelativePath> prefixes,
+      const std::vector<std::string>& globs);
+
+  bool matchesEverything() const {
+    return prefixes_.empty() && globs_.empty();
+  }
+
+  bool matches(RelativePathPiece path) const;
+
+  /**
+   * Returns directories that together contain every path the filter can
+   * match: the prefixes, and the leading literal directories of the globs.
+   *
+   * The Journal indexes subscribers by these, so that a change only needs to
+   * be checked against the filters whose roots are parents of the changed
+   * path.
+   */
+  std::vector<RelativePathPiece> getRoots() const;
+
+ private:
+  struct Glob {
+    RelativePath root;
+    GlobMatcher matcher;
+  };
+
+  std::vector<RelativePath> prefixes_;
+  std::vector<Glob> globs_;
+};
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalPathTable.h"
+
+#include <folly/logging/xlog.h>
+#include <folly/memory/Malloc.h>
+#include <memory>
+#include <utility>
+
+namespace facebook {
+namespace eden {
+
+struct JournalPath::Entry {
+  Entry(RelativePathPiece p, JournalPathTable* t)
+      : path{p.copy()}, table{t} {}
+
+  RelativePath path;
+  JournalPathTable* table;
+  size_t refCount{0};
+};
+
+size_t JournalPathTable::estimateEntryMemoryUsage(const RelativePath& path) {
+  /* NOTE: The following code assumes an unordered_map is separated into an
+   * array of buckets, each one being a chain of nodes containing a next
+   * pointer, a key-value pair, and a stored hash
+   */
+  size_t nodeSize = folly::goodMallocSize(
+      sizeof(void*) + sizeof(std::pair<RelativePathPiece, void*>) +
+      sizeof(size_t));
+  return nodeSize + folly::goodMallocSize(sizeof(JournalPath::Entry)) +
+      estimateIndirectMemoryUsage(path);
+}
+
+JournalPath::JournalPath(Entry* entry) noexcept : entry_{entry} {
+  ++entry_->refCount;
+}
+
+JournalPath::JournalPath(const JournalPath& other) noexcept
+    : entry_{other.entry_} {
+  if (entry_) {
+    ++entry_->refCount;
+  }
+}
+
+JournalPath::JournalPath(JournalPath&& other) noexcept
+    : entry_{std::exchange(other.entry_, nullptr)} {}
+
+JournalPath& JournalPath::operator=(const JournalPath& other) noexcept {
+  if (this != &other) {
+    reset();
+    entry_ = other.entry_;
+    if (entry_) {
+      ++entry_->refCount;
+    }
+  }
+  return *this;
+}
+
+JournalPath& JournalPath::operator=(JournalPath&& other) noexcept {
+  if (this != &other) {
+    reset();
+    entry_ = std::exchange(other.entry_, nullptr);
+  }
+  return *this;
+}
+
+JournalPath::~JournalPath() {
+  reset();
+}
+
+const RelativePath& JournalPath::path() const noexcept {
+  XDCHECK(entry_);
+  return entry_->path;
+}
+
+void JournalPath::reset() noexcept {
+  if (entry_) {
+    if (--entry_->refCount == 0) {
+      entry_->table->release(entry_);
+    }
+    entry_ = nullptr;
+  }
+}
+
+JournalPathTable::~JournalPathTable() {
+  // All deltas must have been destroyed before the table.
+  XDCHECK(entries_.empty()) << entries_.size() << " journal paths leaked";
+  for (auto& entry : entries_) {
+    delete entry.second;
+  }
+}
+
+JournalPath JournalPathTable::intern(RelativePathPiece path) {
+  auto it = entries_.find(path);
+  if (it != entries_.end()) {
+    return JournalPath{it->second};
+  }
+
+  auto entry = std::make_unique<JournalPath::Entry>(path, this);
+  entries_.emplace(entry->path.piece(), entry.get());
+  entryMemoryUsage_ += estimateEntryMemoryUsage(entry->path);
+  return JournalPath{entry.release()};
+}
+
+void JournalPathTable::release(JournalPath::Entry* entry) noexcept {
+  entryMemoryUsage_ -= estimateEntryMemoryUsage(entry->path);
+  entries_.erase(entry->path.piece());
+  delete entry;
+}
+
+size_t JournalPathTable::estimateMemoryUsage() const noexcept {
+  return entryMemoryUsage_ +
+      folly::goodMallocSize(sizeof(void*) * entries_.bucket_count());
+}
+
+} // namespace eden
+} // namespace facebook
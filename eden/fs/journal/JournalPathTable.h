@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook {
+namespace eden {
+
+class JournalPathTable;
+
+/**
+ * A reference to a path interned in a JournalPathTable.
+ *
+ * Journal deltas store JournalPaths rather than RelativePaths so that a file
+ * that is modified many times only has its name stored once, and each delta
+ * only pays for a pointer per path.  Two JournalPaths from the same table are
+ * equal if and only if they refer to the same path.
+ *
+ * JournalPath is not thread-safe: it must only be copied or destroyed while
+ * holding the lock that protects its JournalPathTable.
+ */
+class JournalPath {
+ public:
+  JournalPath() noexcept = default;
+  JournalPath(const JournalPath& other) noexcept;
+  JournalPath(JournalPath&& other) noexcept;
+  JournalPath& operator=(const JournalPath& other) noexcept;
+  JournalPath& operator=(JournalPath&& other) noexcept;
+  ~JournalPath();
+
+  explicit operator bool() const noexcept {
+    return entry_ != nullptr;
+  }
+
+  /**
+   * Get the interned path.  Must not be called on a null JournalPath.
+   */
+  const RelativePath& path() const noexcept;
+
+  bool operator==(const JournalPath& other) const noexcept {
+    return entry_ == other.entry_;
+  }
+  bool operator!=(const JournalPath& other) const noexcept {
+    return entry_ != other.entry_;
+  }
+
+ private:
+  friend class JournalPathTable;
+  struct Entry;
+
+  explicit JournalPath(Entry* entry) noexcept;
+  void reset() noexcept;
+
+  Entry* entry_{nullptr};
+};
+
+/**
+ * A refcounted table of the paths referenced by a Journal's deltas.
+ *
+ * Paths are removed from the table as soon as the last delta referring to
+ * them is truncated, so the table only ever holds the paths that are still
+ * part of the Journal's history.
+ */
+class JournalPathTable {
+ public:
+  JournalPathTable() = default;
+  ~JournalPathTable();
+
+  JournalPathTable(const JournalPathTable&) = delete;
+  JournalPathTable& operator=(const JournalPathTable&) = delete;
+  JournalPathTable(JournalPathTable&&) = delete;
+  JournalPathTable& operator=(JournalPathTable&&) = delete;
+
+  /**
+   * Return a reference to the interned copy of path, adding it to the table
+   * if necessary.
+   */
+  JournalPath intern(RelativePathPiece path);
+
+  /** The number of distinct paths in the table. */
+  size_t size() const noexcept {
+    return entries_.size();
+  }
+
+  /** Get memory used (in bytes) by the table and the paths it holds */
+  size_t estimateMemoryUsage() const noexcept;
+
+ private:
+  friend class JournalPath;
+
+  void release(JournalPath::Entry* entry) noexcept;
+
+  static size_t estimateEntryMemoryUsage(const RelativePath& path);
+
+  /**
+   * The interned paths, keyed by a piece referring to the path stored in the
+   * entry itself.
+   */
+  std::unordered_map<RelativePathPiece, JournalPath::Entry*> entries_;
+
+  /**
+   * Memory used by the entries and their paths, excluding the hash table's
+   * bucket array, which is computed on demand.
+   */
+  size_t entryMemoryUsage_{0};
+};
+
+} // namespace eden
+} // namespace facebook
@@ -13,6 +13,13 @@ using namespace facebook::eden;
 
 namespace {
 
+/** Build a long path whose final component is name. */
+RelativePath makeLongPath(folly::StringPiece name) {
+  auto dir = std::string(100, 'd');
+  return RelativePath{folly::to<std::string>(
+      dir, "/", dir, "/", dir, "/", dir, "/", dir, "/", name)};
+}
+
 struct JournalTest : ::testing::Test {
   std::shared_ptr<EdenStats> edenStats{std::make_shared<EdenStats>()};
   Journal journal{edenStats};
@@ -397,6 +404,36 @@ TEST_F(JournalTest, memory_usage) {
   }
 }
 
+TEST_F(JournalTest, repeated_paths_are_stored_once) {
+  auto path = makeLongPath("file.txt");
+  uint64_t initialMem = journal.estimateMemoryUsage();
+  journal.recordCreated(path);
+  uint64_t firstMem = journal.estimateMemoryUsage();
+  EXPECT_GT(firstMem - initialMem, 500);
+
+  for (int i = 0; i < 10; i++) {
+    journal.recordRemoved(path);
+    journal.recordCreated(path);
+  }
+  ASSERT_EQ(21, journal.getStats()->entryCount);
+  // Every delta after the first only references the interned path.
+  uint64_t repeatedMem = journal.estimateMemoryUsage();
+  EXPECT_LT((repeatedMem - firstMem) / 20, 500);
+}
+
+TEST_F(JournalTest, truncation_releases_paths) {
+  journal.setMemoryLimit(0);
+  journal.recordCreated(makeLongPath("file.txt"));
+  uint64_t firstMem = journal.estimateMemoryUsage();
+  for (int i = 0; i < 100; i++) {
+    journal.recordCreated(makeLongPath(folly::to<std::string>("file", i)));
+  }
+  // Only the most recent delta is remembered, so only its path should be
+  // accounted for.
+  ASSERT_EQ(1, journal.getStats()->entryCount);
+  EXPECT_LT(journal.estimateMemoryUsage(), firstMem + 100);
+}
+
 TEST_F(JournalTest, set_get_memory_limit) {
   journal.setMemoryLimit(500);
   ASSERT_EQ(500, journal.getMemoryLimit());
@@ -603,3 +640,84 @@ TEST_F(JournalTest, all_subscribers_are_notified_after_any_observation) {
   EXPECT_EQ(2u, calls1);
   EXPECT_EQ(2u, calls2);
 }
+
+TEST_F(JournalTest, filtered_subscribers_are_notified_of_matching_changes) {
+  unsigned calls = 0;
+  auto sub = journal.registerSubscriber(
+      [&] { ++calls; }, JournalPathFilter{{RelativePath{"src/x"}}, {}});
+
+  journal.recordChanged("src/y/a"_relpath);
+  journal.recordChanged("src/xy"_relpath);
+  EXPECT_EQ(0u, calls);
+
+  journal.recordChanged("src/x/a"_relpath);
+  EXPECT_EQ(1u, calls);
+  journal.getLatest();
+  journal.recordCreated("src/x"_relpath);
+  EXPECT_EQ(2u, calls);
+  journal.getLatest();
+  journal.recordRenamed("other/a"_relpath, "src/x/b"_relpath);
+  EXPECT_EQ(3u, calls);
+
+  // Changing the commit may change any path.
+  journal.getLatest();
+  journal.recordHashUpdate(Hash("1111111111111111111111111111111111111111"));
+  EXPECT_EQ(4u, calls);
+
+  journal.getLatest();
+  journal.cancelSubscriber(sub);
+  journal.recordChanged("src/x/a"_relpath);
+  EXPECT_EQ(4u, calls);
+}
+
+TEST_F(JournalTest, filtered_subscribers_are_notified_once_until_observed) {
+  unsigned filteredCalls = 0;
+  unsigned calls = 0;
+  auto sub1 = journal.registerSubscriber(
+      [&] { ++filteredCalls; },
+      JournalPathFilter{{RelativePath{"src"}}, {"lib/**/*.cpp"}});
+  (void)sub1;
+  auto sub2 = journal.registerSubscriber([&] { ++calls; });
+  (void)sub2;
+
+  journal.recordChanged("lib/a/b.h"_relpath);
+  EXPECT_EQ(0u, filteredCalls);
+  EXPECT_EQ(1u, calls);
+
+  journal.recordChanged("lib/a/b.cpp"_relpath);
+  journal.recordChanged("src/c"_relpath);
+  EXPECT_EQ(1u, filteredCalls);
+  EXPECT_EQ(1u, calls);
+
+  journal.accumulateRange();
+  journal.recordChanged("src/d"_relpath);
+  EXPECT_EQ(2u, filteredCalls);
+  EXPECT_EQ(2u, calls);
+}
+
+TEST_F(JournalTest, accumulate_range_with_filter) {
+  journal.recordCreated("a/1"_relpath);
+  journal.recordCreated("b/1"_relpath);
+  journal.recordChanged("a/2"_relpath);
+  journal.recordUncleanPaths(
+      Hash("1111111111111111111111111111111111111111"),
+      Hash("2222222222222222222222222222222222222222"),
+      {RelativePath{"a/3"}, RelativePath{"b/3"}});
+  journal.recordChanged("b/2"_relpath);
+
+  auto summed =
+      journal.accumulateRange(1, JournalPathFilter{{RelativePath{"a"}}, {}});
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(1, summed->fromSequence);
+  EXPECT_EQ(5, summed->toSequence);
+  EXPECT_EQ(2, summed->snapshotTransitions.size());
+  EXPECT_EQ(2, summed->changedFilesInOverlay.size());
+  EXPECT_TRUE(summed->changedFilesInOverlay[RelativePath{"a/1"}].isNew());
+  EXPECT_FALSE(summed->changedFilesInOverlay[RelativePath{"a/2"}].isNew());
+  EXPECT_EQ(1, summed->uncleanPaths.size());
+  EXPECT_EQ(1, summed->uncleanPaths.count(RelativePath{"a/3"}));
+}
+
+TEST_F(JournalTest, invalid_filter_globs_are_rejected) {
+  EXPECT_THROW(JournalPathFilter({}, {"src/foo**bar"}), std::invalid_argument);
+}
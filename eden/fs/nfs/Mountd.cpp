@@ -50,12 +50,14 @@ class MountdServerProcessor final : public RpcServerProcessor {
   folly::Future<folly::Unit>
   exprt(folly::io::Cursor deser, folly::io::Appender ser, uint32_t xid);
 
-  void registerMount(AbsolutePathPiece path, InodeNumber rootIno);
+  void registerMount(
+      AbsolutePathPiece path,
+      InodeNumber rootIno,
+      uint64_t generation);
   void unregisterMount(AbsolutePathPiece path);
 
  private:
-  folly::Synchronized<std::unordered_map<AbsolutePath, InodeNumber>>
-      mountPoints_;
+  folly::Synchronized<std::unordered_map<AbsolutePath, nfs_fh3>> mountPoints_;
 };
 
 namespace {
@@ -116,7 +118,7 @@ folly::Future<folly::Unit> MountdServerProcessor::mount(
   if (found != mounts->end()) {
     XdrTrait<mountstat3>::serialize(ser, mountstat3::MNT3_OK);
     XdrTrait<mountres3_ok>::serialize(
-        ser, mountres3_ok{{found->second}, {auth_flavor::AUTH_UNIX}});
+        ser, mountres3_ok{found->second, {auth_flavor::AUTH_UNIX}});
   } else {
     XdrTrait<mountstat3>::serialize(ser, mountstat3::MNT3ERR_NOENT);
   }
@@ -198,9 +200,12 @@ folly::Future<folly::Unit> MountdServerProcessor::dispatchRpc(
 
 void MountdServerProcessor::registerMount(
     AbsolutePathPiece path,
-    InodeNumber ino) {
+    InodeNumber ino,
+    uint64_t generation) {
   auto map = mountPoints_.wlock();
-  auto [iter, inserted] = map->emplace(path.copy(), ino);
+  // The root inode is its own parent.
+  auto [iter, inserted] =
+      map->emplace(path.copy(), nfs_fh3{ino, ino, generation});
   XCHECK_EQ(inserted, true);
 }
 
@@ -217,8 +222,11 @@ Mountd::Mountd(bool registerWithRpcbind, folly::EventBase* evb)
   }
 }
 
-void Mountd::registerMount(AbsolutePathPiece path, InodeNumber ino) {
-  proc_->registerMount(path, ino);
+void Mountd::registerMount(
+    AbsolutePathPiece path,
+    InodeNumber ino,
+    uint64_t generation) {
+  proc_->registerMount(path, ino, generation);
 }
 
 void Mountd::unregisterMount(AbsolutePathPiece path) {
@@ -44,9 +44,13 @@ class Mountd {
    * Register a path as the root of a mount point.
    *
    * Once registered, the mount RPC request for that specific path will answer
-   * positively with the passed in InodeNumber.
+   * positively with a file handle for the passed in InodeNumber, tagged with
+   * the mount generation.
    */
-  void registerMount(AbsolutePathPiece path, InodeNumber rootIno);
+  void registerMount(
+      AbsolutePathPiece path,
+      InodeNumber rootIno,
+      uint64_t generation);
 
   /**
    * Unregister the mount point matching the path.
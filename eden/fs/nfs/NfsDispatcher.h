@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/Unit.h>
+#include <sys/stat.h>
+#include <optional>
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/utils/BufVec.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace folly {
+template <class T>
+class Future;
+} // namespace folly
+
+namespace facebook::eden {
+
+class EdenStats;
+struct nfs_fh3;
+
+/**
+ * Interface between the NFSv3 protocol implementation in Nfsd3 and the inode
+ * layer.
+ *
+ * Files are identified by the file handle sent by the client rather than by
+ * InodeNumber, as the inode number alone may no longer be known to the
+ * InodeMap, see nfs_fh3.
+ */
+class NfsDispatcher {
+ public:
+  NfsDispatcher(EdenStats* stats, uint64_t mountGeneration)
+      : stats_(stats), mountGeneration_(mountGeneration) {}
+  virtual ~NfsDispatcher() {}
+
+  EdenStats* getStats() const {
+    return stats_;
+  }
+
+  /**
+   * Generation of the mount, to be stored in the file handles handed out to
+   * the client.
+   */
+  uint64_t getMountGeneration() const {
+    return mountGeneration_;
+  }
+
+  /**
+   * Return value of the write method.
+   */
+  struct WriteRes {
+    /** Number of bytes written. */
+    size_t written;
+    /** Attributes of the file after the write, if available. */
+    std::optional<struct stat> postStat;
+  };
+
+  /**
+   * Write data at offset to the file. The data is not required to be on
+   * stable storage when the returned future completes, see commit.
+   */
+  virtual folly::Future<WriteRes>
+  write(const nfs_fh3& file, BufVec data, off_t offset) = 0;
+
+  /**
+   * Return value of the create and mkdir methods.
+   */
+  struct CreateRes {
+    InodeNumber ino;
+    struct stat stat;
+  };
+
+  /**
+   * What create does when name already exists, see createmode3 in RFC 1813.
+   */
+  enum class CreateMode {
+    /**
+     * Return the existing regular file, truncated to truncateTo if it is set.
+     */
+    Unchecked,
+    /**
+     * Fail with EEXIST.
+     */
+    Guarded,
+    /**
+     * Return the existing regular file if it was created by a request with
+     * the same verifier, so that a retransmitted request succeeds, and fail
+     * with EEXIST otherwise. The verifier is stored in the file's atime and
+     * mtime until the client sets them.
+     */
+    Exclusive,
+  };
+
+  struct CreateArgs {
+    CreateMode how{CreateMode::Guarded};
+    mode_t mode{0644};
+    /** Only used by CreateMode::Unchecked. */
+    std::optional<uint64_t> truncateTo;
+    /** Only used by CreateMode::Exclusive. */
+    uint64_t verifier{0};
+  };
+
+  /**
+   * Create a regular file named name in the directory dir.
+   */
+  virtual folly::Future<CreateRes>
+  create(const nfs_fh3& dir, PathComponent name, CreateArgs args) = 0;
+
+  /**
+   * Create a directory named name in the directory dir.
+   */
+  virtual folly::Future<CreateRes>
+  mkdir(const nfs_fh3& dir, PathComponent name, mode_t mode) = 0;
+
+  /**
+   * Remove the non-directory named name from the directory dir.
+   *
+   * Returns the number of the removed inode if it no longer has any name.
+   */
+  virtual folly::Future<std::optional<InodeNumber>> unlink(
+      const nfs_fh3& dir,
+      PathComponent name) = 0;
+
+  /**
+   * Move fromName in fromDir to toName in toDir, replacing toName if it
+   * exists.
+   *
+   * Returns the number of the replaced inode if it no longer has any name.
+   */
+  virtual folly::Future<std::optional<InodeNumber>> rename(
+      const nfs_fh3& fromDir,
+      PathComponent fromName,
+      const nfs_fh3& toDir,
+      PathComponent toName) = 0;
+
+  /**
+   * Make the data previously written to the file durable, along with the
+   * metadata needed to read it back, such as its size. All of the file's
+   * metadata, including its timestamps, is flushed unless datasync is true.
+   */
+  virtual folly::Future<folly::Unit> commit(
+      const nfs_fh3& file,
+      bool datasync) = 0;
+
+ private:
+  EdenStats* stats_{nullptr};
+  uint64_t mountGeneration_{0};
+};
+
+} // namespace facebook::eden
+
+#endif
@@ -8,6 +8,7 @@
 #ifndef _WIN32
 
 #include "eden/fs/nfs/NfsServer.h"
+#include "eden/fs/nfs/NfsDispatcher.h"
 #include "eden/fs/nfs/Nfsd3.h"
 
 namespace facebook::eden {
@@ -15,20 +16,21 @@ namespace facebook::eden {
 NfsServer::NfsMountInfo NfsServer::registerMount(
     AbsolutePathPiece path,
     InodeNumber rootIno,
-    Dispatcher* const dispatcher,
+    std::unique_ptr<NfsDispatcher> dispatcher,
     const folly::Logger* straceLogger,
     std::shared_ptr<ProcessNameCache> processNameCache,
     folly::Duration requestTimeout,
     Notifications* notifications) {
+  auto generation = dispatcher->getMountGeneration();
   auto nfsd = std::make_unique<Nfsd3>(
       false,
       evb_,
-      dispatcher,
+      std::move(dispatcher),
       straceLogger,
       std::move(processNameCache),
       requestTimeout,
       notifications);
-  mountd_.registerMount(path, rootIno);
+  mountd_.registerMount(path, rootIno, generation);
 
   auto nfsdPort = nfsd->getPort();
   return {std::move(nfsd), mountd_.getPort(), nfsdPort};
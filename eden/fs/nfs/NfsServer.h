@@ -15,7 +15,7 @@
 
 namespace facebook::eden {
 
-class Dispatcher;
+class NfsDispatcher;
 class Notifications;
 class ProcessNameCache;
 
@@ -57,7 +57,7 @@ class NfsServer {
   NfsServer::NfsMountInfo registerMount(
       AbsolutePathPiece path,
       InodeNumber rootIno,
-      Dispatcher* const dispatcher,
+      std::unique_ptr<NfsDispatcher> dispatcher,
       const folly::Logger* straceLogger,
       std::shared_ptr<ProcessNameCache> processNameCache,
       folly::Duration requestTimeout,
@@ -9,17 +9,159 @@
 
 #include "eden/fs/nfs/Nfsd3.h"
 
+#include <unordered_map>
+
+#include <folly/Random.h>
+#include <folly/Synchronized.h>
 #include <folly/Utility.h>
 #include <folly/futures/Future.h>
+#include "eden/fs/nfs/NfsDispatcher.h"
 #include "eden/fs/nfs/NfsdRpc.h"
+#include "eden/fs/utils/StatTimes.h"
+#include "eden/fs/utils/SystemError.h"
 
 namespace facebook::eden {
 
 namespace {
+
+/**
+ * Return the write verifier of this process.
+ *
+ * Data written with UNSTABLE stability is only guaranteed to be durable once
+ * a COMMIT for it succeeded. Clients compare the verifier returned by WRITE
+ * and COMMIT, and a mismatch tells them that EdenFS restarted in between and
+ * that the uncommitted data must be written again.
+ */
+writeverf3 getWriteVerifier() {
+  static const writeverf3 verifier = folly::Random::secureRand64();
+  return verifier;
+}
+
+nfstime3 timespecToNfsTime(const struct timespec& time) {
+  return nfstime3{
+      static_cast<uint32_t>(time.tv_sec), static_cast<uint32_t>(time.tv_nsec)};
+}
+
+ftype3 modeToFtype3(mode_t mode) {
+  if (S_ISREG(mode)) {
+    return ftype3::NF3REG;
+  } else if (S_ISDIR(mode)) {
+    return ftype3::NF3DIR;
+  } else if (S_ISLNK(mode)) {
+    return ftype3::NF3LNK;
+  } else if (S_ISBLK(mode)) {
+    return ftype3::NF3BLK;
+  } else if (S_ISCHR(mode)) {
+    return ftype3::NF3CHR;
+  } else if (S_ISSOCK(mode)) {
+    return ftype3::NF3SOCK;
+  } else {
+    return ftype3::NF3FIFO;
+  }
+}
+
+fattr3 statToFattr3(const struct stat& st) {
+  return fattr3{
+      /*type*/ modeToFtype3(st.st_mode),
+      /*mode*/ static_cast<uint32_t>(st.st_mode & 07777),
+      /*nlink*/ static_cast<uint32_t>(st.st_nlink),
+      /*uid*/ st.st_uid,
+      /*gid*/ st.st_gid,
+      /*size*/ static_cast<uint64_t>(st.st_size),
+      /*used*/ static_cast<uint64_t>(st.st_blocks) * 512,
+      /*rdev*/ specdata3{0, 0},
+      /*fsid*/ static_cast<uint64_t>(st.st_dev),
+      /*fileid*/ st.st_ino,
+      /*atime*/ timespecToNfsTime(stAtime(st)),
+      /*mtime*/ timespecToNfsTime(stMtime(st)),
+      /*ctime*/ timespecToNfsTime(stCtime(st)),
+  };
+}
+
+post_op_attr statToPostOpAttr(const std::optional<struct stat>& st) {
+  if (!st) {
+    return post_op_attr{};
+  }
+  return post_op_attr{{true, statToFattr3(*st)}};
+}
+
+/**
+ * Convert the exception that failed a request into an NFS error.
+ */
+nfsstat3 exceptionToNfsError(const folly::exception_wrapper& ex) {
+  if (auto* err = ex.get_exception<std::system_error>()) {
+    if (!isErrnoError(*err)) {
+      return nfsstat3::NFS3ERR_SERVERFAULT;
+    }
+    switch (err->code().value()) {
+      case EPERM:
+        return nfsstat3::NFS3ERR_PERM;
+      case ENOENT:
+        return nfsstat3::NFS3ERR_NOENT;
+      case EIO:
+      case ETXTBSY:
+        return nfsstat3::NFS3ERR_IO;
+      case ENXIO:
+        return nfsstat3::NFS3ERR_NXIO;
+      case EACCES:
+        return nfsstat3::NFS3ERR_ACCES;
+      case EEXIST:
+        return nfsstat3::NFS3ERR_EXIST;
+      case EXDEV:
+        return nfsstat3::NFS3ERR_XDEV;
+      case ENODEV:
+        return nfsstat3::NFS3ERR_NODEV;
+      case ENOTDIR:
+        return nfsstat3::NFS3ERR_NOTDIR;
+      case EISDIR:
+        return nfsstat3::NFS3ERR_ISDIR;
+      case EINVAL:
+        return nfsstat3::NFS3ERR_INVAL;
+      case EFBIG:
+        return nfsstat3::NFS3ERR_FBIG;
+      case ENOSPC:
+        return nfsstat3::NFS3ERR_NOSPC;
+      case EROFS:
+        return nfsstat3::NFS3ERR_ROFS;
+      case EMLINK:
+        return nfsstat3::NFS3ERR_MLINK;
+      case ENAMETOOLONG:
+        return nfsstat3::NFS3ERR_NAMETOOLONG;
+      case ENOTEMPTY:
+        return nfsstat3::NFS3ERR_NOTEMPTY;
+      case EDQUOT:
+        return nfsstat3::NFS3ERR_DQUOT;
+      case ENOSYS:
+        return nfsstat3::NFS3ERR_NOTSUPP;
+      default:
+        return nfsstat3::NFS3ERR_IO;
+    }
+  } else if (ex.get_exception<PathComponentValidationError>()) {
+    return nfsstat3::NFS3ERR_INVAL;
+  } else if (ex.get_exception<NfsBadHandleError>()) {
+    return nfsstat3::NFS3ERR_BADHANDLE;
+  } else {
+    return nfsstat3::NFS3ERR_SERVERFAULT;
+  }
+}
+
+/**
+ * Return the mode requested by the client, or defaultMode if it didn't set
+ * one.
+ */
+mode_t getRequestedMode(const sattr3& attr, mode_t defaultMode) {
+  if (attr.mode.tag) {
+    return std::get<uint32_t>(attr.mode.v);
+  }
+  return defaultMode;
+}
+
 class Nfsd3ServerProcessor final : public RpcServerProcessor {
  public:
-  explicit Nfsd3ServerProcessor(const folly::Logger* straceLogger)
-      : straceLogger_(straceLogger) {}
+  explicit Nfsd3ServerProcessor(
+      std::unique_ptr<NfsDispatcher> dispatcher,
+      const folly::Logger* straceLogger)
+      : dispatcher_(std::move(dispatcher)), straceLogger_(straceLogger) {}
 
   Nfsd3ServerProcessor(const Nfsd3ServerProcessor&) = delete;
   Nfsd3ServerProcessor(Nfsd3ServerProcessor&&) = delete;
@@ -80,9 +222,63 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
   commit(folly::io::Cursor deser, folly::io::Appender ser, uint32_t xid);
 
  private:
+  /**
+   * Range of a file written with UNSTABLE stability and not yet committed.
+   */
+  struct UnstableRange {
+    uint64_t begin;
+    uint64_t end;
+    /**
+     * Bumped on every UNSTABLE write to the file, including the ones that
+     * fall inside [begin, end), to tell whether the file was written to
+     * while a COMMIT was flushing it.
+     */
+    uint64_t sequence;
+  };
+
+  void recordUnstableWrite(InodeNumber ino, uint64_t offset, uint64_t length);
+
+  /**
+   * Forget the UNSTABLE writes to an inode that no longer has a name: NFS
+   * clients don't remove files that they still have open, so it won't be
+   * committed.
+   */
+  void forgetUnstableWrites(std::optional<InodeNumber> ino);
+
+  std::unique_ptr<NfsDispatcher> dispatcher_;
   const folly::Logger* straceLogger_;
+
+  /**
+   * Uncommitted UNSTABLE writes, used to skip the flush when a COMMIT covers
+   * nothing that was written with UNSTABLE stability. A single range per file
+   * is tracked: clients overwhelmingly write files sequentially.
+   */
+  folly::Synchronized<std::unordered_map<InodeNumber, UnstableRange>>
+      unstableWrites_;
 };
 
+void Nfsd3ServerProcessor::recordUnstableWrite(
+    InodeNumber ino,
+    uint64_t offset,
+    uint64_t length) {
+  auto writes = unstableWrites_.wlock();
+  auto [it, inserted] =
+      writes->try_emplace(ino, UnstableRange{offset, offset + length, 0});
+  if (!inserted) {
+    auto& range = it->second;
+    range.begin = std::min(range.begin, offset);
+    range.end = std::max(range.end, offset + length);
+    ++range.sequence;
+  }
+}
+
+void Nfsd3ServerProcessor::forgetUnstableWrites(
+    std::optional<InodeNumber> ino) {
+  if (ino) {
+    unstableWrites_.wlock()->erase(*ino);
+  }
+}
+
 folly::Future<folly::Unit> Nfsd3ServerProcessor::null(
     folly::io::Cursor /*deser*/,
     folly::io::Appender ser,
@@ -140,27 +336,149 @@ folly::Future<folly::Unit> Nfsd3ServerProcessor::read(
 }
 
 folly::Future<folly::Unit> Nfsd3ServerProcessor::write(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::Appender ser,
     uint32_t xid) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, xid);
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, xid);
+
+  auto args = XdrTrait<WRITE3args>::deserialize(deser);
+  auto file = args.file;
+  auto ino = file.ino;
+  auto offset = args.offset;
+  auto stable = args.stable;
+
+  return dispatcher_->write(file, std::move(args.data), offset)
+      .thenValue([this, file, ino, offset, stable](
+                     NfsDispatcher::WriteRes res) {
+        if (stable == stable_how::UNSTABLE) {
+          // Leave the data in the overlay file, a COMMIT will flush it.
+          recordUnstableWrite(ino, offset, res.written);
+          return folly::makeFuture(std::move(res));
+        }
+        // DATA_SYNC only needs the data and the metadata required to read it
+        // back, FILE_SYNC needs all of the file's metadata.
+        return dispatcher_
+            ->commit(file, /*datasync=*/stable == stable_how::DATA_SYNC)
+            .thenValue([res = std::move(res)](folly::Unit) mutable {
+              return std::move(res);
+            });
+      })
+      .thenTry([ser = std::move(ser), stable](
+                   folly::Try<NfsDispatcher::WriteRes> try_) mutable {
+        if (try_.hasException()) {
+          WRITE3res res{
+              {exceptionToNfsError(try_.exception()), WRITE3resfail{}}};
+          XdrTrait<WRITE3res>::serialize(ser, res);
+        } else {
+          const auto& writeRes = try_.value();
+          WRITE3res res{
+              {nfsstat3::NFS3_OK,
+               WRITE3resok{
+                   wcc_data{
+                       /*before*/ pre_op_attr{},
+                       /*after*/ statToPostOpAttr(writeRes.postStat),
+                   },
+                   static_cast<uint32_t>(writeRes.written),
+                   stable,
+                   getWriteVerifier(),
+               }}};
+          XdrTrait<WRITE3res>::serialize(ser, res);
+        }
+        return folly::unit;
+      });
 }
 
 folly::Future<folly::Unit> Nfsd3ServerProcessor::create(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::Appender ser,
     uint32_t xid) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, xid);
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, xid);
+
+  auto args = XdrTrait<CREATE3args>::deserialize(deser);
+
+  NfsDispatcher::CreateArgs createArgs;
+  switch (args.how.tag) {
+    case createmode3::UNCHECKED: {
+      createArgs.how = NfsDispatcher::CreateMode::Unchecked;
+      const auto& attr = std::get<sattr3>(args.how.v);
+      createArgs.mode = getRequestedMode(attr, createArgs.mode);
+      if (attr.size.tag) {
+        createArgs.truncateTo = std::get<uint64_t>(attr.size.v);
+      }
+      break;
+    }
+    case createmode3::GUARDED:
+      createArgs.how = NfsDispatcher::CreateMode::Guarded;
+      createArgs.mode =
+          getRequestedMode(std::get<sattr3>(args.how.v), createArgs.mode);
+      break;
+    case createmode3::EXCLUSIVE:
+      createArgs.how = NfsDispatcher::CreateMode::Exclusive;
+      createArgs.verifier = std::get<createverf3>(args.how.v);
+      break;
+  }
+
+  return folly::makeFutureWith([&] {
+           return dispatcher_->create(
+               args.where.dir, PathComponent{args.where.name}, createArgs);
+         })
+      .thenTry([ser = std::move(ser),
+                dir = args.where.dir.ino,
+                generation = dispatcher_->getMountGeneration()](
+                   folly::Try<NfsDispatcher::CreateRes> try_) mutable {
+        if (try_.hasException()) {
+          CREATE3res res{
+              {exceptionToNfsError(try_.exception()), CREATE3resfail{}}};
+          XdrTrait<CREATE3res>::serialize(ser, res);
+        } else {
+          const auto& createRes = try_.value();
+          CREATE3res res{
+              {nfsstat3::NFS3_OK,
+               CREATE3resok{
+                   post_op_fh3{{true, nfs_fh3{createRes.ino, dir, generation}}},
+                   statToPostOpAttr(createRes.stat),
+                   wcc_data{},
+               }}};
+          XdrTrait<CREATE3res>::serialize(ser, res);
+        }
+        return folly::unit;
+      });
 }
 
 folly::Future<folly::Unit> Nfsd3ServerProcessor::mkdir(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::Appender ser,
     uint32_t xid) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, xid);
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, xid);
+
+  auto args = XdrTrait<MKDIR3args>::deserialize(deser);
+  auto mode = getRequestedMode(args.attributes, 0755);
+
+  return folly::makeFutureWith([&] {
+           return dispatcher_->mkdir(
+               args.where.dir, PathComponent{args.where.name}, mode);
+         })
+      .thenTry([ser = std::move(ser),
+                dir = args.where.dir.ino,
+                generation = dispatcher_->getMountGeneration()](
+                   folly::Try<NfsDispatcher::CreateRes> try_) mutable {
+        if (try_.hasException()) {
+          MKDIR3res res{
+              {exceptionToNfsError(try_.exception()), MKDIR3resfail{}}};
+          XdrTrait<MKDIR3res>::serialize(ser, res);
+        } else {
+          const auto& mkdirRes = try_.value();
+          MKDIR3res res{
+              {nfsstat3::NFS3_OK,
+               MKDIR3resok{
+                   post_op_fh3{{true, nfs_fh3{mkdirRes.ino, dir, generation}}},
+                   statToPostOpAttr(mkdirRes.stat),
+                   wcc_data{},
+               }}};
+          XdrTrait<MKDIR3res>::serialize(ser, res);
+        }
+        return folly::unit;
+      });
 }
 
 folly::Future<folly::Unit> Nfsd3ServerProcessor::symlink(
@@ -180,11 +498,30 @@ folly::Future<folly::Unit> Nfsd3ServerProcessor::mknod(
 }
 
 folly::Future<folly::Unit> Nfsd3ServerProcessor::remove(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::Appender ser,
     uint32_t xid) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, xid);
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, xid);
+
+  auto args = XdrTrait<REMOVE3args>::deserialize(deser);
+
+  return folly::makeFutureWith([&] {
+           return dispatcher_->unlink(
+               args.object.dir, PathComponent{args.object.name});
+         })
+      .thenTry([this, ser = std::move(ser)](
+                   folly::Try<std::optional<InodeNumber>> try_) mutable {
+        if (try_.hasException()) {
+          REMOVE3res res{
+              {exceptionToNfsError(try_.exception()), REMOVE3resfail{}}};
+          XdrTrait<REMOVE3res>::serialize(ser, res);
+        } else {
+          forgetUnstableWrites(try_.value());
+          REMOVE3res res{{nfsstat3::NFS3_OK, REMOVE3resok{}}};
+          XdrTrait<REMOVE3res>::serialize(ser, res);
+        }
+        return folly::unit;
+      });
 }
 
 folly::Future<folly::Unit> Nfsd3ServerProcessor::rmdir(
@@ -196,11 +533,33 @@ folly::Future<folly::Unit> Nfsd3ServerProcessor::rmdir(
 }
 
 folly::Future<folly::Unit> Nfsd3ServerProcessor::rename(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::Appender ser,
     uint32_t xid) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, xid);
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, xid);
+
+  auto args = XdrTrait<RENAME3args>::deserialize(deser);
+
+  return folly::makeFutureWith([&] {
+           return dispatcher_->rename(
+               args.from.dir,
+               PathComponent{args.from.name},
+               args.to.dir,
+               PathComponent{args.to.name});
+         })
+      .thenTry([this, ser = std::move(ser)](
+                   folly::Try<std::optional<InodeNumber>> try_) mutable {
+        if (try_.hasException()) {
+          RENAME3res res{
+              {exceptionToNfsError(try_.exception()), RENAME3resfail{}}};
+          XdrTrait<RENAME3res>::serialize(ser, res);
+        } else {
+          forgetUnstableWrites(try_.value());
+          RENAME3res res{{nfsstat3::NFS3_OK, RENAME3resok{}}};
+          XdrTrait<RENAME3res>::serialize(ser, res);
+        }
+        return folly::unit;
+      });
 }
 
 folly::Future<folly::Unit> Nfsd3ServerProcessor::link(
@@ -296,11 +655,65 @@ folly::Future<folly::Unit> Nfsd3ServerProcessor::pathconf(
 }
 
 folly::Future<folly::Unit> Nfsd3ServerProcessor::commit(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::Appender ser,
     uint32_t xid) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, xid);
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, xid);
+
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+  auto ino = args.file.ino;
+  // A count of 0 means up to the end of the file.
+  uint64_t end = args.count == 0 ? std::numeric_limits<uint64_t>::max()
+                                 : args.offset + args.count;
+
+  // There is nothing to flush if no part of the requested range was written
+  // with UNSTABLE stability.
+  std::optional<UnstableRange> range;
+  {
+    auto writes = unstableWrites_.rlock();
+    auto it = writes->find(ino);
+    if (it != writes->end() && it->second.begin < end &&
+        args.offset < it->second.end) {
+      range = it->second;
+    }
+  }
+
+  auto serializeResult = [ser = std::move(ser)](
+                             folly::Try<folly::Unit> try_) mutable {
+    if (try_.hasException()) {
+      COMMIT3res res{
+          {exceptionToNfsError(try_.exception()), COMMIT3resfail{}}};
+      XdrTrait<COMMIT3res>::serialize(ser, res);
+    } else {
+      COMMIT3res res{
+          {nfsstat3::NFS3_OK, COMMIT3resok{wcc_data{}, getWriteVerifier()}}};
+      XdrTrait<COMMIT3res>::serialize(ser, res);
+    }
+    return folly::unit;
+  };
+
+  if (!range) {
+    return serializeResult(folly::Try<folly::Unit>{folly::unit});
+  }
+
+  // Like knfsd, flush the whole file along with its metadata: a write that
+  // fills a hole or extends the file is only durable once the file's block
+  // map and size are.
+  return dispatcher_->commit(args.file, /*datasync=*/false)
+      .thenTry([this, ino, range = *range](folly::Try<folly::Unit> try_) {
+        if (try_.hasValue()) {
+          // The whole file was flushed, forget the range unless it was written
+          // to in the meantime, even within the range: that write may have
+          // landed after the flush.
+          auto writes = unstableWrites_.wlock();
+          auto it = writes->find(ino);
+          if (it != writes->end() && it->second.sequence == range.sequence) {
+            writes->erase(it);
+          }
+        }
+        return folly::makeFuture(std::move(try_));
+      })
+      .thenTry(std::move(serializeResult));
 }
 
 using Handler = folly::Future<folly::Unit> (Nfsd3ServerProcessor::*)(
@@ -402,12 +815,16 @@ folly::Future<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
 Nfsd3::Nfsd3(
     bool registerWithRpcbind,
     folly::EventBase* evb,
-    Dispatcher* const /*dispatcher*/,
+    std::unique_ptr<NfsDispatcher> dispatcher,
     const folly::Logger* straceLogger,
     std::shared_ptr<ProcessNameCache> /*processNameCache*/,
     folly::Duration /*requestTimeout*/,
     Notifications* /*notifications*/)
-    : server_(std::make_shared<Nfsd3ServerProcessor>(straceLogger), evb) {
+    : server_(
+          std::make_shared<Nfsd3ServerProcessor>(
+              std::move(dispatcher),
+              straceLogger),
+          evb) {
   if (registerWithRpcbind) {
     server_.registerService(kNfsdProgNumber, kNfsd3ProgVersion);
   }
@@ -16,7 +16,7 @@
 
 namespace facebook::eden {
 
-class Dispatcher;
+class NfsDispatcher;
 class Notifications;
 class ProcessNameCache;
 
@@ -41,7 +41,7 @@ class Nfsd3 {
   Nfsd3(
       bool registerWithRpcbind,
       folly::EventBase* evb,
-      Dispatcher* const dispatcher,
+      std::unique_ptr<NfsDispatcher> dispatcher,
       const folly::Logger* straceLogger,
       std::shared_ptr<ProcessNameCache> processNameCache,
       folly::Duration requestTimeout,
@@ -27,6 +27,10 @@ EDEN_XDR_SERDE_IMPL(
     atime,
     mtime,
     ctime);
+EDEN_XDR_SERDE_IMPL(wcc_attr, size, mtime, ctime);
+EDEN_XDR_SERDE_IMPL(wcc_data, before, after);
+EDEN_XDR_SERDE_IMPL(sattr3, mode, uid, gid, size, atime, mtime);
+EDEN_XDR_SERDE_IMPL(diropargs3, dir, name);
 EDEN_XDR_SERDE_IMPL(
     FSINFO3resok,
     obj_attributes,
@@ -51,6 +55,23 @@ EDEN_XDR_SERDE_IMPL(
     case_insensitive,
     case_preserving);
 EDEN_XDR_SERDE_IMPL(PATHCONF3resfail, obj_attributes);
+EDEN_XDR_SERDE_IMPL(WRITE3resok, file_wcc, count, committed, verf);
+EDEN_XDR_SERDE_IMPL(WRITE3resfail, file_wcc);
+EDEN_XDR_SERDE_IMPL(CREATE3args, where, how);
+EDEN_XDR_SERDE_IMPL(CREATE3resok, obj, obj_attributes, dir_wcc);
+EDEN_XDR_SERDE_IMPL(CREATE3resfail, dir_wcc);
+EDEN_XDR_SERDE_IMPL(MKDIR3args, where, attributes);
+EDEN_XDR_SERDE_IMPL(MKDIR3resok, obj, obj_attributes, dir_wcc);
+EDEN_XDR_SERDE_IMPL(MKDIR3resfail, dir_wcc);
+EDEN_XDR_SERDE_IMPL(REMOVE3args, object);
+EDEN_XDR_SERDE_IMPL(REMOVE3resok, dir_wcc);
+EDEN_XDR_SERDE_IMPL(REMOVE3resfail, dir_wcc);
+EDEN_XDR_SERDE_IMPL(RENAME3args, from, to);
+EDEN_XDR_SERDE_IMPL(RENAME3resok, fromdir_wcc, todir_wcc);
+EDEN_XDR_SERDE_IMPL(RENAME3resfail, fromdir_wcc, todir_wcc);
+EDEN_XDR_SERDE_IMPL(COMMIT3args, file, offset, count);
+EDEN_XDR_SERDE_IMPL(COMMIT3resok, file_wcc, verf);
+EDEN_XDR_SERDE_IMPL(COMMIT3resfail, file_wcc);
 } // namespace facebook::eden
 
 #endif
@@ -9,6 +9,7 @@
 
 #ifndef _WIN32
 
+#include <stdexcept>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/nfs/rpc/Rpc.h"
 
@@ -101,35 +102,89 @@ EDEN_XDR_SERDE_DECL(specdata3, specdata1, specdata2);
 /**
  * The NFS spec specify this struct as being opaque from the client
  * perspective, and thus we are free to use what is needed to uniquely identify
- * a file. In EdenFS, this is perfectly represented by an InodeNumber.
+ * a file. In EdenFS, this is mostly represented by an InodeNumber.
  *
  * As an InodeNumber is unique per mount, an Nfsd program can only handle one
  * mount per instance. This will either need to be extended to support multiple
  * mounts, or an Nfsd instance per mount will need to be created.
  *
+ * Unlike FUSE, NFS clients never tell us when they stop using a file handle,
+ * and they expect handles to remain valid across an EdenFS restart. The
+ * InodeMap only remembers inode numbers that have a non-zero FS refcount, so
+ * the handle also contains the inode number of the parent directory at the
+ * time the handle was handed out: this is enough to reload the inode once the
+ * InodeMap forgot about it, see InodeMap::lookupInodeWithParentHint. The
+ * parent of the root inode is the root inode itself.
+ *
+ * The generation is the EdenMount generation that created the handle. Inode
+ * numbers are persisted in the overlay and thus stay valid across a graceful
+ * restart, so it isn't used to reject handles, but it allows telling apart
+ * handles that predate a restart when debugging.
+ *
  * Note that this structure is serialized as an opaque byte vector, and will
  * thus be preceded by a uint32_t.
  */
 struct nfs_fh3 {
   InodeNumber ino;
+  InodeNumber parent;
+  uint64_t generation{0};
+
+  /** Serialized size of a handle that only contained the inode number. */
+  static constexpr uint32_t kLegacySize = sizeof(uint64_t);
+  static constexpr uint32_t kSize = 3 * sizeof(uint64_t);
 };
 
 template <>
 struct XdrTrait<nfs_fh3> {
   static void serialize(folly::io::Appender& appender, const nfs_fh3& fh) {
-    XdrTrait<uint32_t>::serialize(appender, sizeof(nfs_fh3));
+    XdrTrait<uint32_t>::serialize(appender, nfs_fh3::kSize);
     XdrTrait<uint64_t>::serialize(appender, fh.ino.get());
+    XdrTrait<uint64_t>::serialize(appender, fh.parent.get());
+    XdrTrait<uint64_t>::serialize(appender, fh.generation);
   }
 
+  /**
+   * Handles that weren't handed out by EdenFS are returned empty, so that
+   * the request fails with NFS3ERR_BADHANDLE, see NfsBadHandleError.
+   */
   static nfs_fh3 deserialize(folly::io::Cursor& cursor) {
     uint32_t size = XdrTrait<uint32_t>::deserialize(cursor);
-    XCHECK_EQ(size, sizeof(nfs_fh3));
-    return {InodeNumber{XdrTrait<uint64_t>::deserialize(cursor)}};
+    nfs_fh3 fh;
+    if (size != nfs_fh3::kLegacySize && size != nfs_fh3::kSize) {
+      // Skip the opaque data and its padding so that the rest of the request
+      // can still be parsed.
+      cursor.skip(static_cast<size_t>(size) + (4 - size % 4) % 4);
+      return fh;
+    }
+    uint64_t ino = XdrTrait<uint64_t>::deserialize(cursor);
+    uint64_t parent = ino;
+    if (size == nfs_fh3::kSize) {
+      parent = XdrTrait<uint64_t>::deserialize(cursor);
+      fh.generation = XdrTrait<uint64_t>::deserialize(cursor);
+    }
+    // A handle of the legacy size was handed out by an older EdenFS before a
+    // graceful restart. Using the inode itself as its parent means there is
+    // no parent to reload it from.
+    if (ino != 0 && parent != 0) {
+      fh.ino = InodeNumber{ino};
+      fh.parent = InodeNumber{parent};
+    }
+    return fh;
   }
 };
 
+/**
+ * Thrown when a request refers to a file handle that is empty, see
+ * XdrTrait<nfs_fh3>::deserialize.
+ */
+class NfsBadHandleError : public std::runtime_error {
+ public:
+  NfsBadHandleError() : std::runtime_error("malformed NFS file handle") {}
+};
+
 inline bool operator==(const nfs_fh3& a, const nfs_fh3& b) {
-  return a.ino == b.ino;
+  return a.ino == b.ino && a.parent == b.parent &&
+      a.generation == b.generation;
 }
 
 struct nfstime3 {
@@ -183,6 +238,114 @@ struct XdrTrait<post_op_attr> : public XdrTrait<post_op_attr::Base> {
   }
 };
 
+/**
+ * Optional value, encoded as a bool followed by the value if the bool is true.
+ */
+template <typename T>
+struct XdrOptionalVariant : public XdrVariant<bool, T> {};
+
+template <typename T>
+struct XdrTrait<XdrOptionalVariant<T>>
+    : public XdrTrait<typename XdrOptionalVariant<T>::Base> {
+  static XdrOptionalVariant<T> deserialize(folly::io::Cursor& cursor) {
+    XdrOptionalVariant<T> ret;
+    ret.tag = XdrTrait<bool>::deserialize(cursor);
+    if (ret.tag) {
+      ret.v = XdrTrait<T>::deserialize(cursor);
+    }
+    return ret;
+  }
+};
+
+/**
+ * Result of most procedures: the ResOk variant on success, ResFail otherwise.
+ */
+template <typename ResOk, typename ResFail>
+struct NfsResult : public XdrVariant<nfsstat3, ResOk, ResFail> {};
+
+template <typename ResOk, typename ResFail>
+struct XdrTrait<NfsResult<ResOk, ResFail>>
+    : public XdrTrait<typename NfsResult<ResOk, ResFail>::Base> {
+  static NfsResult<ResOk, ResFail> deserialize(folly::io::Cursor& cursor) {
+    NfsResult<ResOk, ResFail> ret;
+    ret.tag = XdrTrait<nfsstat3>::deserialize(cursor);
+    switch (ret.tag) {
+      case nfsstat3::NFS3_OK:
+        ret.v = XdrTrait<ResOk>::deserialize(cursor);
+        break;
+      default:
+        ret.v = XdrTrait<ResFail>::deserialize(cursor);
+        break;
+    }
+    return ret;
+  }
+};
+
+struct wcc_attr {
+  uint64_t size;
+  nfstime3 mtime;
+  nfstime3 ctime;
+};
+EDEN_XDR_SERDE_DECL(wcc_attr, size, mtime, ctime);
+
+using pre_op_attr = XdrOptionalVariant<wcc_attr>;
+
+/**
+ * Weak cache consistency data: attributes of an object before and after an
+ * operation, allowing the client to tell whether it was the only one to
+ * modify it. Both are optional.
+ */
+struct wcc_data {
+  pre_op_attr before;
+  post_op_attr after;
+};
+EDEN_XDR_SERDE_DECL(wcc_data, before, after);
+
+using post_op_fh3 = XdrOptionalVariant<nfs_fh3>;
+
+enum class time_how {
+  DONT_CHANGE = 0,
+  SET_TO_SERVER_TIME = 1,
+  SET_TO_CLIENT_TIME = 2,
+};
+
+struct set_time : public XdrVariant<time_how, nfstime3> {};
+
+template <>
+struct XdrTrait<set_time> : public XdrTrait<set_time::Base> {
+  static set_time deserialize(folly::io::Cursor& cursor) {
+    set_time ret;
+    ret.tag = XdrTrait<time_how>::deserialize(cursor);
+    if (ret.tag == time_how::SET_TO_CLIENT_TIME) {
+      ret.v = XdrTrait<nfstime3>::deserialize(cursor);
+    }
+    return ret;
+  }
+};
+
+using set_mode3 = XdrOptionalVariant<uint32_t>;
+using set_uid3 = XdrOptionalVariant<uint32_t>;
+using set_gid3 = XdrOptionalVariant<uint32_t>;
+using set_size3 = XdrOptionalVariant<uint64_t>;
+using set_atime = set_time;
+using set_mtime = set_time;
+
+struct sattr3 {
+  set_mode3 mode;
+  set_uid3 uid;
+  set_gid3 gid;
+  set_size3 size;
+  set_atime atime;
+  set_mtime mtime;
+};
+EDEN_XDR_SERDE_DECL(sattr3, mode, uid, gid, size, atime, mtime);
+
+struct diropargs3 {
+  nfs_fh3 dir;
+  std::string name;
+};
+EDEN_XDR_SERDE_DECL(diropargs3, dir, name);
+
 // FSINFO Procedure:
 
 const uint32_t FSF3_LINK = 0x0001;
@@ -288,6 +451,200 @@ struct XdrTrait<PATHCONF3res> : public XdrTrait<PATHCONF3res::Base> {
   }
 };
 
+// WRITE Procedure:
+
+enum class stable_how {
+  UNSTABLE = 0,
+  DATA_SYNC = 1,
+  FILE_SYNC = 2,
+};
+
+/**
+ * Opaque value that identifies a server instance. Clients compare the
+ * verifier returned by WRITE and COMMIT to detect that the server restarted
+ * and that data written with UNSTABLE stability must be written again.
+ */
+using writeverf3 = uint64_t;
+
+struct WRITE3args {
+  nfs_fh3 file;
+  uint64_t offset;
+  uint32_t count;
+  stable_how stable;
+  std::unique_ptr<folly::IOBuf> data;
+};
+
+template <>
+struct XdrTrait<WRITE3args> {
+  static void serialize(folly::io::Appender& appender, const WRITE3args& a) {
+    XdrTrait<nfs_fh3>::serialize(appender, a.file);
+    XdrTrait<uint64_t>::serialize(appender, a.offset);
+    XdrTrait<uint32_t>::serialize(appender, a.count);
+    XdrTrait<stable_how>::serialize(appender, a.stable);
+    XdrTrait<std::unique_ptr<folly::IOBuf>>::serialize(appender, a.data);
+  }
+
+  static WRITE3args deserialize(folly::io::Cursor& cursor) {
+    WRITE3args ret;
+    ret.file = XdrTrait<nfs_fh3>::deserialize(cursor);
+    ret.offset = XdrTrait<uint64_t>::deserialize(cursor);
+    ret.count = XdrTrait<uint32_t>::deserialize(cursor);
+    ret.stable = XdrTrait<stable_how>::deserialize(cursor);
+    ret.data = XdrTrait<std::unique_ptr<folly::IOBuf>>::deserialize(cursor);
+    return ret;
+  }
+};
+
+struct WRITE3resok {
+  wcc_data file_wcc;
+  uint32_t count;
+  stable_how committed;
+  writeverf3 verf;
+};
+EDEN_XDR_SERDE_DECL(WRITE3resok, file_wcc, count, committed, verf);
+
+struct WRITE3resfail {
+  wcc_data file_wcc;
+};
+EDEN_XDR_SERDE_DECL(WRITE3resfail, file_wcc);
+
+using WRITE3res = NfsResult<WRITE3resok, WRITE3resfail>;
+
+// CREATE Procedure:
+
+enum class createmode3 {
+  UNCHECKED = 0,
+  GUARDED = 1,
+  EXCLUSIVE = 2,
+};
+
+using createverf3 = uint64_t;
+
+struct createhow3 : public XdrVariant<createmode3, sattr3, createverf3> {};
+
+template <>
+struct XdrTrait<createhow3> : public XdrTrait<createhow3::Base> {
+  static createhow3 deserialize(folly::io::Cursor& cursor) {
+    createhow3 ret;
+    ret.tag = XdrTrait<createmode3>::deserialize(cursor);
+    switch (ret.tag) {
+      case createmode3::UNCHECKED:
+      case createmode3::GUARDED:
+        ret.v = XdrTrait<sattr3>::deserialize(cursor);
+        break;
+      case createmode3::EXCLUSIVE:
+        ret.v = XdrTrait<createverf3>::deserialize(cursor);
+        break;
+    }
+    return ret;
+  }
+};
+
+struct CREATE3args {
+  diropargs3 where;
+  createhow3 how;
+};
+EDEN_XDR_SERDE_DECL(CREATE3args, where, how);
+
+struct CREATE3resok {
+  post_op_fh3 obj;
+  post_op_attr obj_attributes;
+  wcc_data dir_wcc;
+};
+EDEN_XDR_SERDE_DECL(CREATE3resok, obj, obj_attributes, dir_wcc);
+
+struct CREATE3resfail {
+  wcc_data dir_wcc;
+};
+EDEN_XDR_SERDE_DECL(CREATE3resfail, dir_wcc);
+
+using CREATE3res = NfsResult<CREATE3resok, CREATE3resfail>;
+
+// MKDIR Procedure:
+
+struct MKDIR3args {
+  diropargs3 where;
+  sattr3 attributes;
+};
+EDEN_XDR_SERDE_DECL(MKDIR3args, where, attributes);
+
+struct MKDIR3resok {
+  post_op_fh3 obj;
+  post_op_attr obj_attributes;
+  wcc_data dir_wcc;
+};
+EDEN_XDR_SERDE_DECL(MKDIR3resok, obj, obj_attributes, dir_wcc);
+
+struct MKDIR3resfail {
+  wcc_data dir_wcc;
+};
+EDEN_XDR_SERDE_DECL(MKDIR3resfail, dir_wcc);
+
+using MKDIR3res = NfsResult<MKDIR3resok, MKDIR3resfail>;
+
+// REMOVE Procedure:
+
+struct REMOVE3args {
+  diropargs3 object;
+};
+EDEN_XDR_SERDE_DECL(REMOVE3args, object);
+
+struct REMOVE3resok {
+  wcc_data dir_wcc;
+};
+EDEN_XDR_SERDE_DECL(REMOVE3resok, dir_wcc);
+
+struct REMOVE3resfail {
+  wcc_data dir_wcc;
+};
+EDEN_XDR_SERDE_DECL(REMOVE3resfail, dir_wcc);
+
+using REMOVE3res = NfsResult<REMOVE3resok, REMOVE3resfail>;
+
+// RENAME Procedure:
+
+struct RENAME3args {
+  diropargs3 from;
+  diropargs3 to;
+};
+EDEN_XDR_SERDE_DECL(RENAME3args, from, to);
+
+struct RENAME3resok {
+  wcc_data fromdir_wcc;
+  wcc_data todir_wcc;
+};
+EDEN_XDR_SERDE_DECL(RENAME3resok, fromdir_wcc, todir_wcc);
+
+struct RENAME3resfail {
+  wcc_data fromdir_wcc;
+  wcc_data todir_wcc;
+};
+EDEN_XDR_SERDE_DECL(RENAME3resfail, fromdir_wcc, todir_wcc);
+
+using RENAME3res = NfsResult<RENAME3resok, RENAME3resfail>;
+
+// COMMIT Procedure:
+
+struct COMMIT3args {
+  nfs_fh3 file;
+  uint64_t offset;
+  uint32_t count;
+};
+EDEN_XDR_SERDE_DECL(COMMIT3args, file, offset, count);
+
+struct COMMIT3resok {
+  wcc_data file_wcc;
+  writeverf3 verf;
+};
+EDEN_XDR_SERDE_DECL(COMMIT3resok, file_wcc, verf);
+
+struct COMMIT3resfail {
+  wcc_data file_wcc;
+};
+EDEN_XDR_SERDE_DECL(COMMIT3resfail, file_wcc);
+
+using COMMIT3res = NfsResult<COMMIT3resok, COMMIT3resfail>;
+
 } // namespace facebook::eden
 
 #endif
@@ -31,6 +31,15 @@ void serialize_variable(folly::io::Appender& appender, folly::ByteRange value) {
   serialize_fixed(appender, value);
 }
 
+void serialize_iobuf(folly::io::Appender& appender, const folly::IOBuf& buf) {
+  auto len = buf.computeChainDataLength();
+  XdrTrait<uint32_t>::serialize(appender, len);
+  for (auto range : buf) {
+    appender.push(range);
+  }
+  addPadding(appender, len);
+}
+
 } // namespace detail
 
 } // namespace facebook::eden
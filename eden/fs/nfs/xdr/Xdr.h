@@ -105,6 +105,12 @@ void serialize_fixed(folly::io::Appender& appender, folly::ByteRange value);
  */
 void serialize_variable(folly::io::Appender& appender, folly::ByteRange value);
 
+/**
+ * Serialize a variable size byte array held in an IOBuf chain, in the same
+ * format as serialize_variable.
+ */
+void serialize_iobuf(folly::io::Appender& appender, const folly::IOBuf& buf);
+
 /**
  * Skip the padding bytes that were written during serialization.
  */
@@ -199,6 +205,28 @@ struct XdrTrait<
   }
 };
 
+/**
+ * IOBufs are encoded in the same way as a vector of bytes. Deserializing
+ * shares the underlying buffer instead of copying the data, which allows
+ * large payloads such as NFS WRITE data to be forwarded without a copy.
+ */
+template <>
+struct XdrTrait<std::unique_ptr<folly::IOBuf>> {
+  static void serialize(
+      folly::io::Appender& appender,
+      const std::unique_ptr<folly::IOBuf>& value) {
+    detail::serialize_iobuf(appender, *value);
+  }
+
+  static std::unique_ptr<folly::IOBuf> deserialize(folly::io::Cursor& cursor) {
+    auto len = XdrTrait<uint32_t>::deserialize(cursor);
+    std::unique_ptr<folly::IOBuf> ret;
+    cursor.clone(ret, len);
+    detail::skipPadding(cursor, len);
+    return ret;
+  }
+};
+
 /**
  * Strings are encoded in the same way as a vector.
  */
@@ -123,6 +123,16 @@ TEST(XdrSerialize, variant) {
   roundtrip(var2, sizeof(uint32_t));
 }
 
+TEST(XdrSerialize, iobuf) {
+  auto buf = IOBuf::copyBuffer("hello");
+  buf->prependChain(IOBuf::copyBuffer(" world"));
+  auto encoded = ser(buf);
+  EXPECT_EQ(encoded.coalesce().size(), sizeof(uint32_t) + detail::roundUp(11));
+
+  auto decoded = de<std::unique_ptr<IOBuf>>(encoded);
+  EXPECT_EQ("hello world", decoded->moveToFbString());
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -10,12 +10,21 @@
 #include <gflags/gflags.h>
 
 DEFINE_int32(num_eden_threads, 12, "the number of eden CPU worker threads");
+DEFINE_bool(
+    eden_threads_work_stealing,
+    false,
+    "Give each eden CPU worker thread its own queue, and let idle threads "
+    "steal work from the others, instead of sharing a single queue");
 
 namespace facebook {
 namespace eden {
 
 EdenCPUThreadPool::EdenCPUThreadPool()
-    : UnboundedQueueExecutor(FLAGS_num_eden_threads, "EdenCPUThread") {}
+    : UnboundedQueueExecutor(
+          FLAGS_num_eden_threads,
+          "EdenCPUThread",
+          FLAGS_eden_threads_work_stealing ? QueueType::WorkStealing
+                                           : QueueType::Shared) {}
 
 } // namespace eden
 } // namespace facebook
@@ -15,6 +15,7 @@
 #include <functional>
 #include <memory>
 #include <sstream>
+#include <unordered_set>
 
 #include <fb303/ServiceData.h>
 #include <folly/Exception.h>
@@ -138,6 +139,11 @@ DEFINE_uint64(
     minimumBlobCacheEntryCount,
     16,
     "The minimum number of recent blobs to keep cached. Trumps maximumBlobCacheSize");
+DEFINE_bool(
+    blobCacheFrequencyAdmission,
+    false,
+    "Only admit blobs into the blob cache if they are accessed more often than "
+    "the blobs they would evict, to resist scans");
 
 using apache::thrift::ThriftServer;
 using folly::Future;
@@ -160,6 +166,7 @@ constexpr StringPiece kSqlitePath{"storage/sqlite.db"};
 constexpr StringPiece kHgStorePrefix{"store.hg"};
 constexpr StringPiece kFuseRequestPrefix{"fuse"};
 constexpr StringPiece kStateConfig{"config.toml"};
+constexpr StringPiece kSnapshotMountPrefix{"snapshot-"};
 
 std::optional<std::string> getUnixDomainSocketPath(
     const folly::SocketAddress& address) {
@@ -207,6 +214,21 @@ std::string getCounterNameForFuseRequests(
       RequestMetricsScope::stringOfRequestMetric(metric));
 }
 
+#ifndef _WIN32
+std::string getCounterNameForFuseRequestQueue(
+    FuseRequestClass requestClass,
+    const EdenMount* mount) {
+  auto mountName = basename(mount->getPath().stringPiece());
+  // prefix . mount . queued . class
+  return folly::to<std::string>(
+      kFuseRequestPrefix,
+      ".",
+      mountName,
+      ".queued.",
+      fuseRequestClassName(requestClass));
+}
+#endif
+
 std::string normalizeMountPoint(StringPiece mountPath) {
 #ifdef _WIN32
   auto normalized = mountPath.str();
@@ -328,7 +350,10 @@ EdenServer::EdenServer(
       metadataImporterFactory_(std::move(metadataImporterFactory)),
       blobCache_{BlobCache::create(
           FLAGS_maximumBlobCacheSize,
-          FLAGS_minimumBlobCacheEntryCount)},
+          FLAGS_minimumBlobCacheEntryCount,
+          FLAGS_blobCacheFrequencyAdmission
+              ? BlobCache::AdmissionPolicy::Frequency
+              : BlobCache::AdmissionPolicy::Always)},
       // Store a pointer to the EventBase that will be used to drive
       // the main thread.  The runServer() code will end up driving this
       // EventBase.
@@ -540,12 +565,36 @@ Future<Unit> EdenServer::unmountAll() {
 Future<TakeoverData> EdenServer::stopMountsForTakeover(
     folly::Promise<std::optional<TakeoverData>>&& takeoverPromise) {
   std::vector<Future<optional<TakeoverData::MountInfo>>> futures;
+  std::vector<Future<Unit>> unmountFutures;
   {
     const auto mountPoints = mountPoints_.wlock();
     for (auto& entry : *mountPoints) {
       const auto& mountPath = entry.first;
       auto& info = entry.second;
 
+      // The inode numbers of an ephemeral overlay don't survive the restart,
+      // so the new process can't serve the inodes the kernel already knows.
+      // Unmount these instead; the new process mounts them again from
+      // scratch.
+      if (info.edenMount->getOverlay()->getType() ==
+          Overlay::Type::Ephemeral) {
+        XLOG(INFO) << "unmounting \"" << mountPath
+                   << "\" rather than handing over its ephemeral overlay";
+        auto mount = info.edenMount;
+        unmountFutures.push_back(mount->unmount().thenTry(
+            [mount, unmountFuture = info.unmountPromise.getFuture()](
+                auto&& result) mutable {
+              if (result.hasValue()) {
+                return std::move(unmountFuture);
+              }
+              XLOG(ERR) << "Failed to unmount \"" << mount->getPath()
+                        << "\" for takeover: "
+                        << folly::exceptionStr(result.exception());
+              return makeFuture<Unit>(result.exception());
+            }));
+        continue;
+      }
+
       try {
         info.takeoverPromise.emplace();
         auto future = info.takeoverPromise->getFuture();
@@ -573,8 +622,14 @@ Future<TakeoverData> EdenServer::stopMountsForTakeover(
   }
   // Use collectAll() rather than collect() to wait for all of the unmounts
   // to complete, and only check for errors once everything has finished.
-  return folly::collectAll(futures).toUnsafeFuture().thenValue(
-      [takeoverPromise = std::move(takeoverPromise)](
+  // Failing to unmount an ephemeral mount has already been logged, and must
+  // not prevent the takeover of the other mounts.
+  auto takeoverFuture = folly::collectAll(futures).toUnsafeFuture();
+  return folly::collectAll(unmountFutures)
+      .toUnsafeFuture()
+      .thenValue([takeoverFuture = std::move(takeoverFuture)](
+                     auto&&) mutable { return std::move(takeoverFuture); })
+      .thenValue([takeoverPromise = std::move(takeoverPromise)](
           std::vector<folly::Try<optional<TakeoverData::MountInfo>>>
               results) mutable {
         TakeoverData data;
@@ -943,7 +998,9 @@ std::vector<Future<Unit>> EdenServer::prepareMountsTakeover(
     NOT_IMPLEMENTED();
   }
 
+  std::unordered_set<std::string> takenOverPaths;
   for (auto& info : takeoverMounts) {
+    takenOverPaths.insert(info.mountPath.value());
     const auto stateDirectory = info.stateDirectory;
     auto mountFuture =
         makeFutureWith([&] {
@@ -972,6 +1029,55 @@ std::vector<Future<Unit>> EdenServer::prepareMountsTakeover(
     mountFutures.push_back(std::move(mountFuture));
   }
 
+  // Mounts with an ephemeral overlay are unmounted by the old process rather
+  // than handed over, so mount the configured ones again from scratch.
+  folly::dynamic dirs = folly::dynamic::object();
+  try {
+    dirs = CheckoutConfig::loadClientDirectoryMap(edenDir_.getPath());
+  } catch (const std::exception& ex) {
+    incrementStartupMountFailures();
+    logger->warn(
+        "Could not parse config.json file: ",
+        ex.what(),
+        "\nSkipping remount of checkouts with an ephemeral overlay.");
+    return mountFutures;
+  }
+
+  for (const auto& client : dirs.items()) {
+    auto mountPath = client.first.asString();
+    if (takenOverPaths.count(mountPath)) {
+      continue;
+    }
+    auto mountFuture =
+        makeFutureWith([&] {
+          auto initialConfig = CheckoutConfig::loadFromClientDirectory(
+              AbsolutePathPiece{mountPath},
+              edenDir_.getCheckoutStateDir(client.second.asString()));
+          if (!initialConfig->getEphemeralOverlay()) {
+            return makeFuture();
+          }
+          return mount(std::move(initialConfig), false, [](auto) {})
+              .thenTry([logger, mountPath](
+                           folly::Try<std::shared_ptr<EdenMount>>&& result) {
+                if (result.hasValue()) {
+                  logger->log(
+                      "Remounted ",
+                      mountPath,
+                      " with an empty ephemeral overlay");
+                  return makeFuture();
+                }
+                incrementStartupMountFailures();
+                logger->warn(
+                    "Failed to remount ",
+                    mountPath,
+                    ": ",
+                    result.exception().what());
+                return makeFuture<Unit>(std::move(result).exception());
+              });
+        });
+    mountFutures.push_back(std::move(mountFuture));
+  }
+
   return mountFutures;
 }
 
@@ -1215,6 +1321,14 @@ void EdenServer::registerStats(std::shared_ptr<EdenMount> edenMount) {
           return edenMount->getFuseChannel()->getRequestMetric(metric);
         });
   }
+  for (auto requestClass : kFuseRequestClasses) {
+    counters->registerCallback(
+        getCounterNameForFuseRequestQueue(requestClass, edenMount.get()),
+        [edenMount, requestClass] {
+          return edenMount->getFuseChannel()->getRequestQueueDepth(
+              requestClass);
+        });
+  }
 #endif
 #ifdef __linux__
   counters->registerCallback(
@@ -1253,6 +1367,10 @@ void EdenServer::unregisterStats(EdenMount* edenMount) {
     counters->unregisterCallback(getCounterNameForFuseRequests(
         RequestMetricsScope::RequestStage::LIVE, metric, edenMount));
   }
+  for (auto requestClass : kFuseRequestClasses) {
+    counters->unregisterCallback(
+        getCounterNameForFuseRequestQueue(requestClass, edenMount));
+  }
 #endif
 #ifdef __linux__
   counters->unregisterCallback(getCounterNameForFuseRequests(
@@ -1322,7 +1440,9 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
       serverState_->getThreadPool().get(),
       serverState_->getProcessNameCache(),
       serverState_->getStructuredLogger(),
-      serverState_->getReloadableConfig().getEdenConfig());
+      serverState_->getReloadableConfig().getEdenConfig(),
+      getObjectStoreSharedState(
+          initialConfig->getRepoType(), initialConfig->getRepoSource()));
   auto journal = std::make_unique<Journal>(getSharedStats());
 
   // Create the EdenMount object and insert the mount into the mountPoints_ map.
@@ -1425,6 +1545,46 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
       });
 }
 
+folly::Future<std::shared_ptr<EdenMount>> EdenServer::mountSnapshot(
+    AbsolutePathPiece mountPath,
+    const CheckoutConfig& source,
+    const Hash& commit) {
+  const auto normalizedPath = normalizeMountPoint(mountPath.stringPiece());
+  {
+    // The client directory is about to be recreated, which must not happen
+    // under an existing or concurrently created mount of the same path.
+    const auto mountPoints = mountPoints_.wlock();
+    if (mountPoints->count(normalizedPath) ||
+        !pendingSnapshotMounts_.insert(normalizedPath).second) {
+      return makeFuture<shared_ptr<EdenMount>>(newEdenError(
+          EEXIST,
+          EdenErrorType::POSIX_ERROR,
+          "mount point \"",
+          normalizedPath,
+          "\" is already mounted"));
+    }
+  }
+
+  return makeFutureWith([&] {
+    SCOPE_EXIT {
+      // By now, mount() has either added the mount to mountPoints_ or failed.
+      const auto mountPoints = mountPoints_.wlock();
+      pendingSnapshotMounts_.erase(normalizedPath);
+    };
+
+    // Name the client directory after the mount path, so that the leftovers
+    // of a snapshot mount that wasn't cleanly unmounted are reused.
+    auto clientDirectory = edenDir_.getCheckoutStateDir(folly::to<string>(
+        kSnapshotMountPrefix,
+        Hash::sha1(folly::ByteRange{StringPiece{normalizedPath}}).toString()));
+    removeRecursively(clientDirectory);
+
+    auto config = CheckoutConfig::createSnapshotMount(
+        mountPath, clientDirectory, source, commit);
+    return mount(std::move(config), /*readOnly=*/true);
+  });
+}
+
 Future<Unit> EdenServer::unmount(StringPiece mountPath) {
   const auto normalizedPath = normalizeMountPoint(mountPath);
 
@@ -1477,14 +1637,30 @@ void EdenServer::mountFinished(
 
   const bool doTakeover = takeoverPromise.has_value();
 
+  // Snapshot mounts have nothing worth keeping once they are unmounted.
+  std::optional<AbsolutePath> clientDirectoryToRemove;
+  if (!doTakeover && edenMount->getConfig()->isSnapshotMount()) {
+    clientDirectoryToRemove = edenMount->getConfig()->getClientDirectory();
+  }
+
   // Shutdown the EdenMount, and fulfill the unmount promise
   // when the shutdown completes
   edenMount->shutdown(doTakeover)
       .via(getMainEventBase())
       .thenTry([unmountPromise = std::move(unmountPromise),
                 takeoverPromise = std::move(takeoverPromise),
-                takeoverData = std::move(takeover)](
+                takeoverData = std::move(takeover),
+                clientDirectoryToRemove = std::move(clientDirectoryToRemove)](
                    folly::Try<SerializedInodeMap>&& result) mutable {
+        if (clientDirectoryToRemove) {
+          try {
+            removeRecursively(*clientDirectoryToRemove);
+          } catch (const std::exception& ex) {
+            XLOG(WARN) << "failed to remove the state of snapshot mount "
+                       << *clientDirectoryToRemove << ": "
+                       << folly::exceptionStr(ex);
+          }
+        }
         if (takeoverPromise) {
           takeoverPromise.value().setWith([&]() mutable {
             takeoverData.value().inodeMap = std::move(result.value());
@@ -1579,6 +1755,32 @@ shared_ptr<BackingStore> EdenServer::getBackingStore(
   return store;
 }
 
+shared_ptr<ObjectStoreSharedState> EdenServer::getObjectStoreSharedState(
+    StringPiece type,
+    StringPiece name) {
+  BackingStoreKey key{type.str(), name.str()};
+  auto lockedStates = objectStoreSharedStates_.wlock();
+  const auto it = lockedStates->find(key);
+  if (it != lockedStates->end()) {
+    return it->second;
+  }
+
+  const auto state = std::make_shared<ObjectStoreSharedState>();
+  lockedStates->emplace(key, state);
+  return state;
+}
+
+std::vector<shared_ptr<ObjectStoreSharedState>>
+EdenServer::getObjectStoreSharedStates() {
+  std::vector<shared_ptr<ObjectStoreSharedState>> states;
+  auto lockedStates = objectStoreSharedStates_.rlock();
+  states.reserve(lockedStates->size());
+  for (const auto& entry : *lockedStates) {
+    states.push_back(entry.second);
+  }
+  return states;
+}
+
 std::unordered_set<std::shared_ptr<BackingStore>>
 EdenServer::getBackingStores() {
   std::unordered_set<std::shared_ptr<BackingStore>> backingStores{};
@@ -14,6 +14,7 @@
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <folly/Executor.h>
@@ -68,6 +69,7 @@ class Dirstate;
 class EdenServiceHandler;
 class LocalStore;
 class MountInfo;
+class ObjectStoreSharedState;
 class Notifications;
 struct SessionInfo;
 class StartupLogger;
@@ -221,6 +223,19 @@ class EdenServer : private TakeoverHandler {
       OverlayChecker::ProgressCallback&& progressCallback = [](auto) {},
       std::optional<TakeoverData::MountInfo>&& optionalTakeover = std::nullopt);
 
+  /**
+   * Mount a read-only view of the given commit, sharing the repository of the
+   * source checkout, and return it.
+   *
+   * This skips everything that makes creating a checkout expensive: the
+   * overlay is ephemeral, and nothing is added to the client directory map.
+   * Unmounting it with unmount() removes all of its state.
+   */
+  FOLLY_NODISCARD folly::Future<std::shared_ptr<EdenMount>> mountSnapshot(
+      AbsolutePathPiece mountPath,
+      const CheckoutConfig& source,
+      const Hash& commit);
+
   /**
    * Takeover a mount from another eden instance
    */
@@ -312,6 +327,24 @@ class EdenServer : private TakeoverHandler {
       folly::StringPiece type,
       folly::StringPiece name);
 
+  /**
+   * Look up the ObjectStoreSharedState for the specified repository
+   * type+name.
+   *
+   * Like BackingStores, this is shared by all the mount points that use the
+   * same repository so that their ObjectStores share cached metadata and
+   * concurrent fetches.
+   */
+  std::shared_ptr<ObjectStoreSharedState> getObjectStoreSharedState(
+      folly::StringPiece type,
+      folly::StringPiece name);
+
+  /**
+   * Look up the ObjectStoreSharedState of every known repository.
+   */
+  std::vector<std::shared_ptr<ObjectStoreSharedState>>
+  getObjectStoreSharedStates();
+
   AbsolutePathPiece getEdenDir() const {
     return edenDir_.getPath();
   }
@@ -422,6 +455,8 @@ class EdenServer : private TakeoverHandler {
   using BackingStoreKey = std::pair<std::string, std::string>;
   using BackingStoreMap =
       std::unordered_map<BackingStoreKey, std::shared_ptr<BackingStore>>;
+  using ObjectStoreSharedStateMap = std::
+      unordered_map<BackingStoreKey, std::shared_ptr<ObjectStoreSharedState>>;
   using MountMap = folly::StringKeyedMap<struct EdenMountInfo>;
   class ThriftServerEventHandler;
 
@@ -564,10 +599,19 @@ class EdenServer : private TakeoverHandler {
   MetadataImporterFactory metadataImporterFactory_;
   std::shared_ptr<LocalStore> localStore_;
   folly::Synchronized<BackingStoreMap> backingStores_;
+  folly::Synchronized<ObjectStoreSharedStateMap> objectStoreSharedStates_;
   const std::shared_ptr<BlobCache> blobCache_;
 
   folly::Synchronized<MountMap> mountPoints_;
 
+  /**
+   * Mount points whose snapshot mount is being set up by mountSnapshot(),
+   * before they are added to mountPoints_. Only accessed with mountPoints_
+   * locked, so that checking for an existing mount and reserving the mount
+   * point happen atomically.
+   */
+  std::unordered_set<std::string> pendingSnapshotMounts_;
+
 #ifndef _WIN32
   /**
    * A server that waits on a new edenfs process to attempt
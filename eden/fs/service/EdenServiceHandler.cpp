@@ -16,10 +16,15 @@
 #include <folly/Conv.h>
 #include <folly/FileUtil.h>
 #include <folly/Portability.h>
+#include <folly/ScopeGuard.h>
 #include <folly/String.h>
 #include <folly/chrono/Conv.h>
 #include <folly/container/Access.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/AsyncGenerator.h>
+#endif
 #include <folly/futures/Future.h>
+#include <folly/io/Cursor.h>
 #include <folly/logging/Logger.h>
 #include <folly/logging/LoggerDB.h>
 #include <folly/logging/xlog.h>
@@ -35,6 +40,7 @@
 #endif // _WIN32
 
 #include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/inodes/BulkFileReader.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/GlobNode.h"
@@ -57,9 +63,11 @@
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/BlobMetadata.h"
 #include "eden/fs/store/Diff.h"
+#include "eden/fs/store/GlobResultCache.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/TreeFetchScheduler.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 #include "eden/fs/telemetry/Tracing.h"
 #include "eden/fs/utils/Bug.h"
@@ -322,6 +330,11 @@ namespace eden {
 
 const char* const kServiceName = "EdenFS";
 
+/**
+ * The maximum size of the data of each chunk sent by streamReadFiles().
+ */
+constexpr size_t kReadFilesChunkSize = 1024 * 1024;
+
 EdenServiceHandler::EdenServiceHandler(
     std::vector<std::string> originalCommandLine,
     EdenServer* server)
@@ -410,6 +423,30 @@ void EdenServiceHandler::mount(std::unique_ptr<MountArgument> argument) {
   }
 }
 
+void EdenServiceHandler::mountSnapshot(
+    std::unique_ptr<MountSnapshotArgument> argument) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      INFO,
+      *argument->mountPoint_ref(),
+      *argument->sourceMountPoint_ref(),
+      logHash(*argument->commit_ref()));
+  try {
+    auto sourceMount = server_->getMount(*argument->sourceMountPoint_ref());
+    server_
+        ->mountSnapshot(
+            AbsolutePathPiece{*argument->mountPoint_ref()},
+            *sourceMount->getConfig(),
+            hashFromThrift(*argument->commit_ref()))
+        .get();
+  } catch (const EdenError& ex) {
+    XLOG(ERR) << "Error: " << ex.what();
+    throw;
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "Error: " << ex.what();
+    throw newEdenError(ex);
+  }
+}
+
 void EdenServiceHandler::unmount(std::unique_ptr<std::string> mountPoint) {
   auto helper = INSTRUMENT_THRIFT_CALL(INFO, *mountPoint);
   try {
@@ -581,10 +618,43 @@ void EdenServiceHandler::getCurrentJournalPosition(
   }
 }
 
+namespace {
+JournalPathFilter toJournalPathFilter(const JournalFilter& filter) {
+  try {
+    std::vector<RelativePath> prefixes;
+    prefixes.reserve(filter.pathPrefixes_ref()->size());
+    for (const auto& prefix : *filter.pathPrefixes_ref()) {
+      prefixes.emplace_back(prefix);
+    }
+    return JournalPathFilter{std::move(prefixes), *filter.globs_ref()};
+  } catch (const std::exception& ex) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "invalid journal filter: ",
+        folly::exceptionStr(ex));
+  }
+}
+} // namespace
+
 apache::thrift::ServerStream<JournalPosition>
 EdenServiceHandler::subscribeStreamTemporary(
     std::unique_ptr<std::string> mountPoint) {
-  auto edenMount = server_->getMount(*mountPoint);
+  return subscribeToJournal(*mountPoint, JournalPathFilter{});
+}
+
+apache::thrift::ServerStream<JournalPosition>
+EdenServiceHandler::subscribeStreamFiltered(
+    std::unique_ptr<std::string> mountPoint,
+    std::unique_ptr<JournalFilter> filter) {
+  return subscribeToJournal(*mountPoint, toJournalPathFilter(*filter));
+}
+
+apache::thrift::ServerStream<JournalPosition>
+EdenServiceHandler::subscribeToJournal(
+    StringPiece mountPoint,
+    JournalPathFilter filter) {
+  auto edenMount = server_->getMount(mountPoint);
 
   // We need a weak ref on the mount because the thrift stream plumbing
   // may outlive the mount point
@@ -649,7 +719,8 @@ EdenServiceHandler::subscribeStreamTemporary(
         // the subscriber should call getCurrentJournalPosition or
         // getFilesChangedSince.
         stream->publisher.next(pos);
-      }));
+      },
+      std::move(filter)));
 
   return std::move(streamAndPublisher.first);
 }
@@ -901,15 +972,122 @@ apache::thrift::ServerStream<HgEvent> EdenServiceHandler::traceHgEvents(
   return std::move(serverStream);
 }
 
+#if FOLLY_HAS_COROUTINES
+namespace {
+/**
+ * Produce the chunks of the files of reader, reading the next files only as
+ * the client asks for more chunks.
+ */
+folly::coro::AsyncGenerator<FileContentsChunk&&> readFilesGenerator(
+    std::shared_ptr<BulkFileReader> reader,
+    std::unique_ptr<ThriftLogHelper> helper) {
+  SCOPE_EXIT {
+    // The stream ended or was cancelled. The reads started ahead of it still
+    // use the fetch context that helper owns.
+    reader->stop().ensure([helper = std::move(helper)] {});
+  };
+
+  while (true) {
+    std::optional<BulkFileReader::File> file;
+    try {
+      file = co_await reader->next();
+    } catch (const std::exception& ex) {
+      throw newEdenError(ex);
+    }
+    if (!file) {
+      co_return;
+    }
+
+    if (file->contents.hasException()) {
+      FileContentsChunk chunk;
+      chunk.index_ref() = static_cast<int32_t>(file->index);
+      chunk.offset_ref() = 0;
+      chunk.last_ref() = true;
+      chunk.error_ref() = newEdenError(file->contents.exception());
+      co_yield std::move(chunk);
+      continue;
+    }
+
+    // The chunks share the buffers of the file's contents.
+    folly::io::Cursor cursor{file->contents.value().get()};
+    int64_t offset = 0;
+    do {
+      FileContentsChunk chunk;
+      chunk.index_ref() = static_cast<int32_t>(file->index);
+      chunk.offset_ref() = offset;
+      offset += cursor.cloneAtMost(*chunk.data_ref(), kReadFilesChunkSize);
+      chunk.last_ref() = cursor.isAtEnd();
+      co_yield std::move(chunk);
+    } while (!cursor.isAtEnd());
+  }
+}
+} // namespace
+#endif
+
+apache::thrift::ServerStream<FileContentsChunk>
+EdenServiceHandler::streamReadFiles(
+    std::unique_ptr<std::string> mountPoint,
+    std::unique_ptr<ReadFilesRequest> request) {
+#if FOLLY_HAS_COROUTINES
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3, *mountPoint, toLogArg(*request->paths_ref()));
+  auto edenMount = server_->getMount(*mountPoint);
+
+  std::vector<RelativePath> paths;
+  paths.reserve(request->paths_ref()->size());
+  for (const auto& path : *request->paths_ref()) {
+    paths.emplace_back(path);
+  }
+  std::optional<Hash> commit;
+  if (auto commitHash = request->commit_ref()) {
+    commit = hashFromThrift(*commitHash);
+  }
+
+  auto reader = std::make_shared<BulkFileReader>(
+      std::move(edenMount),
+      std::move(paths),
+      std::move(commit),
+      helper->getFetchContext());
+
+  // Unlike a publisher, which buffers everything it is given, the generator
+  // is only pulled as the client grants credits, which paces the reads.
+  return readFilesGenerator(std::move(reader), std::move(helper));
+#else
+  NOT_IMPLEMENTED();
+#endif
+}
+
 void EdenServiceHandler::getFilesChangedSince(
     FileDelta& out,
     std::unique_ptr<std::string> mountPoint,
     std::unique_ptr<JournalPosition> fromPosition) {
   auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
   auto edenMount = server_->getMount(*mountPoint);
+  getFilesChangedSince(out, *edenMount, *fromPosition, JournalPathFilter{});
+}
 
-  if (*fromPosition->mountGeneration_ref() !=
-      static_cast<ssize_t>(edenMount->getMountGeneration())) {
+void EdenServiceHandler::getFilesChangedSinceFiltered(
+    FileDelta& out,
+    std::unique_ptr<std::string> mountPoint,
+    std::unique_ptr<JournalPosition> fromPosition,
+    std::unique_ptr<JournalFilter> filter) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3,
+      *mountPoint,
+      toLogArg(*filter->pathPrefixes_ref()),
+      toLogArg(*filter->globs_ref()));
+  auto edenMount = server_->getMount(*mountPoint);
+  getFilesChangedSince(
+      out, *edenMount, *fromPosition, toJournalPathFilter(*filter));
+}
+
+void EdenServiceHandler::getFilesChangedSince(
+    FileDelta& out,
+    EdenMount& edenMount,
+    const JournalPosition& fromPosition,
+    const JournalPathFilter& filter) {
+  if (*fromPosition.mountGeneration_ref() !=
+      static_cast<ssize_t>(edenMount.getMountGeneration())) {
     throw newEdenError(
         ERANGE,
         EdenErrorType::MOUNT_GENERATION_CHANGED,
@@ -921,14 +1099,14 @@ void EdenServiceHandler::getFilesChangedSince(
   // The +1 is because the core merge stops at the item prior to
   // its limitSequence parameter and we want the changes *since*
   // the provided sequence number.
-  auto summed = edenMount->getJournal().accumulateRange(
-      *fromPosition->sequenceNumber_ref() + 1);
+  auto summed = edenMount.getJournal().accumulateRange(
+      *fromPosition.sequenceNumber_ref() + 1, filter);
 
   // We set the default toPosition to be where we where if summed is null
   out.toPosition_ref()->sequenceNumber_ref() =
-      *fromPosition->sequenceNumber_ref();
-  out.toPosition_ref()->snapshotHash_ref() = *fromPosition->snapshotHash_ref();
-  out.toPosition_ref()->mountGeneration_ref() = edenMount->getMountGeneration();
+      *fromPosition.sequenceNumber_ref();
+  out.toPosition_ref()->snapshotHash_ref() = *fromPosition.snapshotHash_ref();
+  out.toPosition_ref()->mountGeneration_ref() = edenMount.getMountGeneration();
 
   out.fromPosition_ref() = *out.toPosition_ref();
 
@@ -944,7 +1122,7 @@ void EdenServiceHandler::getFilesChangedSince(
     out.toPosition_ref()->snapshotHash_ref() =
         thriftHash(summed->snapshotTransitions.back());
     out.toPosition_ref()->mountGeneration_ref() =
-        edenMount->getMountGeneration();
+        edenMount.getMountGeneration();
 
     out.fromPosition_ref()->sequenceNumber_ref() = summed->fromSequence;
     out.fromPosition_ref()->snapshotHash_ref() =
@@ -1148,12 +1326,28 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::future_globFiles(
   // GlobResults will hold on to references to these hashes
   auto originHashes = std::make_unique<std::vector<Hash>>();
 
+  // Bounds the tree fetches of all the evaluations below. It must outlive
+  // them.
+  auto treeFetcher = std::make_shared<TreeFetchScheduler>(
+      edenMount->getObjectStore(),
+      server_->getServerState()
+          ->getEdenConfig()
+          ->maxTraversalTreeFetches.getValue());
+
   // Globs will be evaluated against the specified commits or the current commit
   // if none are specified. The results will be collected here.
   std::vector<folly::Future<std::vector<GlobNode::GlobResult>>> globResults{};
 
   auto rootHashes = params->revisions_ref();
   if (!rootHashes->empty()) {
+    // Source control trees are immutable, so the results of globs against a
+    // revision can be cached. The cache doesn't know the contents of the
+    // matching files though, so it can't be used when prefetching them.
+    auto globCache = fileBlobsToPrefetch
+        ? nullptr
+        : std::make_shared<GlobResultCache>(
+              server_->getLocalStore(), server_->getSharedStats());
+
     // Note that we MUST reserve here, otherwise while emplacing we might
     // invalidate the earlier commitHash refrences
     globResults.reserve(rootHashes->size());
@@ -1161,27 +1355,65 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::future_globFiles(
     for (auto& rootHash : *rootHashes) {
       const Hash& originHash =
           originHashes->emplace_back(hashFromThrift(rootHash));
-      globResults.emplace_back(edenMount->getObjectStore()
-                                   ->getTreeForCommit(originHash, fetchContext)
-                                   .thenValue([edenMount,
-                                               globRoot,
-                                               &fetchContext,
-                                               fileBlobsToPrefetch,
-                                               &originHash](auto&& rootTree) {
-                                     return globRoot->evaluate(
-                                         edenMount->getObjectStore(),
-                                         fetchContext,
-                                         RelativePathPiece(),
-                                         rootTree,
-                                         fileBlobsToPrefetch,
-                                         originHash);
-                                   }));
+      globResults.emplace_back(
+          edenMount->getObjectStore()
+              ->getTreeForCommit(originHash, fetchContext)
+              .thenValue([treeFetcher,
+                          globRoot,
+                          globCache,
+                          globs = *params->globs_ref(),
+                          includeDotfiles = *params->includeDotfiles_ref(),
+                          &fetchContext,
+                          fileBlobsToPrefetch,
+                          &originHash](std::shared_ptr<const Tree>&& rootTree) {
+                auto evaluate = [=, &fetchContext, &originHash] {
+                  return globRoot->evaluate(
+                      treeFetcher.get(),
+                      fetchContext,
+                      RelativePathPiece(),
+                      rootTree,
+                      fileBlobsToPrefetch,
+                      originHash);
+                };
+                if (!globCache) {
+                  return evaluate();
+                }
+
+                auto key = GlobResultCache::makeKey(
+                    rootTree->getHash(), globs, includeDotfiles);
+                return globCache->get(key).thenValue(
+                    [globCache, key, evaluate, &originHash](
+                        std::optional<std::vector<GlobResultCache::Entry>>&&
+                            cached) {
+                      if (cached) {
+                        std::vector<GlobNode::GlobResult> results;
+                        results.reserve(cached->size());
+                        for (auto& entry : *cached) {
+                          results.emplace_back(
+                              std::move(entry.name), entry.dtype, originHash);
+                        }
+                        return folly::makeFuture(std::move(results));
+                      }
+                      return evaluate().thenValue(
+                          [globCache,
+                           key](std::vector<GlobNode::GlobResult>&& results) {
+                            std::vector<GlobResultCache::Entry> entries;
+                            entries.reserve(results.size());
+                            for (const auto& result : results) {
+                              entries.push_back(GlobResultCache::Entry{
+                                  result.name, result.dtype});
+                            }
+                            globCache->put(key, std::move(entries));
+                            return std::move(results);
+                          });
+                    });
+              }));
     }
   } else {
     const Hash& originHash =
         originHashes->emplace_back(edenMount->getParentCommits().parent1());
     globResults.emplace_back(globRoot->evaluate(
-        edenMount->getObjectStore(),
+        treeFetcher.get(),
         fetchContext,
         RelativePathPiece(),
         edenMount->getRootInode(),
@@ -1194,6 +1426,7 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::future_globFiles(
       folly::collectAll(std::move(globResults))
           .via(server_->getServerState()->getThreadPool().get())
           .thenValue([fileBlobsToPrefetch,
+                      treeFetcher,
                       suppressFileList = *params->suppressFileList_ref()](
                          std::vector<folly::Try<
                              std::vector<GlobNode::GlobResult>>>&& rawResults) {
@@ -1289,8 +1522,19 @@ folly::Future<std::unique_ptr<Glob>> EdenServiceHandler::future_globFiles(
                 futures.emplace_back(store->prefetchBlobs(batch, fetchContext));
               }
 
-              return folly::collectUnsafe(futures).thenValue(
-                  [glob = std::move(out)](auto&&) mutable {
+              auto prefetched = folly::collectUnsafe(futures).unit();
+#ifndef _WIN32
+              // Pushing the prefetched contents into the kernel is
+              // best-effort, so the reply doesn't wait for it.
+              prefetched = std::move(prefetched)
+                               .thenValue([edenMount,
+                                           fileBlobsToPrefetch](folly::Unit) {
+                                 (void)edenMount->storeBlobsInKernelCache(
+                                     *fileBlobsToPrefetch->rlock());
+                               });
+#endif // !_WIN32
+              return std::move(prefetched)
+                  .thenValue([glob = std::move(out)](folly::Unit) mutable {
                     return makeFuture(std::move(glob));
                   });
             }
@@ -1743,6 +1987,9 @@ void EdenServiceHandler::clearFetchCounts() {
   for (auto& mount : server_->getMountPoints()) {
     mount->getObjectStore()->clearFetchCounts();
   }
+  for (auto& sharedState : server_->getObjectStoreSharedStates()) {
+    sharedState->pidFetchCounts.clear();
+  }
 }
 
 void EdenServiceHandler::clearFetchCountsByMount(
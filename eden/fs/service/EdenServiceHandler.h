@@ -23,6 +23,7 @@ namespace eden {
 class Hash;
 class EdenMount;
 class EdenServer;
+class JournalPathFilter;
 class TreeInode;
 class ObjectFetchContext;
 
@@ -49,6 +50,8 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
 
   void unmount(std::unique_ptr<std::string> mountPoint) override;
 
+  void mountSnapshot(std::unique_ptr<MountSnapshotArgument> argument) override;
+
   void listMounts(std::vector<MountInfo>& results) override;
 
   void checkOutRevision(
@@ -86,6 +89,12 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<JournalPosition> fromPosition) override;
 
+  void getFilesChangedSinceFiltered(
+      FileDelta& out,
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<JournalPosition> fromPosition,
+      std::unique_ptr<JournalFilter> filter) override;
+
   void setJournalMemoryLimit(
       std::unique_ptr<PathString> mountPoint,
       int64_t limit) override;
@@ -120,6 +129,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   apache::thrift::ServerStream<JournalPosition> subscribeStreamTemporary(
       std::unique_ptr<std::string> mountPoint) override;
 
+  apache::thrift::ServerStream<JournalPosition> subscribeStreamFiltered(
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<JournalFilter> filter) override;
+
 #ifndef _WIN32
   apache::thrift::ServerStream<FsEvent> traceFsEvents(
       std::unique_ptr<std::string> mountPoint,
@@ -129,6 +142,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   apache::thrift::ServerStream<HgEvent> traceHgEvents(
       std::unique_ptr<std::string> mountPoint) override;
 
+  apache::thrift::ServerStream<FileContentsChunk> streamReadFiles(
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<ReadFilesRequest> request) override;
+
   void getManifestEntry(
       ManifestEntry& out,
       std::unique_ptr<std::string> mountPoint,
@@ -273,6 +290,23 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       const EdenMount* mount,
       const RelativePathPiece filename);
 
+  /**
+   * Notify the returned stream of the journal changes that match the filter.
+   */
+  apache::thrift::ServerStream<JournalPosition> subscribeToJournal(
+      folly::StringPiece mountPoint,
+      JournalPathFilter filter);
+
+  /**
+   * Fill out with the journal changes since fromPosition that match the
+   * filter.
+   */
+  void getFilesChangedSince(
+      FileDelta& out,
+      EdenMount& edenMount,
+      const JournalPosition& fromPosition,
+      const JournalPathFilter& filter);
+
   const std::vector<std::string> originalCommandLine_;
   EdenServer* const server_;
 };
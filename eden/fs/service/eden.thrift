@@ -184,6 +184,18 @@ struct MountArgument {
   3: bool readOnly;
 }
 
+/**
+ * Arguments to mountSnapshot().
+ *
+ * sourceMountPoint is an existing checkout, whose repository the snapshot
+ * shares.
+ */
+struct MountSnapshotArgument {
+  1: PathString mountPoint;
+  2: PathString sourceMountPoint;
+  3: BinaryHash commit;
+}
+
 union SHA1Result {
   1: BinaryHash sha1;
   2: EdenError error;
@@ -245,6 +257,20 @@ struct JournalPosition {
   3: BinaryHash snapshotHash;
 }
 
+/**
+ * Selects the changed paths that a journal query or subscription is
+ * interested in.
+ *
+ * A path matches if it is equal to or under one of the pathPrefixes, or if it
+ * matches one of the globs.  The globs are matched against the whole path
+ * relative to the mount point, so a glob must start with a recursive wildcard
+ * to match files in any directory.  A filter with neither matches every path.
+ */
+struct JournalFilter {
+  1: list<PathString> pathPrefixes;
+  2: list<string> globs;
+}
+
 /**
  * Holds information about a set of paths that changed between two points.
  * fromPosition, toPosition define the time window.
@@ -816,6 +842,17 @@ service EdenService extends fb303_core.BaseService {
   void mount(1: MountArgument info) throws (1: EdenError ex);
   void unmount(1: PathString mountPoint) throws (1: EdenError ex);
 
+  /**
+   * Mount a read-only view of a commit at a new mount point.
+   *
+   * This is much cheaper than cloning a new checkout: the view shares the
+   * object store and blob cache of the source checkout, and doesn't have an
+   * on-disk overlay.  It isn't remounted when EdenFS restarts.
+   *
+   * Use unmount() to tear it down, which also removes all of its state.
+   */
+  void mountSnapshot(1: MountSnapshotArgument info) throws (1: EdenError ex);
+
   /**
    * Potentially check out the specified snapshot, reporting conflicts (and
    * possibly errors), as appropriate.
@@ -925,6 +962,17 @@ service EdenService extends fb303_core.BaseService {
     2: JournalPosition fromPosition,
   ) throws (1: EdenError ex);
 
+  /** Like getFilesChangedSince, but only returns the changed and unclean
+   * paths that match the filter.
+   * The positions and snapshotTransitions still cover every change, so that
+   * toPosition can be used as the basis of the next query.
+   */
+  FileDelta getFilesChangedSinceFiltered(
+    1: PathString mountPoint,
+    2: JournalPosition fromPosition,
+    3: JournalFilter filter,
+  ) throws (1: EdenError ex);
+
   /** Sets the memory limit on the journal such that the journal will forget
    * old data to keep itself under a certain estimated memory use.
    */
@@ -101,6 +101,30 @@ struct HgEvent {
   7: optional RequestInfo requestInfo
 }
 
+// Lets the contents of files be sent without copying them.
+typedef binary (cpp2.type = "folly::IOBuf") IOBuf
+
+struct ReadFilesRequest {
+  1: list<eden.PathString> paths
+  // If set, the files are read from this commit instead of the working copy.
+  2: optional eden.BinaryHash commit
+}
+
+/**
+ * A piece of the contents of one of the files of a ReadFilesRequest.
+ *
+ * index is the position of the file in the paths of the request, and offset
+ * is the position of data in the file. last is set on the final chunk of
+ * each file. If the file could not be read, its only chunk has error set.
+ */
+struct FileContentsChunk {
+  1: i32 index
+  2: i64 offset
+  3: IOBuf data
+  4: bool last
+  5: optional eden.EdenError error
+}
+
 /**
  * This Thrift service defines streaming functions. It is separate from
  * EdenService because older Thrift runtimes do not support Thrift streaming,
@@ -131,6 +155,18 @@ service StreamingEdenService extends eden.EdenService {
     1: eden.PathString mountPoint
   );
 
+  /**
+   * Like subscribeStreamTemporary, but only sends notifications for changes
+   * to paths that match the filter, and for changes of the current commit.
+   *
+   * The subscriber should respond to a notification by calling
+   * getFilesChangedSinceFiltered with the same filter.
+   */
+  stream<eden.JournalPosition> subscribeStreamFiltered(
+    1: eden.PathString mountPoint,
+    2: eden.JournalFilter filter,
+  );
+
   /**
    * Returns, in order, a stream of FUSE or PrjFS requests and responses for
    * the given mount.
@@ -150,4 +186,18 @@ service StreamingEdenService extends eden.EdenService {
    */
    stream<HgEvent> traceHgEvents(
      1: eden.PathString mountPoint)
+
+  /**
+   * Returns the contents of many files of the given mount at once, which is
+   * much cheaper than reading them one by one through the filesystem.
+   *
+   * The files are sent in the order of the paths, each as a sequence of
+   * FileContentsChunk. Errors reading one file are reported in its chunk,
+   * and don't interrupt the stream. Files are only read a little ahead of
+   * the chunks the client consumes.
+   */
+  stream<FileContentsChunk> streamReadFiles(
+    1: eden.PathString mountPoint,
+    2: ReadFilesRequest request,
+  );
 }
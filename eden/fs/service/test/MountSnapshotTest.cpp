@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <functional>
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <thrift/lib/cpp2/server/ThriftServer.h>
+
+#include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/service/EdenServer.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/testharness/TestServer.h"
+#include "eden/fs/utils/FileUtils.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+class MountSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // The "null" repository type has no commits, so snapshot mounts of it
+    // fail to initialize, which is enough to check how mountSnapshot() sets
+    // up and tears down their state.
+    auto clientDir = testServer_.getTmpDir() + "source"_pc;
+    ensureDirectoryExists(clientDir);
+    auto config =
+        "[repository]\n"
+        "path = \"/nonexistent\"\n"
+        "type = \"null\"\n";
+    writeFile(clientDir + "config.toml"_pc, folly::StringPiece{config})
+        .value();
+    source_ = CheckoutConfig::loadFromClientDirectory(
+        testServer_.getTmpDir() + "checkout"_pc, clientDir);
+  }
+
+  EdenServer& getServer() {
+    return testServer_.getServer();
+  }
+
+  AbsolutePath getSnapshotClientDir(AbsolutePathPiece mountPath) {
+    return testServer_.getTmpDir() + "eden/clients"_relpath +
+        PathComponent{folly::to<std::string>(
+            "snapshot-",
+            Hash::sha1(folly::ByteRange{mountPath.stringPiece()})
+                .toString())};
+  }
+
+  void runServer() {
+    auto& thriftServer = getServer().getServer();
+    thriftServer->serve();
+  }
+
+  /**
+   * Run fn on the main EventBase once condition holds, giving up after about
+   * ten seconds.
+   */
+  void runWhen(
+      std::function<bool()> condition,
+      std::function<void()> fn,
+      size_t attempts = 1000) {
+    if (attempts == 0 || condition()) {
+      fn();
+      return;
+    }
+    getServer().getMainEventBase()->runAfterDelay(
+        [this, condition, fn, attempts] {
+          runWhen(condition, fn, attempts - 1);
+        },
+        10);
+  }
+
+  template <typename F>
+  void runOnServerStart(F&& fn) {
+    auto cb = std::make_unique<folly::EventBase::FunctionLoopCallback>(
+        std::forward<F>(fn));
+    folly::EventBaseManager::get()->getEventBase()->runInLoop(cb.release());
+  }
+
+  TestServer testServer_;
+  std::unique_ptr<CheckoutConfig> source_;
+  Hash commit_{"0123456789abcdef0123456789abcdef01234567"};
+};
+} // namespace
+
+TEST_F(MountSnapshotTest, mountPointIsReservedWhileMounting) {
+  auto mountPath = testServer_.getTmpDir() + "snapshot"_pc;
+  auto clientDir = getSnapshotClientDir(mountPath);
+
+  runOnServerStart([&] {
+    auto first = getServer().mountSnapshot(mountPath, *source_, commit_);
+
+    // The state of the first mount is set up without a config.toml, since
+    // snapshot mounts are never remounted.
+    EXPECT_TRUE(folly::fs::exists((clientDir + "SNAPSHOT"_pc).value()));
+    EXPECT_FALSE(folly::fs::exists((clientDir + "config.toml"_pc).value()));
+
+    // The first mount is only torn down on the main EventBase, so it still
+    // owns the mount point and its client directory must be left alone.
+    auto second = getServer().mountSnapshot(mountPath, *source_, commit_);
+    ASSERT_TRUE(second.isReady());
+    try {
+      std::move(second).get();
+      ADD_FAILURE() << "mounting the same path twice should fail";
+    } catch (const EdenError& err) {
+      EXPECT_EQ(EEXIST, *err.errorCode_ref());
+    }
+    EXPECT_TRUE(folly::fs::exists((clientDir + "SNAPSHOT"_pc).value()));
+
+    std::move(first)
+        .via(getServer().getMainEventBase())
+        .thenTry([&](folly::Try<std::shared_ptr<EdenMount>>&& result) {
+          EXPECT_TRUE(result.hasException());
+          getServer().stop();
+        });
+  });
+
+  runServer();
+}
+
+TEST_F(MountSnapshotTest, failedMountRemovesItsState) {
+  auto mountPath = testServer_.getTmpDir() + "snapshot"_pc;
+  auto clientDir = getSnapshotClientDir(mountPath);
+
+  // Leftovers of a snapshot mount that wasn't cleanly unmounted are replaced.
+  ensureDirectoryExists(clientDir);
+  writeFile(clientDir + "leftover"_pc, folly::StringPiece{"stale"}).value();
+
+  runOnServerStart([&] {
+    auto mount = getServer().mountSnapshot(mountPath, *source_, commit_);
+    EXPECT_FALSE(folly::fs::exists((clientDir + "leftover"_pc).value()));
+
+    std::move(mount)
+        .via(getServer().getMainEventBase())
+        .thenTry([&](folly::Try<std::shared_ptr<EdenMount>>&& result) {
+          EXPECT_TRUE(result.hasException());
+          // The client directory is removed once the mount is torn down.
+          runWhen(
+              [&] { return !folly::fs::exists(clientDir.value()); },
+              [&] {
+                EXPECT_FALSE(folly::fs::exists(clientDir.value()));
+                getServer().stop();
+              });
+        });
+  });
+
+  runServer();
+}
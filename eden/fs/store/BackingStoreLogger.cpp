@@ -32,6 +32,12 @@ void BackingStoreLogger::logImport(
   if (!loggingAvailable_) {
     return;
   }
+  // Most imports aren't logged once sampled, so decide before looking up the
+  // process name.
+  auto sampleRate = logger_->sampleEvent<ServerDataFetch>();
+  if (!sampleRate) {
+    return;
+  }
   auto pid = context.getClientPid();
   auto cause = context.getCause();
   auto importPathString = importPath.stringPiece().str();
@@ -73,12 +79,14 @@ void BackingStoreLogger::logImport(
       break;
   }
 
-  logger_->logEvent(ServerDataFetch{
-      std::move(cause_string),
-      pid,
-      std::move(cmdline),
-      std::move(importPathString),
-      std::move(typeString)});
+  logger_->logEvent(
+      ServerDataFetch{
+          std::move(cause_string),
+          pid,
+          std::move(cmdline),
+          std::move(importPathString),
+          std::move(typeString)},
+      sampleRate);
 }
 
 } // namespace eden
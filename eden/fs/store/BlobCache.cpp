@@ -47,19 +47,38 @@ std::shared_ptr<const Blob> BlobInterestHandle::getBlob() const {
   return blob_.lock();
 }
 
+namespace {
+/// The share of the cache used by the admission window.
+constexpr size_t kWindowSizeDivisor = 100;
+
+/// Used to size the frequency sketch from the maximum cache size.
+constexpr size_t kExpectedAverageBlobSize = 16 * 1024;
+} // namespace
+
 std::shared_ptr<BlobCache> BlobCache::create(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount) {
+    size_t minimumEntryCount,
+    AdmissionPolicy admissionPolicy) {
   // Allow make_shared with private constructor.
   struct BC : BlobCache {
-    BC(size_t x, size_t y) : BlobCache{x, y} {}
+    BC(size_t x, size_t y, AdmissionPolicy z) : BlobCache{x, y, z} {}
   };
-  return std::make_shared<BC>(maximumCacheSizeBytes, minimumEntryCount);
+  return std::make_shared<BC>(
+      maximumCacheSizeBytes, minimumEntryCount, admissionPolicy);
 }
 
-BlobCache::BlobCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount)
+BlobCache::BlobCache(
+    size_t maximumCacheSizeBytes,
+    size_t minimumEntryCount,
+    AdmissionPolicy admissionPolicy)
     : maximumCacheSizeBytes_{maximumCacheSizeBytes},
-      minimumEntryCount_{minimumEntryCount} {}
+      minimumEntryCount_{minimumEntryCount},
+      windowSizeBytes_{maximumCacheSizeBytes / kWindowSizeDivisor} {
+  if (admissionPolicy == AdmissionPolicy::Frequency) {
+    state_.wlock()->sketch = std::make_unique<FrequencySketch>(std::max(
+        minimumEntryCount, maximumCacheSizeBytes / kExpectedAverageBlobSize));
+  }
+}
 
 BlobCache::~BlobCache() {}
 
@@ -72,6 +91,7 @@ BlobCache::GetResult BlobCache::get(const Hash& hash, Interest interest) {
   BlobInterestHandle interestHandle;
 
   auto state = state_.wlock();
+  recordAccess(*state, hash, interest);
 
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
@@ -104,10 +124,14 @@ BlobCache::GetResult BlobCache::get(const Hash& hash, Interest interest) {
 
   XLOG(DBG6) << "BlobCache::get hit";
 
+  if (interest != Interest::UnlikelyNeededAgain) {
+    item->bypassAdmission = false;
+  }
+
   // TODO: Should we avoid promoting if interest is UnlikelyNeededAgain?
   // For now, we'll try not to be too clever.
-  state->evictionQueue.splice(
-      state->evictionQueue.end(), state->evictionQueue, item->index);
+  auto& queue = getQueue(*state, *item);
+  queue.splice(queue.end(), queue, item->index);
   ++state->hitCount;
   return GetResult{item->blob, std::move(interestHandle)};
 }
@@ -138,6 +162,7 @@ BlobInterestHandle BlobCache::insert(
   XLOG(DBG6) << "  creating entry with generation=" << cacheItemGeneration;
 
   auto state = state_.wlock();
+  recordAccess(*state, hash, interest);
   auto [iter, inserted] =
       state->items.try_emplace(hash, std::move(blob), cacheItemGeneration);
   // noexcept from here until `try`
@@ -151,21 +176,31 @@ BlobInterestHandle BlobCache::insert(
   }
   auto* itemPtr = &iter->second;
   if (inserted) {
+    // With an admission policy, new entries start in the window.
+    itemPtr->inWindow = state->sketch != nullptr;
+    itemPtr->bypassAdmission = interest == Interest::UnlikelyNeededAgain;
+    auto& queue = getQueue(*state, *itemPtr);
     try {
-      state->evictionQueue.push_back(itemPtr);
+      queue.push_back(itemPtr);
     } catch (std::exception&) {
       state->items.erase(iter);
       throw;
     }
-    iter->second.index = std::prev(state->evictionQueue.end());
+    iter->second.index = std::prev(queue.end());
     state->totalSize += size;
+    if (itemPtr->inWindow) {
+      state->windowSize += size;
+    }
     evictUntilFits(*state);
   } else {
     XLOG(DBG6) << "  duplicate entry, using generation " << itemPtr->generation;
     // Inserting duplicate entry - use its generation.
     interestHandle.cacheItemGeneration_ = itemPtr->generation;
-    state->evictionQueue.splice(
-        state->evictionQueue.end(), state->evictionQueue, itemPtr->index);
+    if (interest != Interest::UnlikelyNeededAgain) {
+      itemPtr->bypassAdmission = false;
+    }
+    auto& queue = getQueue(*state, *itemPtr);
+    queue.splice(queue.end(), queue, itemPtr->index);
   }
   return interestHandle;
 }
@@ -179,8 +214,10 @@ void BlobCache::clear() {
   XLOG(DBG6) << "BlobCache::clear";
   auto state = state_.wlock();
   state->totalSize = 0;
+  state->windowSize = 0;
   state->items.clear();
   state->evictionQueue.clear();
+  state->windowQueue.clear();
 }
 
 BlobCache::Stats BlobCache::getStats() const {
@@ -192,6 +229,7 @@ BlobCache::Stats BlobCache::getStats() const {
   stats.missCount = state->missCount;
   stats.evictionCount = state->evictionCount;
   stats.dropCount = state->dropCount;
+  stats.rejectionCount = state->rejectionCount;
   return stats;
 }
 
@@ -221,26 +259,96 @@ void BlobCache::dropInterestHandle(
   }
 
   if (--item->referenceCount == 0) {
-    state->evictionQueue.erase(item->index);
+    getQueue(*state, *item).erase(item->index);
     ++state->dropCount;
     evictItem(*state, item);
   }
 }
 
+std::list<BlobCache::CacheItem*>& BlobCache::getQueue(
+    State& state,
+    CacheItem& item) {
+  return item.inWindow ? state.windowQueue : state.evictionQueue;
+}
+
+void BlobCache::recordAccess(
+    State& state,
+    const Hash& hash,
+    Interest interest) {
+  // Accesses that are unlikely to be repeated, like scans, would only pollute
+  // the frequency estimates.
+  if (state.sketch && interest != Interest::UnlikelyNeededAgain) {
+    state.sketch->increment(hash);
+  }
+}
+
+void BlobCache::admitFromWindow(State& state) noexcept {
+  while (state.windowSize > windowSizeBytes_) {
+    CacheItem* candidate = state.windowQueue.front();
+    auto size = candidate->blob->getSize();
+    if (shouldAdmit(state, *candidate)) {
+      state.evictionQueue.splice(
+          state.evictionQueue.end(), state.windowQueue, candidate->index);
+      candidate->inWindow = false;
+      state.windowSize -= size;
+    } else {
+      XLOG(DBG6) << "not admitting " << candidate->blob->getHash();
+      state.windowQueue.pop_front();
+      ++state.rejectionCount;
+      evictItem(state, candidate);
+    }
+  }
+}
+
+bool BlobCache::shouldAdmit(State& state, const CacheItem& candidate)
+    const noexcept {
+  auto size = candidate.blob->getSize();
+  auto mainSize = state.totalSize - state.windowSize;
+  auto mainCapacity = maximumCacheSizeBytes_ - windowSizeBytes_;
+  if (mainSize + size <= mainCapacity ||
+      state.items.size() <= minimumEntryCount_) {
+    return true;
+  }
+  if (candidate.bypassAdmission) {
+    return false;
+  }
+
+  // The candidate must be more popular than every entry it would displace,
+  // which prevents large one-off blobs from displacing many small hot ones.
+  auto candidateFrequency = state.sketch->estimate(candidate.blob->getHash());
+  size_t freed = 0;
+  for (auto* victim : state.evictionQueue) {
+    if (mainSize + size - freed <= mainCapacity) {
+      break;
+    }
+    if (state.sketch->estimate(victim->blob->getHash()) >= candidateFrequency) {
+      return false;
+    }
+    freed += victim->blob->getSize();
+  }
+  return true;
+}
+
 void BlobCache::evictUntilFits(State& state) noexcept {
   XLOG(DBG6) << "state.totalSize=" << state.totalSize
              << ", maximumCacheSizeBytes_=" << maximumCacheSizeBytes_
              << ", evictionQueue.size()=" << state.evictionQueue.size()
+             << ", windowQueue.size()=" << state.windowQueue.size()
              << ", minimumEntryCount_=" << minimumEntryCount_;
+  if (state.sketch) {
+    admitFromWindow(state);
+  }
   while (state.totalSize > maximumCacheSizeBytes_ &&
-         state.evictionQueue.size() > minimumEntryCount_) {
+         state.items.size() > minimumEntryCount_) {
     evictOne(state);
   }
 }
 
 void BlobCache::evictOne(State& state) noexcept {
-  CacheItem* front = state.evictionQueue.front();
-  state.evictionQueue.pop_front();
+  auto& queue =
+      state.evictionQueue.empty() ? state.windowQueue : state.evictionQueue;
+  CacheItem* front = queue.front();
+  queue.pop_front();
   ++state.evictionCount;
   evictItem(state, front);
 }
@@ -249,6 +357,9 @@ void BlobCache::evictItem(State& state, CacheItem* item) noexcept {
   XLOG(DBG6) << "evicting " << item->blob->getHash()
              << " generation=" << item->generation;
   auto size = item->blob->getSize();
+  if (item->inWindow) {
+    state.windowSize -= size;
+  }
   // TODO: Releasing this BlobPtr here can run arbitrary deleters which could,
   // in theory, try to reacquire the BlobCache's lock. The blob could be
   // scheduled for deletion in a deletion queue but then it's hard to ensure
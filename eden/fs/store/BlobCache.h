@@ -10,8 +10,10 @@
 #include <folly/Synchronized.h>
 #include <cstddef>
 #include <list>
+#include <memory>
 #include <unordered_map>
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/store/FrequencySketch.h"
 
 namespace facebook {
 namespace eden {
@@ -77,6 +79,15 @@ class BlobInterestHandle {
  * frequently-accessed large blobs when they are larger than the maximum cache
  * size.
  *
+ * Optionally, the cache can use a frequency-aware admission policy (TinyLFU)
+ * to resist scans, like a `grep -r`, that would otherwise flush the hot blobs
+ * out of the cache. New blobs are first inserted into a small window at the
+ * front of the cache. When they leave the window, they are only admitted into
+ * the main cache if they have been accessed more often recently than every
+ * blob they would displace. Blobs inserted with UnlikelyNeededAgain bypass
+ * the admission filter: they are only admitted if they fit without
+ * displacing anything.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 class BlobCache : public std::enable_shared_from_this<BlobCache> {
@@ -122,11 +133,20 @@ class BlobCache : public std::enable_shared_from_this<BlobCache> {
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    uint64_t rejectionCount{0};
+  };
+
+  enum class AdmissionPolicy {
+    /** Every inserted blob is cached, and evicted in LRU order. */
+    Always,
+    /** See the TinyLFU admission policy described above. */
+    Frequency,
   };
 
   static std::shared_ptr<BlobCache> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount);
+      size_t minimumEntryCount,
+      AdmissionPolicy admissionPolicy = AdmissionPolicy::Always);
   ~BlobCache();
 
   /**
@@ -202,6 +222,13 @@ class BlobCache : public std::enable_shared_from_this<BlobCache> {
     /// Given a unique value upon allocation. Used to verify InterestHandle
     // matches this specific item.
     uint64_t generation{0};
+
+    /// Whether index points into the window queue or the eviction queue.
+    bool inWindow{false};
+
+    /// Set while the blob has only been inserted or accessed with
+    /// UnlikelyNeededAgain.
+    bool bypassAdmission{false};
   };
 
   struct State {
@@ -211,21 +238,38 @@ class BlobCache : public std::enable_shared_from_this<BlobCache> {
     /// Entries are evicted from the front of the queue.
     std::list<CacheItem*> evictionQueue;
 
+    /// With AdmissionPolicy::Frequency, new entries wait in this queue before
+    /// they are considered for admission into the eviction queue.
+    std::list<CacheItem*> windowQueue;
+    size_t windowSize{0};
+
+    /// Only allocated with AdmissionPolicy::Frequency.
+    std::unique_ptr<FrequencySketch> sketch;
+
     uint64_t hitCount{0};
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    uint64_t rejectionCount{0};
   };
 
   void dropInterestHandle(const Hash& hash, uint64_t generation) noexcept;
 
-  explicit BlobCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount);
+  BlobCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      AdmissionPolicy admissionPolicy);
+  static std::list<CacheItem*>& getQueue(State& state, CacheItem& item);
+  void recordAccess(State& state, const Hash& hash, Interest interest);
+  void admitFromWindow(State& state) noexcept;
+  bool shouldAdmit(State& state, const CacheItem& candidate) const noexcept;
   void evictUntilFits(State& state) noexcept;
   void evictOne(State& state) noexcept;
   void evictItem(State&, CacheItem* item) noexcept;
 
   const size_t maximumCacheSizeBytes_;
   const size_t minimumEntryCount_;
+  const size_t windowSizeBytes_;
   folly::Synchronized<State> state_;
 
   friend class BlobInterestHandle;
@@ -649,9 +649,9 @@ FOLLY_NODISCARD Future<Unit> diffTrees(
     const GitIgnoreStack* ignore,
     bool isIgnored) {
   auto scmTreeFuture =
-      context->store->getTree(scmHash, context->getFetchContext());
+      context->getTreeFetcher().getTree(scmHash, context->getFetchContext());
   auto wdTreeFuture =
-      context->store->getTree(wdHash, context->getFetchContext());
+      context->getTreeFetcher().getTree(wdHash, context->getFetchContext());
   // Optimization for the case when both tree objects are immediately ready.
   // We can avoid copying the input path in this case.
   if (scmTreeFuture.isReady() && wdTreeFuture.isReady()) {
@@ -681,7 +681,8 @@ FOLLY_NODISCARD Future<Unit> diffAddedTree(
     Hash wdHash,
     const GitIgnoreStack* ignore,
     bool isIgnored) {
-  auto wdFuture = context->store->getTree(wdHash, context->getFetchContext());
+  auto wdFuture =
+      context->getTreeFetcher().getTree(wdHash, context->getFetchContext());
   // Optimization for the case when the tree object is immediately ready.
   // We can avoid copying the input path in this case.
   if (wdFuture.isReady()) {
@@ -700,7 +701,8 @@ FOLLY_NODISCARD Future<Unit> diffRemovedTree(
     DiffContext* context,
     RelativePathPiece currentPath,
     Hash scmHash) {
-  auto scmFuture = context->store->getTree(scmHash, context->getFetchContext());
+  auto scmFuture =
+      context->getTreeFetcher().getTree(scmHash, context->getFetchContext());
   // Optimization for the case when the tree object is immediately ready.
   // We can avoid copying the input path in this case.
   if (scmFuture.isReady()) {
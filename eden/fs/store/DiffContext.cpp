@@ -24,13 +24,15 @@ DiffContext::DiffContext(
     const ObjectStore* os,
     std::unique_ptr<TopLevelIgnores> topLevelIgnores,
     LoadFileFunction loadFileContentsFromPath,
-    ResponseChannelRequest* request)
+    ResponseChannelRequest* request,
+    size_t maxTreeFetches)
     : callback{cb},
       store{os},
       listIgnored{listIgnored},
       topLevelIgnores_(std::move(topLevelIgnores)),
       loadFileContentsFromPath_{loadFileContentsFromPath},
-      request_{request} {}
+      request_{request},
+      treeFetcher_{os, maxTreeFetches, [this] { return isCancelled(); }} {}
 
 DiffContext::DiffContext(DiffCallback* cb, const ObjectStore* os)
     : callback{cb},
@@ -38,7 +40,8 @@ DiffContext::DiffContext(DiffCallback* cb, const ObjectStore* os)
       listIgnored{true},
       topLevelIgnores_{std::unique_ptr<TopLevelIgnores>()},
       loadFileContentsFromPath_{nullptr},
-      request_{nullptr} {};
+      request_{nullptr},
+      treeFetcher_{os} {};
 
 DiffContext::~DiffContext() = default;
 
@@ -11,6 +11,7 @@
 #include <folly/futures/Future.h>
 
 #include "eden/fs/store/StatsFetchContext.h"
+#include "eden/fs/store/TreeFetchScheduler.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace folly {
@@ -55,7 +56,8 @@ class DiffContext {
       const ObjectStore* os,
       std::unique_ptr<TopLevelIgnores> topLevelIgnores,
       LoadFileFunction loadFileContentsFromPath,
-      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request = nullptr);
+      apache::thrift::ResponseChannelRequest* FOLLY_NULLABLE request = nullptr,
+      size_t maxTreeFetches = TreeFetchScheduler::kDefaultMaxInFlight);
   DiffContext(DiffCallback* cb, const ObjectStore* os);
 
   DiffContext(const DiffContext&) = delete;
@@ -80,12 +82,20 @@ class DiffContext {
   StatsFetchContext& getFetchContext() {
     return fetchContext_;
   }
+  /**
+   * Source control trees must be fetched through this, to bound the number
+   * of concurrent fetches. Queued fetches fail once the diff is cancelled.
+   */
+  TreeFetchScheduler& getTreeFetcher() {
+    return treeFetcher_;
+  }
 
  private:
   std::unique_ptr<TopLevelIgnores> topLevelIgnores_;
   const LoadFileFunction loadFileContentsFromPath_;
   apache::thrift::ResponseChannelRequest* const FOLLY_NULLABLE request_;
   StatsFetchContext fetchContext_;
+  TreeFetchScheduler treeFetcher_;
 };
 } // namespace eden
 } // namespace facebook
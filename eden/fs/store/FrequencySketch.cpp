@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FrequencySketch.h"
+
+#include <folly/Bits.h>
+#include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <algorithm>
+
+namespace facebook {
+namespace eden {
+
+namespace {
+constexpr size_t kMinimumWidth = 64;
+constexpr size_t kMaximumWidth = 1 << 20;
+
+size_t hashObject(const Hash& hash) {
+  // Hash::getHashCode() only looks at a prefix of the hash, which is not
+  // enough for hashes that aren't uniformly distributed.
+  auto bytes = hash.getBytes();
+  return folly::hash::SpookyHashV2::Hash64(bytes.data(), bytes.size(), 0);
+}
+} // namespace
+
+constexpr uint8_t FrequencySketch::kMaxFrequency;
+constexpr size_t FrequencySketch::kDepth;
+
+FrequencySketch::FrequencySketch(size_t expectedEntries)
+    : width_{folly::nextPowTwo(
+          std::clamp(expectedEntries, kMinimumWidth, kMaximumWidth))},
+      sampleSize_{10 * width_},
+      table_(kDepth * width_) {}
+
+size_t FrequencySketch::getIndex(size_t hashValue, size_t row) const {
+  // Each row uses a differently seeded hash of the object.
+  auto mixed = folly::hash::twang_mix64(hashValue + row * 0x9e3779b97f4a7c15);
+  return row * width_ + (mixed & (width_ - 1));
+}
+
+void FrequencySketch::increment(const Hash& hash) {
+  auto hashValue = hashObject(hash);
+  bool incremented = false;
+  for (size_t row = 0; row < kDepth; ++row) {
+    auto& counter = table_[getIndex(hashValue, row)];
+    if (counter < kMaxFrequency) {
+      ++counter;
+      incremented = true;
+    }
+  }
+  if (incremented && ++additions_ >= sampleSize_) {
+    age();
+  }
+}
+
+uint8_t FrequencySketch::estimate(const Hash& hash) const {
+  auto hashValue = hashObject(hash);
+  uint8_t frequency = kMaxFrequency;
+  for (size_t row = 0; row < kDepth; ++row) {
+    frequency = std::min(frequency, table_[getIndex(hashValue, row)]);
+  }
+  return frequency;
+}
+
+void FrequencySketch::age() {
+  for (auto& counter : table_) {
+    counter >>= 1;
+  }
+  additions_ /= 2;
+}
+
+} // namespace eden
+} // namespace facebook
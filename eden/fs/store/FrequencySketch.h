@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "eden/fs/model/Hash.h"
+
+namespace facebook {
+namespace eden {
+
+/**
+ * A count-min sketch estimating how often objects were accessed recently, in
+ * a fixed amount of memory. Used by BlobCache to decide which blobs are worth
+ * admitting.
+ *
+ * Counters saturate at 15. Once the number of recorded accesses reaches ten
+ * times the width of the sketch, all the counters are halved, so that the
+ * estimates favor recent accesses.
+ *
+ * This class is not thread-safe.
+ */
+class FrequencySketch {
+ public:
+  static constexpr uint8_t kMaxFrequency = 15;
+
+  /**
+   * expectedEntries is the number of distinct objects that the sketch should
+   * be able to tell apart.
+   */
+  explicit FrequencySketch(size_t expectedEntries);
+
+  void increment(const Hash& hash);
+
+  uint8_t estimate(const Hash& hash) const;
+
+ private:
+  static constexpr size_t kDepth = 4;
+
+  size_t getIndex(size_t hashValue, size_t row) const;
+  void age();
+
+  size_t width_;
+  size_t sampleSize_;
+  size_t additions_{0};
+  // kDepth rows of width_ counters.
+  std::vector<uint8_t> table_;
+};
+
+} // namespace eden
+} // namespace facebook
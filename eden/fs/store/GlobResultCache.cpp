@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/GlobResultCache.h"
+
+#include <folly/Format.h>
+#include <folly/Varint.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook {
+namespace eden {
+
+namespace {
+constexpr uint8_t kFormatVersion = 1;
+
+void appendVarint(std::string& out, uint64_t value) {
+  uint8_t buf[folly::kMaxVarintLength64];
+  auto length = folly::encodeVarint(value, buf);
+  out.append(reinterpret_cast<const char*>(buf), length);
+}
+
+uint64_t readVarint(folly::ByteRange& data) {
+  auto value = folly::tryDecodeVarint(data);
+  if (value.hasError()) {
+    throw std::invalid_argument("truncated glob results");
+  }
+  return value.value();
+}
+} // namespace
+
+GlobResultCache::GlobResultCache(
+    std::shared_ptr<LocalStore> localStore,
+    std::shared_ptr<EdenStats> stats)
+    : localStore_{std::move(localStore)}, stats_{std::move(stats)} {}
+
+Hash GlobResultCache::makeKey(
+    const Hash& rootTreeHash,
+    std::vector<std::string> globs,
+    bool includeDotfiles) {
+  std::sort(globs.begin(), globs.end());
+  globs.erase(std::unique(globs.begin(), globs.end()), globs.end());
+
+  // The format version is part of the key, so that results stored in an older
+  // format are never read.
+  std::string keyData;
+  keyData.push_back(static_cast<char>(kFormatVersion));
+  keyData.append(
+      reinterpret_cast<const char*>(rootTreeHash.getBytes().data()),
+      Hash::RAW_SIZE);
+  keyData.push_back(includeDotfiles ? 1 : 0);
+  for (const auto& glob : globs) {
+    // Patterns can't contain NUL bytes, so this is unambiguous.
+    keyData.append(glob);
+    keyData.push_back('\0');
+  }
+  return Hash::sha1(folly::StringPiece{keyData});
+}
+
+folly::Future<std::optional<std::vector<GlobResultCache::Entry>>>
+GlobResultCache::get(const Hash& key) const {
+  return localStore_->getFuture(KeySpace::GlobResultFamily, key.getBytes())
+      .thenTry([key, stats = stats_](folly::Try<StoreResult>&& data)
+                   -> std::optional<std::vector<Entry>> {
+        auto& threadStats = stats->getObjectStoreStatsForCurrentThread();
+        try {
+          if (data->isValid()) {
+            auto entries = deserialize(data->bytes());
+            threadStats.globResultCacheHit.addValue(1);
+            return entries;
+          }
+        } catch (const std::exception& ex) {
+          XLOG(WARN) << "ignoring cached glob results " << key << ": "
+                     << ex.what();
+        }
+        threadStats.globResultCacheMiss.addValue(1);
+        return std::nullopt;
+      });
+}
+
+void GlobResultCache::put(const Hash& key, std::vector<Entry> entries) const {
+  auto data = serialize(std::move(entries));
+  try {
+    localStore_->put(KeySpace::GlobResultFamily, key, folly::StringPiece{data});
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "failed to cache glob results " << key << ": " << ex.what();
+  }
+}
+
+std::string GlobResultCache::serialize(std::vector<Entry> entries) {
+  std::sort(entries.begin(), entries.end());
+  entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+  std::string out;
+  out.push_back(static_cast<char>(kFormatVersion));
+  appendVarint(out, entries.size());
+  folly::StringPiece previous;
+  for (const auto& entry : entries) {
+    auto name = entry.name.stringPiece();
+    size_t shared = 0;
+    while (shared < name.size() && shared < previous.size() &&
+           name[shared] == previous[shared]) {
+      ++shared;
+    }
+    appendVarint(out, shared);
+    appendVarint(out, name.size() - shared);
+    out.append(name.begin() + shared, name.end());
+    out.push_back(static_cast<char>(entry.dtype));
+    previous = name;
+  }
+  return out;
+}
+
+std::vector<GlobResultCache::Entry> GlobResultCache::deserialize(
+    folly::ByteRange data) {
+  if (data.empty() || data[0] != kFormatVersion) {
+    throw std::invalid_argument("unsupported glob results format");
+  }
+  data.advance(1);
+
+  auto count = readVarint(data);
+  std::vector<Entry> entries;
+  // Each entry takes at least 3 bytes.
+  entries.reserve(std::min<uint64_t>(count, data.size() / 3));
+  std::string name;
+  for (uint64_t i = 0; i < count; ++i) {
+    auto shared = readVarint(data);
+    auto length = readVarint(data);
+    if (shared > name.size() || length >= data.size()) {
+      throw std::invalid_argument(folly::sformat(
+          "glob result {} is truncated or refers to a missing prefix", i));
+    }
+    name.resize(shared);
+    name.append(reinterpret_cast<const char*>(data.data()), length);
+    data.advance(length);
+    auto dtype = static_cast<dtype_t>(data[0]);
+    data.advance(1);
+    entries.push_back(Entry{RelativePath{name}, dtype});
+  }
+  if (!data.empty()) {
+    throw std::invalid_argument("trailing data after glob results");
+  }
+  return entries;
+}
+
+} // namespace eden
+} // namespace facebook
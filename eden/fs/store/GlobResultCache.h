@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/futures/Future.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook {
+namespace eden {
+
+class EdenStats;
+class LocalStore;
+
+/**
+ * Caches the results of globs evaluated against source control trees, which
+ * are immutable, in the GlobResultFamily key space of the LocalStore.
+ *
+ * Results are keyed by the root tree, the set of patterns and the options
+ * that affect the matches, so that repeating a query against the same
+ * revision does not need to load any tree.
+ *
+ * GlobResultCache objects are cheap to create: all the state is held in the
+ * LocalStore.
+ */
+class GlobResultCache {
+ public:
+  struct Entry {
+    RelativePath name;
+    dtype_t dtype;
+
+    bool operator==(const Entry& other) const {
+      return name == other.name && dtype == other.dtype;
+    }
+    bool operator<(const Entry& other) const {
+      return name < other.name || (name == other.name && dtype < other.dtype);
+    }
+  };
+
+  GlobResultCache(
+      std::shared_ptr<LocalStore> localStore,
+      std::shared_ptr<EdenStats> stats);
+
+  /**
+   * Compute the key of the results of evaluating the globs against the given
+   * root tree. The order of the globs and duplicates don't matter.
+   */
+  static Hash makeKey(
+      const Hash& rootTreeHash,
+      std::vector<std::string> globs,
+      bool includeDotfiles);
+
+  /**
+   * Returns the cached results for the key, or std::nullopt if there are
+   * none.
+   *
+   * The cache is only an optimization: errors reading or writing it are
+   * logged, and otherwise treated as a miss.
+   */
+  folly::Future<std::optional<std::vector<Entry>>> get(const Hash& key) const;
+
+  void put(const Hash& key, std::vector<Entry> entries) const;
+
+  /**
+   * Serialize the entries sorted by name, each storing only the part of its
+   * name that differs from the previous one.
+   *
+   * The serialized data is stored as:
+   * - format version (1 byte)
+   * - number of entries (varint)
+   * - for each entry:
+   *   - length of the prefix shared with the previous name (varint)
+   *   - length of the rest of the name (varint)
+   *   - rest of the name
+   *   - dtype (1 byte)
+   */
+  static std::string serialize(std::vector<Entry> entries);
+
+  /**
+   * Throws std::invalid_argument if the data is not valid.
+   */
+  static std::vector<Entry> deserialize(folly::ByteRange data);
+
+ private:
+  std::shared_ptr<LocalStore> localStore_;
+  std::shared_ptr<EdenStats> stats_;
+};
+
+} // namespace eden
+} // namespace facebook
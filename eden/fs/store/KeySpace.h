@@ -99,6 +99,11 @@ class KeySpace {
       7,
       "treemeta",
       Ephemeral{&EdenConfig::localStoreTreeMetaSizeLimit}};
+  // Results of globs against source control trees, see GlobResultCache.
+  static constexpr KeySpaceRecord GlobResultFamily{
+      8,
+      "globresult",
+      Ephemeral{&EdenConfig::localStoreGlobResultSizeLimit}};
 
   static constexpr const KeySpaceRecord* kAll[] = {
       &BlobFamily,
@@ -108,7 +113,8 @@ class KeySpace {
       &HgCommitToTreeFamily,
       &BlobSizeFamily,
       &ScsProxyHashFamily,
-      &TreeMetaDataFamily};
+      &TreeMetaDataFamily,
+      &GlobResultFamily};
   static constexpr size_t kTotalCount = std::size(kAll);
 
  private:
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ObjectNegativeCache.h"
+
+#include <algorithm>
+
+#include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/EnumValue.h"
+
+namespace facebook {
+namespace eden {
+
+constexpr size_t ObjectNegativeCache::kDefaultMaxEntries;
+
+ObjectNegativeCache::ObjectNegativeCache(size_t maxEntries)
+    : trees_{folly::in_place, maxEntries},
+      blobs_{folly::in_place, maxEntries} {}
+
+folly::Synchronized<ObjectNegativeCache::Map>& ObjectNegativeCache::getMap(
+    ObjectType type) {
+  switch (type) {
+    case ObjectType::Tree:
+      return trees_;
+    case ObjectType::Blob:
+      return blobs_;
+  }
+  EDEN_BUG() << "unknown object type " << enumValue(type);
+}
+
+std::optional<ObjectNegativeCache::Failure> ObjectNegativeCache::lookup(
+    ObjectType type,
+    const Hash& id,
+    Clock::time_point now) {
+  auto map = getMap(type).rlock();
+  auto it = map->findWithoutPromotion(id);
+  if (it == map->end() || now >= it->second.retryAfter) {
+    return std::nullopt;
+  }
+  return it->second.failure;
+}
+
+void ObjectNegativeCache::recordNotFound(
+    ObjectType type,
+    const Hash& id,
+    Clock::duration ttl,
+    Clock::time_point now) {
+  getMap(type).wlock()->set(
+      id, Entry{Failure{ErrorClass::NotFound, {}}, now + ttl});
+}
+
+void ObjectNegativeCache::recordTransientFailure(
+    ObjectType type,
+    const Hash& id,
+    folly::exception_wrapper error,
+    Clock::duration initialBackoff,
+    Clock::duration maxBackoff,
+    Clock::time_point now) {
+  auto map = getMap(type).wlock();
+
+  uint32_t consecutiveFailures = 0;
+  auto it = map->find(id);
+  if (it != map->end() &&
+      it->second.failure.errorClass == ErrorClass::Transient &&
+      now < it->second.retryAfter + maxBackoff) {
+    consecutiveFailures = it->second.consecutiveFailures;
+  }
+
+  auto backoff = initialBackoff;
+  for (uint32_t i = 0; i < consecutiveFailures && backoff < maxBackoff; ++i) {
+    backoff *= 2;
+  }
+  backoff = std::min(backoff, maxBackoff);
+
+  map->set(
+      id,
+      Entry{
+          Failure{ErrorClass::Transient, std::move(error)},
+          now + backoff,
+          consecutiveFailures + 1});
+}
+
+void ObjectNegativeCache::recordSuccess(ObjectType type, const Hash& id) {
+  auto& map = getMap(type);
+  // Failures are rare, avoid serializing all the imports on the write lock.
+  if (!map.rlock()->exists(id)) {
+    return;
+  }
+  map.wlock()->erase(id);
+}
+
+size_t ObjectNegativeCache::size() const {
+  return trees_.rlock()->size() + blobs_.rlock()->size();
+}
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <chrono>
+#include <optional>
+
+#include "eden/fs/model/Hash.h"
+
+namespace facebook {
+namespace eden {
+
+/**
+ * Remembers recent failures to import objects from the backing store, so that
+ * repeated requests for an unavailable object fail fast instead of going to
+ * the backing store every time.
+ *
+ * Objects that the backing store reported as missing are remembered for a
+ * fixed TTL. Other errors are treated as transient: the object is retried
+ * after a backoff that doubles with each consecutive failure.
+ *
+ * The cache is bounded: the least recently recorded failures are evicted
+ * first.
+ */
+class ObjectNegativeCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t kDefaultMaxEntries = 100000;
+
+  enum class ObjectType : uint8_t {
+    Tree,
+    Blob,
+  };
+
+  enum class ErrorClass : uint8_t {
+    /** The backing store does not have the object. */
+    NotFound,
+    /** The import failed, and may succeed if retried. */
+    Transient,
+  };
+
+  struct Failure {
+    ErrorClass errorClass;
+    /** The error of a Transient failure. Empty for NotFound. */
+    folly::exception_wrapper error;
+  };
+
+  explicit ObjectNegativeCache(size_t maxEntries = kDefaultMaxEntries);
+
+  ObjectNegativeCache(const ObjectNegativeCache&) = delete;
+  ObjectNegativeCache& operator=(const ObjectNegativeCache&) = delete;
+
+  /**
+   * If the object failed to import recently enough that it should not be
+   * fetched again yet, return that failure.
+   */
+  std::optional<Failure> lookup(
+      ObjectType type,
+      const Hash& id,
+      Clock::time_point now = Clock::now());
+
+  void recordNotFound(
+      ObjectType type,
+      const Hash& id,
+      Clock::duration ttl,
+      Clock::time_point now = Clock::now());
+
+  /**
+   * Record a transient failure. The object will not be fetched again for
+   * initialBackoff, doubled for each consecutive failure up to maxBackoff.
+   * The count of consecutive failures is reset once the object hasn't failed
+   * for maxBackoff after its last backoff.
+   */
+  void recordTransientFailure(
+      ObjectType type,
+      const Hash& id,
+      folly::exception_wrapper error,
+      Clock::duration initialBackoff,
+      Clock::duration maxBackoff,
+      Clock::time_point now = Clock::now());
+
+  /**
+   * Forget any failure recorded for the object.
+   */
+  void recordSuccess(ObjectType type, const Hash& id);
+
+  size_t size() const;
+
+ private:
+  struct Entry {
+    Failure failure;
+    Clock::time_point retryAfter;
+    uint32_t consecutiveFailures{0};
+  };
+  using Map = folly::EvictingCacheMap<Hash, Entry>;
+
+  folly::Synchronized<Map>& getMap(ObjectType type);
+
+  folly::Synchronized<Map> trees_;
+  folly::Synchronized<Map> blobs_;
+};
+
+} // namespace eden
+} // namespace facebook
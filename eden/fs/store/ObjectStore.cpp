@@ -13,6 +13,7 @@
 #include <folly/futures/Future.h>
 #include <folly/io/IOBuf.h>
 
+#include <optional>
 #include <stdexcept>
 
 #include "eden/fs/model/Blob.h"
@@ -21,6 +22,8 @@
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/EnumValue.h"
 
 using folly::Future;
 using folly::makeFuture;
@@ -38,7 +41,11 @@ std::shared_ptr<ObjectStore> ObjectStore::create(
     folly::Executor::KeepAlive<folly::Executor> executor,
     std::shared_ptr<ProcessNameCache> processNameCache,
     std::shared_ptr<StructuredLogger> structuredLogger,
-    std::shared_ptr<const EdenConfig> edenConfig) {
+    std::shared_ptr<const EdenConfig> edenConfig,
+    std::shared_ptr<ObjectStoreSharedState> sharedState) {
+  if (!sharedState) {
+    sharedState = std::make_shared<ObjectStoreSharedState>();
+  }
   return std::shared_ptr<ObjectStore>{new ObjectStore{
       std::move(localStore),
       std::move(backingStore),
@@ -46,7 +53,8 @@ std::shared_ptr<ObjectStore> ObjectStore::create(
       executor,
       processNameCache,
       structuredLogger,
-      edenConfig}};
+      edenConfig,
+      std::move(sharedState)}};
 }
 
 ObjectStore::ObjectStore(
@@ -56,8 +64,9 @@ ObjectStore::ObjectStore(
     folly::Executor::KeepAlive<folly::Executor> executor,
     std::shared_ptr<ProcessNameCache> processNameCache,
     std::shared_ptr<StructuredLogger> structuredLogger,
-    std::shared_ptr<const EdenConfig> edenConfig)
-    : metadataCache_{folly::in_place, kCacheSize},
+    std::shared_ptr<const EdenConfig> edenConfig,
+    std::shared_ptr<ObjectStoreSharedState> sharedState)
+    : sharedState_{std::move(sharedState)},
       localStore_{std::move(localStore)},
       backingStore_{std::move(backingStore)},
       stats_{std::move(stats)},
@@ -72,7 +81,11 @@ ObjectStore::~ObjectStore() {}
 void ObjectStore::updateProcessFetch(
     const ObjectFetchContext& fetchContext) const {
   if (auto pid = fetchContext.getClientPid()) {
-    auto fetch_count = pidFetchCounts_->recordProcessFetch(pid.value());
+    pidFetchCounts_->recordProcessFetch(pid.value());
+    // Whether a process is fetch-heavy depends on its fetches across all the
+    // mounts of the repository.
+    auto fetch_count =
+        sharedState_->pidFetchCounts.recordProcessFetch(pid.value());
     auto threshold = edenConfig_->fetchHeavyThreshold.getValue();
     if (fetch_count && threshold && !(fetch_count % threshold)) {
       sendFetchHeavyEvent(pid.value(), fetch_count);
@@ -81,10 +94,14 @@ void ObjectStore::updateProcessFetch(
 }
 
 void ObjectStore::sendFetchHeavyEvent(pid_t pid, uint64_t fetch_count) const {
+  auto sampleRate = structuredLogger_->sampleEvent<FetchHeavy>();
+  if (!sampleRate) {
+    return;
+  }
   auto processName = processNameCache_->getSpacedProcessName(pid);
   if (processName.has_value()) {
     structuredLogger_->logEvent(
-        FetchHeavy{processName.value(), pid, fetch_count});
+        FetchHeavy{processName.value(), pid, fetch_count}, sampleRate);
   }
 }
 
@@ -92,7 +109,7 @@ void ObjectStore::deprioritizeWhenFetchHeavy(
     ObjectFetchContext& context) const {
   auto pid = context.getClientPid();
   if (pid.has_value()) {
-    auto fetch_count = pidFetchCounts_->getCountByPid(pid.value());
+    auto fetch_count = sharedState_->pidFetchCounts.getCountByPid(pid.value());
     auto threshold = edenConfig_->fetchHeavyThreshold.getValue();
     if (threshold && fetch_count >= threshold) {
       context.deprioritize(importPriorityDeprioritizeAmount);
@@ -119,42 +136,121 @@ Future<shared_ptr<const Tree>> ObjectStore::getTree(
 
     self->deprioritizeWhenFetchHeavy(fetchContext);
 
-    // Note: We don't currently have logic here to avoid duplicate work if
-    // multiple callers request the same tree at once.  We could store a map
-    // of pending lookups as (Hash --> std::list<Promise<unique_ptr<Tree>>),
-    // and just add a new Promise to the list if this Hash already exists in
-    // the pending list.
-    //
-    // However, de-duplication of object loads will already be done at the
-    // Inode layer.  Therefore we currently don't bother de-duping loads at
-    // this layer.
-
     // Load the tree from the BackingStore.
-    return self->backingStore_->getTree(id, fetchContext)
-        .via(self->executor_)
-        .thenValue([self, id, &fetchContext, localStore = self->localStore_](
-                       unique_ptr<const Tree> loadedTree) {
-          if (!loadedTree) {
-            // TODO: Perhaps we should do some short-term negative
-            // caching?
+    return self->getTreeFromBackingStore(id, fetchContext)
+        .thenValue([self, id, &fetchContext](
+                       BackingStoreResult<Tree> result) {
+          if (!result.object) {
             XLOG(DBG2) << "unable to find tree " << id;
             throw std::domain_error(
                 folly::to<string>("tree ", id.toString(), " not found"));
           }
 
-          localStore->putTree(loadedTree.get());
           XLOG(DBG3) << "tree " << id << " retrieved from backing store";
-          fetchContext.didFetch(
-              ObjectFetchContext::Tree,
-              id,
-              ObjectFetchContext::FromBackingStore);
+          if (result.fetched) {
+            fetchContext.didFetch(
+                ObjectFetchContext::Tree,
+                id,
+                ObjectFetchContext::FromBackingStore);
 
-          self->updateProcessFetch(fetchContext);
-          return shared_ptr<const Tree>(std::move(loadedTree));
+            self->updateProcessFetch(fetchContext);
+          }
+          return std::move(result.object);
         });
   });
 }
 
+namespace {
+template <typename Result>
+Future<Result> makeNegativeCacheResult(
+    const ObjectNegativeCache::Failure& failure) {
+  switch (failure.errorClass) {
+    case ObjectNegativeCache::ErrorClass::NotFound:
+      return makeFuture(Result{});
+    case ObjectNegativeCache::ErrorClass::Transient:
+      return makeFuture<Result>(failure.error);
+  }
+  EDEN_BUG() << "unknown error class " << enumValue(failure.errorClass);
+}
+
+template <typename T>
+void recordImportResult(
+    ObjectNegativeCache& cache,
+    const EdenConfig& config,
+    ObjectNegativeCache::ObjectType type,
+    const Hash& id,
+    const folly::Try<shared_ptr<const T>>& result) {
+  if (result.hasException()) {
+    cache.recordTransientFailure(
+        type,
+        id,
+        result.exception(),
+        config.negativeCacheInitialBackoff.getValue(),
+        config.negativeCacheMaxBackoff.getValue());
+  } else if (!result.value()) {
+    cache.recordNotFound(type, id, config.negativeCacheNotFoundTtl.getValue());
+  } else {
+    cache.recordSuccess(type, id);
+  }
+}
+} // namespace
+
+Future<ObjectStore::BackingStoreResult<Tree>>
+ObjectStore::getTreeFromBackingStore(
+    const Hash& id,
+    ObjectFetchContext& context) const {
+  if (auto failure = sharedState_->negativeCache.lookup(
+          ObjectNegativeCache::ObjectType::Tree, id)) {
+    XLOG(DBG4) << "tree " << id << " recently failed to import";
+    stats_->getObjectStoreStatsForCurrentThread()
+        .getTreeFromNegativeCache.addValue(1);
+    return makeNegativeCacheResult<BackingStoreResult<Tree>>(*failure);
+  }
+
+  // De-duplication of object loads is also done at the Inode layer, but only
+  // within a mount. Mounts of the same repository commonly load the same
+  // trees at the same time, e.g. when checking out the same commit in several
+  // working copies.
+  auto promise =
+      std::make_shared<folly::SharedPromise<shared_ptr<const Tree>>>();
+  {
+    auto pending = sharedState_->pendingTreeFetches.wlock();
+    auto [it, inserted] = pending->emplace(id, promise);
+    if (!inserted) {
+      XLOG(DBG4) << "tree " << id << " is already being fetched";
+      return it->second->getFuture().thenValue(
+          [](shared_ptr<const Tree> tree) {
+            return BackingStoreResult<Tree>{std::move(tree), false};
+          });
+    }
+  }
+
+  // The BackingStore may throw instead of returning a failed future, which
+  // must still complete the pending fetch so later requests don't wait on it
+  // forever.
+  auto self = shared_from_this();
+  return folly::makeFutureWith(
+             [&] { return backingStore_->getTree(id, context); })
+      .via(executor_)
+      .thenValue([self, id](unique_ptr<const Tree> loadedTree) {
+        if (loadedTree) {
+          self->localStore_->putTree(loadedTree.get());
+        }
+        return shared_ptr<const Tree>(std::move(loadedTree));
+      })
+      .thenTry([self, id, promise](folly::Try<shared_ptr<const Tree>> tree) {
+        recordImportResult(
+            self->sharedState_->negativeCache,
+            *self->edenConfig_,
+            ObjectNegativeCache::ObjectType::Tree,
+            id,
+            tree);
+        self->sharedState_->pendingTreeFetches.wlock()->erase(id);
+        promise->setTry(folly::Try<shared_ptr<const Tree>>{tree});
+        return BackingStoreResult<Tree>{std::move(tree).value(), true};
+      });
+}
+
 Future<shared_ptr<const Tree>> ObjectStore::getTreeForCommit(
     const Hash& commitID,
     ObjectFetchContext& context) const {
@@ -239,34 +335,80 @@ Future<shared_ptr<const Blob>> ObjectStore::getBlob(
     self->deprioritizeWhenFetchHeavy(fetchContext);
 
     // Look in the BackingStore
-    return self->backingStore_->getBlob(id, fetchContext)
-        .via(self->executor_)
-        .thenValue([self, &fetchContext, id](
-                       unique_ptr<const Blob> loadedBlob) {
-          if (loadedBlob) {
+    return self->getBlobFromBackingStore(id, fetchContext)
+        .thenValue([self, &fetchContext, id](BackingStoreResult<Blob> result) {
+          if (result.object) {
             XLOG(DBG3) << "blob " << id << "  retrieved from backing store";
-            self->updateBlobStats(false, true);
-            fetchContext.didFetch(
-                ObjectFetchContext::Blob,
-                id,
-                ObjectFetchContext::FromBackingStore);
-
-            self->updateProcessFetch(fetchContext);
-
-            auto metadata = self->localStore_->putBlob(id, loadedBlob.get());
-            self->metadataCache_.wlock()->set(id, metadata);
-            return shared_ptr<const Blob>(std::move(loadedBlob));
+            if (result.fetched) {
+              self->updateBlobStats(false, true);
+              fetchContext.didFetch(
+                  ObjectFetchContext::Blob,
+                  id,
+                  ObjectFetchContext::FromBackingStore);
+
+              self->updateProcessFetch(fetchContext);
+            }
+            return std::move(result.object);
           }
 
           XLOG(DBG2) << "unable to find blob " << id;
           self->updateBlobStats(false, false);
-          // TODO: Perhaps we should do some short-term negative caching?
           throw std::domain_error(
               folly::to<string>("blob ", id.toString(), " not found"));
         });
   });
 }
 
+Future<ObjectStore::BackingStoreResult<Blob>>
+ObjectStore::getBlobFromBackingStore(
+    const Hash& id,
+    ObjectFetchContext& context) const {
+  if (auto failure = sharedState_->negativeCache.lookup(
+          ObjectNegativeCache::ObjectType::Blob, id)) {
+    XLOG(DBG4) << "blob " << id << " recently failed to import";
+    stats_->getObjectStoreStatsForCurrentThread()
+        .getBlobFromNegativeCache.addValue(1);
+    return makeNegativeCacheResult<BackingStoreResult<Blob>>(*failure);
+  }
+
+  auto promise =
+      std::make_shared<folly::SharedPromise<shared_ptr<const Blob>>>();
+  {
+    auto pending = sharedState_->pendingBlobFetches.wlock();
+    auto [it, inserted] = pending->emplace(id, promise);
+    if (!inserted) {
+      XLOG(DBG4) << "blob " << id << " is already being fetched";
+      return it->second->getFuture().thenValue(
+          [](shared_ptr<const Blob> blob) {
+            return BackingStoreResult<Blob>{std::move(blob), false};
+          });
+    }
+  }
+
+  auto self = shared_from_this();
+  return folly::makeFutureWith(
+             [&] { return backingStore_->getBlob(id, context); })
+      .via(executor_)
+      .thenValue([self, id](unique_ptr<const Blob> loadedBlob) {
+        if (loadedBlob) {
+          auto metadata = self->localStore_->putBlob(id, loadedBlob.get());
+          self->sharedState_->metadataCache.wlock()->set(id, metadata);
+        }
+        return shared_ptr<const Blob>(std::move(loadedBlob));
+      })
+      .thenTry([self, id, promise](folly::Try<shared_ptr<const Blob>> blob) {
+        recordImportResult(
+            self->sharedState_->negativeCache,
+            *self->edenConfig_,
+            ObjectNegativeCache::ObjectType::Blob,
+            id,
+            blob);
+        self->sharedState_->pendingBlobFetches.wlock()->erase(id);
+        promise->setTry(folly::Try<shared_ptr<const Blob>>{blob});
+        return BackingStoreResult<Blob>{std::move(blob).value(), true};
+      });
+}
+
 void ObjectStore::updateBlobStats(bool local, bool backing) const {
   ObjectStoreThreadStats& stats = stats_->getObjectStoreStatsForCurrentThread();
   stats.getBlobFromLocalStore.addValue(local);
@@ -278,7 +420,7 @@ Future<BlobMetadata> ObjectStore::getBlobMetadata(
     ObjectFetchContext& context) const {
   // Check in-memory cache
   {
-    auto metadataCache = metadataCache_.wlock();
+    auto metadataCache = sharedState_->metadataCache.wlock();
     auto cacheIter = metadataCache->find(id);
     if (cacheIter != metadataCache->end()) {
       updateBlobMetadataStats(true, false, false);
@@ -299,7 +441,7 @@ Future<BlobMetadata> ObjectStore::getBlobMetadata(
       [self, id, &context](std::optional<BlobMetadata>&& metadata) {
         if (metadata) {
           self->updateBlobMetadataStats(false, true, false);
-          self->metadataCache_.wlock()->set(id, *metadata);
+          self->sharedState_->metadataCache.wlock()->set(id, *metadata);
           context.didFetch(
               ObjectFetchContext::BlobMetadata,
               id,
@@ -319,25 +461,42 @@ Future<BlobMetadata> ObjectStore::getBlobMetadata(
         //
         // TODO: This should probably check the LocalStore for the blob first,
         // especially when we begin to expire entries in RocksDB.
-        return self->backingStore_->getBlob(id, context)
-            .via(self->executor_)
-            .thenValue([self, id, &context](std::unique_ptr<Blob> blob) {
+        return self->getBlobFromBackingStore(id, context)
+            .thenValue([self, id, &context](BackingStoreResult<Blob> result) {
+              const auto& blob = result.object;
               if (blob) {
-                self->updateBlobMetadataStats(false, false, true);
-                auto metadata = self->localStore_->putBlob(id, blob.get());
-                self->metadataCache_.wlock()->set(id, metadata);
+                if (result.fetched) {
+                  self->updateBlobMetadataStats(false, false, true);
+                }
+                // The fetch saved the metadata in the cache, unless it was
+                // evicted since.
+                std::optional<BlobMetadata> metadata;
+                {
+                  auto metadataCache =
+                      self->sharedState_->metadataCache.wlock();
+                  auto cacheIter = metadataCache->find(id);
+                  if (cacheIter != metadataCache->end()) {
+                    metadata = cacheIter->second;
+                  }
+                }
+                if (!metadata) {
+                  metadata = BlobMetadata{
+                      Hash::sha1(blob->getContents()), blob->getSize()};
+                }
                 // I could see an argument for recording this fetch with
                 // type Blob instead of BlobMetadata, but it's probably more
                 // useful in context to know how many metadata fetches
                 // occurred. Also, since backing stores don't directly
                 // support fetching metadata, it should be clear.
-                context.didFetch(
-                    ObjectFetchContext::BlobMetadata,
-                    id,
-                    ObjectFetchContext::FromBackingStore);
-
-                self->updateProcessFetch(context);
-                return makeFuture(metadata);
+                if (result.fetched) {
+                  context.didFetch(
+                      ObjectFetchContext::BlobMetadata,
+                      id,
+                      ObjectFetchContext::FromBackingStore);
+
+                  self->updateProcessFetch(context);
+                }
+                return makeFuture(*metadata);
               }
 
               self->updateBlobMetadataStats(false, false, false);
@@ -10,6 +10,7 @@
 #include <folly/Executor.h>
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <folly/futures/SharedPromise.h>
 #include <memory>
 #include <unordered_map>
 
@@ -20,6 +21,7 @@
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ObjectNegativeCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/utils/ProcessNameCache.h"
@@ -56,6 +58,67 @@ struct PidFetchCounts {
   }
 };
 
+/**
+ * State shared by the ObjectStores of all the mounts that use the same
+ * BackingStore.
+ *
+ * Several checkouts of the same repository commonly look up the same trees and
+ * blobs. Sharing this state lets them share the blob metadata cache, and makes
+ * concurrent fetches of the same object from the BackingStore collapse into a
+ * single fetch, regardless of which mount issued them.
+ */
+class ObjectStoreSharedState {
+ public:
+  static constexpr size_t kDefaultMetadataCacheSize = 1000000;
+
+  explicit ObjectStoreSharedState(
+      size_t metadataCacheSize = kDefaultMetadataCacheSize)
+      : metadataCache{folly::in_place, metadataCacheSize} {}
+
+  ObjectStoreSharedState(const ObjectStoreSharedState&) = delete;
+  ObjectStoreSharedState& operator=(const ObjectStoreSharedState&) = delete;
+
+  /**
+   * During status and checkout, it's common to look up the SHA-1 for a given
+   * blob ID. To avoid needing to hit RocksDB, keep a bounded in-memory cache of
+   * the sizes and SHA-1s of blobs we've seen. Each node is somewhere around 50
+   * bytes (20+28 + LRU overhead) and we store kDefaultMetadataCacheSize
+   * entries, which EvictingCacheMap divides in two for some reason. At the
+   * time of this comment, EvictingCacheMap does not store its nodes densely,
+   * so there may also be some jemalloc tracking overhead and some internal
+   * fragmentation depending on whether the node fits cleanly into one of
+   * jemalloc's size classes.
+   *
+   * TODO: It never makes sense to rlock an LRU cache, since cache hits mutate
+   * the data structure. Thus, should we use a more appropriate type of lock?
+   */
+  folly::Synchronized<folly::EvictingCacheMap<Hash, BlobMetadata>>
+      metadataCache;
+
+  /**
+   * Number of fetches for each process across all the mounts, used to detect
+   * fetch-heavy processes. Each ObjectStore also keeps per-mount counts.
+   */
+  PidFetchCounts pidFetchCounts;
+
+  /**
+   * Objects currently being fetched from the BackingStore. Requests for an
+   * object that is already being fetched wait for that fetch to complete
+   * instead of starting another one.
+   */
+  template <typename T>
+  using PendingFetchMap = folly::Synchronized<std::unordered_map<
+      Hash,
+      std::shared_ptr<folly::SharedPromise<std::shared_ptr<const T>>>>>;
+  PendingFetchMap<Tree> pendingTreeFetches;
+  PendingFetchMap<Blob> pendingBlobFetches;
+
+  /**
+   * Objects that recently failed to import from the BackingStore.
+   */
+  ObjectNegativeCache negativeCache;
+};
+
 constexpr uint64_t importPriorityDeprioritizeAmount{1};
 
 /**
@@ -78,13 +141,14 @@ class ObjectStore : public IObjectStore,
       folly::Executor::KeepAlive<folly::Executor> executor,
       std::shared_ptr<ProcessNameCache> processNameCache,
       std::shared_ptr<StructuredLogger> structuredLogger,
-      std::shared_ptr<const EdenConfig> edenConfig);
+      std::shared_ptr<const EdenConfig> edenConfig,
+      std::shared_ptr<ObjectStoreSharedState> sharedState = nullptr);
   ~ObjectStore() override;
 
   /**
-   * When pid of fetchContext is available, this function updates
-   * pidFetchCounts_. If the current process needs to be logged as
-   * a fetch-heavy process, it sends a FetchHeavy event to Scuba.
+   * When pid of fetchContext is available, this function updates the
+   * per-mount and shared fetch counts. If the current process needs to be
+   * logged as a fetch-heavy process, it sends a FetchHeavy event to Scuba.
    */
   void updateProcessFetch(const ObjectFetchContext& fetchContext) const;
 
@@ -175,10 +239,23 @@ class ObjectStore : public IObjectStore,
     return backingStore_;
   }
 
+  const std::shared_ptr<ObjectStoreSharedState>& getSharedState() const {
+    return sharedState_;
+  }
+
+  /**
+   * Number of fetches for each process made through this ObjectStore, i.e.
+   * for this mount only.
+   */
   folly::Synchronized<std::unordered_map<pid_t, uint64_t>>& getPidFetches() {
     return pidFetchCounts_->map_;
   }
 
+  /**
+   * Clear the fetch counts of this mount. The counts shared with the other
+   * mounts of the repository, used for fetch-heavy process detection, are
+   * left alone.
+   */
   void clearFetchCounts() {
     pidFetchCounts_->clear();
   }
@@ -192,7 +269,8 @@ class ObjectStore : public IObjectStore,
       folly::Executor::KeepAlive<folly::Executor> executor,
       std::shared_ptr<ProcessNameCache> processNameCache,
       std::shared_ptr<StructuredLogger> structuredLogger,
-      std::shared_ptr<const EdenConfig> edenConfig);
+      std::shared_ptr<const EdenConfig> edenConfig,
+      std::shared_ptr<ObjectStoreSharedState> sharedState);
   // Forbidden copy constructor and assignment operator
   ObjectStore(ObjectStore const&) = delete;
   ObjectStore& operator=(ObjectStore const&) = delete;
@@ -208,24 +286,45 @@ class ObjectStore : public IObjectStore,
       const Hash& id,
       ObjectFetchContext& context) const;
 
-  static constexpr size_t kCacheSize = 1000000;
+  /**
+   * The result of getTreeFromBackingStore() and getBlobFromBackingStore().
+   */
+  template <typename T>
+  struct BackingStoreResult {
+    /**
+     * nullptr if the object does not exist.
+     */
+    std::shared_ptr<const T> object;
+
+    /**
+     * Whether this request is the one that fetched the object from the
+     * BackingStore, as opposed to one that joined another request's fetch or
+     * found a recent failure in the negative cache. Only the fetching request
+     * records the fetch, so that fetch counts are not inflated by requests
+     * that shared it.
+     */
+    bool fetched{false};
+  };
 
   /**
-   * During status and checkout, it's common to look up the SHA-1 for a given
-   * blob ID. To avoid needing to hit RocksDB, keep a bounded in-memory cache of
-   * the sizes and SHA-1s of blobs we've seen. Each node is somewhere around 50
-   * bytes (20+28 + LRU overhead) and we store kMetadataCacheSize entries, which
-   * EvictingCacheMap divides in two for some reason. At the time of this
-   * comment, EvictingCacheMap does not store its nodes densely, so there may
-   * also be some jemalloc tracking overhead and some internal fragmentation
-   * depending on whether the node fits cleanly into one of jemalloc's size
-   * classes.
-   *
-   * TODO: It never makes sense to rlock an LRU cache, since cache hits mutate
-   * the data structure. Thus, should we use a more appropriate type of lock?
+   * Fetch a Tree from the BackingStore and save it in the LocalStore, joining
+   * any in-progress fetch of the same tree by any mount sharing our
+   * ObjectStoreSharedState.
+   */
+  folly::Future<BackingStoreResult<Tree>> getTreeFromBackingStore(
+      const Hash& id,
+      ObjectFetchContext& context) const;
+
+  /**
+   * Fetch a Blob from the BackingStore and save it and its metadata in the
+   * LocalStore and metadata cache, joining any in-progress fetch of the same
+   * blob.
    */
-  mutable folly::Synchronized<folly::EvictingCacheMap<Hash, BlobMetadata>>
-      metadataCache_;
+  folly::Future<BackingStoreResult<Blob>> getBlobFromBackingStore(
+      const Hash& id,
+      ObjectFetchContext& context) const;
+
+  std::shared_ptr<ObjectStoreSharedState> const sharedState_;
 
   /*
    * The LocalStore.
@@ -245,8 +344,9 @@ class ObjectStore : public IObjectStore,
 
   folly::Executor::KeepAlive<folly::Executor> executor_;
 
-  /* number of fetches for each process collected
-   * from the beginning of the eden daemon progress */
+  /* number of fetches for each process collected from the beginning of the
+   * eden daemon progress, for this mount only. The counts across all mounts
+   * sharing the BackingStore are in sharedState_. */
   std::unique_ptr<PidFetchCounts> pidFetchCounts_;
 
   /* process name cache and structured logger used for
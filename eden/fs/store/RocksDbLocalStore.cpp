@@ -18,6 +18,7 @@
 #include <folly/io/IOBuf.h>
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
+#include <rocksdb/cache.h>
 #include <rocksdb/convenience.h>
 #include <rocksdb/db.h>
 #include <rocksdb/filter_policy.h>
@@ -43,13 +44,85 @@ using std::chrono::duration_cast;
 namespace {
 using namespace facebook::eden;
 
-rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
+/**
+ * The maximum number of getFuture() calls that are coalesced into a single
+ * MultiGet.  Larger bursts are split across several ioPool_ threads.
+ */
+constexpr size_t kMaxCoalescedGets = 256;
+
+// Most of the column families will share the same cache.  We want the blob
+// data to live in its own smaller cache; the assumption is that the vfs cache
+// will compensate for that, together with the idea that we shouldn't need to
+// materialize a great many files.
+constexpr size_t kBlockCacheSize = 64 * 1024 * 1024;
+constexpr size_t kBlobBlockCacheSize = 8 * 1024 * 1024;
+
+/**
+ * Values at least this large are returned in an IOBuf that pins the block
+ * holding them in the block cache, rather than being copied out of it.
+ *
+ * Smaller values are copied, so that a small tree or metadata entry doesn't
+ * keep a whole data block alive.  Larger values fill most of their block.
+ */
+constexpr size_t kMinPinnedValueSize = 16 * 1024;
+
+/**
+ * A value pinned in a block cache, owned by the IOBuf pointing to it.
+ *
+ * The pinned block is released back to the block cache, which therefore has
+ * to outlive the slice even if the DB has been closed in the meantime.
+ */
+struct PinnedValue {
+  std::shared_ptr<rocksdb::Cache> blockCache;
+  rocksdb::PinnableSlice slice;
+};
+
+void freePinnedValue(void* /* buffer */, void* userData) {
+  delete static_cast<PinnedValue*>(userData);
+}
+
+StoreResult makeStoreResult(
+    rocksdb::PinnableSlice&& value,
+    const std::shared_ptr<rocksdb::Cache>& blockCache) {
+  if (!value.IsPinned()) {
+    // RocksDB already copied the value into the slice's own string, e.g.
+    // because it was found in a memtable.
+    return StoreResult(std::move(*value.GetSelf()));
+  }
+  if (value.size() < kMinPinnedValueSize) {
+    return StoreResult(value.ToString());
+  }
+  auto data = const_cast<char*>(value.data());
+  auto size = value.size();
+  auto pinned =
+      std::make_unique<PinnedValue>(PinnedValue{blockCache, std::move(value)});
+  return StoreResult(folly::IOBuf(
+      folly::IOBuf::TAKE_OWNERSHIP,
+      data,
+      size,
+      freePinnedValue,
+      pinned.release()));
+}
+
+rocksdb::ColumnFamilyOptions makeColumnOptions(
+    std::shared_ptr<rocksdb::Cache> blockCache) {
   rocksdb::ColumnFamilyOptions options;
 
   // We'll never perform range scans on any of the keys that we store.
   // This enables bloom filters and a hash policy that improves our
   // get/put performance.
-  options.OptimizeForPointLookup(LRUblockCacheSizeMB);
+  //
+  // This is what OptimizeForPointLookup() does, except that we supply the
+  // block cache: values pinned in it may outlive the DB.
+  rocksdb::BlockBasedTableOptions tableOptions;
+  tableOptions.data_block_index_type =
+      rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+  tableOptions.data_block_hash_table_util_ratio = 0.75;
+  tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10));
+  tableOptions.block_cache = std::move(blockCache);
+  options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
+  options.memtable_prefix_bloom_size_ratio = 0.02;
+  options.memtable_whole_key_filtering = true;
 
   options.OptimizeLevelStyleCompaction();
   return options;
@@ -61,13 +134,11 @@ rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
  */
 const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
     const rocksdb::DBOptions& db_options,
-    const std::string& name) {
-  // Most of the column families will share the same cache.  We
-  // want the blob data to live in its own smaller cache; the assumption
-  // is that the vfs cache will compensate for that, together with the
-  // idea that we shouldn't need to materialize a great many files.
-  auto options = makeColumnOptions(64);
-  auto blobOptions = makeColumnOptions(8);
+    const std::string& name,
+    const std::shared_ptr<rocksdb::Cache>& blockCache,
+    const std::shared_ptr<rocksdb::Cache>& blobBlockCache) {
+  auto options = makeColumnOptions(blockCache);
+  auto blobOptions = makeColumnOptions(blobBlockCache);
 
   // We have to open all column families that currenly exists in our RocksDb.
   // Else we will get "Invalid argument: You have to open all column
@@ -244,10 +315,17 @@ rocksdb::Options getRocksdbOptions() {
   return options;
 }
 
-RocksHandles openDB(AbsolutePathPiece path, RocksDBOpenMode mode) {
+RocksHandles openDB(
+    AbsolutePathPiece path,
+    RocksDBOpenMode mode,
+    const std::shared_ptr<rocksdb::Cache>& blockCache,
+    const std::shared_ptr<rocksdb::Cache>& blobBlockCache) {
   auto options = getRocksdbOptions();
-  const auto columnDescriptors =
-      columnFamilies(rocksdb::DBOptions{options}, path.stringPiece().str());
+  const auto columnDescriptors = columnFamilies(
+      rocksdb::DBOptions{options},
+      path.stringPiece().str(),
+      blockCache,
+      blobBlockCache);
   try {
     return RocksHandles(path.stringPiece(), mode, options, columnDescriptors);
   } catch (const RocksException& ex) {
@@ -279,7 +357,26 @@ RocksDbLocalStore::RocksDbLocalStore(
     : structuredLogger_{std::move(structuredLogger)},
       faultInjector_(*faultInjector),
       ioPool_(12, "RocksLocalStore"),
-      dbHandles_(folly::in_place, openDB(pathToRocksDb, mode)) {
+      blockCache_{rocksdb::NewLRUCache(kBlockCacheSize)},
+      blobBlockCache_{rocksdb::NewLRUCache(kBlobBlockCacheSize)},
+      dbHandles_(
+          folly::in_place,
+          openDB(pathToRocksDb, mode, blockCache_, blobBlockCache_)) {
+  fb303::fbData->addHistogram(
+      folly::to<string>(statsPrefix_, "coalesced_get.batch_size"),
+      /*bucketWidth=*/8,
+      /*min=*/0,
+      /*max=*/kMaxCoalescedGets);
+  fb303::fbData->exportHistogramPercentile(
+      folly::to<string>(statsPrefix_, "coalesced_get.batch_size"), 50, 99);
+  fb303::fbData->addHistogram(
+      folly::to<string>(statsPrefix_, "coalesced_get.queue_delay_us"),
+      /*bucketWidth=*/100,
+      /*min=*/0,
+      /*max=*/10000);
+  fb303::fbData->exportHistogramPercentile(
+      folly::to<string>(statsPrefix_, "coalesced_get.queue_delay_us"), 50, 99);
+
   // Publish fb303 stats once when we first open the DB.
   // These will be kept up-to-date later by the periodicManagementTask() call.
   computeStats(/*publish=*/true, /*config=*/nullptr);
@@ -307,8 +404,11 @@ void RocksDbLocalStore::repairDB(AbsolutePathPiece path) {
   auto dbPathStr = path.stringPiece().str();
   rocksdb::DBOptions dbOptions(getRocksdbOptions());
 
-  const auto columnDescriptors =
-      columnFamilies(dbOptions, path.stringPiece().str());
+  const auto columnDescriptors = columnFamilies(
+      dbOptions,
+      path.stringPiece().str(),
+      rocksdb::NewLRUCache(kBlockCacheSize),
+      rocksdb::NewLRUCache(kBlobBlockCacheSize));
 
   auto status = RepairDB(
       dbPathStr, dbOptions, columnDescriptors, unknownColumFamilyOptions);
@@ -374,7 +474,7 @@ void RocksDbLocalStore::compactKeySpace(KeySpace keySpace) {
 
 StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
   auto handles = getHandles();
-  string value;
+  rocksdb::PinnableSlice value;
   auto status = handles->db->Get(
       ReadOptions(),
       handles->columns[keySpace->index].get(),
@@ -394,31 +494,121 @@ StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
     throw RocksException::build(
         status, "failed to get ", folly::hexlify(key), " from local store");
   }
-  return StoreResult(std::move(value));
+  return makeStoreResult(std::move(value), getBlockCache(keySpace));
 }
 
 FOLLY_NODISCARD folly::Future<StoreResult> RocksDbLocalStore::getFuture(
     KeySpace keySpace,
     folly::ByteRange key) const {
-  // We're really just passing key through to the get() method, but we need to
-  // make a copy of it on the way through.  It will usually be an eden::Hash
-  // but can potentially be an arbitrary length so we can't just use Hash as
-  // the storage here.  std::string is appropriate, but there's some noise
-  // with the conversion from unsigned/signed and back again.
+  // We need to make a copy of the key on the way through.  It will usually be
+  // an eden::Hash but can potentially be an arbitrary length so we can't just
+  // use Hash as the storage here.  std::string is appropriate, but there's
+  // some noise with the conversion from unsigned/signed and back again.
   return faultInjector_.checkAsync("local store get single", "")
-      .via(&ioPool_)
+      .toUnsafeFuture()
       .thenValue([keySpace,
                   key = std::string(
                       reinterpret_cast<const char*>(key.data()), key.size()),
-                  this](folly::Unit&&) {
-        return get(
-            keySpace,
-            folly::ByteRange(
-                reinterpret_cast<const unsigned char*>(key.data()),
-                key.size()));
+                  this](folly::Unit&&) mutable {
+        return enqueueGet(keySpace, std::move(key));
       });
 }
 
+folly::Future<StoreResult> RocksDbLocalStore::enqueueGet(
+    KeySpace keySpace,
+    std::string key) const {
+  PendingGet get{
+      std::move(key),
+      folly::Promise<StoreResult>{},
+      std::chrono::steady_clock::now()};
+  auto future = get.promise.getFuture();
+
+  // Schedule one flush for every kMaxCoalescedGets queued reads.  Each flush
+  // takes at most that many, so a queued read always has a flush pending.
+  // Reads that arrive before a scheduled flush starts running join its batch.
+  bool scheduleFlush;
+  {
+    auto pending = pendingGets_[keySpace->index].lock();
+    pending->push_back(std::move(get));
+    scheduleFlush = pending->size() % kMaxCoalescedGets == 1;
+  }
+  if (scheduleFlush) {
+    ioPool_.add([this, keySpace] { flushPendingGets(keySpace); });
+  }
+  return future;
+}
+
+void RocksDbLocalStore::flushPendingGets(KeySpace keySpace) const {
+  std::vector<PendingGet> batch;
+  {
+    auto pending = pendingGets_[keySpace->index].lock();
+    if (pending->size() <= kMaxCoalescedGets) {
+      batch.swap(*pending);
+    } else {
+      auto end = pending->begin() + kMaxCoalescedGets;
+      batch.assign(
+          std::make_move_iterator(pending->begin()),
+          std::make_move_iterator(end));
+      pending->erase(pending->begin(), end);
+    }
+  }
+  if (batch.empty()) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  fb303::fbData->addHistogramValue(
+      folly::to<string>(statsPrefix_, "coalesced_get.batch_size"),
+      batch.size());
+  fb303::fbData->addHistogramValue(
+      folly::to<string>(statsPrefix_, "coalesced_get.queue_delay_us"),
+      duration_cast<std::chrono::microseconds>(now - batch.front().enqueueTime)
+          .count());
+
+  std::vector<rocksdb::Status> statuses(batch.size());
+  std::vector<rocksdb::PinnableSlice> values(batch.size());
+  try {
+    auto handles = getHandles();
+    std::vector<Slice> keySlices;
+    keySlices.reserve(batch.size());
+    for (auto& get : batch) {
+      keySlices.emplace_back(get.key);
+    }
+    handles->db->MultiGet(
+        ReadOptions(),
+        handles->columns[keySpace->index].get(),
+        keySlices.size(),
+        keySlices.data(),
+        values.data(),
+        statuses.data());
+  } catch (const std::exception& ex) {
+    auto ew = folly::exception_wrapper{std::current_exception(), ex};
+    for (auto& get : batch) {
+      get.promise.setException(ew);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < batch.size(); ++i) {
+    auto& status = statuses[i];
+    auto& promise = batch[i].promise;
+    if (status.ok()) {
+      promise.setValue(
+          makeStoreResult(std::move(values[i]), getBlockCache(keySpace)));
+    } else if (status.IsNotFound()) {
+      // Return an empty StoreResult
+      promise.setValue(StoreResult());
+    } else {
+      // As in get(), only compute the hex string of the key on failure.
+      promise.setException(RocksException::build(
+          status,
+          "failed to get ",
+          folly::hexlify(batch[i].key),
+          " from local store"));
+    }
+  }
+}
+
 FOLLY_NODISCARD folly::Future<std::vector<StoreResult>>
 RocksDbLocalStore::getBatch(
     KeySpace keySpace,
@@ -446,14 +636,18 @@ RocksDbLocalStore::getBatch(
               XLOG(DBG3) << __func__ << " starting to actually do work";
               auto handles = store->getHandles();
               std::vector<Slice> keySlices;
-              std::vector<std::string> values;
-              std::vector<rocksdb::ColumnFamilyHandle*> columns;
+              std::vector<rocksdb::PinnableSlice> values(keys->size());
+              std::vector<rocksdb::Status> statuses(keys->size());
               for (auto& key : *keys) {
                 keySlices.emplace_back(key);
-                columns.emplace_back(handles->columns[keySpace->index].get());
               }
-              auto statuses = handles->db->MultiGet(
-                  ReadOptions(), columns, keySlices, &values);
+              handles->db->MultiGet(
+                  ReadOptions(),
+                  handles->columns[keySpace->index].get(),
+                  keySlices.size(),
+                  keySlices.data(),
+                  values.data(),
+                  statuses.data());
 
               std::vector<StoreResult> results;
               for (size_t i = 0; i < keys->size(); ++i) {
@@ -478,7 +672,8 @@ RocksDbLocalStore::getBatch(
                       folly::hexlify(keys->at(i)),
                       " from local store");
                 }
-                results.emplace_back(std::move(values[i]));
+                results.push_back(makeStoreResult(
+                    std::move(values[i]), store->getBlockCache(keySpace)));
               }
               return results;
             }));
@@ -498,7 +693,7 @@ RocksDbLocalStore::getBatch(
 }
 
 bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
-  string value;
+  rocksdb::PinnableSlice value;
   auto handles = getHandles();
   auto status = handles->db->Get(
       ReadOptions(),
@@ -736,5 +931,11 @@ void RocksDbLocalStore::throwStoreClosedError() const {
   throw std::runtime_error("the RocksDB local store is already closed");
 }
 
+const std::shared_ptr<rocksdb::Cache>& RocksDbLocalStore::getBlockCache(
+    KeySpace keySpace) const {
+  return keySpace->index == KeySpace::BlobFamily.index ? blobBlockCache_
+                                                       : blockCache_;
+}
+
 } // namespace eden
 } // namespace facebook
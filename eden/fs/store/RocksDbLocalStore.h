@@ -9,7 +9,12 @@
 
 #include <folly/CppAttributes.h>
 #include <folly/Synchronized.h>
+#include <folly/futures/Promise.h>
+#include <rocksdb/cache.h>
+#include <array>
 #include <bitset>
+#include <chrono>
+#include <vector>
 
 #include "eden/fs/rocksdb/RocksHandles.h"
 #include "eden/fs/store/LocalStore.h"
@@ -77,6 +82,11 @@ class RocksDbLocalStore : public LocalStore {
     return handles;
   }
   [[noreturn]] void throwStoreClosedError() const;
+
+  /**
+   * Get the block cache used by the column family of a key space.
+   */
+  const std::shared_ptr<rocksdb::Cache>& getBlockCache(KeySpace keySpace) const;
   std::shared_ptr<RocksDbLocalStore> getSharedFromThis() {
     return std::static_pointer_cast<RocksDbLocalStore>(shared_from_this());
   }
@@ -112,14 +122,56 @@ class RocksDbLocalStore : public LocalStore {
    */
   SizeSummary computeStats(bool publish, const EdenConfig* config);
 
+  /**
+   * A point read issued through getFuture() that is waiting to be sent to
+   * RocksDB as part of a MultiGet batch.
+   */
+  struct PendingGet {
+    std::string key;
+    folly::Promise<StoreResult> promise;
+    std::chrono::steady_clock::time_point enqueueTime;
+  };
+
+  /**
+   * Queue a point read so that it can be coalesced with other concurrent
+   * reads of the same key space.
+   */
+  folly::Future<StoreResult> enqueueGet(KeySpace keySpace, std::string key)
+      const;
+
+  /**
+   * Issue up to kMaxCoalescedGets pending reads for the key space as a
+   * single MultiGet call.  Runs on ioPool_.
+   */
+  void flushPendingGets(KeySpace keySpace) const;
+
   void triggerAutoGC(SizeSummary before);
   void autoGCFinished(bool successful, uint64_t ephemeralSizeBefore);
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
   const std::string statsPrefix_{"local_store."};
   FaultInjector& faultInjector_;
+  /**
+   * Point reads waiting for a MultiGet, indexed by key space.
+   *
+   * A flush is scheduled on ioPool_ whenever a read starts a new batch, so
+   * reads arriving while the pool is busy are coalesced rather than each
+   * queuing a separate Get.  This must outlive ioPool_, which drains its
+   * remaining work on destruction.
+   */
+  mutable std::array<
+      folly::Synchronized<std::vector<PendingGet>>,
+      KeySpace::kTotalCount>
+      pendingGets_;
   mutable UnboundedQueueExecutor ioPool_;
   folly::Synchronized<AutoGCState> autoGCState_;
+  /**
+   * The block caches of the column families, created here rather than by
+   * RocksDB: values returned from them without a copy keep a reference to
+   * their cache, since they may outlive the DB.
+   */
+  std::shared_ptr<rocksdb::Cache> blockCache_;
+  std::shared_ptr<rocksdb::Cache> blobBlockCache_;
   folly::Synchronized<RocksHandles> dbHandles_;
 };
 
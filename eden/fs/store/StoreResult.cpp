@@ -28,10 +28,13 @@ IOBuf StoreResult::iobufWrapper() const {
 
 folly::IOBuf StoreResult::extractIOBuf() {
   ensureValid();
+  if (buf_) {
+    return std::move(*buf_);
+  }
 
-  // Unfortunately RocksDB returns data to us in a std::string.  This makes it
-  // difficult for us to control the lifetime.  We end up having to allocate a
-  // new std::string on the heap, just to control when it will free the
+  // Unfortunately most stores return data to us in a std::string.  This makes
+  // it difficult for us to control the lifetime.  We end up having to allocate
+  // a new std::string on the heap, just to control when it will free the
   // underlying data it points to.
   auto stringPtr = std::make_unique<std::string>(std::move(data_));
   // Extract the data and size before we pass stringPtr.release()
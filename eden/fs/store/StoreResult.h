@@ -8,22 +8,22 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <optional>
 #include <string>
 
-namespace folly {
-class IOBuf;
-}
-
 namespace facebook {
 namespace eden {
 
 /*
  * StoreResult contains the result of a LocalStore lookup.
  *
- * RocksDB returns the data in a std::string (which is somewhat unfortunate,
- * since it gives us relatively poor memory management control).
+ * Most stores return the data in a std::string (which is somewhat unfortunate,
+ * since it gives us relatively poor memory management control).  The data may
+ * also be held in an IOBuf, which lets RocksDbLocalStore return large values
+ * without copying them out of its block cache.
  *
- * This class is a wrapper around the returned string, with a few benefits:
+ * This class is a wrapper around the returned data, with a few benefits:
  * - It can also represent a "not found" result, so we can efficiently handle
  *   key lookups that are not present, without throwing an exception.
  * - It is move-only, so prevents us from ever unintentionally copying the
@@ -43,6 +43,12 @@ class StoreResult {
   explicit StoreResult(std::string&& data)
       : valid_(true), data_(std::move(data)) {}
 
+  /**
+   * Construct a StoreResult from a single, unchained IOBuf.
+   */
+  explicit StoreResult(folly::IOBuf&& data)
+      : valid_(true), buf_(std::move(data)) {}
+
   StoreResult(StoreResult&&) = default;
   StoreResult& operator=(StoreResult&&) = default;
 
@@ -54,16 +60,6 @@ class StoreResult {
     return valid_;
   }
 
-  /**
-   * Get a reference to the std::string result.
-   *
-   * Throws std::domain_error if the key was not present in the store.
-   */
-  const std::string& asString() const {
-    ensureValid();
-    return data_;
-  }
-
   /**
    * Get a ByteRange pointing to the result.
    *
@@ -71,6 +67,9 @@ class StoreResult {
    */
   folly::ByteRange bytes() const {
     ensureValid();
+    if (buf_) {
+      return folly::ByteRange{buf_->data(), buf_->length()};
+    }
     return folly::StringPiece{data_};
   }
 
@@ -80,8 +79,7 @@ class StoreResult {
    * Throws std::domain_error if the key was not present in the store.
    */
   folly::StringPiece piece() const {
-    ensureValid();
-    return folly::StringPiece{data_};
+    return folly::StringPiece{bytes()};
   }
 
   /**
@@ -95,10 +93,16 @@ class StoreResult {
 
   /**
    * Extract the std::string contained in this StoreResult.
+   *
+   * This copies the data if it is held in an IOBuf.
    */
   std::string extractValue() {
     ensureValid();
     valid_ = false;
+    if (buf_) {
+      return std::string{
+          reinterpret_cast<const char*>(buf_->data()), buf_->length()};
+    }
     return std::move(data_);
   }
 
@@ -108,9 +112,9 @@ class StoreResult {
    * This will return a managed IOBuf, which will free the result data when
    * the last IOBuf clone is destroyed.
    *
-   * This does require a memory allocation to move the stored std::string onto
-   * the heap (but it just does a small allocation for the string object
-   * itself, and not the string data).
+   * If the data is held in a std::string, this does require a memory
+   * allocation to move it onto the heap (but it just does a small allocation
+   * for the string object itself, and not the string data).
    */
   folly::IOBuf extractIOBuf();
 
@@ -134,8 +138,9 @@ class StoreResult {
   // Whether or not the result is value
   // If the key was not found in the store, valid_ will be false.
   bool valid_{false};
-  // The std::string containing the data
+  // The std::string containing the data, unless it is held in buf_
   std::string data_;
+  std::optional<folly::IOBuf> buf_;
 };
 } // namespace eden
 } // namespace facebook
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TreeFetchScheduler.h"
+
+#include <algorithm>
+#include <optional>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+
+namespace facebook {
+namespace eden {
+
+constexpr size_t TreeFetchScheduler::kDefaultMaxInFlight;
+
+TreeFetchScheduler::TreeFetchScheduler(
+    const ObjectStore* store,
+    size_t maxInFlight,
+    CancellationCheck isCancelled)
+    : store_{store},
+      maxInFlight_{std::max<size_t>(maxInFlight, 1)},
+      isCancelled_{std::move(isCancelled)} {}
+
+folly::Future<std::shared_ptr<const Tree>> TreeFetchScheduler::getTree(
+    const Hash& id,
+    ObjectFetchContext& context) {
+  if (isCancelled()) {
+    return folly::makeFuture<std::shared_ptr<const Tree>>(
+        TraversalCancelledError{});
+  }
+
+  {
+    auto state = state_.lock();
+    if (state->inFlight >= maxInFlight_) {
+      state->queue.push_back(PendingFetch{id, &context, {}});
+      return state->queue.back().promise.getFuture();
+    }
+    ++state->inFlight;
+  }
+  return startFetch(id, context);
+}
+
+folly::Future<std::shared_ptr<const Tree>> TreeFetchScheduler::startFetch(
+    const Hash& id,
+    ObjectFetchContext& context) {
+  return store_->getTree(id, context).ensure([this] { fetchFinished(); });
+}
+
+void TreeFetchScheduler::fetchFinished() {
+  {
+    auto state = state_.lock();
+    --state->inFlight;
+    ++state->fetched;
+    if (state->draining) {
+      return;
+    }
+    state->draining = true;
+  }
+  drainQueue();
+}
+
+void TreeFetchScheduler::drainQueue() {
+  while (true) {
+    std::vector<PendingFetch> cancelled;
+    std::optional<PendingFetch> next;
+    {
+      auto state = state_.lock();
+      if (state->cancelled) {
+        cancelled.swap(state->queue);
+      } else if (!state->queue.empty() && state->inFlight < maxInFlight_) {
+        next = std::move(state->queue.back());
+        state->queue.pop_back();
+        ++state->inFlight;
+      }
+      if (cancelled.empty() && !next) {
+        state->draining = false;
+        return;
+      }
+    }
+
+    if (next && isCancelled_ && isCancelled_()) {
+      auto state = state_.lock();
+      state->cancelled = true;
+      --state->inFlight;
+      cancelled.push_back(std::move(*next));
+      next.reset();
+    }
+
+    // Fulfill the promises outside of the lock, since their callbacks may
+    // issue more fetches.
+    for (auto& fetch : cancelled) {
+      fetch.promise.setException(TraversalCancelledError{});
+    }
+    if (next) {
+      startFetch(next->id, *next->context)
+          .thenTry([promise = std::move(next->promise)](
+                       folly::Try<std::shared_ptr<const Tree>>&& tree) mutable {
+            promise.setTry(std::move(tree));
+          });
+    }
+  }
+}
+
+void TreeFetchScheduler::cancel() {
+  {
+    auto state = state_.lock();
+    state->cancelled = true;
+    if (state->draining) {
+      return;
+    }
+    state->draining = true;
+  }
+  drainQueue();
+}
+
+bool TreeFetchScheduler::isCancelled() const {
+  if (state_.lock()->cancelled) {
+    return true;
+  }
+  return isCancelled_ && isCancelled_();
+}
+
+TreeFetchScheduler::Progress TreeFetchScheduler::getProgress() const {
+  auto state = state_.lock();
+  return Progress{state->fetched, state->inFlight, state->queue.size()};
+}
+
+} // namespace eden
+} // namespace facebook
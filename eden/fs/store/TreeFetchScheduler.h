@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/futures/Future.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "eden/fs/model/Hash.h"
+
+namespace facebook {
+namespace eden {
+
+class ObjectFetchContext;
+class ObjectStore;
+class Tree;
+
+/**
+ * Thrown by TreeFetchScheduler::getTree() once the traversal is cancelled.
+ */
+class TraversalCancelledError : public std::runtime_error {
+ public:
+  TraversalCancelledError() : std::runtime_error{"tree traversal cancelled"} {}
+};
+
+/**
+ * Schedules the tree fetches of a recursive traversal of source control
+ * trees, such as a glob or a diff.
+ *
+ * Traversals recurse by chaining a future for every child directory, so a
+ * wide tree would otherwise have all of its subtrees fetched, and held in
+ * memory, at once. The scheduler starts at most maxInFlight fetches at a time
+ * and queues the others. Queued fetches are started most recent first: these
+ * are the children of the trees that were fetched last, so the traversal
+ * proceeds depth first and finishes subtrees before starting new ones.
+ *
+ * Once the traversal is cancelled, queued and new fetches fail with
+ * TraversalCancelledError instead of being started.
+ *
+ * The scheduler must outlive the futures it returns.
+ */
+class TreeFetchScheduler {
+ public:
+  static constexpr size_t kDefaultMaxInFlight = 256;
+
+  struct Progress {
+    /** Fetches that completed, successfully or not. */
+    size_t fetched{0};
+    size_t inFlight{0};
+    size_t queued{0};
+  };
+
+  /**
+   * Returns true once the traversal should stop, e.g. because the client
+   * that requested it went away. Checked before starting each fetch.
+   */
+  using CancellationCheck = std::function<bool()>;
+
+  explicit TreeFetchScheduler(
+      const ObjectStore* store,
+      size_t maxInFlight = kDefaultMaxInFlight,
+      CancellationCheck isCancelled = nullptr);
+
+  TreeFetchScheduler(const TreeFetchScheduler&) = delete;
+  TreeFetchScheduler& operator=(const TreeFetchScheduler&) = delete;
+
+  folly::Future<std::shared_ptr<const Tree>> getTree(
+      const Hash& id,
+      ObjectFetchContext& context);
+
+  /**
+   * Fail the queued and future fetches. Fetches that already started are
+   * left to complete.
+   */
+  void cancel();
+
+  bool isCancelled() const;
+
+  Progress getProgress() const;
+
+ private:
+  struct PendingFetch {
+    Hash id;
+    ObjectFetchContext* context;
+    folly::Promise<std::shared_ptr<const Tree>> promise;
+  };
+
+  struct State {
+    std::vector<PendingFetch> queue;
+    size_t inFlight{0};
+    size_t fetched{0};
+    bool cancelled{false};
+    // Whether a thread is starting queued fetches.
+    bool draining{false};
+  };
+
+  folly::Future<std::shared_ptr<const Tree>> startFetch(
+      const Hash& id,
+      ObjectFetchContext& context);
+  void fetchFinished();
+
+  /**
+   * Start queued fetches until the queue is empty or maxInFlight_ is
+   * reached. Only one thread drains the queue at a time, so that a fetch
+   * completing immediately does not recurse into starting the next one.
+   */
+  void drainQueue();
+
+  const ObjectStore* const store_;
+  const size_t maxInFlight_;
+  const CancellationCheck isCancelled_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace eden
+} // namespace facebook
@@ -21,13 +21,17 @@ template <typename Request, typename... Input>
 std::pair<HgImportRequest, folly::Future<typename Request::Response>>
 makeRequest(
     ImportPriority priority,
+    ObjectFetchContext::Cause cause,
     std::unique_ptr<RequestMetricsScope> metricsScope,
     Input&&... input) {
   auto promise = folly::Promise<typename Request::Response>{};
   auto future = promise.getFuture();
   return std::make_pair(
       HgImportRequest{
-          Request{std::forward<Input>(input)...}, priority, std::move(promise)},
+          Request{std::forward<Input>(input)...},
+          priority,
+          std::move(promise),
+          cause},
       std::move(future).ensure([metrics = std::move(metricsScope)]() {}));
 }
 } // namespace
@@ -37,9 +41,10 @@ HgImportRequest::makeBlobImportRequest(
     Hash hash,
     HgProxyHash proxyHash,
     ImportPriority priority,
-    std::unique_ptr<RequestMetricsScope> metricsScope) {
+    std::unique_ptr<RequestMetricsScope> metricsScope,
+    ObjectFetchContext::Cause cause) {
   return makeRequest<BlobImport>(
-      priority, std::move(metricsScope), hash, std::move(proxyHash));
+      priority, cause, std::move(metricsScope), hash, std::move(proxyHash));
 }
 
 std::pair<HgImportRequest, folly::Future<std::unique_ptr<Tree>>>
@@ -48,9 +53,11 @@ HgImportRequest::makeTreeImportRequest(
     HgProxyHash proxyHash,
     ImportPriority priority,
     std::unique_ptr<RequestMetricsScope> metricsScope,
-    bool prefetchMetadata) {
+    bool prefetchMetadata,
+    ObjectFetchContext::Cause cause) {
   return makeRequest<TreeImport>(
       priority,
+      cause,
       std::move(metricsScope),
       hash,
       std::move(proxyHash),
@@ -63,7 +70,10 @@ HgImportRequest::makePrefetchRequest(
     ImportPriority priority,
     std::unique_ptr<RequestMetricsScope> metricsScope) {
   return makeRequest<Prefetch>(
-      priority, std::move(metricsScope), std::move(hashes));
+      priority,
+      ObjectFetchContext::Cause::Unknown,
+      std::move(metricsScope),
+      std::move(hashes));
 }
 } // namespace eden
 } // namespace facebook
@@ -15,6 +15,7 @@
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/ImportPriority.h"
+#include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/hg/HgProxyHash.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/utils/Bug.h"
@@ -58,7 +59,8 @@ class HgImportRequest {
       Hash hash,
       HgProxyHash proxyHash,
       ImportPriority priority,
-      std::unique_ptr<RequestMetricsScope> metricsScope);
+      std::unique_ptr<RequestMetricsScope> metricsScope,
+      ObjectFetchContext::Cause cause = ObjectFetchContext::Cause::Unknown);
 
   static std::pair<HgImportRequest, folly::Future<std::unique_ptr<Tree>>>
   makeTreeImportRequest(
@@ -66,7 +68,8 @@ class HgImportRequest {
       HgProxyHash proxyHash,
       ImportPriority priority,
       std::unique_ptr<RequestMetricsScope> metricsScope,
-      bool prefetchMetadata);
+      bool prefetchMetadata,
+      ObjectFetchContext::Cause cause = ObjectFetchContext::Cause::Unknown);
 
   static std::pair<HgImportRequest, folly::Future<folly::Unit>>
   makePrefetchRequest(
@@ -78,9 +81,11 @@ class HgImportRequest {
   HgImportRequest(
       RequestType request,
       ImportPriority priority,
-      folly::Promise<typename RequestType::Response>&& promise)
+      folly::Promise<typename RequestType::Response>&& promise,
+      ObjectFetchContext::Cause cause = ObjectFetchContext::Cause::Unknown)
       : request_(std::move(request)),
         priority_(priority),
+        cause_(cause),
         promise_(std::move(promise)) {}
 
   ~HgImportRequest() = default;
@@ -116,6 +121,13 @@ class HgImportRequest {
     return unique_;
   }
 
+  /**
+   * What caused this import, used to throttle imports.
+   */
+  ObjectFetchContext::Cause getCause() const {
+    return cause_;
+  }
+
  private:
   HgImportRequest(const HgImportRequest&) = delete;
   HgImportRequest& operator=(const HgImportRequest&) = delete;
@@ -128,6 +140,7 @@ class HgImportRequest {
 
   Request request_;
   ImportPriority priority_;
+  ObjectFetchContext::Cause cause_;
   Response promise_;
   uint64_t unique_ = generateUniqueID();
 
@@ -7,12 +7,21 @@
 
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
 
+#include <folly/Utility.h>
 #include <folly/futures/Future.h>
 #include <algorithm>
+#include <chrono>
+#include <optional>
 
 namespace facebook {
 namespace eden {
 
+namespace {
+// How long dequeue() waits before checking again whether throttled requests
+// can be dispatched, if no new request comes in.
+constexpr auto kMaxThrottleWait = std::chrono::milliseconds{10};
+} // namespace
+
 void HgImportRequestQueue::stop() {
   auto state = state_.lock();
   if (state->running) {
@@ -38,51 +47,116 @@ void HgImportRequestQueue::enqueue(HgImportRequest request) {
 }
 
 std::vector<HgImportRequest> HgImportRequestQueue::dequeue(size_t count) {
-  auto state = state_.lock();
+  return dequeue(count, [](HgImportThrottle::RequestClass) {
+    return HgImportThrottle::Clock::duration::zero();
+  });
+}
 
-  while (state->running && state->queue.empty()) {
-    queueCV_.wait(state.getUniqueLock());
-  }
+std::vector<HgImportRequest> HgImportRequestQueue::dequeue(
+    size_t count,
+    ThrottleDelayFn getThrottleDelay) {
+  using Clock = HgImportThrottle::Clock;
+  using RequestClass = HgImportThrottle::RequestClass;
 
-  if (!state->running) {
-    state->queue.clear();
-    return std::vector<HgImportRequest>();
-  }
+  auto state = state_.lock();
 
-  auto& queue = state->queue;
+  for (;;) {
+    if (!state->running) {
+      state->queue.clear();
+      for (auto& throttled : state->throttled) {
+        throttled.clear();
+      }
+      return std::vector<HgImportRequest>();
+    }
 
-  std::vector<HgImportRequest> result;
-  std::vector<HgImportRequest> putback;
-  std::optional<size_t> type;
+    auto& queue = state->queue;
 
-  for (size_t i = 0; i < count * 3; i++) {
-    if (queue.empty() || result.size() == count) {
-      break;
+    std::array<
+        std::optional<Clock::duration>,
+        HgImportThrottle::kNumRequestClasses>
+        delays;
+    auto getDelay = [&](RequestClass requestClass) {
+      auto& delay = delays[folly::to_underlying(requestClass)];
+      if (!delay) {
+        delay = getThrottleDelay(requestClass);
+      }
+      return *delay;
+    };
+
+    // Give the requests of the classes that are no longer throttled back to
+    // the queue.
+    for (size_t i = 0; i < state->throttled.size(); i++) {
+      auto& throttled = state->throttled[i];
+      if (throttled.empty() ||
+          getDelay(static_cast<RequestClass>(i)) > Clock::duration::zero()) {
+        continue;
+      }
+      for (auto& request : throttled) {
+        queue.emplace_back(std::move(request));
+        std::push_heap(queue.begin(), queue.end());
+      }
+      throttled.clear();
     }
 
-    std::pop_heap(queue.begin(), queue.end());
-
-    auto request = std::move(queue.back());
-    queue.pop_back();
+    std::vector<HgImportRequest> result;
+    std::vector<HgImportRequest> putback;
+    std::optional<size_t> type;
+
+    // Throttled requests are not counted, so that they can't hide the requests
+    // of other classes behind them.
+    size_t considered = 0;
+    while (!queue.empty() && result.size() < count && considered < count * 3) {
+      std::pop_heap(queue.begin(), queue.end());
+
+      auto request = std::move(queue.back());
+      queue.pop_back();
+
+      auto requestClass = HgImportThrottle::classify(request.getCause());
+      if (getDelay(requestClass) > Clock::duration::zero()) {
+        auto& throttled = state->throttled[folly::to_underlying(requestClass)];
+        throttled.emplace_back(std::move(request));
+        std::push_heap(throttled.begin(), throttled.end());
+        continue;
+      }
 
-    if (!type) {
-      type = request.getType();
-      result.emplace_back(std::move(request));
-    } else {
-      if (*type == request.getType()) {
+      considered++;
+      if (!type) {
+        type = request.getType();
         result.emplace_back(std::move(request));
       } else {
-        putback.emplace_back(std::move(request));
+        if (*type == request.getType()) {
+          result.emplace_back(std::move(request));
+        } else {
+          putback.emplace_back(std::move(request));
+        }
       }
     }
-  }
 
-  for (auto& item : putback) {
-    queue.emplace_back(std::move(item));
-    std::push_heap(queue.begin(), queue.end());
-  }
+    for (auto& item : putback) {
+      queue.emplace_back(std::move(item));
+      std::push_heap(queue.begin(), queue.end());
+    }
+
+    if (!result.empty()) {
+      return result;
+    }
 
-  return result;
+    // Everything is throttled, or there is nothing to do. Wait for a new
+    // request, or for a throttled class to recover.
+    auto wait = Clock::duration::max();
+    for (size_t i = 0; i < state->throttled.size(); i++) {
+      if (!state->throttled[i].empty()) {
+        wait = std::min(wait, getDelay(static_cast<RequestClass>(i)));
+      }
+    }
+    if (wait == Clock::duration::max()) {
+      queueCV_.wait(state.getUniqueLock());
+    } else {
+      queueCV_.wait_for(
+          state.getUniqueLock(),
+          std::min<Clock::duration>(wait, kMaxThrottleWait));
+    }
+  }
 }
 } // namespace eden
 } // namespace facebook
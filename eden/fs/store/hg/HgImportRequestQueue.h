@@ -7,12 +7,15 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <array>
 #include <condition_variable>
 #include <mutex>
 #include <vector>
 
 #include "eden/fs/store/hg/HgImportRequest.h"
+#include "eden/fs/store/hg/HgImportThrottle.h"
 
 namespace facebook {
 namespace eden {
@@ -36,6 +39,26 @@ class HgImportRequestQueue {
    */
   std::vector<HgImportRequest> dequeue(size_t count);
 
+  /**
+   * Returns how long the requests of a class have to wait before they can be
+   * dispatched, zero if they can be dispatched now.
+   */
+  using ThrottleDelayFn = folly::FunctionRef<HgImportThrottle::Clock::duration(
+      HgImportThrottle::RequestClass)>;
+
+  /*
+   * Like dequeue(count), but only returns requests of the classes that
+   * getThrottleDelay says can be dispatched. The requests of throttled classes
+   * are set aside until their class is no longer throttled, so they neither
+   * hold a worker nor block the requests of the other classes. This blocks
+   * while every queued request is throttled.
+   *
+   * getThrottleDelay is called with the queue lock held.
+   */
+  std::vector<HgImportRequest> dequeue(
+      size_t count,
+      ThrottleDelayFn getThrottleDelay);
+
   void stop();
 
  private:
@@ -45,6 +68,13 @@ class HgImportRequestQueue {
   struct State {
     bool running = true;
     std::vector<HgImportRequest> queue;
+    /**
+     * Heaps of the requests that were throttled, by request class.
+     */
+    std::array<
+        std::vector<HgImportRequest>,
+        HgImportThrottle::kNumRequestClasses>
+        throttled;
   };
 
   folly::Synchronized<State, std::mutex> state_;
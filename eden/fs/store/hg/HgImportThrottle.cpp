@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgImportThrottle.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/EnumValue.h"
+
+namespace facebook {
+namespace eden {
+
+namespace {
+/**
+ * A token bucket that holds at most one second worth of tokens, and that may
+ * go into debt. The rate is passed to every call so that it can be
+ * reconfigured at any time.
+ */
+class TokenBucket {
+ public:
+  HgImportThrottle::Clock::duration getDelay(
+      double rate,
+      HgImportThrottle::Clock::time_point now) {
+    if (rate <= 0) {
+      return HgImportThrottle::Clock::duration::zero();
+    }
+    auto state = state_.lock();
+    refill(*state, rate, now);
+    if (state->balance >= 0) {
+      return HgImportThrottle::Clock::duration::zero();
+    }
+    return std::chrono::duration_cast<HgImportThrottle::Clock::duration>(
+        std::chrono::duration<double>{-state->balance / rate});
+  }
+
+  void charge(
+      double amount,
+      double rate,
+      HgImportThrottle::Clock::time_point now) {
+    if (rate <= 0) {
+      return;
+    }
+    auto state = state_.lock();
+    refill(*state, rate, now);
+    state->balance -= amount;
+  }
+
+ private:
+  struct State {
+    double balance = 0;
+    // Starts at the clock's epoch so that a new bucket starts full.
+    HgImportThrottle::Clock::time_point lastRefill;
+  };
+
+  static void
+  refill(State& state, double rate, HgImportThrottle::Clock::time_point now) {
+    if (now <= state.lastRefill) {
+      return;
+    }
+    auto elapsed =
+        std::chrono::duration<double>{now - state.lastRefill}.count();
+    state.balance = std::min(rate, state.balance + rate * elapsed);
+    state.lastRefill = now;
+  }
+
+  folly::Synchronized<State, std::mutex> state_;
+};
+} // namespace
+
+class HgImportThrottle::Level {
+ public:
+  Clock::duration getDelay(
+      const HgImportLimits::Rate& rate,
+      Clock::time_point now) {
+    return std::max(
+        requests_.getDelay(rate.requestsPerSecond, now),
+        bytes_.getDelay(rate.bytesPerSecond, now));
+  }
+
+  void chargeRequests(
+      size_t count,
+      const HgImportLimits::Rate& rate,
+      Clock::time_point now) {
+    requests_.charge(count, rate.requestsPerSecond, now);
+  }
+
+  void chargeBytes(
+      size_t bytes,
+      const HgImportLimits::Rate& rate,
+      Clock::time_point now) {
+    bytes_.charge(bytes, rate.bytesPerSecond, now);
+  }
+
+ private:
+  TokenBucket requests_;
+  TokenBucket bytes_;
+};
+
+HgImportThrottle::HgImportThrottle(std::shared_ptr<Level> globalLevel)
+    : global_{globalLevel ? std::move(globalLevel) : getProcessLevel()},
+      repository_{std::make_unique<Level>()},
+      channel_{std::make_unique<Level>()},
+      thrift_{std::make_unique<Level>()},
+      background_{std::make_unique<Level>()} {}
+
+HgImportThrottle::~HgImportThrottle() = default;
+
+HgImportThrottle::RequestClass HgImportThrottle::classify(
+    ObjectFetchContext::Cause cause) {
+  switch (cause) {
+    case ObjectFetchContext::Cause::Channel:
+      return RequestClass::Channel;
+    case ObjectFetchContext::Cause::Thrift:
+      return RequestClass::Thrift;
+    case ObjectFetchContext::Cause::Unknown:
+      return RequestClass::Background;
+  }
+  EDEN_BUG() << "unknown fetch cause " << enumValue(cause);
+}
+
+std::shared_ptr<HgImportThrottle::Level> HgImportThrottle::getProcessLevel() {
+  static auto* level = new std::shared_ptr<Level>{makeLevel()};
+  return *level;
+}
+
+std::shared_ptr<HgImportThrottle::Level> HgImportThrottle::makeLevel() {
+  return std::make_shared<Level>();
+}
+
+HgImportThrottle::Level& HgImportThrottle::getClassLevel(
+    RequestClass requestClass) {
+  switch (requestClass) {
+    case RequestClass::Channel:
+      return *channel_;
+    case RequestClass::Thrift:
+      return *thrift_;
+    case RequestClass::Background:
+      return *background_;
+  }
+  EDEN_BUG() << "unknown request class " << enumValue(requestClass);
+}
+
+const HgImportLimits::Rate& HgImportThrottle::getClassRate(
+    RequestClass requestClass,
+    const HgImportLimits& limits) {
+  switch (requestClass) {
+    case RequestClass::Channel:
+      return limits.channel;
+    case RequestClass::Thrift:
+      return limits.thrift;
+    case RequestClass::Background:
+      return limits.background;
+  }
+  EDEN_BUG() << "unknown request class " << enumValue(requestClass);
+}
+
+template <typename Fn>
+void HgImportThrottle::forEachLevel(
+    RequestClass requestClass,
+    const HgImportLimits& limits,
+    Fn&& fn) {
+  fn(*global_, limits.global);
+  fn(*repository_, limits.repository);
+  fn(getClassLevel(requestClass), getClassRate(requestClass, limits));
+}
+
+HgImportThrottle::Clock::duration HgImportThrottle::getDelay(
+    RequestClass requestClass,
+    const HgImportLimits& limits,
+    Clock::time_point now) {
+  auto delay = getClassLevel(requestClass)
+                   .getDelay(getClassRate(requestClass, limits), now);
+  if (requestClass == RequestClass::Channel) {
+    // Channel requests borrow from the shared levels.
+    return delay;
+  }
+  return std::max(
+      {delay,
+       global_->getDelay(limits.global, now),
+       repository_->getDelay(limits.repository, now)});
+}
+
+void HgImportThrottle::chargeRequests(
+    RequestClass requestClass,
+    size_t count,
+    const HgImportLimits& limits,
+    Clock::time_point now) {
+  forEachLevel(
+      requestClass,
+      limits,
+      [&](Level& level, const HgImportLimits::Rate& rate) {
+        level.chargeRequests(count, rate, now);
+      });
+}
+
+void HgImportThrottle::chargeBytes(
+    RequestClass requestClass,
+    size_t bytes,
+    const HgImportLimits& limits,
+    Clock::time_point now) {
+  forEachLevel(
+      requestClass,
+      limits,
+      [&](Level& level, const HgImportLimits::Rate& rate) {
+        level.chargeBytes(bytes, rate, now);
+      });
+}
+
+} // namespace eden
+} // namespace facebook
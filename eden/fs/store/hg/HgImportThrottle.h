@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <memory>
+
+#include "eden/fs/store/ObjectFetchContext.h"
+
+namespace facebook {
+namespace eden {
+
+/**
+ * Rates allowed for imports at each level of an HgImportThrottle. A rate of 0
+ * means unlimited.
+ */
+struct HgImportLimits {
+  struct Rate {
+    double requestsPerSecond = 0;
+    double bytesPerSecond = 0;
+  };
+
+  /** Shared by all the repositories of this process. */
+  Rate global;
+  /** Shared by all the mounts of a repository. */
+  Rate repository;
+  /** Imports caused by a filesystem request (FUSE, NFS, ProjectedFS). */
+  Rate channel;
+  /** Imports caused by a Thrift request. */
+  Rate thrift;
+  /** Prefetches and imports with an unknown cause. */
+  Rate background;
+};
+
+/**
+ * Hierarchical token buckets limiting the rate at which HgQueuedBackingStore
+ * dispatches imports.
+ *
+ * Every import is charged to the global level, the repository level, and the
+ * level of its request class. Requests are charged when dispatched, and bytes
+ * once the import completes, so a level may go into debt. A request may only
+ * be dispatched once all of the levels that apply to it are out of debt.
+ *
+ * Channel requests only wait on their own level: they are charged to the
+ * global and repository levels, but do not wait for them to recover. They
+ * thus borrow from the Thrift and background budgets, which wait until the
+ * shared levels are repaid.
+ */
+class HgImportThrottle {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class RequestClass : uint8_t {
+    Channel,
+    Thrift,
+    Background,
+  };
+  static constexpr size_t kNumRequestClasses = 3;
+
+  /**
+   * A request and a bandwidth token bucket. The global level is shared by all
+   * the HgImportThrottles of the process.
+   */
+  class Level;
+
+  explicit HgImportThrottle(std::shared_ptr<Level> globalLevel = nullptr);
+  ~HgImportThrottle();
+
+  HgImportThrottle(const HgImportThrottle&) = delete;
+  HgImportThrottle& operator=(const HgImportThrottle&) = delete;
+
+  static RequestClass classify(ObjectFetchContext::Cause cause);
+
+  /** The level shared by HgImportThrottles created without a global level. */
+  static std::shared_ptr<Level> getProcessLevel();
+
+  static std::shared_ptr<Level> makeLevel();
+
+  /**
+   * Returns how long a request of the given class has to wait before it can
+   * be dispatched. Zero if it can be dispatched now.
+   */
+  Clock::duration getDelay(
+      RequestClass requestClass,
+      const HgImportLimits& limits,
+      Clock::time_point now = Clock::now());
+
+  /** Charge the dispatch of count requests. */
+  void chargeRequests(
+      RequestClass requestClass,
+      size_t count,
+      const HgImportLimits& limits,
+      Clock::time_point now = Clock::now());
+
+  /** Charge bytes that were imported. */
+  void chargeBytes(
+      RequestClass requestClass,
+      size_t bytes,
+      const HgImportLimits& limits,
+      Clock::time_point now = Clock::now());
+
+ private:
+  Level& getClassLevel(RequestClass requestClass);
+  static const HgImportLimits::Rate& getClassRate(
+      RequestClass requestClass,
+      const HgImportLimits& limits);
+
+  template <typename Fn>
+  void forEachLevel(
+      RequestClass requestClass,
+      const HgImportLimits& limits,
+      Fn&& fn);
+
+  std::shared_ptr<Level> global_;
+  std::unique_ptr<Level> repository_;
+  std::unique_ptr<Level> channel_;
+  std::unique_ptr<Level> thrift_;
+  std::unique_ptr<Level> background_;
+};
+
+} // namespace eden
+} // namespace facebook
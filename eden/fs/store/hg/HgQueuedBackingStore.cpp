@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 
+#include <chrono>
 #include <thread>
 #include <utility>
 #include <variant>
@@ -70,11 +71,13 @@ HgQueuedBackingStore::HgQueuedBackingStore(
     std::unique_ptr<HgBackingStore> backingStore,
     std::shared_ptr<ReloadableConfig> config,
     std::unique_ptr<BackingStoreLogger> logger,
-    uint8_t numberThreads)
+    uint8_t numberThreads,
+    std::shared_ptr<HgImportThrottle::Level> globalThrottleLevel)
     : localStore_(std::move(localStore)),
       stats_(std::move(stats)),
       config_(std::move(config)),
       backingStore_(std::move(backingStore)),
+      throttle_(std::move(globalThrottleLevel)),
       logger_(std::move(logger)),
       traceBus_{TraceBus<HgImportTraceEvent>::create("hg", kTraceBusCapacity)} {
   threads_.reserve(numberThreads);
@@ -198,12 +201,30 @@ void HgQueuedBackingStore::processPrefetchRequests(
 void HgQueuedBackingStore::processRequest() {
   folly::setThreadName("hgqueue");
   for (;;) {
-    auto requests = queue_.dequeue(FLAGS_hg_queue_batch_size);
+    auto limits = getImportLimits();
+    bool throttled = false;
+    auto start = HgImportThrottle::Clock::now();
+    auto requests = queue_.dequeue(
+        FLAGS_hg_queue_batch_size,
+        [&](HgImportThrottle::RequestClass requestClass) {
+          auto delay = throttle_.getDelay(requestClass, limits);
+          throttled |= delay > HgImportThrottle::Clock::duration::zero();
+          return delay;
+        });
 
     if (requests.empty()) {
       break;
     }
 
+    if (throttled) {
+      stats_->getHgBackingStoreStatsForCurrentThread()
+          .hgImportThrottled.addValue(
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  HgImportThrottle::Clock::now() - start)
+                  .count());
+    }
+    chargeRequests(requests, limits);
+
     const auto& first = requests.at(0);
 
     if (first.isType<HgImportRequest::BlobImport>()) {
@@ -216,6 +237,41 @@ void HgQueuedBackingStore::processRequest() {
   }
 }
 
+void HgQueuedBackingStore::chargeRequests(
+    const std::vector<HgImportRequest>& requests,
+    const HgImportLimits& limits) {
+  for (const auto& request : requests) {
+    throttle_.chargeRequests(
+        HgImportThrottle::classify(request.getCause()), 1, limits);
+  }
+  stats_->getHgBackingStoreStatsForCurrentThread().hgImportRequests.addValue(
+      requests.size());
+}
+
+HgImportLimits HgQueuedBackingStore::getImportLimits() const {
+  HgImportLimits limits;
+  if (!config_) {
+    return limits;
+  }
+  auto config = config_->getEdenConfig();
+  limits.global = {
+      static_cast<double>(config->importRequestsPerSecond.getValue()),
+      static_cast<double>(config->importBytesPerSecond.getValue())};
+  limits.repository = {
+      static_cast<double>(config->repoImportRequestsPerSecond.getValue()),
+      static_cast<double>(config->repoImportBytesPerSecond.getValue())};
+  limits.channel = {
+      static_cast<double>(config->channelImportRequestsPerSecond.getValue()),
+      static_cast<double>(config->channelImportBytesPerSecond.getValue())};
+  limits.thrift = {
+      static_cast<double>(config->thriftImportRequestsPerSecond.getValue()),
+      static_cast<double>(config->thriftImportBytesPerSecond.getValue())};
+  limits.background = {
+      static_cast<double>(config->backgroundImportRequestsPerSecond.getValue()),
+      static_cast<double>(config->backgroundImportBytesPerSecond.getValue())};
+  return limits;
+}
+
 folly::SemiFuture<std::unique_ptr<Tree>> HgQueuedBackingStore::getTree(
     const Hash& id,
     ObjectFetchContext& context) {
@@ -231,7 +287,8 @@ folly::SemiFuture<std::unique_ptr<Tree>> HgQueuedBackingStore::getTree(
       proxyHash,
       context.getPriority(),
       std::move(importTracker),
-      context.prefetchMetadata());
+      context.prefetchMetadata(),
+      context.getCause());
   uint64_t unique = request.getUnique();
 
   traceBus_->publish(
@@ -264,16 +321,31 @@ folly::SemiFuture<std::unique_ptr<Blob>> HgQueuedBackingStore::getBlob(
   auto importTracker =
       std::make_unique<RequestMetricsScope>(&pendingImportBlobWatches_);
   auto [request, future] = HgImportRequest::makeBlobImportRequest(
-      id, proxyHash, context.getPriority(), std::move(importTracker));
+      id,
+      proxyHash,
+      context.getPriority(),
+      std::move(importTracker),
+      context.getCause());
   auto unique = request.getUnique();
   traceBus_->publish(
       HgImportTraceEvent::queue(unique, HgImportTraceEvent::BLOB, proxyHash));
 
   queue_.enqueue(std::move(request));
-  return std::move(future).ensure(
-      [this, unique, proxyHash = std::move(proxyHash)] {
+  return std::move(future)
+      .ensure([this, unique, proxyHash = std::move(proxyHash)] {
         traceBus_->publish(HgImportTraceEvent::finish(
             unique, HgImportTraceEvent::BLOB, proxyHash));
+      })
+      .thenValue([this,
+                  requestClass = HgImportThrottle::classify(
+                      context.getCause())](std::unique_ptr<Blob>&& blob) {
+        // The size of an import is only known once it completes, so the
+        // bandwidth limits are enforced on the following requests.
+        auto size = blob->getSize();
+        throttle_.chargeBytes(requestClass, size, getImportLimits());
+        stats_->getHgBackingStoreStatsForCurrentThread().hgImportBytes.addValue(
+            size);
+        return std::move(blob);
       });
 }
 
@@ -19,6 +19,7 @@
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include "eden/fs/store/hg/HgImportThrottle.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/TraceBus.h"
 
@@ -103,7 +104,8 @@ class HgQueuedBackingStore : public BackingStore {
       std::unique_ptr<HgBackingStore> backingStore,
       std::shared_ptr<ReloadableConfig> config,
       std::unique_ptr<BackingStoreLogger> logger,
-      uint8_t numberThreads = kNumberHgQueueWorker);
+      uint8_t numberThreads = kNumberHgQueueWorker,
+      std::shared_ptr<HgImportThrottle::Level> globalThrottleLevel = nullptr);
 
   ~HgQueuedBackingStore() override;
 
@@ -166,6 +168,19 @@ class HgQueuedBackingStore : public BackingStore {
    */
   void processRequest();
 
+  /**
+   * Charge the dispatch of requests to HgImportThrottle. The queue only
+   * returns requests whose class is not throttled.
+   */
+  void chargeRequests(
+      const std::vector<HgImportRequest>& requests,
+      const HgImportLimits& limits);
+
+  /**
+   * Read the current import rate limits from the config.
+   */
+  HgImportLimits getImportLimits() const;
+
   /**
    * Logs a backing store fetch to scuba if the path being fetched is
    * in the configured paths to log. If `identifer` is a RelativePathPiece this
@@ -227,6 +242,8 @@ class HgQueuedBackingStore : public BackingStore {
    */
   HgImportRequestQueue queue_;
 
+  HgImportThrottle throttle_;
+
   /**
    * The worker thread pool. These threads will be running `processRequest`
    * forever to process incoming import requests
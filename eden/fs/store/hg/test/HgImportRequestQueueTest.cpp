@@ -8,6 +8,7 @@
 #include <folly/logging/xlog.h>
 #include <gtest/gtest.h>
 #include <array>
+#include <chrono>
 #include <memory>
 
 #include "eden/fs/model/Hash.h"
@@ -15,6 +16,7 @@
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include "eden/fs/store/hg/HgImportThrottle.h"
 #include "eden/fs/store/hg/HgProxyHash.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/utils/IDGen.h"
@@ -30,7 +32,8 @@ Hash uniqueHash() {
 
 std::pair<Hash, HgImportRequest> makeBlobImportRequest(
     ImportPriority priority,
-    RequestMetricsScope::LockedRequestWatchList& pendingImportWatches) {
+    RequestMetricsScope::LockedRequestWatchList& pendingImportWatches,
+    ObjectFetchContext::Cause cause = ObjectFetchContext::Cause::Unknown) {
   auto hgRevHash = uniqueHash();
   auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, hgRevHash};
   auto hash = proxyHash.sha1();
@@ -39,7 +42,11 @@ std::pair<Hash, HgImportRequest> makeBlobImportRequest(
   return std::make_pair(
       hash,
       HgImportRequest::makeBlobImportRequest(
-          hash, std::move(proxyHash), priority, std::move(importTracker))
+          hash,
+          std::move(proxyHash),
+          priority,
+          std::move(importTracker),
+          cause)
           .first);
 }
 
@@ -155,3 +162,38 @@ TEST(HgImportRequestQueueTest, getMultipleRequests) {
         enqueued_blob.end());
   }
 }
+
+TEST(HgImportRequestQueueTest, throttledRequestsDoNotBlockOtherClasses) {
+  RequestMetricsScope::LockedRequestWatchList pendingImportWatches;
+
+  auto queue = HgImportRequestQueue{};
+
+  // Background imports ahead of a channel import.
+  for (int i = 0; i < 10; i++) {
+    auto [hash, request] = makeBlobImportRequest(
+        ImportPriority(ImportPriorityKind::Normal, 1), pendingImportWatches);
+    queue.enqueue(std::move(request));
+  }
+  auto [channelHash, channelRequest] = makeBlobImportRequest(
+      ImportPriority(ImportPriorityKind::Normal, 0),
+      pendingImportWatches,
+      ObjectFetchContext::Cause::Channel);
+  queue.enqueue(std::move(channelRequest));
+
+  auto throttleBackground = [](HgImportThrottle::RequestClass requestClass)
+      -> HgImportThrottle::Clock::duration {
+    if (requestClass == HgImportThrottle::RequestClass::Background) {
+      return std::chrono::hours{1};
+    }
+    return HgImportThrottle::Clock::duration::zero();
+  };
+  auto dequeued = queue.dequeue(1, throttleBackground);
+  ASSERT_EQ(1, dequeued.size());
+  EXPECT_EQ(
+      channelHash,
+      dequeued.at(0).getRequest<HgImportRequest::BlobImport>()->hash);
+
+  // The background imports are dispatched once they are no longer throttled.
+  EXPECT_EQ(5, queue.dequeue(5).size());
+  EXPECT_EQ(5, queue.dequeue(5).size());
+}
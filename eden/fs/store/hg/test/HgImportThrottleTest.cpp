@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgImportThrottle.h"
+
+#include <gtest/gtest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using RequestClass = HgImportThrottle::RequestClass;
+
+namespace {
+const auto kStart = HgImportThrottle::Clock::time_point{} + 1h;
+const auto kNoDelay = HgImportThrottle::Clock::duration::zero();
+} // namespace
+
+TEST(HgImportThrottleTest, unlimited_imports_are_never_delayed) {
+  HgImportThrottle throttle{HgImportThrottle::makeLevel()};
+  HgImportLimits limits;
+  throttle.chargeRequests(RequestClass::Background, 1000000, limits, kStart);
+  throttle.chargeBytes(RequestClass::Background, 1000000, limits, kStart);
+  EXPECT_EQ(kNoDelay, throttle.getDelay(RequestClass::Background, limits));
+}
+
+TEST(HgImportThrottleTest, requests_wait_for_debt_to_be_repaid) {
+  HgImportThrottle throttle{HgImportThrottle::makeLevel()};
+  HgImportLimits limits;
+  limits.background.requestsPerSecond = 10;
+
+  // A new bucket holds one second worth of requests.
+  throttle.chargeRequests(RequestClass::Background, 10, limits, kStart);
+  EXPECT_EQ(
+      kNoDelay, throttle.getDelay(RequestClass::Background, limits, kStart));
+
+  throttle.chargeRequests(RequestClass::Background, 1, limits, kStart);
+  EXPECT_EQ(100ms, throttle.getDelay(RequestClass::Background, limits, kStart));
+  EXPECT_EQ(
+      kNoDelay,
+      throttle.getDelay(RequestClass::Background, limits, kStart + 100ms));
+
+  // Other classes are not affected by the background limit.
+  EXPECT_EQ(kNoDelay, throttle.getDelay(RequestClass::Thrift, limits, kStart));
+}
+
+TEST(HgImportThrottleTest, imported_bytes_delay_later_requests) {
+  HgImportThrottle throttle{HgImportThrottle::makeLevel()};
+  HgImportLimits limits;
+  limits.repository.bytesPerSecond = 1000;
+
+  throttle.chargeBytes(RequestClass::Thrift, 3000, limits, kStart);
+  EXPECT_EQ(2s, throttle.getDelay(RequestClass::Thrift, limits, kStart));
+  EXPECT_EQ(2s, throttle.getDelay(RequestClass::Background, limits, kStart));
+}
+
+TEST(HgImportThrottleTest, channel_requests_borrow_from_shared_levels) {
+  HgImportThrottle throttle{HgImportThrottle::makeLevel()};
+  HgImportLimits limits;
+  limits.global.requestsPerSecond = 10;
+  limits.repository.requestsPerSecond = 10;
+
+  throttle.chargeRequests(RequestClass::Channel, 20, limits, kStart);
+  EXPECT_EQ(kNoDelay, throttle.getDelay(RequestClass::Channel, limits, kStart));
+  EXPECT_EQ(1s, throttle.getDelay(RequestClass::Thrift, limits, kStart));
+  EXPECT_EQ(1s, throttle.getDelay(RequestClass::Background, limits, kStart));
+
+  // Channel requests still wait on their own limit.
+  limits.channel.requestsPerSecond = 10;
+  throttle.chargeRequests(RequestClass::Channel, 15, limits, kStart);
+  EXPECT_EQ(500ms, throttle.getDelay(RequestClass::Channel, limits, kStart));
+}
+
+TEST(HgImportThrottleTest, global_level_is_shared) {
+  auto global = HgImportThrottle::makeLevel();
+  HgImportThrottle first{global};
+  HgImportThrottle second{global};
+  HgImportLimits limits;
+  limits.global.requestsPerSecond = 10;
+
+  first.chargeRequests(RequestClass::Background, 15, limits, kStart);
+  EXPECT_EQ(500ms, second.getDelay(RequestClass::Background, limits, kStart));
+
+  limits.global.requestsPerSecond = 0;
+  limits.repository.requestsPerSecond = 10;
+  first.chargeRequests(RequestClass::Background, 15, limits, kStart);
+  EXPECT_EQ(
+      kNoDelay, second.getDelay(RequestClass::Background, limits, kStart));
+}
@@ -258,3 +258,60 @@ TEST(
   handle3.reset();
   EXPECT_TRUE(cache->contains(hash3));
 }
+
+TEST(BlobCache, frequency_admission_rejects_one_off_blobs) {
+  auto cache = BlobCache::create(10, 0, BlobCache::AdmissionPolicy::Frequency);
+  cache->insert(blob3);
+  cache->get(hash3);
+  cache->get(hash3);
+  cache->insert(blob4);
+  cache->insert(blob5); // would evict blob3, which is more popular
+
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_FALSE(cache->contains(hash5));
+  EXPECT_EQ(1, cache->getStats().rejectionCount);
+}
+
+TEST(BlobCache, frequency_admission_admits_popular_blobs) {
+  auto cache = BlobCache::create(10, 0, BlobCache::AdmissionPolicy::Frequency);
+  cache->insert(blob3);
+  cache->get(hash3);
+  cache->get(hash3);
+  cache->insert(blob4);
+  for (int i = 0; i < 3; ++i) {
+    cache->insert(blob5);
+    EXPECT_FALSE(cache->contains(hash5));
+  }
+
+  cache->insert(blob5); // now accessed more often than blob3
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_TRUE(cache->contains(hash5));
+}
+
+TEST(BlobCache, frequency_admission_protects_small_blobs_from_large_blob) {
+  auto cache = BlobCache::create(20, 0, BlobCache::AdmissionPolicy::Frequency);
+  for (const auto& blob : {blob3, blob4, blob5}) {
+    cache->insert(blob);
+    cache->get(blob->getHash());
+  }
+  cache->insert(blob9);
+
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_TRUE(cache->contains(hash5));
+  EXPECT_FALSE(cache->contains(hash9));
+}
+
+TEST(BlobCache, unlikely_needed_again_blobs_only_use_free_space) {
+  auto cache = BlobCache::create(10, 0, BlobCache::AdmissionPolicy::Frequency);
+  cache->insert(blob3, BlobCache::Interest::UnlikelyNeededAgain);
+  EXPECT_TRUE(cache->contains(hash3)) << "blob3 fits in the empty cache";
+
+  cache->insert(blob4);
+  cache->insert(blob5, BlobCache::Interest::UnlikelyNeededAgain);
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_FALSE(cache->contains(hash5));
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FrequencySketch.h"
+
+#include <folly/Conv.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::eden;
+
+namespace {
+Hash makeHash(size_t i) {
+  auto str = folly::to<std::string>(i);
+  return Hash::sha1(folly::ByteRange{folly::StringPiece{str}});
+}
+} // namespace
+
+TEST(FrequencySketchTest, counts_accesses) {
+  FrequencySketch sketch{64};
+  auto hash = makeHash(0);
+  EXPECT_EQ(0, sketch.estimate(hash));
+  sketch.increment(hash);
+  sketch.increment(hash);
+  EXPECT_EQ(2, sketch.estimate(hash));
+  EXPECT_EQ(0, sketch.estimate(makeHash(1)));
+}
+
+TEST(FrequencySketchTest, counts_saturate) {
+  FrequencySketch sketch{64};
+  auto hash = makeHash(0);
+  for (int i = 0; i < 100; ++i) {
+    sketch.increment(hash);
+  }
+  EXPECT_EQ(FrequencySketch::kMaxFrequency, sketch.estimate(hash));
+}
+
+TEST(FrequencySketchTest, counts_age) {
+  FrequencySketch sketch{64};
+  auto hash = makeHash(0);
+  for (int i = 0; i < FrequencySketch::kMaxFrequency; ++i) {
+    sketch.increment(hash);
+  }
+  // The sketch ages once it has recorded ten times its width.
+  for (size_t i = 1; i <= 640; ++i) {
+    sketch.increment(makeHash(i));
+  }
+  EXPECT_LT(sketch.estimate(hash), FrequencySketch::kMaxFrequency);
+}
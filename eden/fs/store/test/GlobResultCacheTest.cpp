@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/GlobResultCache.h"
+
+#include <folly/Conv.h>
+#include <gtest/gtest.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/testharness/TestUtil.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using Entry = GlobResultCache::Entry;
+
+namespace {
+std::vector<Entry> makeEntries() {
+  return {
+      Entry{RelativePath{"dir/sub/b.txt"}, dtype_t::Regular},
+      Entry{RelativePath{"dir/a.txt"}, dtype_t::Regular},
+      Entry{RelativePath{"dir"}, dtype_t::Dir},
+      Entry{RelativePath{"dir/sub"}, dtype_t::Dir},
+      Entry{RelativePath{"dir/a.txt"}, dtype_t::Regular},
+  };
+}
+} // namespace
+
+TEST(GlobResultCacheTest, serialized_entries_are_sorted_and_deduplicated) {
+  auto entries = GlobResultCache::deserialize(
+      folly::StringPiece{GlobResultCache::serialize(makeEntries())});
+  std::vector<Entry> expected{
+      Entry{RelativePath{"dir"}, dtype_t::Dir},
+      Entry{RelativePath{"dir/a.txt"}, dtype_t::Regular},
+      Entry{RelativePath{"dir/sub"}, dtype_t::Dir},
+      Entry{RelativePath{"dir/sub/b.txt"}, dtype_t::Regular},
+  };
+  EXPECT_EQ(expected, entries);
+}
+
+TEST(GlobResultCacheTest, names_share_prefixes) {
+  std::vector<Entry> entries;
+  size_t namesSize = 0;
+  for (int i = 0; i < 100; ++i) {
+    auto name = folly::to<std::string>("some/long/directory/name/file", i);
+    namesSize += name.size();
+    entries.push_back(Entry{RelativePath{name}, dtype_t::Regular});
+  }
+  auto data = GlobResultCache::serialize(entries);
+  EXPECT_LT(data.size(), namesSize / 4);
+  EXPECT_EQ(100, GlobResultCache::deserialize(folly::StringPiece{data}).size());
+}
+
+TEST(GlobResultCacheTest, invalid_data_is_rejected) {
+  auto data = GlobResultCache::serialize(makeEntries());
+  EXPECT_THROW(
+      GlobResultCache::deserialize(
+          folly::StringPiece{data}.subpiece(0, data.size() - 1)),
+      std::invalid_argument);
+  EXPECT_THROW(
+      GlobResultCache::deserialize(folly::StringPiece{data + "x"}),
+      std::invalid_argument);
+  EXPECT_THROW(
+      GlobResultCache::deserialize(folly::StringPiece{}),
+      std::invalid_argument);
+}
+
+TEST(GlobResultCacheTest, key_ignores_pattern_order_and_duplicates) {
+  auto tree = makeTestHash("1");
+  auto key = GlobResultCache::makeKey(tree, {"**/BUCK", "**/TARGETS"}, false);
+  EXPECT_EQ(
+      key,
+      GlobResultCache::makeKey(
+          tree, {"**/TARGETS", "**/BUCK", "**/TARGETS"}, false));
+  EXPECT_NE(
+      key,
+      GlobResultCache::makeKey(tree, {"**/BUCK", "**/TARGETS"}, true));
+  EXPECT_NE(
+      key,
+      GlobResultCache::makeKey(
+          makeTestHash("2"), {"**/BUCK", "**/TARGETS"}, false));
+  EXPECT_NE(key, GlobResultCache::makeKey(tree, {"**/BUCK**/TARGETS"}, false));
+}
+
+TEST(GlobResultCacheTest, results_are_stored_in_the_local_store) {
+  GlobResultCache cache{
+      std::make_shared<MemoryLocalStore>(), std::make_shared<EdenStats>()};
+  auto key = GlobResultCache::makeKey(makeTestHash("1"), {"**/BUCK"}, false);
+
+  EXPECT_FALSE(cache.get(key).get(0ms).has_value());
+  cache.put(key, makeEntries());
+  auto cached = cache.get(key).get(0ms);
+  ASSERT_TRUE(cached.has_value());
+  EXPECT_EQ(4, cached->size());
+}
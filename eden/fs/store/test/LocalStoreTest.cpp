@@ -8,6 +8,7 @@
 #ifndef _WIN32
 
 #include "eden/fs/store/test/LocalStoreTest.h"
+#include <folly/futures/Future.h>
 #include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
 
@@ -180,6 +181,39 @@ TEST_P(LocalStoreTest, testMultipleBlobWriters) {
   EXPECT_EQ("hello world1_4", result1_4.piece());
 }
 
+TEST_P(LocalStoreTest, testConcurrentGetFutures) {
+  // Issue enough concurrent reads that stores which coalesce them have to
+  // split them across several batches.
+  constexpr size_t kKeyCount = 1000;
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < kKeyCount; ++i) {
+    keys.push_back(folly::to<std::string>("key", i));
+    if (i % 2 == 0) {
+      store_->put(
+          KeySpace::BlobFamily,
+          StringPiece{keys.back()},
+          StringPiece{folly::to<std::string>("value", i)});
+    }
+  }
+
+  std::vector<folly::Future<StoreResult>> futures;
+  for (const auto& key : keys) {
+    futures.push_back(
+        store_->getFuture(KeySpace::BlobFamily, StringPiece{key}));
+  }
+  auto results = folly::collect(futures).get(10s);
+
+  ASSERT_EQ(kKeyCount, results.size());
+  for (size_t i = 0; i < kKeyCount; ++i) {
+    if (i % 2 == 0) {
+      ASSERT_TRUE(results[i].isValid()) << keys[i];
+      EXPECT_EQ(folly::to<std::string>("value", i), results[i].piece());
+    } else {
+      EXPECT_FALSE(results[i].isValid()) << keys[i];
+    }
+  }
+}
+
 TEST_P(LocalStoreTest, testClearKeySpace) {
   store_->put(KeySpace::BlobFamily, "key1"_sp, "blob1"_sp);
   store_->put(KeySpace::BlobFamily, "key2"_sp, "blob2"_sp);
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ObjectNegativeCache.h"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using ObjectType = ObjectNegativeCache::ObjectType;
+using ErrorClass = ObjectNegativeCache::ErrorClass;
+
+namespace {
+const auto kStart = ObjectNegativeCache::Clock::time_point{} + 1h;
+const Hash kId{"0123456789abcdef0123456789abcdef01234567"};
+
+folly::exception_wrapper makeError() {
+  return folly::make_exception_wrapper<std::runtime_error>("import failed");
+}
+} // namespace
+
+TEST(ObjectNegativeCache, not_found_objects_are_remembered_for_ttl) {
+  ObjectNegativeCache cache;
+  cache.recordNotFound(ObjectType::Blob, kId, 30s, kStart);
+
+  auto failure = cache.lookup(ObjectType::Blob, kId, kStart + 29s);
+  ASSERT_TRUE(failure.has_value());
+  EXPECT_EQ(ErrorClass::NotFound, failure->errorClass);
+  EXPECT_FALSE(cache.lookup(ObjectType::Tree, kId, kStart + 29s).has_value());
+  EXPECT_FALSE(cache.lookup(ObjectType::Blob, kId, kStart + 30s).has_value());
+}
+
+TEST(ObjectNegativeCache, transient_failures_back_off_exponentially) {
+  ObjectNegativeCache cache;
+  auto now = kStart;
+  for (auto backoff : {1s, 2s, 4s, 5s, 5s}) {
+    cache.recordTransientFailure(
+        ObjectType::Tree, kId, makeError(), 1s, 5s, now);
+    auto failure = cache.lookup(ObjectType::Tree, kId, now + backoff - 1ms);
+    ASSERT_TRUE(failure.has_value());
+    EXPECT_EQ(ErrorClass::Transient, failure->errorClass);
+    EXPECT_TRUE(failure->error.is_compatible_with<std::runtime_error>());
+    EXPECT_FALSE(
+        cache.lookup(ObjectType::Tree, kId, now + backoff).has_value());
+    now += backoff;
+  }
+
+  // A failure long after the previous one starts over.
+  now += 10s;
+  cache.recordTransientFailure(ObjectType::Tree, kId, makeError(), 1s, 5s, now);
+  EXPECT_FALSE(cache.lookup(ObjectType::Tree, kId, now + 1s).has_value());
+
+  cache.recordSuccess(ObjectType::Tree, kId);
+  EXPECT_EQ(0, cache.size());
+}
@@ -186,3 +186,105 @@ TEST_F(ObjectStoreTest, get_size_and_sha1_only_imports_blob_once) {
 
   EXPECT_EQ(1, backingStore->getAccessCount(readyBlobId));
 }
+
+TEST_F(ObjectStoreTest, concurrent_fetches_are_shared_across_object_stores) {
+  StoredBlob* storedBlob = backingStore->putBlob("shared"_sp);
+  auto id = storedBlob->get().getHash();
+
+  // A second mount of the same repository.
+  auto otherObjectStore = ObjectStore::create(
+      localStore,
+      backingStore,
+      stats,
+      executor,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      EdenConfig::createTestEdenConfig(),
+      objectStore->getSharedState());
+  LoggingFetchContext otherContext;
+
+  auto future1 = objectStore->getBlob(id, context);
+  auto future2 = otherObjectStore->getBlob(id, otherContext);
+  EXPECT_FALSE(future1.isReady());
+  EXPECT_FALSE(future2.isReady());
+  EXPECT_EQ(1, backingStore->getAccessCount(id));
+
+  storedBlob->setReady();
+  auto blob1 = std::move(future1).get(0ms);
+  auto blob2 = std::move(future2).get(0ms);
+  EXPECT_EQ(blob1, blob2);
+
+  // Only the request that went to the backing store records the fetch.
+  ASSERT_EQ(1, context.requests.size());
+  EXPECT_EQ(ObjectFetchContext::FromBackingStore, context.requests[0].origin);
+  EXPECT_EQ(0, otherContext.requests.size());
+
+  // The metadata cached by the first fetch is visible to both mounts.
+  otherObjectStore->getBlobSize(id, otherContext).get(0ms);
+  ASSERT_EQ(1, otherContext.requests.size());
+  EXPECT_EQ(
+      ObjectFetchContext::FromMemoryCache, otherContext.requests[0].origin);
+}
+
+TEST_F(ObjectStoreTest, clearing_fetch_counts_only_clears_this_mount) {
+  auto otherObjectStore = ObjectStore::create(
+      localStore,
+      backingStore,
+      stats,
+      executor,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      EdenConfig::createTestEdenConfig(),
+      objectStore->getSharedState());
+  constexpr pid_t kPid = 1234;
+  context.clientPid = kPid;
+
+  objectStore->getBlob(readyBlobId, context).get(0ms);
+  otherObjectStore->getBlob(readyBlobId, context).get(0ms);
+  auto& sharedCounts = objectStore->getSharedState()->pidFetchCounts;
+  EXPECT_EQ(2, sharedCounts.getCountByPid(kPid));
+
+  objectStore->clearFetchCounts();
+  EXPECT_TRUE(objectStore->getPidFetches().rlock()->empty());
+  EXPECT_EQ(1, otherObjectStore->getPidFetches().rlock()->at(kPid));
+  EXPECT_EQ(2, sharedCounts.getCountByPid(kPid));
+}
+
+TEST_F(ObjectStoreTest, backing_store_throwing_does_not_block_later_fetches) {
+  auto config = EdenConfig::createTestEdenConfig();
+  config->negativeCacheInitialBackoff.setValue(0ns, ConfigSource::CommandLine);
+  objectStore = ObjectStore::create(
+      localStore,
+      backingStore,
+      stats,
+      executor,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      config);
+
+  // FakeBackingStore throws rather than returning a failed future for
+  // objects it doesn't know about.
+  auto data = "late"_sp;
+  auto id = Hash::sha1(data);
+  EXPECT_THROW(objectStore->getBlob(id, context).get(0ms), std::domain_error);
+
+  putReadyBlob(data);
+  auto blob = objectStore->getBlob(id, context).get(0ms);
+  EXPECT_EQ(data, blob->getContents().cloneCoalescedAsValue().moveToFbString());
+}
+
+TEST_F(ObjectStoreTest, failed_imports_are_not_retried_immediately) {
+  StoredBlob* storedBlob = backingStore->putBlob("flaky"_sp);
+  auto id = storedBlob->get().getHash();
+
+  auto future = objectStore->getBlob(id, context);
+  storedBlob->triggerError(std::runtime_error("import failed"));
+  EXPECT_THROW_RE(
+      std::move(future).get(0ms), std::runtime_error, "import failed");
+
+  // The failure is returned without going to the backing store again.
+  auto retry = objectStore->getBlob(id, context);
+  ASSERT_TRUE(retry.isReady());
+  EXPECT_THROW_RE(std::move(retry).get(), std::runtime_error, "import failed");
+  EXPECT_EQ(1, backingStore->getAccessCount(id));
+}
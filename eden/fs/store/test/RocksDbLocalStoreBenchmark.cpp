@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/RocksDbLocalStore.h"
+
+#include <benchmark/benchmark.h>
+#include <folly/futures/Future.h>
+#include "eden/fs/benchharness/Bench.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/FaultInjector.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+constexpr size_t kKeyCount = 100000;
+
+/**
+ * Reads issued by each benchmark thread before waiting for the results,
+ * approximating the number of outstanding lookups per FUSE worker during a
+ * lookup storm.
+ */
+constexpr size_t kOutstandingReads = 64;
+
+struct Store {
+  Store()
+      : tempDir{makeTempDir()},
+        store{std::make_shared<RocksDbLocalStore>(
+            AbsolutePathPiece{tempDir.path().string()},
+            std::make_shared<NullStructuredLogger>(),
+            &faultInjector)} {
+    auto batch = store->beginWrite();
+    for (size_t i = 0; i < kKeyCount; ++i) {
+      auto hash = getKey(i);
+      batch->put(KeySpace::TreeFamily, hash, hash.getBytes());
+    }
+    batch->flush();
+  }
+
+  static Hash getKey(size_t i) {
+    return Hash::sha1(folly::to<std::string>(i));
+  }
+
+  folly::test::TemporaryDirectory tempDir;
+  FaultInjector faultInjector{/*enabled=*/false};
+  std::shared_ptr<RocksDbLocalStore> store;
+};
+
+Store& getStore() {
+  static Store store;
+  return store;
+}
+
+} // namespace
+
+static void RocksDbLocalStore_get(benchmark::State& state) {
+  auto& store = getStore();
+  size_t i = state.thread_index * kOutstandingReads;
+  for (auto _ : state) {
+    for (size_t j = 0; j < kOutstandingReads; ++j) {
+      auto key = Store::getKey(i++ % kKeyCount);
+      benchmark::DoNotOptimize(
+          store.store->get(KeySpace::TreeFamily, key.getBytes()));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kOutstandingReads);
+}
+BENCHMARK(RocksDbLocalStore_get)->Threads(1)->Threads(8)->Threads(32);
+
+static void RocksDbLocalStore_getFuture(benchmark::State& state) {
+  auto& store = getStore();
+  size_t i = state.thread_index * kOutstandingReads;
+  std::vector<folly::Future<StoreResult>> futures;
+  futures.reserve(kOutstandingReads);
+  for (auto _ : state) {
+    for (size_t j = 0; j < kOutstandingReads; ++j) {
+      auto key = Store::getKey(i++ % kKeyCount);
+      futures.push_back(
+          store.store->getFuture(KeySpace::TreeFamily, key.getBytes()));
+    }
+    benchmark::DoNotOptimize(folly::collect(futures).get());
+    futures.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * kOutstandingReads);
+}
+BENCHMARK(RocksDbLocalStore_getFuture)->Threads(1)->Threads(8)->Threads(32);
+
+EDEN_BENCHMARK_MAIN();
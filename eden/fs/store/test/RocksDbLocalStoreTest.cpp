@@ -12,6 +12,7 @@
 namespace {
 
 using namespace facebook::eden;
+using namespace folly::string_piece_literals;
 
 LocalStoreImplResult makeRocksDbLocalStore(FaultInjector* faultInjector) {
   auto tempDir = makeTempDir();
@@ -22,6 +23,26 @@ LocalStoreImplResult makeRocksDbLocalStore(FaultInjector* faultInjector) {
   return {std::move(tempDir), std::move(store)};
 }
 
+TEST(RocksDbLocalStoreTest, large_values_outlive_the_store) {
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto [tempDir, store] = makeRocksDbLocalStore(&faultInjector);
+
+  std::string large(1024 * 1024, 'x');
+  store->put(KeySpace::BlobFamily, "large"_sp, folly::StringPiece{large});
+  store->put(KeySpace::BlobFamily, "small"_sp, "hello world"_sp);
+  // Compacting flushes the memtable, so that the values are read from the
+  // block cache.
+  store->compactKeySpace(KeySpace::BlobFamily);
+
+  auto largeBuf = store->get(KeySpace::BlobFamily, "large"_sp).extractIOBuf();
+  auto smallBuf = store->get(KeySpace::BlobFamily, "small"_sp).extractIOBuf();
+  store->close();
+  store.reset();
+
+  EXPECT_EQ(large, largeBuf.moveToFbString());
+  EXPECT_EQ("hello world", smallBuf.moveToFbString());
+}
+
 INSTANTIATE_TEST_CASE_P(
     RocksDB,
     LocalStoreTest,
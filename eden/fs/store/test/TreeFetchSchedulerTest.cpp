@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TreeFetchScheduler.h"
+
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <gtest/gtest.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/StoredObject.h"
+#include "eden/fs/testharness/TestUtil.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct TreeFetchSchedulerTest : ::testing::Test {
+  void SetUp() override {
+    auto localStore = std::make_shared<MemoryLocalStore>();
+    backingStore = std::make_shared<FakeBackingStore>(localStore);
+    objectStore = ObjectStore::create(
+        localStore,
+        backingStore,
+        std::make_shared<EdenStats>(),
+        &folly::QueuedImmediateExecutor::instance(),
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        EdenConfig::createTestEdenConfig());
+  }
+
+  std::shared_ptr<FakeBackingStore> backingStore;
+  std::shared_ptr<ObjectStore> objectStore;
+};
+
+} // namespace
+
+TEST_F(TreeFetchSchedulerTest, fetches_beyond_the_limit_are_queued) {
+  TreeFetchScheduler fetcher{objectStore.get(), /*maxInFlight=*/1};
+  auto* tree1 = backingStore->putTree(makeTestHash("1"), {});
+  auto* tree2 = backingStore->putTree(makeTestHash("2"), {});
+  auto* tree3 = backingStore->putTree(makeTestHash("3"), {});
+  auto& context = ObjectFetchContext::getNullContext();
+
+  auto future1 = fetcher.getTree(makeTestHash("1"), context);
+  auto future2 = fetcher.getTree(makeTestHash("2"), context);
+  auto future3 = fetcher.getTree(makeTestHash("3"), context);
+  EXPECT_EQ(1, fetcher.getProgress().inFlight);
+  EXPECT_EQ(2, fetcher.getProgress().queued);
+
+  // The most recently queued fetch is started first.
+  tree1->setReady();
+  ASSERT_TRUE(future1.isReady());
+  EXPECT_EQ(makeTestHash("1"), std::move(future1).get(0ms)->getHash());
+  EXPECT_FALSE(future2.isReady());
+  EXPECT_EQ(1, fetcher.getProgress().queued);
+
+  tree2->setReady();
+  EXPECT_FALSE(future2.isReady());
+  tree3->setReady();
+  EXPECT_EQ(makeTestHash("3"), std::move(future3).get(0ms)->getHash());
+  EXPECT_EQ(makeTestHash("2"), std::move(future2).get(0ms)->getHash());
+
+  auto progress = fetcher.getProgress();
+  EXPECT_EQ(3, progress.fetched);
+  EXPECT_EQ(0, progress.inFlight);
+  EXPECT_EQ(0, progress.queued);
+}
+
+TEST_F(TreeFetchSchedulerTest, cancel_fails_queued_fetches) {
+  TreeFetchScheduler fetcher{objectStore.get(), /*maxInFlight=*/1};
+  auto* tree1 = backingStore->putTree(makeTestHash("1"), {});
+  backingStore->putTree(makeTestHash("2"), {});
+  auto& context = ObjectFetchContext::getNullContext();
+
+  auto future1 = fetcher.getTree(makeTestHash("1"), context);
+  auto future2 = fetcher.getTree(makeTestHash("2"), context);
+  fetcher.cancel();
+  EXPECT_THROW(std::move(future2).get(0ms), TraversalCancelledError);
+  EXPECT_THROW(
+      fetcher.getTree(makeTestHash("2"), context).get(0ms),
+      TraversalCancelledError);
+
+  // Fetches that were already started still complete.
+  tree1->setReady();
+  EXPECT_EQ(makeTestHash("1"), std::move(future1).get(0ms)->getHash());
+}
+
+TEST_F(TreeFetchSchedulerTest, cancellation_check_is_consulted) {
+  bool cancelled = false;
+  TreeFetchScheduler fetcher{
+      objectStore.get(), /*maxInFlight=*/1, [&] { return cancelled; }};
+  auto* tree1 = backingStore->putTree(makeTestHash("1"), {});
+  backingStore->putTree(makeTestHash("2"), {});
+  auto& context = ObjectFetchContext::getNullContext();
+
+  auto future1 = fetcher.getTree(makeTestHash("1"), context);
+  auto future2 = fetcher.getTree(makeTestHash("2"), context);
+  cancelled = true;
+  tree1->setReady();
+  EXPECT_EQ(makeTestHash("1"), std::move(future1).get(0ms)->getHash());
+  EXPECT_THROW(std::move(future2).get(0ms), TraversalCancelledError);
+  EXPECT_TRUE(fetcher.isCancelled());
+}
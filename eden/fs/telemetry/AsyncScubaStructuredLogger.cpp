@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/AsyncScubaStructuredLogger.h"
+
+#include <folly/container/F14Map.h>
+#include <folly/json.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include "eden/fs/telemetry/ScribeLogger.h"
+#include "eden/fs/telemetry/ScubaStructuredLogger.h"
+
+namespace {
+/**
+ * If the aggregator thread is backed up, limit the number of queued events to
+ * the following.
+ */
+constexpr size_t kMaxQueuedEvents = 10000;
+} // namespace
+
+namespace facebook {
+namespace eden {
+
+namespace {
+
+struct AggregatedEvent {
+  folly::dynamic document;
+  int64_t count;
+};
+
+/**
+ * Events that are identical once their timestamp is ignored, keyed by their
+ * serialized form, in the order they were first seen.
+ */
+class EventAggregator {
+ public:
+  void add(const DynamicEvent& event) {
+    auto document = ScubaStructuredLogger::toDocument(event);
+
+    // Build the key without the timestamp, sorting keys so that equal events
+    // always serialize identically.
+    folly::dynamic time = nullptr;
+    auto* ints = document.get_ptr("int");
+    if (ints) {
+      if (auto* t = ints->get_ptr("time")) {
+        time = *t;
+        ints->erase("time");
+      }
+    }
+    folly::json::serialization_opts opts;
+    opts.sort_keys = true;
+    auto key = folly::json::serialize(document, opts);
+
+    auto [it, inserted] = index_.try_emplace(std::move(key), events_.size());
+    if (!inserted) {
+      ++events_[it->second].count;
+      return;
+    }
+    if (ints && !time.isNull()) {
+      // Report the time of the first occurrence.
+      (*ints)["time"] = time;
+    }
+    events_.push_back(AggregatedEvent{std::move(document), 1});
+  }
+
+  bool empty() const {
+    return events_.empty();
+  }
+
+  /**
+   * Serialize the aggregated events and reset the aggregator.
+   */
+  std::vector<std::string> takeMessages() {
+    std::vector<std::string> messages;
+    messages.reserve(events_.size());
+    for (auto& event : events_) {
+      if (event.count > 1) {
+        event.document.setDefault("int", folly::dynamic::object)["count"] =
+            event.count;
+      }
+      messages.push_back(folly::toJson(event.document));
+    }
+    events_.clear();
+    index_.clear();
+    return messages;
+  }
+
+ private:
+  std::vector<AggregatedEvent> events_;
+  folly::F14FastMap<std::string, size_t> index_;
+};
+
+} // namespace
+
+AsyncScubaStructuredLogger::AsyncScubaStructuredLogger(
+    std::shared_ptr<ScribeLogger> scribeLogger,
+    SessionInfo sessionInfo,
+    SampleRates sampleRates,
+    std::chrono::nanoseconds aggregationInterval)
+    : StructuredLogger{true, std::move(sessionInfo), std::move(sampleRates)},
+      scribeLogger_{std::move(scribeLogger)},
+      aggregationInterval_{aggregationInterval} {
+  aggregatorThread_ = std::thread([this] {
+    folly::setThreadName("StructuredLogAgg");
+    aggregatorThread();
+  });
+}
+
+AsyncScubaStructuredLogger::~AsyncScubaStructuredLogger() {
+  queue_.enqueue(std::nullopt);
+  aggregatorThread_.join();
+}
+
+void AsyncScubaStructuredLogger::logDynamicEvent(DynamicEvent event) {
+  if (queuedEvents_.fetch_add(1, std::memory_order_relaxed) >=
+      kMaxQueuedEvents) {
+    queuedEvents_.fetch_sub(1, std::memory_order_relaxed);
+    XLOG_EVERY_MS(DBG7, 10000)
+        << "StructuredLogger queue full, dropping event";
+    return;
+  }
+  queue_.enqueue(std::move(event));
+}
+
+void AsyncScubaStructuredLogger::aggregatorThread() {
+  EventAggregator aggregator;
+  auto flush = [&] {
+    if (!aggregator.empty()) {
+      scribeLogger_->logBatch(aggregator.takeMessages());
+    }
+  };
+
+  auto deadline = std::chrono::steady_clock::now() + aggregationInterval_;
+  for (;;) {
+    std::optional<DynamicEvent> event;
+    if (!queue_.try_dequeue_until(event, deadline)) {
+      flush();
+      deadline = std::chrono::steady_clock::now() + aggregationInterval_;
+      continue;
+    }
+    if (!event) {
+      // The logger is being destroyed.
+      flush();
+      return;
+    }
+    queuedEvents_.fetch_sub(1, std::memory_order_relaxed);
+    aggregator.add(*event);
+    if (std::chrono::steady_clock::now() >= deadline) {
+      flush();
+      deadline = std::chrono::steady_clock::now() + aggregationInterval_;
+    }
+  }
+}
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/concurrency/UnboundedQueue.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <thread>
+#include "eden/fs/telemetry/StructuredLogger.h"
+
+namespace facebook {
+namespace eden {
+
+class ScribeLogger;
+
+/**
+ * A StructuredLogger that moves serialization and I/O off of the logging
+ * thread.
+ *
+ * logEvent() only pushes the event onto a lock-free queue. A background thread
+ * drains the queue, folds events that are identical apart from their "time"
+ * field into a single event with a "count" field, and hands everything
+ * collected during each aggregation interval to the ScribeLogger as one batch.
+ *
+ * If the background thread falls behind, new events are dropped rather than
+ * letting the queue grow without bound.
+ */
+class AsyncScubaStructuredLogger final : public StructuredLogger {
+ public:
+  AsyncScubaStructuredLogger(
+      std::shared_ptr<ScribeLogger> scribeLogger,
+      SessionInfo sessionInfo,
+      SampleRates sampleRates,
+      std::chrono::nanoseconds aggregationInterval);
+
+  /**
+   * Flushes every event logged before destruction to the ScribeLogger.
+   */
+  ~AsyncScubaStructuredLogger() override;
+
+ private:
+  void logDynamicEvent(DynamicEvent event) override;
+
+  void aggregatorThread();
+
+  std::shared_ptr<ScribeLogger> scribeLogger_;
+  const std::chrono::nanoseconds aggregationInterval_;
+
+  /**
+   * Events waiting to be aggregated. An empty optional asks the aggregator
+   * thread to flush and exit.
+   */
+  folly::UMPSCQueue<std::optional<DynamicEvent>, /*MayBlock=*/true> queue_;
+
+  /**
+   * Number of events in queue_, used to bound its size.
+   */
+  std::atomic<size_t> queuedEvents_{0};
+
+  std::thread aggregatorThread_;
+};
+
+} // namespace eden
+} // namespace facebook
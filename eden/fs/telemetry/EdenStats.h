@@ -143,6 +143,12 @@ class ChannelThreadStats : public EdenThreadStatsBase {
   Histogram poll{createHistogram("fuse.poll_us")};
   Histogram forgetmulti{createHistogram("fuse.forgetmulti_us")};
   Histogram fallocate{createHistogram("fuse.fallocate_us")};
+
+  // Time spent by requests waiting for a worker thread of their class.
+  Histogram metadataQueueWait{createHistogram("fuse.metadata_queue_wait_us")};
+  Histogram dataQueueWait{createHistogram("fuse.data_queue_wait_us")};
+  Histogram mutationQueueWait{createHistogram("fuse.mutation_queue_wait_us")};
+  Histogram forgetQueueWait{createHistogram("fuse.forget_queue_wait_us")};
 #else
   Timeseries outOfOrderCreate{createTimeseries("prjfs.out_of_order_create")};
 
@@ -198,6 +204,23 @@ class ObjectStoreThreadStats : public EdenThreadStatsBase {
       createTimeseries("object_store.get_blob_size.local_store")};
   Timeseries getBlobSizeFromBackingStore{
       createTimeseries("object_store.get_blob_size.backing_store")};
+
+  // Requests that failed without going to the backing store because the
+  // object recently failed to import.
+  Timeseries getTreeFromNegativeCache{
+      this,
+      "object_store.get_tree.negative_cache",
+      fb303::SUM,
+      fb303::RATE};
+  Timeseries getBlobFromNegativeCache{
+      this,
+      "object_store.get_blob.negative_cache",
+      fb303::SUM,
+      fb303::RATE};
+
+  // Globs against source control trees, @see GlobResultCache
+  Timeseries globResultCacheHit{createTimeseries("glob_result_cache.hit")};
+  Timeseries globResultCacheMiss{createTimeseries("glob_result_cache.miss")};
 };
 
 /**
@@ -213,6 +236,20 @@ class HgBackingStoreThreadStats : public EdenThreadStatsBase {
       createHistogram("store.mononoke.get_tree")};
   Histogram mononokeBackingStoreGetBlob{
       createHistogram("store.mononoke.get_blob")};
+
+  // Imports dispatched by HgQueuedBackingStore, and the time its workers
+  // spent waiting for HgImportThrottle.
+  Timeseries hgImportRequests{
+      this,
+      "store.hg.import_requests",
+      fb303::SUM,
+      fb303::RATE};
+  Timeseries hgImportBytes{
+      this,
+      "store.hg.import_bytes",
+      fb303::SUM,
+      fb303::RATE};
+  Histogram hgImportThrottled{createHistogram("store.hg.import_throttled_us")};
 };
 
 /**
@@ -30,11 +30,12 @@ folly::dynamic dynamicMap(const std::unordered_map<Key, Value>& map) {
 
 ScubaStructuredLogger::ScubaStructuredLogger(
     std::shared_ptr<ScribeLogger> scribeLogger,
-    SessionInfo sessionInfo)
-    : StructuredLogger{true, std::move(sessionInfo)},
+    SessionInfo sessionInfo,
+    SampleRates sampleRates)
+    : StructuredLogger{true, std::move(sessionInfo), std::move(sampleRates)},
       scribeLogger_{std::move(scribeLogger)} {}
 
-void ScubaStructuredLogger::logDynamicEvent(DynamicEvent event) {
+folly::dynamic ScubaStructuredLogger::toDocument(const DynamicEvent& event) {
   folly::dynamic document = folly::dynamic::object;
 
   const auto& intMap = event.getIntMap();
@@ -52,7 +53,11 @@ void ScubaStructuredLogger::logDynamicEvent(DynamicEvent event) {
     document["double"] = dynamicMap(doubleMap);
   }
 
-  scribeLogger_->log(folly::toJson(document));
+  return document;
+}
+
+void ScubaStructuredLogger::logDynamicEvent(DynamicEvent event) {
+  scribeLogger_->log(folly::toJson(toDocument(event)));
 }
 
 } // namespace eden
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/dynamic.h>
 #include <memory>
 #include "eden/fs/telemetry/StructuredLogger.h"
 
@@ -20,7 +21,14 @@ class ScubaStructuredLogger final : public StructuredLogger {
  public:
   ScubaStructuredLogger(
       std::shared_ptr<ScribeLogger> scribeLogger,
-      SessionInfo sessionInfo);
+      SessionInfo sessionInfo,
+      SampleRates sampleRates = {});
+
+  /**
+   * Convert an event into the document format expected by the log database:
+   * an object with "int", "normal", and "double" objects holding the fields.
+   */
+  static folly::dynamic toDocument(const DynamicEvent& event);
 
  private:
   void logDynamicEvent(DynamicEvent event) override;
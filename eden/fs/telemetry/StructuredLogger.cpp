@@ -7,6 +7,7 @@
 
 #include "eden/fs/telemetry/StructuredLogger.h"
 
+#include <folly/Random.h>
 #include <time.h>
 #include <random>
 
@@ -35,10 +36,29 @@ uint32_t getSessionId() {
 namespace facebook {
 namespace eden {
 
-StructuredLogger::StructuredLogger(bool enabled, SessionInfo sessionInfo)
+StructuredLogger::StructuredLogger(
+    bool enabled,
+    SessionInfo sessionInfo,
+    SampleRates sampleRates)
     : enabled_{enabled},
       sessionId_{getSessionId()},
-      sessionInfo_{std::move(sessionInfo)} {}
+      sessionInfo_{std::move(sessionInfo)},
+      sampleRates_{std::move(sampleRates)} {}
+
+uint32_t StructuredLogger::sampleEventType(const char* type) const {
+  if (sampleRates_.empty()) {
+    return 1;
+  }
+  auto it = sampleRates_.find(type);
+  if (it == sampleRates_.end()) {
+    return 1;
+  }
+  auto sampleRate = it->second;
+  if (sampleRate > 1 && !folly::Random::oneIn(sampleRate)) {
+    return 0;
+  }
+  return sampleRate;
+}
 
 DynamicEvent StructuredLogger::populateDefaultFields(const char* type) {
   DynamicEvent event;
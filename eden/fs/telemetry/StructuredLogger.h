@@ -16,24 +16,59 @@ namespace eden {
 
 class StructuredLogger {
  public:
-  explicit StructuredLogger(bool enabled, SessionInfo sessionInfo);
+  /**
+   * Sampling rates keyed by event type. A rate of N logs one in N events of
+   * that type, and a rate of 0 drops every event of that type. Event types
+   * that are not present are always logged.
+   */
+  using SampleRates = std::unordered_map<std::string, uint32_t>;
+
+  explicit StructuredLogger(
+      bool enabled,
+      SessionInfo sessionInfo,
+      SampleRates sampleRates = {});
   virtual ~StructuredLogger() = default;
 
+  /**
+   * Decide whether the next event of type Event is logged. Returns 0 if it is
+   * dropped, and otherwise the sample rate to pass to logEvent() along with
+   * it.
+   *
+   * Producers whose events are costly to build, for instance because they
+   * look up a process name, call this before building them, so that dropped
+   * events cost no more than a hash lookup and a random number.
+   */
   template <typename Event>
-  void logEvent(const Event& event) {
+  uint32_t sampleEvent() const {
     // Avoid a bunch of work if it's going to be thrown away by the
     // logDynamicEvent implementation.
     if (!enabled_) {
-      return;
+      return 0;
     }
 
     // constexpr to ensure that the type field on the Event struct is constexpr
     // too.
     constexpr const char* type = Event::type;
+    return sampleEventType(type);
+  }
 
-    // TODO: consider moving the event to another thread and populating the
-    // default fields there to reduce latency at the call site.
-    DynamicEvent de{populateDefaultFields(type)};
+  template <typename Event>
+  void logEvent(const Event& event) {
+    if (auto sampleRate = sampleEvent<Event>()) {
+      logEvent(event, sampleRate);
+    }
+  }
+
+  /**
+   * Log an event for which sampleEvent() returned sampleRate.
+   */
+  template <typename Event>
+  void logEvent(const Event& event, uint32_t sampleRate) {
+    DynamicEvent de{populateDefaultFields(Event::type)};
+    if (sampleRate > 1) {
+      // Lets consumers weight each logged event by the number it represents.
+      de.addInt("sample_rate", sampleRate);
+    }
     event.populate(de);
     logDynamicEvent(std::move(de));
   }
@@ -43,9 +78,16 @@ class StructuredLogger {
 
   DynamicEvent populateDefaultFields(const char* type);
 
+  /**
+   * Returns 0 if the next event of the given type is dropped, and its sample
+   * rate otherwise.
+   */
+  uint32_t sampleEventType(const char* type) const;
+
   bool enabled_;
   uint32_t sessionId_;
   SessionInfo sessionInfo_;
+  const SampleRates sampleRates_;
 };
 
 } // namespace eden
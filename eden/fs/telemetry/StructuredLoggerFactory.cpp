@@ -11,7 +11,7 @@
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 
 #ifndef _WIN32
-#include "eden/fs/telemetry/ScubaStructuredLogger.h"
+#include "eden/fs/telemetry/AsyncScubaStructuredLogger.h"
 #include "eden/fs/telemetry/SubprocessScribeLogger.h"
 #endif
 
@@ -37,8 +37,11 @@ std::unique_ptr<StructuredLogger> makeDefaultStructuredLogger(
 #ifndef _WIN32
   auto logger =
       std::make_unique<SubprocessScribeLogger>(binary.c_str(), category);
-  return std::make_unique<ScubaStructuredLogger>(
-      std::move(logger), std::move(sessionInfo));
+  return std::make_unique<AsyncScubaStructuredLogger>(
+      std::move(logger),
+      std::move(sessionInfo),
+      config.eventSampleRates.getValue(),
+      config.eventAggregationInterval.getValue());
 #else
   return std::make_unique<NullStructuredLogger>();
 #endif
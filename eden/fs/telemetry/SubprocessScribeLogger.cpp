@@ -8,6 +8,7 @@
 #include "eden/fs/telemetry/SubprocessScribeLogger.h"
 
 #include <folly/logging/xlog.h>
+#include <folly/portability/SysUio.h>
 #include <folly/system/ThreadName.h>
 
 namespace {
@@ -88,33 +89,57 @@ void SubprocessScribeLogger::closeProcess() {
   process_.waitOrTerminateOrKill(kProcessExitTimeout, kProcessTerminateTimeout);
 }
 
-void SubprocessScribeLogger::log(std::string message) {
+bool SubprocessScribeLogger::enqueueLocked(
+    State& state,
+    std::string& message) {
+  XCHECK(!state.shouldStop) << "log() called during destruction - that's UB";
+  if (state.didStop) {
+    return false;
+  }
   size_t messageSize = message.size();
+  if (state.totalBytes + messageSize > kQueueLimitBytes) {
+    XLOG_EVERY_MS(DBG7, 10000) << "ScribeLogger queue full, dropping message";
+    // queue full, dropping!
+    return false;
+  }
+
+  // This order is important in order to be atomic under std::bad_alloc.
+  state.messages.emplace_back(std::move(message));
+  state.totalBytes += messageSize;
+  return true;
+}
+
+void SubprocessScribeLogger::log(std::string message) {
+  bool queued = enqueueLocked(*state_.lock(), message);
+  if (queued) {
+    newMessageOrStop_.notify_one();
+  }
+}
 
+void SubprocessScribeLogger::logBatch(std::vector<std::string> messages) {
+  bool queued = false;
   {
     auto state = state_.lock();
-    XCHECK(!state->shouldStop) << "log() called during destruction - that's UB";
-    if (state->didStop) {
-      return;
+    for (auto& message : messages) {
+      queued |= enqueueLocked(*state, message);
     }
-    if (state->totalBytes + messageSize > kQueueLimitBytes) {
-      XLOG_EVERY_MS(DBG7, 10000) << "ScribeLogger queue full, dropping message";
-      // queue full, dropping!
-      return;
-    }
-
-    // This order is important in order to be atomic under std::bad_alloc.
-    state->messages.emplace_back(std::move(message));
-    state->totalBytes += messageSize;
   }
-  newMessageOrStop_.notify_one();
+  if (queued) {
+    newMessageOrStop_.notify_one();
+  }
 }
 
 void SubprocessScribeLogger::writerThread() {
   auto fd = process_.stdinFd();
 
+  // Each message is written with a trailing newline, so a single writev can
+  // carry at most half of IOV_MAX messages.
+  constexpr size_t kMaxMessagesPerWrite = IOV_MAX / 2;
+  char newline = '\n';
+  std::vector<iovec> iov;
+
   for (;;) {
-    std::string message;
+    std::list<std::string> messages;
 
     {
       auto state = state_.lock();
@@ -122,13 +147,10 @@ void SubprocessScribeLogger::writerThread() {
         return state->shouldStop || !state->messages.empty();
       });
       if (!state->messages.empty()) {
-        XCHECK_LE(state->messages.front().size(), state->totalBytes)
-            << "totalSize accounting fell out of sync!";
-
-        // The below statements are all noexcept.
-        std::swap(message, state->messages.front());
-        state->messages.pop_front();
-        state->totalBytes -= message.size();
+        // Take every queued message so they can be written with as few
+        // syscalls as possible. The below statements are all noexcept.
+        std::swap(messages, state->messages);
+        state->totalBytes = 0;
       } else {
         // If the predicate succeeded but we have no messages, then we're
         // shutting down cleanly.
@@ -142,25 +164,29 @@ void SubprocessScribeLogger::writerThread() {
       }
     }
 
-    char newline = '\n';
-    std::array<iovec, 2> iov;
-    iov[0].iov_base = message.data();
-    iov[0].iov_len = message.size();
-    iov[1].iov_base = &newline;
-    iov[1].iov_len = sizeof(newline);
-    if (fd.writevFull(iov.data(), iov.size()).hasException()) {
-      // TODO: We could attempt to restart the process here.
-      XLOG(ERR) << "Failed to writev to logger process stdin: "
-                << folly::errnoStr(errno) << ". Giving up!";
-      // Give up. Allow the ScribeLogger class to be destroyed.
-      {
-        auto state = state_.lock();
-        state->didStop = true;
-        state->messages.clear();
-        state->totalBytes = 0;
+    auto it = messages.begin();
+    while (it != messages.end()) {
+      iov.clear();
+      for (size_t i = 0; i < kMaxMessagesPerWrite && it != messages.end();
+           ++i, ++it) {
+        iov.push_back({it->data(), it->size()});
+        iov.push_back({&newline, sizeof(newline)});
+      }
+
+      if (fd.writevFull(iov.data(), iov.size()).hasException()) {
+        // TODO: We could attempt to restart the process here.
+        XLOG(ERR) << "Failed to writev to logger process stdin: "
+                  << folly::errnoStr(errno) << ". Giving up!";
+        // Give up. Allow the ScribeLogger class to be destroyed.
+        {
+          auto state = state_.lock();
+          state->didStop = true;
+          state->messages.clear();
+          state->totalBytes = 0;
+        }
+        allMessagesWritten_.notify_one();
+        return;
       }
-      allMessagesWritten_.notify_one();
-      return;
     }
   }
 }
@@ -51,6 +51,14 @@ class SubprocessScribeLogger : public ScribeLogger {
   void log(std::string message) override;
   using ScribeLogger::log;
 
+  /**
+   * Forwards several log messages to the external process, waking the writer
+   * thread once for the whole batch.
+   *
+   * If the writer process is not keeping up, messages are dropped.
+   */
+  void logBatch(std::vector<std::string> messages) override;
+
  private:
   void closeProcess();
   void writerThread();
@@ -65,6 +73,12 @@ class SubprocessScribeLogger : public ScribeLogger {
     std::list<std::string> messages;
   };
 
+  /**
+   * Queue a message. Returns false if the message was dropped, either because
+   * the writer has stopped or because the queue is full.
+   */
+  static bool enqueueLocked(State& state, std::string& message);
+
   SpawnedProcess process_;
   std::thread writerThread_;
 
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/AsyncScubaStructuredLogger.h"
+#include <folly/Synchronized.h>
+#include <folly/json.h>
+#include <gtest/gtest.h>
+#include "eden/fs/telemetry/ScribeLogger.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct TestScribeLogger : public ScribeLogger {
+  folly::Synchronized<std::vector<std::string>> lines;
+  std::atomic<size_t> batches{0};
+
+  void log(std::string line) override {
+    lines.wlock()->emplace_back(std::move(line));
+  }
+
+  void logBatch(std::vector<std::string> messages) override {
+    ++batches;
+    auto locked = lines.wlock();
+    for (auto& message : messages) {
+      locked->emplace_back(std::move(message));
+    }
+  }
+};
+
+struct TestLogEvent {
+  static constexpr const char* type = "test_event";
+
+  std::string str;
+  int number = 0;
+
+  void populate(DynamicEvent& event) const {
+    event.addString("str", str);
+    event.addInt("number", number);
+  }
+};
+
+struct OtherLogEvent {
+  static constexpr const char* type = "other_event";
+
+  void populate(DynamicEvent&) const {}
+};
+
+std::vector<folly::dynamic> parseLines(TestScribeLogger& scribe) {
+  std::vector<folly::dynamic> docs;
+  for (const auto& line : *scribe.lines.rlock()) {
+    docs.push_back(folly::parseJson(line));
+  }
+  return docs;
+}
+
+std::unique_ptr<AsyncScubaStructuredLogger> makeLogger(
+    std::shared_ptr<ScribeLogger> scribe,
+    StructuredLogger::SampleRates sampleRates = {}) {
+  // Use a long interval so that everything is flushed together when the
+  // logger is destroyed.
+  return std::make_unique<AsyncScubaStructuredLogger>(
+      std::move(scribe), SessionInfo{}, std::move(sampleRates), 1h);
+}
+
+} // namespace
+
+TEST(AsyncScubaStructuredLoggerTest, identical_events_are_aggregated) {
+  auto scribe = std::make_shared<TestScribeLogger>();
+  auto logger = makeLogger(scribe);
+  for (int i = 0; i < 5; ++i) {
+    logger->logEvent(TestLogEvent{"name", 10});
+  }
+  logger.reset();
+
+  auto docs = parseLines(*scribe);
+  ASSERT_EQ(1, docs.size());
+  EXPECT_EQ(5, docs[0]["int"]["count"].asInt());
+  EXPECT_EQ(10, docs[0]["int"]["number"].asInt());
+  EXPECT_TRUE(docs[0]["int"].count("time"));
+  EXPECT_EQ(1, scribe->batches.load());
+}
+
+TEST(AsyncScubaStructuredLoggerTest, different_events_are_logged_separately) {
+  auto scribe = std::make_shared<TestScribeLogger>();
+  auto logger = makeLogger(scribe);
+  logger->logEvent(TestLogEvent{"a", 1});
+  logger->logEvent(TestLogEvent{"a", 2});
+  logger->logEvent(TestLogEvent{"b", 1});
+  logger->logEvent(OtherLogEvent{});
+  logger.reset();
+
+  auto docs = parseLines(*scribe);
+  ASSERT_EQ(4, docs.size());
+  for (const auto& doc : docs) {
+    EXPECT_FALSE(doc["int"].count("count"));
+  }
+  EXPECT_EQ("a", docs[0]["normal"]["str"].asString());
+  EXPECT_EQ(2, docs[1]["int"]["number"].asInt());
+  EXPECT_EQ("b", docs[2]["normal"]["str"].asString());
+  EXPECT_EQ("other_event", docs[3]["normal"]["type"].asString());
+}
+
+TEST(AsyncScubaStructuredLoggerTest, sample_rate_of_zero_drops_events) {
+  auto scribe = std::make_shared<TestScribeLogger>();
+  auto logger = makeLogger(scribe, {{"test_event", 0}});
+  logger->logEvent(TestLogEvent{"name", 10});
+  logger->logEvent(OtherLogEvent{});
+  logger.reset();
+
+  auto docs = parseLines(*scribe);
+  ASSERT_EQ(1, docs.size());
+  EXPECT_EQ("other_event", docs[0]["normal"]["type"].asString());
+  EXPECT_FALSE(docs[0]["int"].count("sample_rate"));
+}
+
+TEST(AsyncScubaStructuredLoggerTest, sampled_events_record_their_rate) {
+  auto scribe = std::make_shared<TestScribeLogger>();
+  auto logger = makeLogger(scribe, {{"test_event", 2}});
+  for (int i = 0; i < 1000; ++i) {
+    logger->logEvent(TestLogEvent{"name", 10});
+  }
+  logger.reset();
+
+  auto docs = parseLines(*scribe);
+  ASSERT_EQ(1, docs.size());
+  EXPECT_EQ(2, docs[0]["int"]["sample_rate"].asInt());
+  auto count = docs[0]["int"]["count"].asInt();
+  EXPECT_GT(count, 0);
+  EXPECT_LT(count, 1000);
+}
+
+TEST(AsyncScubaStructuredLoggerTest, producers_can_sample_before_building) {
+  auto scribe = std::make_shared<TestScribeLogger>();
+  auto logger = makeLogger(scribe, {{"test_event", 0}});
+  EXPECT_EQ(0, logger->sampleEvent<TestLogEvent>());
+  auto sampleRate = logger->sampleEvent<OtherLogEvent>();
+  ASSERT_EQ(1, sampleRate);
+  logger->logEvent(OtherLogEvent{}, sampleRate);
+  logger.reset();
+
+  auto docs = parseLines(*scribe);
+  ASSERT_EQ(1, docs.size());
+  EXPECT_EQ("other_event", docs[0]["normal"]["type"].asString());
+  EXPECT_FALSE(docs[0]["int"].count("sample_rate"));
+}
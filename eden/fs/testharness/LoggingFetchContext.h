@@ -27,7 +27,7 @@ class LoggingFetchContext : public ObjectFetchContext {
   }
 
   std::optional<pid_t> getClientPid() const override {
-    return std::nullopt;
+    return clientPid;
   }
 
   Cause getCause() const override {
@@ -35,6 +35,7 @@ class LoggingFetchContext : public ObjectFetchContext {
   }
 
   std::vector<Request> requests;
+  std::optional<pid_t> clientPid;
 };
 
 } // namespace eden
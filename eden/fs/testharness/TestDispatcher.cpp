@@ -65,6 +65,60 @@ TestDispatcher::PendingLookup TestDispatcher::waitForLookup(
     }
   }
 }
+
+Future<FuseDispatcher::Attr> TestDispatcher::getattr(
+    InodeNumber ino,
+    ObjectFetchContext& /*context*/) {
+  XLOG(DBG5) << "received getattr: ino=" << ino;
+  struct stat st = {};
+  st.st_ino = ino.get();
+  return Attr{st};
+}
+
+Future<BufVec> TestDispatcher::read(
+    InodeNumber ino,
+    size_t size,
+    off_t off,
+    ObjectFetchContext& /*context*/) {
+  XLOG(DBG5) << "received read: ino=" << ino << ", size=" << size
+             << ", off=" << off;
+  {
+    auto state = state_.lock();
+    ++state->reads;
+    ++state->blockedReads;
+    requestReceived_.notify_all();
+    while (!state->readsUnblocked) {
+      requestReceived_.wait(state.getUniqueLock());
+    }
+    --state->blockedReads;
+  }
+  return BufVec{folly::IOBuf::create(0)};
+}
+
+void TestDispatcher::waitForBlockedReads(
+    size_t count,
+    std::chrono::milliseconds timeout) {
+  auto state = state_.lock();
+  auto end_time = std::chrono::steady_clock::now() + timeout;
+  while (state->blockedReads < count) {
+    if (requestReceived_.wait_until(state.getUniqueLock(), end_time) ==
+        std::cv_status::timeout) {
+      throw std::runtime_error(folly::to<string>(
+          "timed out waiting for ",
+          count,
+          " reads to block in the test dispatcher"));
+    }
+  }
+}
+
+void TestDispatcher::unblockReads() {
+  state_.lock()->readsUnblocked = true;
+  requestReceived_.notify_all();
+}
+
+size_t TestDispatcher::getReadCount() const {
+  return state_.lock()->reads;
+}
 } // namespace eden
 } // namespace facebook
 
@@ -58,12 +58,48 @@ class TestDispatcher : public FuseDispatcher {
       uint64_t requestId,
       std::chrono::milliseconds timeout = std::chrono::milliseconds(500));
 
+  /**
+   * Replies right away with attributes that only have st_ino set.
+   */
+  folly::Future<Attr> getattr(InodeNumber ino, ObjectFetchContext& context)
+      override;
+
+  /**
+   * Blocks the calling thread until unblockReads() is called, like a read
+   * waiting on a slow import would, then returns no data.
+   */
+  folly::Future<BufVec> read(
+      InodeNumber ino,
+      size_t size,
+      off_t off,
+      ObjectFetchContext& context) override;
+
+  /**
+   * Wait until count threads are blocked in read().
+   */
+  void waitForBlockedReads(
+      size_t count,
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(500));
+
+  /**
+   * Let the blocked reads, and all the reads after them, return.
+   */
+  void unblockReads();
+
+  /**
+   * Returns the number of FUSE_READ requests received so far.
+   */
+  size_t getReadCount() const;
+
  private:
   struct State {
     std::unordered_map<uint64_t, PendingLookup> pendingLookups;
+    size_t reads{0};
+    size_t blockedReads{0};
+    bool readsUnblocked{false};
   };
 
-  folly::Synchronized<State, std::mutex> state_;
+  mutable folly::Synchronized<State, std::mutex> state_;
   std::condition_variable requestReceived_;
 };
 
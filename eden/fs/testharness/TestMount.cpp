@@ -89,6 +89,17 @@ TestMount::TestMount()
   initTestDirectory();
 
   auto userInfo = UserInfo::lookup();
+  edenConfig_ = make_shared<EdenConfig>(
+      /*userName=*/folly::StringPiece{"bob"},
+      /*userID=*/uid_t{},
+      /*userHomePath=*/AbsolutePath{testDir_->path().string()},
+      /*userConfigPath=*/
+      AbsolutePath{testDir_->path().string() + ".edenrc"},
+      /*systemConfigDir=*/AbsolutePath{testDir_->path().string()},
+      /*systemConfigPath=*/
+      AbsolutePath{
+          testDir_->path().string() + "edenfs.rc",
+      });
   serverState_ = {make_shared<ServerState>(
       userInfo,
       privHelper_,
@@ -96,17 +107,7 @@ TestMount::TestMount()
       clock_,
       make_shared<ProcessNameCache>(),
       make_shared<NullStructuredLogger>(),
-      make_shared<EdenConfig>(
-          /*userName=*/folly::StringPiece{"bob"},
-          /*userID=*/uid_t{},
-          /*userHomePath=*/AbsolutePath{testDir_->path().string()},
-          /*userConfigPath=*/
-          AbsolutePath{testDir_->path().string() + ".edenrc"},
-          /*systemConfigDir=*/AbsolutePath{testDir_->path().string()},
-          /*systemConfigPath=*/
-          AbsolutePath{
-              testDir_->path().string() + "edenfs.rc",
-          }),
+      edenConfig_,
       nullptr,
       /*enableFaultInjection=*/true)};
 }
@@ -235,6 +236,21 @@ void TestMount::createMountWithoutInitializing(
   createMountWithoutInitializing(nextCommitHash(), rootBuilder, startReady);
 }
 
+void TestMount::useEphemeralOverlay() {
+  XCHECK(config_) << "useEphemeralOverlay() must be called before the mount "
+                     "is initialized";
+  auto configPath = config_->getClientDirectory() + "config.toml"_pc;
+  writeFile(
+      configPath,
+      folly::StringPiece{"[repository]\n"
+                         "path = \"/test\"\n"
+                         "type = \"test\"\n"
+                         "ephemeral-overlay = true\n"})
+      .value();
+  config_ = CheckoutConfig::loadFromClientDirectory(
+      config_->getMountPath(), config_->getClientDirectory());
+}
+
 void TestMount::initTestDirectory() {
   // Create the temporary directory
   testDir_ = makeTempDir();
@@ -33,6 +33,7 @@ namespace facebook {
 namespace eden {
 class BlobCache;
 class CheckoutConfig;
+class EdenConfig;
 class FakeBackingStore;
 class FakeFuse;
 class FakePrivHelper;
@@ -152,6 +153,14 @@ class TestMount {
       FakeTreeBuilder& rootBuilder,
       bool startReady = true);
 
+  /**
+   * Give the mount an ephemeral overlay, as if its config.toml set
+   * ephemeral-overlay.
+   *
+   * This must be called before the mount is initialized.
+   */
+  void useEphemeralOverlay();
+
   /**
    * Perform FUSE initialization on the EdenMount.
    *
@@ -300,6 +309,16 @@ class TestMount {
     return serverState_;
   }
 
+  /**
+   * Get the EdenConfig used by this mount's ServerState.
+   *
+   * Tests may use this to override settings with ConfigSource::CommandLine
+   * before exercising the code that reads them.
+   */
+  const std::shared_ptr<EdenConfig>& getEdenConfig() const {
+    return edenConfig_;
+  }
+
   /**
    * Get a hash to use for the next commit.
    *
@@ -393,6 +412,7 @@ class TestMount {
   // that still reference the EdenMount (or its owned objects).
   std::shared_ptr<folly::ManualExecutor> serverExecutor_;
 
+  std::shared_ptr<EdenConfig> edenConfig_;
   std::shared_ptr<ServerState> serverState_;
 };
 } // namespace eden
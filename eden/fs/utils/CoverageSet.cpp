@@ -99,5 +99,22 @@ size_t CoverageSet::getIntervalCount() const noexcept {
   return set_.size();
 }
 
+size_t CoverageSet::getCoveredSize() const noexcept {
+  size_t total = 0;
+  for (const auto& interval : set_) {
+    total += interval.end - interval.begin;
+  }
+  return total;
+}
+
+std::vector<std::pair<size_t, size_t>> CoverageSet::getIntervals() const {
+  std::vector<std::pair<size_t, size_t>> result;
+  result.reserve(set_.size());
+  for (const auto& interval : set_) {
+    result.emplace_back(interval.begin, interval.end);
+  }
+  return result;
+}
+
 } // namespace eden
 } // namespace facebook
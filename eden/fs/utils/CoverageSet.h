@@ -9,6 +9,8 @@
 
 #include <cstddef>
 #include <set>
+#include <utility>
+#include <vector>
 
 namespace facebook {
 namespace eden {
@@ -46,6 +48,16 @@ class CoverageSet {
    */
   size_t getIntervalCount() const noexcept;
 
+  /**
+   * Returns the total number of units covered by the set.
+   */
+  size_t getCoveredSize() const noexcept;
+
+  /**
+   * Returns the covered intervals as [begin, end) pairs, in ascending order.
+   */
+  std::vector<std::pair<size_t, size_t>> getIntervals() const;
+
  private:
   struct Interval {
     size_t begin;
@@ -111,6 +111,15 @@ template <
     typename = typename detail::RecordTypeRequirements<T>::type>
 class MappedDiskVector {
  public:
+  /**
+   * Creates an empty MappedDiskVector in the given file, which must be empty.
+   * Unlike open(), the file is not locked: this is meant for files that
+   * aren't shared, like an unlinked or in-memory file.
+   */
+  static MappedDiskVector createInFile(folly::File file) {
+    return initializeFromScratch(std::move(file));
+  }
+
   /**
    * Opens or creates the MappedDiskVector at the specified path.  The path is
    * only used to open the file - a single file descriptor is used from then on
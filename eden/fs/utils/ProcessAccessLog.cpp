@@ -11,6 +11,8 @@
 #include <folly/MapUtil.h>
 #include <folly/MicroLock.h>
 #include <folly/ThreadLocal.h>
+#include <folly/synchronization/AsymmetricMemoryBarrier.h>
+#include <thread>
 
 #include "eden/fs/utils/ProcessNameCache.h"
 
@@ -22,50 +24,67 @@ struct ThreadLocalBucket {
       : state_{folly::in_place, processAccessLog} {}
 
   ~ThreadLocalBucket() {
-    // This thread is going away, so merge our data into the parent.
-    mergeUpstream();
+    // This thread is going away, so merge our data into the parent. No write
+    // can race with this, since they only happen on this thread.
+    state_.lock()->mergeUpstream();
   }
 
   /**
    * Returns whether the pid was newly-recorded in this thread-second or not.
    */
-  bool add(
-      uint64_t secondsSinceStart,
-      pid_t pid,
-      ProcessAccessLog::AccessType type) {
-    auto state = state_.lock();
-
+  template <typename Sample>
+  bool add(uint64_t secondsSinceStart, pid_t pid, Sample sample) {
     // isNewPid must be initialized because BucketedLog::add will not call
     // Bucket::add if secondsSinceStart is too old and the sample is dropped.
     // (In that case, it's unnecessary to record the process name.)
     bool isNewPid = false;
-    state->buckets.add(secondsSinceStart, pid, isNewPid, type);
+
+    // Fast path: only this thread ever modifies the buckets, so unless a
+    // reader is merging them upstream right now, there is no need to lock.
+    // The light barrier pairs with the heavy barrier of readers, which makes
+    // this a plain store and load on the writer's side.
+    writing_.store(true, std::memory_order_relaxed);
+    folly::asymmetricLightBarrier();
+    if (readers_.load(std::memory_order_acquire) == 0) {
+      state_.unsafeGetUnlocked().buckets.add(
+          secondsSinceStart, pid, isNewPid, sample);
+      writing_.store(false, std::memory_order_release);
+      return isNewPid;
+    }
+    writing_.store(false, std::memory_order_release);
+
+    // A reader is merging the buckets, so wait for it to finish.
+    state_.lock()->buckets.add(secondsSinceStart, pid, isNewPid, sample);
     return isNewPid;
   }
 
-  bool add(
-      uint64_t secondsSinceStart,
-      pid_t pid,
-      std::chrono::nanoseconds duration) {
-    auto state = state_.lock();
+  /**
+   * Announces a reader. Once folly::asymmetricHeavyBarrier() has been called
+   * afterwards, writes of this thread all go through the lock until the
+   * matching endRead(). Calling the barrier separately lets readers stop many
+   * threads with a single barrier.
+   */
+  void beginRead() {
+    readers_.fetch_add(1, std::memory_order_relaxed);
+  }
 
-    bool isNewPid = false;
-    state->buckets.add(secondsSinceStart, pid, isNewPid, duration);
-    return isNewPid;
+  void endRead() {
+    readers_.fetch_sub(1, std::memory_order_release);
   }
 
+  /**
+   * Must be called between beginRead() and endRead(), after the barrier.
+   */
   void mergeUpstream() {
-    auto state = state_.lock();
-    if (!state->owner) {
-      return;
-    }
-    state->owner->state_.withWLock(
-        [&](auto& ownerState) { ownerState.buckets.merge(state->buckets); });
-    state->buckets.clear();
+    auto state = lockAndWaitForWriter();
+    state->mergeUpstream();
   }
 
+  /**
+   * Must be called between beginRead() and endRead(), after the barrier.
+   */
   void clearOwnerIfMe(ProcessAccessLog* owner) {
-    auto state = state_.lock();
+    auto state = lockAndWaitForWriter();
     if (state->owner == owner) {
       state->owner = nullptr;
     }
@@ -77,15 +96,25 @@ struct ThreadLocalBucket {
    * needs a mechanism to stop writers for the duration of the read.
    *
    * Reading the data (merging up-stream from all of the threads) is
-   * exceptionally rare, so this lock should largely stay uncontended. I
-   * considered using folly::SpinLock, but the documentation strongly suggests
-   * not. I am hoping that acquiring an uncontended MicroLock
-   * boils down to a single CAS, even though lock xchg can be painful by itself.
+   * exceptionally rare, so writers don't take this lock unless a reader is
+   * active: they only announce their writes in writing_, and readers count
+   * themselves in readers_ before waiting for the current write to finish.
+   * The lock serializes readers, and writers that found readers_ non-zero.
    *
    * This lock must always be acquired before the owner's buckets lock.
    */
   struct State {
     explicit State(ProcessAccessLog* pal) : owner{pal} {}
+
+    void mergeUpstream() {
+      if (!owner) {
+        return;
+      }
+      owner->state_.withWLock(
+          [&](auto& ownerState) { ownerState.buckets.merge(buckets); });
+      buckets.clear();
+    }
+
     ProcessAccessLog::Buckets buckets;
     ProcessAccessLog* owner;
   };
@@ -96,6 +125,19 @@ struct ThreadLocalBucket {
     }
   };
   folly::Synchronized<State, InitedMicroLock> state_;
+
+  auto lockAndWaitForWriter() {
+    auto state = state_.lock();
+    // A write that started on the fast path before the reader was announced
+    // may still be in progress.
+    while (writing_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    return state;
+  }
+
+  std::atomic<bool> writing_{false};
+  std::atomic<size_t> readers_{0};
 };
 
 namespace {
@@ -143,8 +185,14 @@ ProcessAccessLog::ProcessAccessLog(
 }
 
 ProcessAccessLog::~ProcessAccessLog() {
-  for (auto& tlb : threadLocalBucketPtr.accessAllThreads()) {
+  auto accessor = threadLocalBucketPtr.accessAllThreads();
+  for (auto& tlb : accessor) {
+    tlb.beginRead();
+  }
+  folly::asymmetricHeavyBarrier();
+  for (auto& tlb : accessor) {
     tlb.clearOwnerIfMe(this);
+    tlb.endRead();
   }
 }
 
@@ -203,9 +251,19 @@ std::unordered_map<pid_t, AccessCounts> ProcessAccessLog::getAccessCounts(
     std::chrono::seconds lastNSeconds) {
   auto secondCount = lastNSeconds.count();
   // First, merge all the thread-local buckets into their owners, including us.
-  for (auto& tlb : threadLocalBucketPtr.accessAllThreads()) {
-    // This must be done outside of acquiring our own state_ lock.
-    tlb.mergeUpstream();
+  // This must be done outside of acquiring our own state_ lock.
+  {
+    auto accessor = threadLocalBucketPtr.accessAllThreads();
+    for (auto& tlb : accessor) {
+      tlb.beginRead();
+    }
+    // Divert the writes of all the threads at once, since the heavy barrier
+    // is expensive.
+    folly::asymmetricHeavyBarrier();
+    for (auto& tlb : accessor) {
+      tlb.mergeUpstream();
+      tlb.endRead();
+    }
   }
 
   auto state = state_.wlock();
@@ -11,18 +11,36 @@
 #include <folly/executors/ManualExecutor.h>
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include "eden/fs/utils/WorkStealingExecutor.h"
 
 namespace facebook {
 namespace eden {
 
+namespace {
+std::shared_ptr<folly::Executor> makeThreadPool(
+    size_t threadCount,
+    folly::StringPiece threadNamePrefix,
+    UnboundedQueueExecutor::QueueType queueType) {
+  switch (queueType) {
+    case UnboundedQueueExecutor::QueueType::Shared:
+      break;
+    case UnboundedQueueExecutor::QueueType::WorkStealing:
+      return std::make_shared<WorkStealingExecutor>(
+          threadCount, threadNamePrefix);
+  }
+  return std::make_shared<folly::CPUThreadPoolExecutor>(
+      threadCount,
+      std::make_unique<folly::UnboundedBlockingQueue<
+          folly::CPUThreadPoolExecutor::CPUTask>>(),
+      std::make_unique<folly::NamedThreadFactory>(threadNamePrefix));
+}
+} // namespace
+
 UnboundedQueueExecutor::UnboundedQueueExecutor(
     size_t threadCount,
-    folly::StringPiece threadNamePrefix)
-    : executor_{std::make_unique<folly::CPUThreadPoolExecutor>(
-          threadCount,
-          std::make_unique<folly::UnboundedBlockingQueue<
-              folly::CPUThreadPoolExecutor::CPUTask>>(),
-          std::make_unique<folly::NamedThreadFactory>(threadNamePrefix))} {}
+    folly::StringPiece threadNamePrefix,
+    QueueType queueType)
+    : executor_{makeThreadPool(threadCount, threadNamePrefix, queueType)} {}
 
 UnboundedQueueExecutor::UnboundedQueueExecutor(
     std::shared_ptr<folly::ManualExecutor> executor)
@@ -26,13 +26,27 @@ namespace eden {
  */
 class UnboundedQueueExecutor : public folly::Executor {
  public:
+  enum class QueueType {
+    /**
+     * A single queue shared by all the threads.
+     */
+    Shared,
+    /**
+     * A queue per thread, with idle threads stealing from the others. See
+     * WorkStealingExecutor.
+     */
+    WorkStealing,
+  };
+
   /**
    * Instantiates with a folly::CPUThreadPoolExecutor with the given threadCount
-   * and threadNamePrefix but with an unlimited queue.
+   * and threadNamePrefix but with an unlimited queue, or with a
+   * WorkStealingExecutor if queueType is WorkStealing.
    */
   explicit UnboundedQueueExecutor(
       size_t threadCount,
-      folly::StringPiece threadNamePrefix);
+      folly::StringPiece threadNamePrefix,
+      QueueType queueType = QueueType::Shared);
 
   /**
    * ManualExecutors are unbounded too.
@@ -6,22 +6,110 @@
  */
 
 #include "eden/fs/utils/Utf8.h"
-#include <folly/Unicode.h>
+#include <folly/lang/Bits.h>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace facebook {
 namespace eden {
 
-std::string ensureValidUtf8(folly::ByteRange str) {
-  std::string output;
-  output.reserve(str.size());
+namespace {
+/**
+ * Returns the number of ASCII characters at the start of [begin, end).
+ */
+size_t asciiPrefixLength(
+    const unsigned char* const begin,
+    const unsigned char* const end) {
+  const unsigned char* p = begin;
+
+#if defined(__AVX2__)
+  while (end - p >= 32) {
+    auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    // Each bit of the mask is the most significant bit of one byte, which is
+    // only set in non-ASCII bytes.
+    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(block));
+    if (mask != 0) {
+      return (p - begin) + folly::findFirstSet(mask) - 1;
+    }
+    p += 32;
+  }
+#endif
+
+#if defined(__SSE2__)
+  while (end - p >= 16) {
+    auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(block));
+    if (mask != 0) {
+      return (p - begin) + folly::findFirstSet(mask) - 1;
+    }
+    p += 16;
+  }
+#endif
+
+  // Portable fallback, and the tail of the SIMD loops: check 8 bytes at a
+  // time, and find the exact position byte by byte.
+  constexpr uint64_t kHighBits = 0x8080808080808080ull;
+  while (end - p >= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    if (word & kHighBits) {
+      break;
+    }
+    p += 8;
+  }
+  while (p != end && *p < 0x80) {
+    ++p;
+  }
+  return p - begin;
+}
+} // namespace
+
+namespace detail {
+size_t validUtf8PrefixLength(folly::ByteRange str) {
+  const unsigned char* const begin = str.begin();
+  const unsigned char* const end = str.end();
+  const unsigned char* p = begin;
+  while (p != end) {
+    p += asciiPrefixLength(p, end);
+    if (p == end) {
+      break;
+    }
+    auto length = validUtf8SequenceLength(
+        reinterpret_cast<const char*>(p), reinterpret_cast<const char*>(end));
+    if (length == 0) {
+      break;
+    }
+    p += length;
+  }
+  return p - begin;
+}
+} // namespace detail
 
+std::string ensureValidUtf8(folly::ByteRange str) {
   const unsigned char* begin = str.begin();
   const unsigned char* const end = str.end();
+
+  auto validLength = detail::validUtf8PrefixLength(str);
+  std::string output{reinterpret_cast<const char*>(begin), validLength};
+  if (validLength == str.size()) {
+    return output;
+  }
+
+  output.reserve(str.size());
+  begin += validLength;
   while (begin != end) {
-    // codePointToUtf8 returns a std::string which is inefficient for something
-    // that always fits in 32 bits, but with SSO it probably never allocates at
-    // least.
-    output += folly::codePointToUtf8(folly::utf8ToCodePoint(begin, end, true));
+    // begin is at an invalid sequence: replace its first byte and look for a
+    // valid sequence at the next one. folly::utf8ToCodePoint isn't used here
+    // since it decodes surrogates, which validUtf8SequenceLength rejects.
+    output += "\xEF\xBF\xBD"; // U+FFFD
+    ++begin;
+
+    validLength = detail::validUtf8PrefixLength(folly::ByteRange{begin, end});
+    output.append(reinterpret_cast<const char*>(begin), validLength);
+    begin += validLength;
   }
   return output;
 }
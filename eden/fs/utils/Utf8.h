@@ -44,7 +44,7 @@ constexpr bool isValidContinuation(
     const char* const end,
     size_t num,
     uint32_t& codepoint) {
-  if (begin + num - 1 > end) {
+  if (static_cast<size_t>(end - begin) < num) {
     return false;
   }
 
@@ -58,62 +58,103 @@ constexpr bool isValidContinuation(
 
   return true;
 }
+
+/**
+ * Returns the length of the correctly-encoded UTF-8 sequence at begin, or 0 if
+ * the bytes at begin aren't one. Sequences encoding surrogates or codepoints
+ * past U+10FFFF aren't correctly encoded.
+ */
+constexpr size_t validUtf8SequenceLength(
+    const char* begin,
+    const char* const end) {
+  const char* const start = begin;
+  char first = *begin++;
+  if (!isBitSet(first, 7)) {
+    // ASCII character, nothing to do.
+  } else if (!isBitSet(first, 6)) {
+    // 10xxxxxx isn't a valid for the first byte.
+    return 0;
+  } else if (!isBitSet(first, 5)) {
+    // 110xxxxx: 2 bytes
+    uint32_t codepoint = folly::to_unsigned(first) & 0x1F;
+    if (!isValidContinuation(begin, end, 1, codepoint)) {
+      return 0;
+    }
+
+    // Is this an overlong encoding?
+    if (codepoint < 0x80) {
+      return 0;
+    }
+  } else if (!isBitSet(first, 4)) {
+    // 1110xxxx: 3 bytes
+    uint32_t codepoint = folly::to_unsigned(first) & 0xF;
+    if (!isValidContinuation(begin, end, 2, codepoint)) {
+      return 0;
+    }
+
+    // Is this an overlong encoding (E0 followed by less than A0)?
+    if (codepoint < 0x800) {
+      return 0;
+    }
+
+    // Surrogates (ED followed by A0 or more) are reserved for UTF-16 and
+    // can't be encoded in UTF-8.
+    if (codepoint >= 0xD800 && codepoint <= 0xDFFF) {
+      return 0;
+    }
+  } else if (!isBitSet(first, 3)) {
+    // 11110xxx: 4 bytes
+    uint32_t codepoint = folly::to_unsigned(first) & 0x7;
+    if (!isValidContinuation(begin, end, 3, codepoint)) {
+      return 0;
+    }
+
+    // Is this an overlong encoding (F0 followed by less than 90)?
+    if (codepoint < 0x10000) {
+      return 0;
+    }
+
+    // Is this past the last unicode codepoint (F4 followed by 90 or more, or
+    // F5 to F7)?
+    if (codepoint > 0x10FFFF) {
+      return 0;
+    }
+  } else {
+    // 11111xxx isn't ever valid.
+    return 0;
+  }
+
+  return begin - start;
+}
+
+/**
+ * Returns the length of the longest prefix of str that is correctly-encoded
+ * UTF-8.
+ *
+ * Runs of ASCII characters are skipped many bytes at a time with SIMD
+ * instructions where available, which makes this much faster than
+ * isValidUtf8() on the mostly-ASCII paths EdenFS deals with, but it can't be
+ * used in constant expressions.
+ */
+size_t validUtf8PrefixLength(folly::ByteRange str);
 } // namespace detail
 
 /**
  * Returns whether the given string is correctly-encoded UTF-8.
  *
- * This doesn't verify whether the codepoints are actually valid unicode
- * characters.
+ * This rejects surrogates and codepoints past U+10FFFF, but doesn't verify
+ * whether the other codepoints are actually assigned unicode characters.
  */
 constexpr bool isValidUtf8(folly::StringPiece str) {
   const char* begin = str.begin();
   const char* const end = str.end();
 
   while (begin != end) {
-    char first = *begin++;
-    if (!detail::isBitSet(first, 7)) {
-      // ASCII character, nothing to do.
-    } else if (!detail::isBitSet(first, 6)) {
-      // 10xxxxxx isn't a valid for the first byte.
-      return false;
-    } else if (!detail::isBitSet(first, 5)) {
-      // 110xxxxx: 2 bytes
-      uint32_t codepoint = folly::to_unsigned(first) & 0x1F;
-      if (!detail::isValidContinuation(begin, end, 1, codepoint)) {
-        return false;
-      }
-
-      // Is this an overlong encoding?
-      if (codepoint < 0x80) {
-        return false;
-      }
-    } else if (!detail::isBitSet(first, 4)) {
-      // 1110xxxx: 3 bytes
-      uint32_t codepoint = folly::to_unsigned(first) & 0xF;
-      if (!detail::isValidContinuation(begin, end, 2, codepoint)) {
-        return false;
-      }
-
-      // Is this an overlong encoding?
-      if (codepoint < 0x800) {
-        return false;
-      }
-    } else if (!detail::isBitSet(first, 3)) {
-      // 11110xxx: 4 bytes
-      uint32_t codepoint = folly::to_unsigned(first) & 0x7;
-      if (!detail::isValidContinuation(begin, end, 3, codepoint)) {
-        return false;
-      }
-
-      // Is this an overlong encoding?
-      if (codepoint < 0x10000) {
-        return false;
-      }
-    } else {
-      // 11111xxx isn't ever valid.
+    auto length = detail::validUtf8SequenceLength(begin, end);
+    if (length == 0) {
       return false;
     }
+    begin += length;
   }
 
   return true;
@@ -139,10 +180,11 @@ inline std::string ensureValidUtf8(folly::StringPiece str) {
 inline std::string ensureValidUtf8(std::string&& str) {
   // Avoid a copy in the common case by checking for validity before attempting
   // to re-encode.
-  if (isValidUtf8(str)) {
+  auto bytes = folly::ByteRange{folly::StringPiece{str}};
+  if (detail::validUtf8PrefixLength(bytes) == str.size()) {
     return std::move(str);
   } else {
-    return ensureValidUtf8(str);
+    return ensureValidUtf8(bytes);
   }
 }
 
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <folly/ExceptionString.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/logging/xlog.h>
+
+namespace facebook {
+namespace eden {
+
+namespace {
+/**
+ * The executor the current thread is a worker of, if any, and the index of
+ * that worker.
+ */
+thread_local const WorkStealingExecutor* currentExecutor = nullptr;
+thread_local size_t currentWorker = 0;
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(
+    size_t threadCount,
+    folly::StringPiece threadNamePrefix) {
+  threadCount = std::max<size_t>(threadCount, 1);
+  workers_.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+
+  folly::NamedThreadFactory threadFactory{threadNamePrefix};
+  threads_.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads_.push_back(threadFactory.newThread([this, i] { workerLoop(i); }));
+  }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  {
+    std::lock_guard<std::mutex> lock{sleepMutex_};
+    stopping_ = true;
+  }
+  sleepCondition_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingExecutor::add(folly::Func func) {
+  if (currentExecutor == this) {
+    auto& worker = *workers_[currentWorker];
+    std::lock_guard<std::mutex> lock{worker.mutex};
+    if (worker.slot) {
+      worker.queue.push_back(std::move(worker.slot));
+    }
+    worker.slot = std::move(func);
+  } else {
+    auto& worker = *workers_
+        [nextWorker_.fetch_add(1, std::memory_order_relaxed) %
+         workers_.size()];
+    std::lock_guard<std::mutex> lock{worker.mutex};
+    worker.queue.push_back(std::move(func));
+  }
+
+  // Count the function once it can be taken, so that a worker woken up for
+  // it finds it rather than spinning until it is queued.
+  pending_.fetch_add(1);
+
+  // Workers increment sleepers_ before checking pending_ and going to sleep,
+  // so either they see the function, or we see them and wake one up.
+  if (sleepers_.load() > 0) {
+    std::lock_guard<std::mutex> lock{sleepMutex_};
+    sleepCondition_.notify_one();
+  }
+}
+
+folly::Func WorkStealingExecutor::takeFunction(size_t index) {
+  folly::Func func;
+  {
+    auto& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock{worker.mutex};
+    if (worker.slot &&
+        (worker.slotRuns < kMaxSlotRuns || worker.queue.empty())) {
+      func = std::move(worker.slot);
+      worker.slot = nullptr;
+      ++worker.slotRuns;
+    } else if (!worker.queue.empty()) {
+      func = std::move(worker.queue.front());
+      worker.queue.pop_front();
+      worker.slotRuns = 0;
+    }
+  }
+
+  for (size_t i = 1; !func && i < workers_.size(); ++i) {
+    auto& victim = *workers_[(index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock{victim.mutex};
+    if (!victim.queue.empty()) {
+      func = std::move(victim.queue.front());
+      victim.queue.pop_front();
+    } else if (victim.slot) {
+      func = std::move(victim.slot);
+      victim.slot = nullptr;
+    }
+  }
+
+  if (func) {
+    pending_.fetch_sub(1);
+  }
+  return func;
+}
+
+bool WorkStealingExecutor::waitForFunction() {
+  std::unique_lock<std::mutex> lock{sleepMutex_};
+  sleepers_.fetch_add(1);
+  sleepCondition_.wait(
+      lock, [this] { return pending_.load() > 0 || stopping_; });
+  sleepers_.fetch_sub(1);
+  return pending_.load() > 0 || !stopping_;
+}
+
+void WorkStealingExecutor::workerLoop(size_t index) {
+  currentExecutor = this;
+  currentWorker = index;
+
+  while (true) {
+    auto func = takeFunction(index);
+    if (!func) {
+      if (!waitForFunction()) {
+        break;
+      }
+      continue;
+    }
+
+    try {
+      func();
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "WorkStealingExecutor: func threw unhandled exception: "
+                << folly::exceptionStr(ex);
+    } catch (...) {
+      XLOG(ERR) << "WorkStealingExecutor: func threw unhandled non-exception "
+                   "object";
+    }
+  }
+
+  currentExecutor = nullptr;
+}
+
+} // namespace eden
+} // namespace facebook
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/Range.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace facebook {
+namespace eden {
+
+/**
+ * A thread pool executor with a queue per worker thread, and where idle
+ * workers steal work from the queues of the others.
+ *
+ * This avoids the contention of a single shared queue when many threads
+ * queue and run large numbers of tiny functions, such as future
+ * continuations. Functions added from one of the workers are queued on its
+ * own queue, so that continuations tend to stay on the thread that queued
+ * them, where their data is likely still in cache.
+ *
+ * Each worker has a single slot in front of a FIFO queue. A function added
+ * from a worker goes in its slot, pushing the previous one to the back of the
+ * queue, so that a continuation runs right after the function that queued
+ * it. To keep a chain of continuations from starving older functions, a
+ * worker takes from its queue after kMaxSlotRuns consecutive functions from
+ * its slot. Functions added from other threads are spread across the back of
+ * the workers' queues, and idle workers steal from the front of the queues of
+ * the others, or from their slot when their queue is empty.
+ *
+ * Like UnboundedQueueExecutor, add() never blocks, and queues are unbounded.
+ * Functions still queued when the executor is destroyed are run before the
+ * destructor returns.
+ */
+class WorkStealingExecutor : public folly::Executor {
+ public:
+  WorkStealingExecutor(size_t threadCount, folly::StringPiece threadNamePrefix);
+  ~WorkStealingExecutor() override;
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+  void add(folly::Func func) override;
+
+  size_t getThreadCount() const {
+    return workers_.size();
+  }
+
+ private:
+  /**
+   * The number of functions a worker runs in a row from its slot before it
+   * takes one from its queue instead.
+   */
+  static constexpr size_t kMaxSlotRuns = 3;
+
+  struct Worker {
+    std::mutex mutex;
+    folly::Func slot;
+    std::deque<folly::Func> queue;
+
+    /**
+     * The number of functions run in a row from the slot. Only used by the
+     * thread of this worker.
+     */
+    size_t slotRuns{0};
+  };
+
+  void workerLoop(size_t index);
+
+  /**
+   * Take a function from the queue of the given worker, or steal one from
+   * the other workers. Returns an empty function if all the queues are empty.
+   */
+  folly::Func takeFunction(size_t index);
+
+  /**
+   * Wait until there is a function to run, and return false if the executor
+   * is being destroyed and all the queues are empty.
+   */
+  bool waitForFunction();
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  /**
+   * The number of functions in all the slots and queues. It is incremented
+   * after a function is queued, so it can briefly go negative when another
+   * worker takes the function first.
+   */
+  std::atomic<int64_t> pending_{0};
+
+  /**
+   * Spreads the functions added from outside of the workers.
+   */
+  std::atomic<size_t> nextWorker_{0};
+
+  std::mutex sleepMutex_;
+  std::condition_variable sleepCondition_;
+  std::atomic<size_t> sleepers_{0};
+  bool stopping_{false};
+};
+
+} // namespace eden
+} // namespace facebook
@@ -95,3 +95,17 @@ TEST(CoverageSetTest, merge_can_replace_many_nodes) {
   EXPECT_FALSE(s.covers(7, 9));
   EXPECT_TRUE(s.covers(1, 8));
 }
+
+TEST(CoverageSetTest, reports_intervals_and_covered_size) {
+  CoverageSet s;
+  EXPECT_EQ(0, s.getCoveredSize());
+  EXPECT_TRUE(s.getIntervals().empty());
+
+  s.add(10, 20);
+  s.add(0, 5);
+  s.add(15, 30);
+  EXPECT_EQ(25, s.getCoveredSize());
+
+  std::vector<std::pair<size_t, size_t>> expected{{0, 5}, {10, 30}};
+  EXPECT_EQ(expected, s.getIntervals());
+}
@@ -33,3 +33,20 @@ BENCHMARK_DEFINE_F(ProcessAccessLogFixture, add_self)(benchmark::State& state) {
 }
 
 BENCHMARK_REGISTER_F(ProcessAccessLogFixture, add_self)->Threads(kThreadCount);
+
+/**
+ * What each FUSE request records: an access, and its duration.
+ */
+BENCHMARK_DEFINE_F(ProcessAccessLogFixture, record_request)
+(benchmark::State& state) {
+  auto myPid = getpid();
+  for (auto _ : state) {
+    processAccessLog.recordAccess(
+        myPid, ProcessAccessLog::AccessType::FsChannelRead);
+    processAccessLog.recordDuration(myPid, std::chrono::microseconds{10});
+  }
+}
+
+BENCHMARK_REGISTER_F(ProcessAccessLogFixture, record_request)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
@@ -8,6 +8,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <sys/types.h>
+#include <atomic>
+#include <thread>
 #include <utility>
 
 #include "eden/fs/utils/ProcessAccessLog.h"
@@ -51,3 +53,34 @@ TEST(ProcessAccessLog, accessAddsProcessToProcessNameCache) {
   log.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelOther);
   EXPECT_THAT(processNameCache->getAllProcessNames(), Contains(Key(Eq(pid))));
 }
+
+TEST(ProcessAccessLog, concurrentAccessesAreAllCounted) {
+  auto pid = pid_t{42};
+  auto log = ProcessAccessLog{std::make_shared<ProcessNameCache>()};
+
+  constexpr size_t kThreadCount = 4;
+  constexpr size_t kAccessCount = 100000;
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&] {
+      for (size_t j = 0; j < kAccessCount; ++j) {
+        log.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelRead);
+      }
+    });
+  }
+  // Read while the threads are writing.
+  std::thread reader{[&] {
+    while (!done.load()) {
+      log.getAccessCounts(10s);
+    }
+  }};
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  done.store(true);
+  reader.join();
+
+  auto counts = log.getAccessCounts(10s);
+  EXPECT_EQ(kThreadCount * kAccessCount, *counts[pid].fsChannelReads_ref());
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+#include <benchmark/benchmark.h>
+#include <folly/synchronization/Baton.h>
+#include <thread>
+
+using namespace facebook::eden;
+
+namespace {
+/**
+ * The number of continuations each chain runs, one after the other.
+ */
+constexpr size_t kChainLength = 1000;
+
+/**
+ * Runs one chain of continuations per pool thread, each continuation queuing
+ * the next from the pool thread, like future callbacks do.
+ */
+void runChains(
+    benchmark::State& state,
+    UnboundedQueueExecutor::QueueType queueType) {
+  auto threadCount = static_cast<size_t>(state.range(0));
+  UnboundedQueueExecutor executor{threadCount, "Benchmark", queueType};
+
+  struct Chain {
+    explicit Chain(UnboundedQueueExecutor& e) : executor{e} {}
+
+    UnboundedQueueExecutor& executor;
+    size_t remaining{kChainLength};
+    folly::Baton<> done;
+
+    void step() {
+      if (--remaining == 0) {
+        done.post();
+        return;
+      }
+      executor.add([this] { step(); });
+    }
+  };
+
+  for (auto _ : state) {
+    std::vector<std::unique_ptr<Chain>> chains;
+    for (size_t i = 0; i < threadCount; ++i) {
+      chains.push_back(std::make_unique<Chain>(executor));
+      executor.add([chain = chains.back().get()] { chain->step(); });
+    }
+    for (auto& chain : chains) {
+      chain->done.wait();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * threadCount * kChainLength);
+}
+} // namespace
+
+static void BM_continuations_shared(benchmark::State& state) {
+  runChains(state, UnboundedQueueExecutor::QueueType::Shared);
+}
+BENCHMARK(BM_continuations_shared)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(std::thread::hardware_concurrency())
+    ->UseRealTime();
+
+static void BM_continuations_work_stealing(benchmark::State& state) {
+  runChains(state, UnboundedQueueExecutor::QueueType::WorkStealing);
+}
+BENCHMARK(BM_continuations_work_stealing)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(std::thread::hardware_concurrency())
+    ->UseRealTime();
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/Utf8.h"
+
+#include <benchmark/benchmark.h>
+#include <folly/Format.h>
+
+using namespace facebook::eden;
+
+namespace {
+/**
+ * Paths shaped like the ones of a large status result.
+ */
+std::vector<std::string> makePaths(size_t count) {
+  std::vector<std::string> paths;
+  paths.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    paths.push_back(folly::sformat(
+        "fbcode/eden/fs/dir{}/subdir{}/some_source_file_{}.cpp",
+        i % 100,
+        i % 1000,
+        i));
+  }
+  return paths;
+}
+} // namespace
+
+static void BM_ensureValidUtf8_ascii(benchmark::State& state) {
+  auto paths = makePaths(state.range(0));
+  for (auto _ : state) {
+    for (const auto& path : paths) {
+      benchmark::DoNotOptimize(ensureValidUtf8(folly::StringPiece{path}));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_ensureValidUtf8_ascii)->Arg(1000000);
+
+static void BM_ensureValidUtf8_invalid(benchmark::State& state) {
+  auto paths = makePaths(state.range(0));
+  for (auto& path : paths) {
+    path.back() = '\xff';
+  }
+  for (auto _ : state) {
+    for (const auto& path : paths) {
+      benchmark::DoNotOptimize(ensureValidUtf8(folly::StringPiece{path}));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_ensureValidUtf8_invalid)->Arg(1000000);
+
+static void BM_isValidUtf8(benchmark::State& state) {
+  auto paths = makePaths(state.range(0));
+  for (auto _ : state) {
+    for (const auto& path : paths) {
+      benchmark::DoNotOptimize(isValidUtf8(path));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_isValidUtf8)->Arg(1000000);
+
+static void BM_validUtf8PrefixLength(benchmark::State& state) {
+  auto paths = makePaths(state.range(0));
+  for (auto _ : state) {
+    for (const auto& path : paths) {
+      benchmark::DoNotOptimize(detail::validUtf8PrefixLength(
+          folly::ByteRange{folly::StringPiece{path}}));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_validUtf8PrefixLength)->Arg(1000000);
@@ -6,6 +6,7 @@
  */
 
 #include "eden/fs/utils/Utf8.h"
+#include <folly/String.h>
 #include <gtest/gtest.h>
 
 using namespace facebook::eden;
@@ -21,6 +22,20 @@ constexpr folly::StringPiece kValidStrings[] = {
     u8"\u0939", // 3 bytes
     u8"\U00010348", // 4 bytes
     u8"\U00040000", // 4 bytes
+    u8"\uD7FF", // last codepoint before the surrogates
+    u8"\uE000", // first codepoint after the surrogates
+    u8"\U0010FFFF", // last codepoint
+};
+
+constexpr folly::StringPiece kInvalidSequences[] = {
+    "\xE0\x9F\xBF", // overlong: E0 followed by less than A0
+    "\xED\xA0\x80", // surrogate: ED followed by A0 or more
+    "\xED\xBF\xBF", // surrogate
+    "\xF0\x8F\xBF\xBF", // overlong: F0 followed by less than 90
+    "\xF4\x90\x80\x80", // past U+10FFFF: F4 followed by 90 or more
+    "\xF5\x80\x80\x80", // past U+10FFFF: lead byte F5 or more
+    "\xF7\xBF\xBF\xBF",
+    "\xF8\x88\x80\x80\x80",
 };
 }
 
@@ -33,6 +48,45 @@ TEST(Utf8Test, isValidUtf8) {
   // overlong
   EXPECT_FALSE(isValidUtf8("\xF0\x82\x82\xAC"));
   EXPECT_FALSE(isValidUtf8("\xA0prefix\xB0"));
+  // truncated
+  EXPECT_FALSE(isValidUtf8("\xC3"));
+  EXPECT_FALSE(isValidUtf8("\xE2\x82"));
+
+  for (auto str : kInvalidSequences) {
+    EXPECT_FALSE(isValidUtf8(str)) << folly::hexlify(str);
+  }
+}
+
+TEST(Utf8Test, validUtf8PrefixLength) {
+  for (auto str : kValidStrings) {
+    EXPECT_EQ(str.size(), detail::validUtf8PrefixLength(folly::ByteRange{str}));
+  }
+
+  // Long enough to go through the vectorized loops before finding the invalid
+  // byte.
+  std::string ascii(100, 'a');
+  for (size_t i = 0; i < ascii.size(); ++i) {
+    auto str = ascii;
+    str[i] = '\xff';
+    EXPECT_EQ(
+        i,
+        detail::validUtf8PrefixLength(
+            folly::ByteRange{folly::StringPiece{str}}));
+  }
+  auto mixed = ascii + u8"\u00A2" + ascii + "\xC3";
+  EXPECT_EQ(
+      mixed.size() - 1,
+      detail::validUtf8PrefixLength(
+          folly::ByteRange{folly::StringPiece{mixed}}));
+
+  for (auto str : kInvalidSequences) {
+    auto prefixed = ascii + str.str();
+    EXPECT_EQ(
+        ascii.size(),
+        detail::validUtf8PrefixLength(
+            folly::ByteRange{folly::StringPiece{prefixed}}))
+        << folly::hexlify(str);
+  }
 }
 
 TEST(Utf8String, ensureValidUtf8) {
@@ -47,4 +101,17 @@ TEST(Utf8String, ensureValidUtf8) {
       ensureValidUtf8("foo\xF0\x82\x82\xAC"
                       "bar"));
   EXPECT_EQ(u8"\uFFFDprefix\uFFFD", ensureValidUtf8("\xA0prefix\xB0"));
+  EXPECT_EQ(
+      std::string(40, 'a') + u8"\uFFFD\u00A2" + std::string(40, 'b'),
+      ensureValidUtf8(
+          std::string(40, 'a') + "\xff\xC2\xA2" + std::string(40, 'b')));
+
+  // Every byte of an invalid sequence is replaced.
+  for (auto str : kInvalidSequences) {
+    std::string expected;
+    for (size_t i = 0; i < str.size(); ++i) {
+      expected += u8"\uFFFD";
+    }
+    EXPECT_EQ(expected, ensureValidUtf8(str)) << folly::hexlify(str);
+  }
 }
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <folly/futures/Future.h>
+#include <folly/synchronization/Baton.h>
+#include <gtest/gtest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+TEST(WorkStealingExecutor, runs_functions_added_from_any_thread) {
+  std::atomic<size_t> count{0};
+  std::function<void(size_t)> chain;
+  {
+    WorkStealingExecutor executor{4, "WorkStealing"};
+    chain = [&](size_t remaining) {
+      ++count;
+      if (remaining > 0) {
+        executor.add([&chain, remaining] { chain(remaining - 1); });
+      }
+    };
+    for (size_t i = 0; i < 100; ++i) {
+      executor.add([&chain] { chain(99); });
+    }
+    // Destroying the executor runs all the queued functions.
+  }
+  EXPECT_EQ(100 * 100, count.load());
+}
+
+TEST(WorkStealingExecutor, wakes_up_idle_threads) {
+  WorkStealingExecutor executor{2, "WorkStealing"};
+  for (size_t i = 0; i < 10; ++i) {
+    folly::Baton<> baton;
+    executor.add([&] { baton.post(); });
+    EXPECT_TRUE(baton.try_wait_for(10s));
+  }
+}
+
+TEST(WorkStealingExecutor, idle_threads_steal_from_busy_ones) {
+  WorkStealingExecutor executor{2, "WorkStealing"};
+  folly::Baton<> blocked;
+  folly::Baton<> stolen;
+  executor.add([&] {
+    // Queue a function on this worker's own queue, and only unblock once
+    // the other worker has run it.
+    executor.add([&] { stolen.post(); });
+    EXPECT_TRUE(stolen.try_wait_for(10s));
+    blocked.post();
+  });
+  EXPECT_TRUE(blocked.try_wait_for(10s));
+}
+
+TEST(WorkStealingExecutor, survives_exceptions) {
+  WorkStealingExecutor executor{1, "WorkStealing"};
+  executor.add([] { throw std::runtime_error("test exception"); });
+  auto future = folly::via(&executor, [] { return 42; });
+  EXPECT_EQ(42, std::move(future).get(10s));
+}
+
+TEST(WorkStealingExecutor, continuation_chains_do_not_starve_older_functions) {
+  WorkStealingExecutor executor{1, "WorkStealing"};
+  constexpr size_t kMaxChainLength = 10000;
+  std::atomic<bool> olderRan{false};
+  std::atomic<bool> externalRan{false};
+  std::atomic<size_t> chainLength{0};
+  folly::Baton<> done;
+  std::function<void()> chain = [&] {
+    // Keep the only worker saturated with continuations until both of the
+    // other functions have run.
+    if ((olderRan && externalRan) || ++chainLength == kMaxChainLength) {
+      done.post();
+      return;
+    }
+    executor.add([&] { chain(); });
+  };
+  folly::Baton<> chainStarted;
+  executor.add([&] {
+    executor.add([&] { olderRan = true; });
+    executor.add([&] { chain(); });
+    chainStarted.post();
+  });
+  ASSERT_TRUE(chainStarted.try_wait_for(10s));
+  executor.add([&] { externalRan = true; });
+
+  ASSERT_TRUE(done.try_wait_for(10s));
+  EXPECT_TRUE(olderRan);
+  EXPECT_TRUE(externalRan);
+  EXPECT_LT(chainLength.load(), kMaxChainLength);
+}
@@ -39,6 +39,7 @@ import sys
 import time
 
 from edenscm.mercurial import (
+    ancestor,
     changegroup,
     changelog,
     cmdutil,
@@ -541,6 +542,56 @@ def perfancestorset(ui, repo, revset, **opts):
     fm.end()
 
 
+@command(
+    "perfcommonancestorsheads",
+    formatteropts
+    + [
+        ("", "revisions", 1000000, "number of revisions of the synthetic DAG"),
+        ("", "heads", 2, "number of revisions to find common ancestors of"),
+        ("", "mergeprob", 0.1, "probability that a revision is a merge"),
+        ("", "python", False, "use the pure Python implementation"),
+    ],
+    norepo=True,
+)
+def perfcommonancestorsheads(
+    ui, revisions=1000000, heads=2, mergeprob=0.1, python=False, **opts
+):
+    """benchmark commonancestorsheads on a synthetic DAG
+
+    The DAG is built in memory as a revlog index, with many short branches
+    and random merges, and the heads are picked among its most recent
+    revisions, like the branches of a merge.
+    """
+    from edenscmnative import parsers
+
+    rng = random.Random(0)
+    data = []
+    for rev in xrange(revisions):
+        p1 = rev - 1
+        p2 = -1
+        if rev > 1 and rng.random() < 0.3:
+            # start or continue a branch
+            p1 = rng.randrange(max(0, rev - 1000), rev)
+        if rev > 1 and rng.random() < mergeprob:
+            p2 = rng.randrange(max(0, rev - 10000), rev - 1)
+        node = struct.pack(">Q", rev) + b"\0" * 12
+        data.append(revlog.indexformatng_pack(0, 0, 0, rev, rev, p1, p2, node))
+    index, cache = parsers.parse_index2(b"".join(data), False)
+
+    # Branch the heads off recent revisions.
+    revs = sorted(rng.sample(xrange(max(0, revisions - 100000), revisions), heads))
+
+    if python:
+        parentrevs = lambda rev: index[rev][5:7]
+        d = lambda: ancestor.commonancestorsheads(parentrevs, *revs)
+    else:
+        d = lambda: index.commonancestorsheads(*revs)
+
+    timer, fm = gettimer(ui, opts)
+    timer(d)
+    fm.end()
+
+
 @command("perfbookmarks", formatteropts)
 def perfbookmarks(ui, repo, **opts):
     """benchmark parsing bookmarks from disk to memory"""
@@ -1056,6 +1107,46 @@ def perfdiffwd(ui, repo, **opts):
     fm.end()
 
 
+@command(
+    "perfmpatch",
+    formatteropts
+    + [
+        ("", "deltas", 1000, "number of deltas of the synthetic chain"),
+        ("", "lines", 10000, "number of lines of the base text"),
+        ("", "edits", 10, "number of lines each delta edits"),
+    ],
+    norepo=True,
+)
+def perfmpatch(ui, deltas=1000, lines=10000, edits=10, **opts):
+    """benchmark applying a synthetic chain of deltas
+
+    Each delta changes, inserts or removes random lines of the text made by
+    the previous ones, like the deltas of a file revlog, and the whole chain
+    is applied to the base text at once.
+    """
+    rng = random.Random(0)
+    base = "".join("line %d\n" % i for i in xrange(lines))
+    old = base.splitlines(True)
+    bins = []
+    for i in xrange(deltas):
+        new = list(old)
+        for j in xrange(edits):
+            pos = rng.randrange(len(new) + 1)
+            op = rng.random()
+            if pos < len(new) and op < 0.5:
+                new[pos] = "changed %d %d\n" % (i, j)
+            elif pos < len(new) and op < 0.75:
+                del new[pos]
+            else:
+                new.insert(pos, "added %d %d\n" % (i, j))
+        bins.append(mdiff.textdiff("".join(old), "".join(new)))
+        old = new
+
+    timer, fm = gettimer(ui, opts)
+    timer(lambda: mdiff.patches(base, bins))
+    fm.end()
+
+
 @command(
     "perfrevset",
     [
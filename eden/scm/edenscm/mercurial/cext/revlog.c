@@ -1307,6 +1307,7 @@ find_gca_candidates(indexObject* self, const int* revs, int revcount) {
           Py_DECREF(obj);
           goto bail;
         }
+        Py_DECREF(obj);
         sv |= poison;
         for (i = 0; i < revcount; i++) {
           if (revs[i] == v)
@@ -1345,6 +1346,251 @@ bail:
   return NULL;
 }
 
+/*
+ * A table of interned bitsets of a fixed size, for find_gca_candidates_many.
+ * Equal sets always get the same index, so sets can be compared by index.
+ */
+typedef struct {
+  int words; /* number of bitmasks in each set */
+  bitmask* sets; /* count * words bitmasks */
+  int count;
+  int capacity;
+  int* buckets; /* open addressing hash table of set index + 1 */
+  int nbuckets; /* a power of two */
+  bitmask* scratch; /* words bitmasks */
+} bitsettable;
+
+static void bitsettable_free(bitsettable* t) {
+  free(t->sets);
+  free(t->buckets);
+  free(t->scratch);
+}
+
+static int bitsettable_init(bitsettable* t, int words) {
+  t->words = words;
+  t->count = 0;
+  t->capacity = 16;
+  t->nbuckets = 64;
+  t->sets = malloc(sizeof(*t->sets) * t->capacity * words);
+  t->buckets = calloc(sizeof(*t->buckets), t->nbuckets);
+  t->scratch = malloc(sizeof(*t->scratch) * words);
+  if (t->sets == NULL || t->buckets == NULL || t->scratch == NULL) {
+    bitsettable_free(t);
+    return -1;
+  }
+  return 0;
+}
+
+static inline const bitmask* bitsettable_get(const bitsettable* t, int id) {
+  return t->sets + (size_t)id * t->words;
+}
+
+static inline int bitset_test(const bitmask* set, int bit) {
+  return (set[bit / 64] >> (bit % 64)) & 1;
+}
+
+static uint64_t bitset_hash(const bitmask* set, int words) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  int i;
+  for (i = 0; i < words; i++) {
+    h ^= set[i];
+    h *= 0x100000001b3ull;
+    h ^= h >> 29;
+  }
+  return h;
+}
+
+static int bitsettable_rehash(bitsettable* t) {
+  int nbuckets = t->nbuckets * 2;
+  int* buckets = calloc(sizeof(*buckets), nbuckets);
+  int id;
+  if (buckets == NULL)
+    return -1;
+  for (id = 0; id < t->count; id++) {
+    uint64_t b = bitset_hash(bitsettable_get(t, id), t->words);
+    while (buckets[b & (nbuckets - 1)])
+      b++;
+    buckets[b & (nbuckets - 1)] = id + 1;
+  }
+  free(t->buckets);
+  t->buckets = buckets;
+  t->nbuckets = nbuckets;
+  return 0;
+}
+
+/*
+ * Return the index of the set equal to the scratch set, adding it to the
+ * table if needed, or -1 if out of memory.
+ */
+static int bitsettable_intern_scratch(bitsettable* t) {
+  const size_t setsize = sizeof(*t->sets) * t->words;
+  uint64_t b = bitset_hash(t->scratch, t->words);
+  int id;
+
+  for (;; b++) {
+    int entry = t->buckets[b & (t->nbuckets - 1)];
+    if (entry == 0)
+      break;
+    if (memcmp(bitsettable_get(t, entry - 1), t->scratch, setsize) == 0)
+      return entry - 1;
+  }
+
+  if (t->count == t->capacity) {
+    bitmask* sets = realloc(t->sets, setsize * t->capacity * 2);
+    if (sets == NULL)
+      return -1;
+    t->sets = sets;
+    t->capacity *= 2;
+  }
+  id = t->count++;
+  memcpy(t->sets + (size_t)id * t->words, t->scratch, setsize);
+  t->buckets[b & (t->nbuckets - 1)] = id + 1;
+
+  /* keep the load factor under one half */
+  if (t->count * 2 > t->nbuckets && bitsettable_rehash(t) == -1)
+    return -1;
+  return id;
+}
+
+/* Return the index of the union of two sets, or -1 if out of memory. */
+static int bitsettable_union(bitsettable* t, int a, int b) {
+  const bitmask* sa = bitsettable_get(t, a);
+  const bitmask* sb = bitsettable_get(t, b);
+  int i;
+  for (i = 0; i < t->words; i++)
+    t->scratch[i] = sa[i] | sb[i];
+  return bitsettable_intern_scratch(t);
+}
+
+/* Return the index of a set with one more bit set, or -1 if out of memory. */
+static int bitsettable_with_bit(bitsettable* t, int a, int bit) {
+  memcpy(t->scratch, bitsettable_get(t, a), sizeof(*t->scratch) * t->words);
+  t->scratch[bit / 64] |= 1ull << (bit % 64);
+  return bitsettable_intern_scratch(t);
+}
+
+/*
+ * Like find_gca_candidates, for any number of revs.
+ *
+ * A bitmask per rev can't hold a bit per input rev anymore, but the set of
+ * inputs reaching a rev is shared by most of its ancestors, so there are few
+ * distinct sets: they are interned in a bitsettable, and each rev only
+ * stores the index of its set plus one, or 0 if it wasn't reached.
+ */
+static PyObject*
+find_gca_candidates_many(indexObject* self, const int* revs, int revcount) {
+  const int poison = revcount;
+  PyObject* gca = PyList_New(0);
+  int i, v, interesting, allseen;
+  int maxrev = -1;
+  int* seen = NULL;
+  bitsettable sets;
+
+  if (gca == NULL)
+    return PyErr_NoMemory();
+
+  if (bitsettable_init(&sets, (revcount + 1 + 63) / 64) == -1) {
+    Py_DECREF(gca);
+    return PyErr_NoMemory();
+  }
+
+  for (i = 0; i < revcount; i++) {
+    if (revs[i] > maxrev)
+      maxrev = revs[i];
+  }
+
+  seen = calloc(sizeof(*seen), maxrev + 1);
+  if (seen == NULL)
+    goto nomem;
+
+  memset(sets.scratch, 0, sizeof(*sets.scratch) * sets.words);
+  for (i = 0; i < revcount; i++) {
+    int id;
+    sets.scratch[i / 64] |= 1ull << (i % 64);
+    id = bitsettable_intern_scratch(&sets);
+    sets.scratch[i / 64] &= ~(1ull << (i % 64));
+    if (id == -1)
+      goto nomem;
+    seen[revs[i]] = id + 1;
+  }
+  for (i = 0; i < revcount; i++)
+    sets.scratch[i / 64] |= 1ull << (i % 64);
+  allseen = bitsettable_intern_scratch(&sets);
+  if (allseen == -1)
+    goto nomem;
+
+  interesting = revcount;
+
+  for (v = maxrev; v >= 0 && interesting; v--) {
+    int sv = seen[v] - 1;
+    int poisoned;
+    int parents[2];
+
+    if (sv < 0)
+      continue;
+
+    poisoned = bitset_test(bitsettable_get(&sets, sv), poison);
+    if (!poisoned) {
+      interesting -= 1;
+      if (sv == allseen) {
+        PyObject* obj = PyInt_FromLong(v);
+        if (obj == NULL)
+          goto bail;
+        if (PyList_Append(gca, obj) == -1) {
+          Py_DECREF(obj);
+          goto bail;
+        }
+        Py_DECREF(obj);
+        sv = bitsettable_with_bit(&sets, sv, poison);
+        if (sv == -1)
+          goto nomem;
+        poisoned = 1;
+        for (i = 0; i < revcount; i++) {
+          if (revs[i] == v)
+            goto done;
+        }
+      }
+    }
+    if (index_get_parents(self, v, parents, maxrev) < 0)
+      goto bail;
+
+    for (i = 0; i < 2; i++) {
+      int p = parents[i];
+      int sp;
+      if (p == -1)
+        continue;
+      sp = seen[p] - 1;
+      if (!poisoned) {
+        if (sp < 0) {
+          seen[p] = sv + 1;
+          interesting++;
+        } else if (sp != sv) {
+          int su = bitsettable_union(&sets, sp, sv);
+          if (su == -1)
+            goto nomem;
+          seen[p] = su + 1;
+        }
+      } else {
+        if (sp >= 0 && !bitset_test(bitsettable_get(&sets, sp), poison))
+          interesting--;
+        seen[p] = sv + 1;
+      }
+    }
+  }
+
+done:
+  free(seen);
+  bitsettable_free(&sets);
+  return gca;
+nomem:
+  PyErr_NoMemory();
+bail:
+  free(seen);
+  bitsettable_free(&sets);
+  Py_XDECREF(gca);
+  return NULL;
+}
+
 /*
  * Given a disjoint set of revs, return the subset with the longest
  * path to the root.
@@ -1500,6 +1746,11 @@ bail:
   return keys;
 }
 
+static int intcmp(const void* a, const void* b) {
+  int x = *(const int*)a, y = *(const int*)b;
+  return (x > y) - (x < y);
+}
+
 /*
  * Given a (possibly overlapping) set of revs, return all the
  * common ancestors heads: heads(::args[0] and ::a[1] and ...)
@@ -1507,7 +1758,6 @@ bail:
 static PyObject* index_commonancestorsheads(indexObject* self, PyObject* args) {
   PyObject* ret = NULL;
   Py_ssize_t argcount, i, len;
-  bitmask repeat = 0;
   int revcount = 0;
   int* revs;
 
@@ -1518,9 +1768,7 @@ static PyObject* index_commonancestorsheads(indexObject* self, PyObject* args) {
   len = index_length(self) - 1;
 
   for (i = 0; i < argcount; i++) {
-    static const int capacity = 24;
     PyObject* obj = PySequence_GetItem(args, i);
-    bitmask x;
     long val;
 
     if (!PyInt_Check(obj)) {
@@ -1538,28 +1786,18 @@ static PyObject* index_commonancestorsheads(indexObject* self, PyObject* args) {
       PyErr_SetString(PyExc_IndexError, "index out of range");
       goto bail;
     }
-    /* this cheesy bloom filter lets us avoid some more
-     * expensive duplicate checks in the common set-is-disjoint
-     * case */
-    x = 1ull << (val & 0x3f);
-    if (repeat & x) {
-      int k;
-      for (k = 0; k < revcount; k++) {
-        if (val == revs[k])
-          goto duplicate;
-      }
-    } else
-      repeat |= x;
-    if (revcount >= capacity) {
-      PyErr_Format(
-          PyExc_OverflowError,
-          "bitset size (%d) > capacity (%d)",
-          revcount,
-          capacity);
-      goto bail;
-    }
     revs[revcount++] = (int)val;
-  duplicate:;
+  }
+
+  /* remove duplicates */
+  if (revcount > 1) {
+    int k;
+    qsort(revs, revcount, sizeof(*revs), intcmp);
+    for (i = 1, k = 1; i < revcount; i++) {
+      if (revs[i] != revs[k - 1])
+        revs[k++] = revs[i];
+    }
+    revcount = k;
   }
 
   if (revcount == 0) {
@@ -1578,7 +1816,11 @@ static PyObject* index_commonancestorsheads(indexObject* self, PyObject* args) {
     goto done;
   }
 
-  ret = find_gca_candidates(self, revs, revcount);
+  /* a single bitmask per rev holds a bit per rev, plus the poison bit */
+  if (revcount < (int)(sizeof(bitmask) * 8))
+    ret = find_gca_candidates(self, revs, revcount);
+  else
+    ret = find_gca_candidates_many(self, revs, revcount);
   if (ret == NULL)
     goto bail;
 
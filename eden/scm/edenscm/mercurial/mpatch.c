@@ -12,7 +12,7 @@
  size of the output and n is the number of patches.
 
  Given a list of binary patches, it unpacks each into a hunk list,
- then combines the hunk lists with a treewise recursion to form a
+ then combines the hunk lists pairwise in a tree to form a
  single hunk list. This hunk list is then applied to the original
  text.
 
@@ -146,44 +146,35 @@ static int discard(struct mpatch_flist* src, int cut, int offset) {
   return offset;
 }
 
-/* combine hunk lists a and b, while adjusting b for offset changes in a/
-   this deletes a and b and returns the resultant list. */
-static struct mpatch_flist* combine(
+/* combine hunk lists a and b into c, while adjusting b for offset changes
+   in a. c must have room for lsize(a) + lsize(b) * 2 more hunks. */
+static void combine(
+    struct mpatch_flist* c,
     struct mpatch_flist* a,
     struct mpatch_flist* b) {
-  struct mpatch_flist* c = NULL;
   struct mpatch_frag *bh, *ct;
   int offset = 0, post;
 
-  if (a && b)
-    c = lalloc((lsize(a) + lsize(b)) * 2);
-
-  if (c) {
-    for (bh = b->head; bh != b->tail; bh++) {
-      /* save old hunks */
-      offset = gather(c, a, bh->start, offset);
-
-      /* discard replaced hunks */
-      post = discard(a, bh->end, offset);
-
-      /* insert new hunk */
-      ct = c->tail;
-      ct->start = bh->start - offset;
-      ct->end = bh->end - post;
-      ct->len = bh->len;
-      ct->data = bh->data;
-      c->tail++;
-      offset = post;
-    }
-
-    /* hold on to tail from a */
-    memcpy(c->tail, a->head, sizeof(struct mpatch_frag) * lsize(a));
-    c->tail += lsize(a);
+  for (bh = b->head; bh != b->tail; bh++) {
+    /* save old hunks */
+    offset = gather(c, a, bh->start, offset);
+
+    /* discard replaced hunks */
+    post = discard(a, bh->end, offset);
+
+    /* insert new hunk */
+    ct = c->tail;
+    ct->start = bh->start - offset;
+    ct->end = bh->end - post;
+    ct->len = bh->len;
+    ct->data = bh->data;
+    c->tail++;
+    offset = post;
   }
 
-  mpatch_lfree(a);
-  mpatch_lfree(b);
-  return c;
+  /* hold on to tail from a */
+  memcpy(c->tail, a->head, sizeof(struct mpatch_frag) * lsize(a));
+  c->tail += lsize(a);
 }
 
 /* decode a binary patch into a hunk list */
@@ -227,7 +218,7 @@ ssize_t mpatch_calcsize(ssize_t len, struct mpatch_flist* l) {
   struct mpatch_frag* f = l->head;
 
   while (f != l->tail) {
-    if (f->start < last || f->end > len) {
+    if (f->start < last || f->end < f->start || f->end > len) {
       return MPATCH_ERR_INVALID_PATCH;
     }
     outlen += f->start - last;
@@ -250,7 +241,7 @@ int mpatch_apply(
   char* p = buf;
 
   while (f != l->tail) {
-    if (f->start < last || f->end > len) {
+    if (f->start < last || f->end < f->start || f->end > len) {
       return MPATCH_ERR_INVALID_PATCH;
     }
     memcpy(p, orig + last, f->start - last);
@@ -264,22 +255,151 @@ int mpatch_apply(
   return 0;
 }
 
-/* recursively generate a patch of all bins between start and end */
+/*
+ Rather than recursing and allocating a new list for every pair of lists
+ that are combined, mpatch_fold keeps a stack of combined lists, which
+ the patches are pushed on one by one. The two lists at the top of the
+ stack are combined whenever they are made of as many patches, like the
+ carries of a binary counter. Like with the recursion, lists of similar
+ sizes are combined, and they are combined while still in cache.
+
+ The lists are stored in two buffers, which are the only allocations
+ besides the decoded patches. A list made of 2^rank patches is in the
+ buffer of the parity of its rank, so the two lists at the top of the
+ stack are always combined at the end of the other buffer.
+*/
+struct foldbuf {
+  struct mpatch_frag* base;
+  ssize_t size, capacity;
+};
+
+/* a list of the stack, made of 2^rank patches unless it's the result of
+   the last combinations */
+struct foldlist {
+  int buf, rank;
+  ssize_t head, tail;
+};
+
+static int foldreserve(struct foldbuf* buf, ssize_t count) {
+  struct mpatch_frag* base;
+  ssize_t capacity = buf->capacity * 2;
+
+  if (buf->base && buf->size + count <= buf->capacity)
+    return 0;
+  if (capacity < buf->size + count)
+    capacity = buf->size + count;
+  if (capacity < 1)
+    capacity = 1;
+  base = (struct mpatch_frag*)realloc(
+      buf->base, sizeof(struct mpatch_frag) * capacity);
+  if (!base)
+    return MPATCH_ERR_NO_MEM;
+  buf->base = base;
+  buf->capacity = capacity;
+  return 0;
+}
+
+static struct mpatch_flist foldview(struct foldbuf* bufs, struct foldlist* l) {
+  struct mpatch_flist view;
+
+  view.base = bufs[l->buf].base;
+  view.head = view.base + l->head;
+  view.tail = view.base + l->tail;
+  return view;
+}
+
+/* the space of a list is reused once everything above it is gone */
+static void foldrelease(struct foldbuf* bufs, struct foldlist* l) {
+  if (bufs[l->buf].size == l->tail)
+    bufs[l->buf].size = l->head;
+}
+
+/* replace the two lists at the top of the stack by their combination */
+static int foldcombine(
+    struct foldbuf* bufs,
+    struct foldlist* stack,
+    ssize_t* depth) {
+  struct foldlist *a = &stack[*depth - 2], *b = &stack[*depth - 1], c;
+  struct mpatch_flist va, vb, vc;
+  struct foldbuf* out;
+
+  c.buf = !a->buf;
+  c.rank = a->rank + 1;
+  out = &bufs[c.buf];
+  /* each hunk of b adds itself and splits at most one hunk of a */
+  if (foldreserve(out, (a->tail - a->head) + (b->tail - b->head) * 2) < 0)
+    return MPATCH_ERR_NO_MEM;
+
+  va = foldview(bufs, a);
+  vb = foldview(bufs, b);
+  vc.base = out->base;
+  vc.head = vc.tail = out->base + out->size;
+  combine(&vc, &va, &vb);
+  c.head = out->size;
+  c.tail = out->size = vc.tail - out->base;
+
+  foldrelease(bufs, b);
+  foldrelease(bufs, a);
+  *a = c;
+  (*depth)--;
+  return 0;
+}
+
+/* generate a patch of all bins between start and end */
 struct mpatch_flist* mpatch_fold(
     void* bins,
     struct mpatch_flist* (*get_next_item)(void*, ssize_t),
     ssize_t start,
     ssize_t end) {
-  ssize_t len;
+  /* the ranks decrease from the bottom of the stack, plus one patch */
+  struct foldlist stack[sizeof(ssize_t) * 8 + 1];
+  struct foldbuf bufs[2] = {{NULL, 0, 0}, {NULL, 0, 0}};
+  struct mpatch_flist *l, *res = NULL;
+  struct foldlist* top;
+  ssize_t depth = 0, i;
 
   if (start + 1 == end) {
     /* trivial case, output a decoded list */
     return get_next_item(bins, start);
   }
 
-  /* divide and conquer, memory management is elsewhere */
-  len = (end - start) / 2;
-  return combine(
-      mpatch_fold(bins, get_next_item, start, start + len),
-      mpatch_fold(bins, get_next_item, start + len, end));
+  for (i = start; i < end; i++) {
+    l = get_next_item(bins, i);
+    if (!l)
+      goto cleanup;
+    if (foldreserve(&bufs[0], lsize(l)) < 0) {
+      mpatch_lfree(l);
+      goto cleanup;
+    }
+    top = &stack[depth++];
+    top->buf = top->rank = 0;
+    top->head = bufs[0].size;
+    top->tail = bufs[0].size += lsize(l);
+    memcpy(bufs[0].base + top->head, l->head, sizeof(*l->head) * lsize(l));
+    mpatch_lfree(l);
+
+    while (depth > 1 && stack[depth - 2].rank == stack[depth - 1].rank) {
+      if (foldcombine(bufs, stack, &depth) < 0)
+        goto cleanup;
+    }
+  }
+
+  /* the patches left over from the last carries */
+  while (depth > 1) {
+    if (foldcombine(bufs, stack, &depth) < 0)
+      goto cleanup;
+  }
+
+  if (depth == 0)
+    goto cleanup;
+  res = (struct mpatch_flist*)malloc(sizeof(struct mpatch_flist));
+  if (res) {
+    *res = foldview(bufs, &stack[0]);
+    bufs[stack[0].buf].base = NULL;
+  }
+
+cleanup:
+  free(bufs[0].base);
+  free(bufs[1].base);
+  return res;
 }
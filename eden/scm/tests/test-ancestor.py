@@ -2,14 +2,24 @@ from __future__ import absolute_import, print_function
 
 import binascii
 import getopt
+import hashlib
 import math
 import os
 import random
 import sys
 import time
 
-from edenscm.mercurial import ancestor, debugcommands, hg, pycompat, ui as uimod, util
+from edenscm.mercurial import (
+    ancestor,
+    debugcommands,
+    hg,
+    pycompat,
+    revlog,
+    ui as uimod,
+    util,
+)
 from edenscm.mercurial.node import nullrev
+from edenscmnative import parsers
 from hghave import require
 
 
@@ -275,6 +285,29 @@ def test_gca():
                         print("  expected:        %s" % expected)
 
 
+def test_commonancestorsheads(seed, rng):
+    # Compare the C implementation of the revlog index against the Python one,
+    # including with more revs than fit in a single bitmask.
+    for i in xrange(20):
+        graph = buildgraph(rng, nodes=300)
+        data = []
+        for rev, parents in enumerate(graph):
+            p1, p2 = (parents + [nullrev])[:2]
+            node = hashlib.sha1(str(rev).encode("ascii")).digest()
+            data.append(revlog.indexformatng_pack(0, 0, 0, rev, rev, p1, p2, node))
+        index, cache = parsers.parse_index2(b"".join(data), False)
+        for count in (2, 3, 24, 63, 64, 100, 200):
+            revs = rng.sample(xrange(len(graph)), count)
+            cgcas = sorted(index.commonancestorsheads(*revs))
+            pygcas = sorted(ancestor.commonancestorsheads(graph.__getitem__, *revs))
+            if cgcas != pygcas:
+                print(
+                    "test_commonancestorsheads (seed %s): for revs %s:" % (seed, revs)
+                )
+                print("  C returned:      %s" % cgcas)
+                print("  Python returned: %s" % pygcas)
+
+
 def main():
     seed = None
     opts, args = getopt.getopt(sys.argv[1:], "s:", ["seed="])
@@ -292,6 +325,7 @@ def main():
     test_missingancestors(seed, rng)
     test_lazyancestors()
     test_gca()
+    test_commonancestorsheads(seed, rng)
 
 
 if __name__ == "__main__":
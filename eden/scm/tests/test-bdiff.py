@@ -1,6 +1,7 @@
 from __future__ import absolute_import, print_function
 
 import collections
+import random
 import struct
 import unittest
 
@@ -60,6 +61,39 @@ class BdiffTests(unittest.TestCase):
         for a, b in cases:
             self.assert_bdiff(a, b)
 
+    def test_patch_chain(self):
+        rng = random.Random(0)
+        versions = ["".join("line %d\n" % i for i in range(100))]
+        for i in range(200):
+            lines = versions[-1].splitlines(True)
+            for j in range(rng.randrange(5)):
+                pos = rng.randrange(len(lines) + 1)
+                if pos < len(lines) and rng.random() < 0.5:
+                    del lines[pos : pos + rng.randrange(1, 4)]
+                else:
+                    lines.insert(pos, "version %d edit %d\n" % (i, j))
+            versions.append("".join(lines))
+        bins = [mdiff.textdiff(a, b) for a, b in zip(versions, versions[1:])]
+
+        # Every chain length, so that the hunk lists are folded in every
+        # possible shape.
+        for end in range(1, len(bins) + 1):
+            self.assertEqual(mdiff.patches(versions[0], bins[:end]), versions[end])
+        for start in range(len(bins)):
+            self.assertEqual(
+                mdiff.patches(versions[start], bins[start:]), versions[-1]
+            )
+
+    def test_patch_chain_past_end(self):
+        # An empty hunk past the end of the text is still invalid when it is
+        # folded with other patches.
+        bins = [
+            struct.pack(">lll", 0, 0, 1) + "b",
+            struct.pack(">lll", 10, 10, 0),
+            struct.pack(">lll", 0, 0, 1) + "c",
+        ]
+        self.assertRaises(mdiff.mpatch.mpatchError, mdiff.patches, "a\n", bins)
+
     def showdiff(self, a, b):
         bin = mdiff.textdiff(a, b)
         pos = 0